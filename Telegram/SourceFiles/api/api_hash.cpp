@@ -91,4 +91,16 @@ int32 CountSavedGifsHash(not_null<Main::Session*> session) {
 	return CountDocumentVectorHash(session->data().stickers().savedGifs());
 }
 
+int32 CountContactsHash(
+		int32 savedCount,
+		std::vector<int32> userIds) {
+	ranges::sort(userIds);
+	auto result = HashInit();
+	HashUpdate(result, savedCount);
+	for (const auto userId : userIds) {
+		HashUpdate(result, userId);
+	}
+	return HashFinalize(result);
+}
+
 } // namespace Api
@@ -22,6 +22,9 @@ namespace Api {
 [[nodiscard]] int32 CountFeaturedStickersHash(
 	not_null<Main::Session*> session);
 [[nodiscard]] int32 CountSavedGifsHash(not_null<Main::Session*> session);
+[[nodiscard]] int32 CountContactsHash(
+	int32 savedCount,
+	std::vector<int32> userIds);
 
 [[nodiscard]] inline uint32 HashInit() {
 	return 0;
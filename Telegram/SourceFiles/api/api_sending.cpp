@@ -66,7 +66,8 @@ void SendExistingMedia(
 		Fn<MTPInputMedia()> inputMedia,
 		Data::FileOrigin origin,
 		Fn<void()> doneCallback = nullptr,
-		bool forwarding = false) {
+		bool forwarding = false,
+		Fn<void()> failCallback = nullptr) {
 	const auto history = message.action.history;
 	const auto peer = history->peer;
 	const auto session = &history->session();
@@ -134,6 +135,13 @@ void SendExistingMedia(
 		caption,
 		MTPReplyMarkup());
 
+	const auto fail = [=](const RPCError &error) {
+		api->sendMessageFail(error, peer, randomId, newId);
+		if (failCallback) {
+			failCallback();
+		}
+	};
+
 	auto performRequest = [=](const auto &repeatRequest) -> void {
 		auto &histories = history->owner().histories();
 		const auto requestType = Data::Histories::RequestType::Send;
@@ -162,11 +170,11 @@ void SendExistingMedia(
 						if (media->fileReference() != usedFileReference) {
 							repeatRequest(repeatRequest);
 						} else {
-							api->sendMessageFail(error, peer, randomId, newId);
+							fail(error);
 						}
-						});
+					});
 				} else {
-					api->sendMessageFail(error, peer, randomId, newId);
+					fail(error);
 				}
 				finish();
 			}).afterRequest(history->sendRequestId
@@ -187,7 +195,8 @@ void SendExistingDocument(
 		Api::MessageToSend &&message,
 		not_null<DocumentData*> document,
 		Fn<void()> doneCallback,
-		bool forwarding) {
+		bool forwarding,
+		Fn<void()> failCallback) {
 	const auto inputMedia = [=] {
 		return MTP_inputMediaDocument(
 			MTP_flags(0),
@@ -201,7 +210,8 @@ void SendExistingDocument(
 		inputMedia,
 		document->stickerOrGifOrigin(),
 		(doneCallback ? std::move(doneCallback) : nullptr),
-		forwarding);
+		forwarding,
+		std::move(failCallback));
 
 	if (document->sticker()) {
 		document->owner().stickers().incrementSticker(document);
@@ -212,7 +222,8 @@ void SendExistingPhoto(
 		Api::MessageToSend &&message,
 		not_null<PhotoData*> photo,
 		Fn<void()> doneCallback,
-		bool forwarding) {
+		bool forwarding,
+		Fn<void()> failCallback) {
 	const auto inputMedia = [=] {
 		return MTP_inputMediaPhoto(
 			MTP_flags(0),
@@ -225,7 +236,8 @@ void SendExistingPhoto(
 		inputMedia,
 		Data::FileOrigin(),
 		(doneCallback ? std::move(doneCallback) : nullptr),
-		forwarding);
+		forwarding,
+		std::move(failCallback));
 }
 
 bool SendDice(Api::MessageToSend &message) {
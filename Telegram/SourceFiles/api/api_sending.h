@@ -26,13 +26,15 @@ void SendExistingDocument(
 	Api::MessageToSend &&message,
 	not_null<DocumentData*> document,
 	Fn<void()> doneCallback = nullptr,
-	bool forwarding = false);
+	bool forwarding = false,
+	Fn<void()> failCallback = nullptr);
 
 void SendExistingPhoto(
 	Api::MessageToSend &&message,
 	not_null<PhotoData*> photo,
 	Fn<void()> doneCallback = nullptr,
-	bool forwarding = false);
+	bool forwarding = false,
+	Fn<void()> failCallback = nullptr);
 
 bool SendDice(Api::MessageToSend &message);
 
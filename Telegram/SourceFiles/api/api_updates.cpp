@@ -51,6 +51,12 @@ constexpr auto kChannelGetDifferenceLimit = 100;
 // 1s wait after show channel history before sending getChannelDifference.
 constexpr auto kWaitForChannelGetDifference = crl::time(1000);
 
+// Not more than that getChannelDifference requests are sent at once,
+// the rest are queued by priority (opened chats, then unread ones).
+constexpr auto kChannelDifferenceRequestsLimit = 8;
+
+constexpr auto kUpdateStatsDumpPeriod = 5 * 60 * crl::time(1000);
+
 // If nothing is received in 1 min we ping.
 constexpr auto kNoUpdatesTimeout = 60 * 1000;
 
@@ -216,8 +222,10 @@ Updates::Updates(not_null<Main::Session*> session)
 , _bySeqTimer([=] { getDifference(); })
 , _byMinChannelTimer([=] { getDifference(); })
 , _failDifferenceTimer([=] { getDifferenceAfterFail(); })
-, _idleFinishTimer([=] { checkIdleFinish(); }) {
+, _idleFinishTimer([=] { checkIdleFinish(); })
+, _updateStatsTimer([=] { dumpUpdateStats(); }) {
 	_ptsWaiter.setRequesting(true);
+	_updateStatsTimer.callEach(kUpdateStatsDumpPeriod);
 
 	session->account().mtpUpdates(
 	) | rpl::start_with_next([=](const MTPUpdates &updates) {
@@ -278,6 +286,10 @@ void Updates::checkLastUpdate(bool afterSleep) {
 void Updates::feedUpdateVector(
 		const MTPVector<MTPUpdate> &updates,
 		bool skipMessageIds) {
+	auto &changes = session().changes();
+	changes.startBatch();
+	const auto guard = gsl::finally([&] { changes.finishBatch(); });
+
 	for (const auto &update : updates.v) {
 		if (skipMessageIds && update.type() == mtpc_updateMessageID) {
 			continue;
@@ -548,6 +560,10 @@ void Updates::feedDifference(
 		const MTPVector<MTPChat> &chats,
 		const MTPVector<MTPMessage> &msgs,
 		const MTPVector<MTPUpdate> &other) {
+	auto &changes = session().changes();
+	changes.startBatch();
+	const auto guard = gsl::finally([&] { changes.finishBatch(); });
+
 	Core::App().checkAutoLock();
 	session().data().processUsers(users);
 	session().data().processChats(chats);
@@ -663,6 +679,18 @@ void Updates::getChannelDifference(
 
 	channel->ptsSetRequesting(true);
 
+	if (_channelDifferenceRequests >= kChannelDifferenceRequestsLimit) {
+		_channelDifferenceQueue.push_back({ channel, from });
+		return;
+	}
+	sendChannelDifference(channel, from);
+}
+
+void Updates::sendChannelDifference(
+		not_null<ChannelData*> channel,
+		ChannelDifferenceRequest from) {
+	++_channelDifferenceRequests;
+
 	auto filter = MTP_channelMessagesFilterEmpty();
 	auto flags = MTPupdates_GetChannelDifference::Flag::f_force | 0;
 	if (from != ChannelDifferenceRequest::PtsGapOrShortPoll) {
@@ -677,12 +705,43 @@ void Updates::getChannelDifference(
 		MTP_int(channel->pts()),
 		MTP_int(kChannelGetDifferenceLimit)
 	)).done([=](const MTPupdates_ChannelDifference &result) {
+		--_channelDifferenceRequests;
 		channelDifferenceDone(channel, result);
+		sendQueuedChannelDifferences();
 	}).fail([=](const RPCError &error) {
+		--_channelDifferenceRequests;
 		channelDifferenceFail(channel, error);
+		sendQueuedChannelDifferences();
 	}).send();
 }
 
+void Updates::sendQueuedChannelDifferences() {
+	while (!_channelDifferenceQueue.empty()
+		&& _channelDifferenceRequests < kChannelDifferenceRequestsLimit) {
+		const auto i = ranges::max_element(
+			_channelDifferenceQueue,
+			ranges::less(),
+			[&](const QueuedChannelDifference &queued) {
+				return channelDifferencePriority(queued.channel);
+			});
+		const auto queued = *i;
+		_channelDifferenceQueue.erase(i);
+		sendChannelDifference(queued.channel, queued.from);
+	}
+}
+
+int Updates::channelDifferencePriority(
+		not_null<ChannelData*> channel) const {
+	if (ranges::contains(
+			_activeChats,
+			channel,
+			[](const auto &pair) { return pair.second.peer; })) {
+		return 2;
+	}
+	const auto history = session().data().historyLoaded(channel->id);
+	return (history && history->unreadCount() > 0) ? 1 : 0;
+}
+
 void Updates::sendPing() {
 	_session->mtp().ping();
 }
@@ -966,6 +1025,13 @@ void Updates::handleSendActionUpdate(
 }
 
 void Updates::applyUpdatesNoPtsCheck(const MTPUpdates &updates) {
+	const auto started = Logs::DebugEnabled() ? crl::profile() : 0;
+	const auto guard = gsl::finally([&] {
+		if (started) {
+			countUpdateTime(updates.type(), started);
+		}
+	});
+
 	switch (updates.type()) {
 	case mtpc_updateShortMessage: {
 		const auto &d = updates.c_updateShortMessage();
@@ -1356,7 +1422,47 @@ void Updates::applyUpdates(
 	session().data().sendHistoryChangeNotifications();
 }
 
+void Updates::countUpdateTime(mtpTypeId type, int64 started) {
+	const auto duration = crl::profile() - started;
+	auto &stats = _updateStats[type];
+	++stats.count;
+	stats.total += duration;
+	accumulate_max(stats.max, duration);
+}
+
+void Updates::dumpUpdateStats() {
+	const auto now = crl::now();
+	const auto period = _updateStatsStart ? (now - _updateStatsStart) : 0;
+	_updateStatsStart = now;
+	const auto stats = base::take(_updateStats);
+	if (stats.empty()) {
+		return;
+	}
+	auto result = QStringList();
+	auto count = 0;
+	for (const auto &[type, data] : stats) {
+		count += data.count;
+		result.push_back(QString("type:0x%1 n:%2 total:%3us avg:%4us max:%5us"
+			).arg(type, 8, 16, QChar('0')
+			).arg(data.count
+			).arg(data.total
+			).arg(data.total / data.count
+			).arg(data.max));
+	}
+	DEBUG_LOG(("Updates Stats: %1 updates in %2 ms\n%3"
+		).arg(count
+		).arg(period
+		).arg(result.join('\n')));
+}
+
 void Updates::feedUpdate(const MTPUpdate &update) {
+	const auto started = Logs::DebugEnabled() ? crl::profile() : 0;
+	const auto guard = gsl::finally([&] {
+		if (started) {
+			countUpdateTime(update.type(), started);
+		}
+	});
+
 	switch (update.type()) {
 
 	// New messages.
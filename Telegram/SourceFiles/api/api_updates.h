@@ -68,6 +68,11 @@ private:
 		rpl::lifetime lifetime;
 	};
 
+	struct QueuedChannelDifference {
+		not_null<ChannelData*> channel;
+		ChannelDifferenceRequest from = ChannelDifferenceRequest::Unknown;
+	};
+
 	void channelRangeDifferenceSend(
 		not_null<ChannelData*> channel,
 		MsgRange range,
@@ -88,6 +93,12 @@ private:
 	void getChannelDifference(
 		not_null<ChannelData*> channel,
 		ChannelDifferenceRequest from = ChannelDifferenceRequest::Unknown);
+	void sendChannelDifference(
+		not_null<ChannelData*> channel,
+		ChannelDifferenceRequest from);
+	void sendQueuedChannelDifferences();
+	[[nodiscard]] int channelDifferencePriority(
+		not_null<ChannelData*> channel) const;
 	void differenceDone(const MTPupdates_Difference &result);
 	void differenceFail(const RPCError &error);
 	void feedDifference(
@@ -122,6 +133,9 @@ private:
 		base::flat_map<not_null<ChannelData*>, crl::time> &whenMap,
 		crl::time &curTime);
 
+	void countUpdateTime(mtpTypeId type, int64 started);
+	void dumpUpdateStats();
+
 	void handleSendActionUpdate(
 		PeerId peerId,
 		MsgId rootId,
@@ -162,6 +176,10 @@ private:
 		not_null<ChannelData*>,
 		mtpRequestId> _rangeDifferenceRequests;
 
+	// Channels waiting for a free getChannelDifference request slot.
+	std::vector<QueuedChannelDifference> _channelDifferenceQueue;
+	int _channelDifferenceRequests = 0;
+
 	crl::time _lastUpdateTime = 0;
 	bool _handlingChannelDifference = false;
 
@@ -172,6 +190,16 @@ private:
 
 	mtpRequestId _onlineRequest = 0;
 	base::Timer _idleFinishTimer;
+
+	// Per update type cost, collected only with debug logs enabled.
+	struct UpdateTypeStats {
+		int count = 0;
+		int64 total = 0;
+		int64 max = 0;
+	};
+	base::flat_map<mtpTypeId, UpdateTypeStats> _updateStats;
+	base::Timer _updateStatsTimer;
+	crl::time _updateStatsStart = 0;
 	crl::time _lastSetOnline = 0;
 	bool _lastWasOnline = false;
 	bool _isIdle = false;
@@ -52,6 +52,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/history.h"
 #include "history/history_message.h"
 #include "history/history_item_components.h"
+#include "history/view/history_view_element.h"
 //#include "history/feed/history_feed_section.h" // #feed
 #include "main/main_session.h"
 #include "main/main_session_settings.h"
@@ -96,6 +97,13 @@ constexpr auto kMaxUsersPerInvite = 100;
 // that was added to this chat.
 constexpr auto kForwardMessagesOnAdd = 100;
 
+// Server accepts that many messages in one messages.forwardMessages.
+constexpr auto kForwardMessagesPerRequest = 100;
+
+// Maximum number of ids in a single users.getUsers / messages.getChats.
+constexpr auto kPeersPerRequest = 100;
+constexpr auto kMessageDataPerRequest = 100;
+
 constexpr auto kTopPromotionInterval = TimeId(60 * 60);
 constexpr auto kTopPromotionMinDelay = TimeId(10);
 constexpr auto kSmallDelayMs = 5;
@@ -106,6 +114,7 @@ constexpr auto kSharedMediaLimit = 100;
 //constexpr auto kFeedMessagesLimit = 50; // #feed
 constexpr auto kReadFeaturedSetsTimeout = crl::time(1000);
 constexpr auto kFileLoaderQueueStopTimeout = crl::time(5000);
+constexpr auto kFileLoaderThreadsMax = 4;
 //constexpr auto kFeedReadTimeout = crl::time(1000); // #feed
 constexpr auto kStickersByEmojiInvalidateTimeout = crl::time(60 * 60 * 1000);
 constexpr auto kNotifySettingSaveTimeout = crl::time(1000);
@@ -117,6 +126,27 @@ using PhotoFileLocationId = Data::PhotoFileLocationId;
 using DocumentFileLocationId = Data::DocumentFileLocationId;
 using UpdatedFileReferences = Data::UpdatedFileReferences;
 
+// Returns the first message with date > offsetDate, the same way
+// messages.getHistory with add_offset = -1 does, or 0 if the loaded
+// part of the history doesn't cover that date.
+[[nodiscard]] MsgId LoadedMessageAfterDate(
+		not_null<History*> history,
+		TimeId offsetDate) {
+	auto previousLoaded = history->loadedAtTop();
+	for (const auto &block : history->blocks) {
+		for (const auto &view : block->messages) {
+			const auto item = view->data();
+			if (!IsServerMsgId(item->id)) {
+				continue;
+			} else if (item->date() > offsetDate) {
+				return previousLoaded ? item->id : 0;
+			}
+			previousLoaded = true;
+		}
+	}
+	return 0;
+}
+
 } // namespace
 
 MTPInputPrivacyKey ApiWrap::Privacy::Input(Key key) {
@@ -182,11 +212,14 @@ ApiWrap::ApiWrap(not_null<Main::Session*> session)
 : MTP::Sender(&session->account().mtp())
 , _session(session)
 , _messageDataResolveDelayed([=] { resolveMessageDatas(); })
+, _peersRequestDelayed([=] { sendPeersRequests(); })
 , _webPagesTimer([=] { resolveWebPages(); })
 , _draftsSaveTimer([=] { saveDraftsToCloud(); })
 , _featuredSetsReadTimer([=] { readFeaturedSets(); })
 , _dialogsLoadState(std::make_unique<DialogsLoadState>())
-, _fileLoader(std::make_unique<TaskQueue>(kFileLoaderQueueStopTimeout))
+, _fileLoader(std::make_unique<TaskQueue>(
+	kFileLoaderQueueStopTimeout,
+	std::clamp(QThread::idealThreadCount(), 1, kFileLoaderThreadsMax)))
 //, _feedReadTimer([=] { readFeeds(); }) // #feed
 , _topPromotionTimer([=] { refreshTopPromotion(); })
 , _updateNotifySettingsTimer([=] { sendNotifySettingsUpdates(); })
@@ -576,10 +609,23 @@ QVector<MTPInputMessage> ApiWrap::collectMessageIds(const MessageDataRequests &r
 	for (auto i = requests.cbegin(), e = requests.cend(); i != e; ++i) {
 		if (i.value().requestId > 0) continue;
 		result.push_back(MTP_inputMessageID(MTP_int(i.key())));
+		if (result.size() == kMessageDataPerRequest) break;
 	}
 	return result;
 }
 
+void ApiWrap::markMessageDataRequests(
+		MessageDataRequests &requests,
+		const QVector<MTPInputMessage> &ids,
+		mtpRequestId requestId) {
+	for (const auto &id : ids) {
+		const auto i = requests.find(id.c_inputMessageID().vid().v);
+		if (i != requests.end()) {
+			i.value().requestId = requestId;
+		}
+	}
+}
+
 ApiWrap::MessageDataRequests *ApiWrap::messageDataRequests(ChannelData *channel, bool onlyExisting) {
 	if (channel) {
 		auto i = _channelMessageDataRequests.find(channel);
@@ -597,41 +643,41 @@ ApiWrap::MessageDataRequests *ApiWrap::messageDataRequests(ChannelData *channel,
 void ApiWrap::resolveMessageDatas() {
 	if (_messageDataRequests.isEmpty() && _channelMessageDataRequests.isEmpty()) return;
 
-	auto ids = collectMessageIds(_messageDataRequests);
-	if (!ids.isEmpty()) {
-		auto requestId = request(MTPmessages_GetMessages(
+	// Large lists are split, the server won't return too many at once.
+	while (true) {
+		const auto ids = collectMessageIds(_messageDataRequests);
+		if (ids.isEmpty()) {
+			break;
+		}
+		const auto requestId = request(MTPmessages_GetMessages(
 			MTP_vector<MTPInputMessage>(ids)
 		)).done([this](const MTPmessages_Messages &result, mtpRequestId requestId) {
 			gotMessageDatas(nullptr, result, requestId);
 		}).fail([this](const RPCError &error, mtpRequestId requestId) {
 			finalizeMessageDataRequest(nullptr, requestId);
 		}).afterDelay(kSmallDelayMs).send();
-		for (auto &request : _messageDataRequests) {
-			if (request.requestId > 0) continue;
-			request.requestId = requestId;
-		}
+		markMessageDataRequests(_messageDataRequests, ids, requestId);
 	}
 	for (auto j = _channelMessageDataRequests.begin(); j != _channelMessageDataRequests.cend();) {
 		if (j->isEmpty()) {
 			j = _channelMessageDataRequests.erase(j);
 			continue;
 		}
-		auto ids = collectMessageIds(j.value());
-		if (!ids.isEmpty()) {
-			auto channel = j.key();
-			auto requestId = request(MTPchannels_GetMessages(
-				j.key()->inputChannel,
+		const auto channel = j.key();
+		while (true) {
+			const auto ids = collectMessageIds(j.value());
+			if (ids.isEmpty()) {
+				break;
+			}
+			const auto requestId = request(MTPchannels_GetMessages(
+				channel->inputChannel,
 				MTP_vector<MTPInputMessage>(ids)
 			)).done([=](const MTPmessages_Messages &result, mtpRequestId requestId) {
 				gotMessageDatas(channel, result, requestId);
 			}).fail([=](const RPCError &error, mtpRequestId requestId) {
 				finalizeMessageDataRequest(channel, requestId);
 			}).afterDelay(kSmallDelayMs).send();
-
-			for (auto &request : *j) {
-				if (request.requestId > 0) continue;
-				request.requestId = requestId;
-			}
+			markMessageDataRequests(j.value(), ids, requestId);
 		}
 		++j;
 	}
@@ -775,16 +821,24 @@ void ApiWrap::requestContacts() {
 	if (_session->data().contactsLoaded().current() || _contactsRequestId) {
 		return;
 	}
+	// The saved contacts are restored right away, so if the server says
+	// they are not modified we already have the full list.
+	const auto saved = local().readContacts();
 	_contactsRequestId = request(MTPcontacts_GetContacts(
-		MTP_int(0)
+		MTP_int(saved.hash)
 	)).done([=](const MTPcontacts_Contacts &result) {
 		_contactsRequestId = 0;
 		if (result.type() == mtpc_contacts_contactsNotModified) {
+			_session->data().contactsLoaded() = true;
 			return;
 		}
 		Assert(result.type() == mtpc_contacts_contacts);
 		const auto &d = result.c_contacts_contacts();
 		_session->data().processUsers(d.vusers());
+		auto ids = std::vector<int32>();
+		auto users = std::vector<not_null<UserData*>>();
+		ids.reserve(d.vcontacts().v.size());
+		users.reserve(d.vcontacts().v.size());
 		for (const auto &contact : d.vcontacts().v) {
 			if (contact.type() != mtpc_contact) continue;
 
@@ -792,7 +846,22 @@ void ApiWrap::requestContacts() {
 			if (userId == _session->userId()) {
 				_session->user()->setIsContact(true);
 			}
+			ids.push_back(userId);
+			users.push_back(_session->data().user(userId));
+		}
+		if (!saved.users.empty()) {
+			const auto now = base::flat_set<not_null<UserData*>>(
+				begin(users),
+				end(users));
+			for (const auto user : saved.users) {
+				if (!now.contains(user)) {
+					user->setIsContact(false);
+				}
+			}
 		}
+		local().writeContacts(
+			Api::CountContactsHash(d.vsaved_count().v, std::move(ids)),
+			users);
 		_session->data().contactsLoaded() = true;
 	}).fail([=](const RPCError &error) {
 		_contactsRequestId = 0;
@@ -1191,37 +1260,138 @@ void ApiWrap::requestPeer(not_null<PeerData*> peer) {
 		return;
 	}
 
-	const auto requestId = [&] {
-		const auto failHandler = [=](const RPCError &error) {
-			_peerRequests.remove(peer);
-		};
-		const auto chatHandler = [=](const MTPmessages_Chats &result) {
-			_peerRequests.remove(peer);
-			const auto &chats = result.match([](const auto &data) {
-				return data.vchats();
-			});
-			_session->data().applyMaximumChatVersions(chats);
-			_session->data().processChats(chats);
-		};
+	// Collect all the peers requested in one go into a single request.
+	_peerRequests.insert(peer, 0);
+	_peersToRequest.push_back(peer);
+	_peersRequestDelayed.call();
+}
+
+void ApiWrap::sendPeersRequests() {
+	sendPeersRequests(base::take(_peersToRequest), kPeersPerRequest);
+	sendPeersRequests(base::take(_peersToRequestSingly), 1);
+}
+
+void ApiWrap::sendPeersRequests(
+		const std::vector<not_null<PeerData*>> &peers,
+		int perRequest) {
+	if (peers.empty()) {
+		return;
+	}
+	auto users = std::vector<not_null<UserData*>>();
+	auto chats = std::vector<not_null<ChatData*>>();
+	auto channels = std::vector<not_null<ChannelData*>>();
+	for (const auto peer : peers) {
 		if (const auto user = peer->asUser()) {
-			return request(MTPusers_GetUsers(
-				MTP_vector<MTPInputUser>(1, user->inputUser)
-			)).done([=](const MTPVector<MTPUser> &result) {
-				_peerRequests.remove(user);
-				_session->data().processUsers(result);
-			}).fail(failHandler).send();
+			users.push_back(user);
 		} else if (const auto chat = peer->asChat()) {
-			return request(MTPmessages_GetChats(
-				MTP_vector<MTPint>(1, chat->inputChat)
-			)).done(chatHandler).fail(failHandler).send();
+			chats.push_back(chat);
 		} else if (const auto channel = peer->asChannel()) {
-			return request(MTPchannels_GetChannels(
-				MTP_vector<MTPInputChannel>(1, channel->inputChannel)
-			)).done(chatHandler).fail(failHandler).send();
+			channels.push_back(channel);
+		} else {
+			Unexpected("Peer type in sendPeersRequests.");
+		}
+	}
+	DEBUG_LOG(("Api Info: "
+		"requesting %1 users, %2 chats and %3 channels, %4 in a batch."
+		).arg(users.size()
+		).arg(chats.size()
+		).arg(channels.size()
+		).arg(perRequest));
+
+	const auto send = [&](const auto &list, auto prepare, auto wrap) {
+		for (auto from = 0; from < int(list.size()); from += perRequest) {
+			const auto till = std::min(
+				from + perRequest,
+				int(list.size()));
+			const auto part = std::vector<not_null<PeerData*>>(
+				begin(list) + from,
+				begin(list) + till);
+			auto ids = QVector<std::decay_t<decltype(prepare(list[0]))>>();
+			ids.reserve(till - from);
+			for (auto i = from; i != till; ++i) {
+				ids.push_back(prepare(list[i]));
+			}
+			const auto finish = [=] {
+				for (const auto peer : part) {
+					_peerRequests.remove(peer);
+				}
+			};
+			const auto fail = [=] {
+				peersRequestFailed(part);
+			};
+			const auto requestId = wrap(std::move(ids), finish, fail);
+			for (const auto peer : part) {
+				_peerRequests.insert(peer, requestId);
+			}
 		}
-		Unexpected("Peer type in requestPeer.");
-	}();
-	_peerRequests.insert(peer, requestId);
+	};
+	const auto chatHandler = [=](const MTPmessages_Chats &result) {
+		const auto &chats = result.match([](const auto &data) {
+			return data.vchats();
+		});
+		_session->data().applyMaximumChatVersions(chats);
+		_session->data().processChats(chats);
+	};
+	send(users, [](not_null<UserData*> user) {
+		return user->inputUser;
+	}, [&](
+			QVector<MTPInputUser> &&ids,
+			Fn<void()> finish,
+			Fn<void()> fail) {
+		return request(MTPusers_GetUsers(
+			MTP_vector<MTPInputUser>(std::move(ids))
+		)).done([=](const MTPVector<MTPUser> &result) {
+			finish();
+			_session->data().processUsers(result);
+		}).fail([=](const RPCError &error) {
+			fail();
+		}).send();
+	});
+	send(chats, [](not_null<ChatData*> chat) {
+		return chat->inputChat;
+	}, [&](
+			QVector<MTPint> &&ids,
+			Fn<void()> finish,
+			Fn<void()> fail) {
+		return request(MTPmessages_GetChats(
+			MTP_vector<MTPint>(std::move(ids))
+		)).done([=](const MTPmessages_Chats &result) {
+			finish();
+			chatHandler(result);
+		}).fail([=](const RPCError &error) {
+			fail();
+		}).send();
+	});
+	send(channels, [](not_null<ChannelData*> channel) {
+		return channel->inputChannel;
+	}, [&](
+			QVector<MTPInputChannel> &&ids,
+			Fn<void()> finish,
+			Fn<void()> fail) {
+		return request(MTPchannels_GetChannels(
+			MTP_vector<MTPInputChannel>(std::move(ids))
+		)).done([=](const MTPmessages_Chats &result) {
+			finish();
+			chatHandler(result);
+		}).fail([=](const RPCError &error) {
+			fail();
+		}).send();
+	});
+}
+
+void ApiWrap::peersRequestFailed(
+		const std::vector<not_null<PeerData*>> &peers) {
+	if (peers.size() == 1) {
+		_peerRequests.remove(peers.front());
+		return;
+	}
+
+	// One bad peer fails the whole batch, so request them one by one.
+	for (const auto peer : peers) {
+		_peerRequests.insert(peer, 0);
+		_peersToRequestSingly.push_back(peer);
+	}
+	_peersRequestDelayed.call();
 }
 
 void ApiWrap::requestPeerSettings(not_null<PeerData*> peer) {
@@ -1390,48 +1560,11 @@ void ApiWrap::markMediaRead(not_null<HistoryItem*> item) {
 }
 
 void ApiWrap::requestPeers(const QList<PeerData*> &peers) {
-	QVector<MTPint> chats;
-	QVector<MTPInputChannel> channels;
-	QVector<MTPInputUser> users;
-	chats.reserve(peers.size());
-	channels.reserve(peers.size());
-	users.reserve(peers.size());
 	for (const auto peer : peers) {
-		if (!peer
-			|| _fullPeerRequests.contains(peer)
-			|| _peerRequests.contains(peer)) {
-			continue;
-		}
-		if (const auto user = peer->asUser()) {
-			users.push_back(user->inputUser);
-		} else if (const auto chat = peer->asChat()) {
-			chats.push_back(chat->inputChat);
-		} else if (const auto channel = peer->asChannel()) {
-			channels.push_back(channel->inputChannel);
+		if (peer) {
+			requestPeer(peer);
 		}
 	}
-	const auto handleChats = [=](const MTPmessages_Chats &result) {
-		_session->data().processChats(result.match([](const auto &data) {
-			return data.vchats();
-		}));
-	};
-	if (!chats.isEmpty()) {
-		request(MTPmessages_GetChats(
-			MTP_vector<MTPint>(chats)
-		)).done(handleChats).send();
-	}
-	if (!channels.isEmpty()) {
-		request(MTPchannels_GetChannels(
-			MTP_vector<MTPInputChannel>(channels)
-		)).done(handleChats).send();
-	}
-	if (!users.isEmpty()) {
-		request(MTPusers_GetUsers(
-			MTP_vector<MTPInputUser>(users)
-		)).done([=](const MTPVector<MTPUser> &result) {
-			_session->data().processUsers(result);
-		}).send();
-	}
 }
 
 void ApiWrap::requestLastParticipants(not_null<ChannelData*> channel) {
@@ -2455,12 +2588,22 @@ void ApiWrap::saveCurrentDraftToCloud() {
 }
 
 void ApiWrap::saveDraftsToCloud() {
-	for (auto i = _draftsSaveRequestIds.begin(), e = _draftsSaveRequestIds.end(); i != e; ++i) {
-		if (i->second) continue; // sent already
+	for (auto i = _draftsSaveRequestIds.begin(); i != _draftsSaveRequestIds.end();) {
+		if (i->second) { // sent already
+			++i;
+			continue;
+		}
 
 		auto history = i->first;
 		auto cloudDraft = history->cloudDraft();
 		auto localDraft = history->localDraft();
+		if (!_session->supportMode()
+			&& (!cloudDraft || !cloudDraft->saveRequestId)
+			&& Data::draftsAreEqual(localDraft, cloudDraft)) {
+			// The draft was changed and restored before the timeout.
+			i = _draftsSaveRequestIds.erase(i);
+			continue;
+		}
 		if (cloudDraft && cloudDraft->saveRequestId) {
 			request(base::take(cloudDraft->saveRequestId)).cancel();
 		}
@@ -2524,15 +2667,16 @@ void ApiWrap::saveDraftsToCloud() {
 		}).send();
 
 		i->second = cloudDraft->saveRequestId;
+		++i;
 	}
 }
 
 bool ApiWrap::isQuitPrevent() {
+	saveDraftsToCloud();
 	if (_draftsSaveRequestIds.empty()) {
 		return false;
 	}
 	LOG(("ApiWrap prevents quit, saving drafts..."));
-	saveDraftsToCloud();
 	return true;
 }
 
@@ -3282,6 +3426,17 @@ void ApiWrap::requestMessageAfterDate(
 	auto maxId = 0;
 	auto minId = 0;
 	auto historyHash = 0;
+	if (const auto history = _session->data().historyLoaded(peer)) {
+		if (const auto id = LoadedMessageAfterDate(history, offsetDate)) {
+			crl::on_main(_session, [
+				id,
+				callback = std::forward<Callback>(callback)
+			]() mutable {
+				callback(id);
+			});
+			return;
+		}
+	}
 	request(MTPmessages_GetHistory(
 		peer->input,
 		MTP_int(offsetId),
@@ -4012,7 +4167,9 @@ void ApiWrap::forwardMessages(
 				&& items.front()->media()->canBeGrouped());
 	};
 
-	const auto forwardQuoted = [&] {
+	const auto forwardQuotedChunk = [&](
+			QVector<MTPint> chunkIds,
+			QVector<MTPlong> chunkRandomIds) {
 		if (shared) {
 			++shared->requestsLeft;
 		}
@@ -4022,8 +4179,8 @@ void ApiWrap::forwardMessages(
 			history->sendRequestId = request(MTPmessages_ForwardMessages(
 				MTP_flags(sendFlags),
 				forwardFrom->input,
-				MTP_vector<MTPint>(ids),
-				MTP_vector<MTPlong>(randomIds),
+				MTP_vector<MTPint>(chunkIds),
+				MTP_vector<MTPlong>(chunkRandomIds),
 				peer->input,
 				MTP_int(action.options.scheduled)
 			)).done([=](const MTPUpdates &result) {
@@ -4033,11 +4190,17 @@ void ApiWrap::forwardMessages(
 				}
 				finish();
 			}).fail([=](const RPCError &error) {
+				auto found = false;
 				if (idsCopy) {
-					for (const auto &[randomId, itemId] : *idsCopy) {
-						sendMessageFail(error, peer, randomId, itemId);
+					for (const auto &randomId : chunkRandomIds) {
+						const auto i = idsCopy->find(randomId.v);
+						if (i != end(*idsCopy)) {
+							sendMessageFail(error, peer, i->first, i->second);
+							found = true;
+						}
 					}
-				} else {
+				}
+				if (!found) {
 					sendMessageFail(error, peer);
 				}
 				finish();
@@ -4048,51 +4211,34 @@ void ApiWrap::forwardMessages(
 		});
 	};
 
-	const auto forwardQuotedSingle = [&] (not_null<HistoryItem *> item) {
-		if (shared) {
-			++shared->requestsLeft;
-		}
-
-		auto currentIds = QVector<MTPint>();
-		currentIds.push_back(MTP_int(item->id));
-
-		auto currentRandomId = randomIds.takeFirst();
-		auto currentRandomIds = QVector<MTPlong>();
-		currentRandomIds.push_back(currentRandomId);
-
-		const auto requestType = Data::Histories::RequestType::Send;
-		histories.sendRequest(history, requestType, [=](Fn<void()> finish) {
-			history->sendRequestId = request(MTPmessages_ForwardMessages(
-				MTP_flags(sendFlags),
-				forwardFrom->input,
-				MTP_vector<MTPint>(currentIds),
-				MTP_vector<MTPlong>(currentRandomIds),
-				peer->input,
-				MTP_int(action.options.scheduled)
-			)).done([=](const MTPUpdates &result) {
-				applyUpdates(result);
-				if (shared && !--shared->requestsLeft) {
-					shared->callback();
-				}
-				finish();
-			}).fail([=, ids = localIds](const RPCError &error) {
-				auto found = false;
-				for (const auto &[randomId, itemId] : *ids) {
-					if (currentRandomId == MTP_long(randomId)) {
-						sendMessageFail(error, peer, randomId, itemId);
-						found = true;
-						break;
+	// Forwards the accumulated messages [from, till) in as few requests as
+	// possible. The requests are sent at once, invokeAfter keeps the order.
+	const auto forwardQuotedRange = [&](int from, int till) {
+		while (from < till) {
+			auto chunkTill = std::min(from + kForwardMessagesPerRequest, till);
+			if (chunkTill < till) {
+				// Don't split an album between two requests.
+				const auto groupId = (*(fromIter + chunkTill))->groupId();
+				if (groupId != MessageGroupId()) {
+					auto groupStart = chunkTill;
+					while (groupStart > from
+						&& (*(fromIter + groupStart - 1))->groupId() == groupId) {
+						--groupStart;
+					}
+					if (groupStart > from) {
+						chunkTill = groupStart;
 					}
 				}
-				if (!found) {
-					sendMessageFail(error, peer);
-				}
-				finish();
-			}).afterRequest(
-				history->sendRequestId
-			).send();
-			return history->sendRequestId;
-		});
+			}
+			forwardQuotedChunk(
+				ids.mid(from, chunkTill - from),
+				randomIds.mid(from, chunkTill - from));
+			from = chunkTill;
+		}
+	};
+
+	const auto forwardQuoted = [&] {
+		forwardQuotedRange(0, int(ids.size()));
 	};
 
 	const auto forwardAlbumUnquoted = [&] {
@@ -4257,7 +4403,8 @@ void ApiWrap::forwardMessages(
 				contact->phoneNumber,
 				contact->firstName,
 				contact->lastName,
-				message.action);
+				message.action,
+				std::move(doneCallback));
 		} else if (media->photo()) {
 			Api::SendExistingPhoto(
 				std::move(message),
@@ -4310,7 +4457,17 @@ void ApiWrap::forwardMessages(
 		} else if (isGrouped()) {
 			forwardAlbumUnquoted();
 		} else {
-			for (auto i = fromIter, e = toIter; i != e; i++) {
+			// Consecutive messages that can't be sent unquoted
+			// are forwarded together in one request.
+			auto quotedFrom = -1;
+			const auto flushQuoted = [&](int till) {
+				if (quotedFrom >= 0) {
+					forwardQuotedRange(quotedFrom, till);
+					quotedFrom = -1;
+				}
+			};
+			auto index = 0;
+			for (auto i = fromIter, e = toIter; i != e; i++, index++) {
 				const auto item = *i;
 				const auto media = item->media();
 
@@ -4320,14 +4477,17 @@ void ApiWrap::forwardMessages(
 						|| media->sharedContact()
 						|| media->photo()
 						|| media->document()) {
+						flushQuoted(index);
 						forwardMediaUnquoted(item);
-					} else {
-						forwardQuotedSingle(item);
+					} else if (quotedFrom < 0) {
+						quotedFrom = index;
 					}
 				} else {
+					flushQuoted(index);
 					forwardMessageUnquoted(item);
 				}
 			}
+			flushQuoted(index);
 		}
 
 		ids.resize(0);
@@ -4388,9 +4548,18 @@ void ApiWrap::shareContact(
 		const QString &phone,
 		const QString &firstName,
 		const QString &lastName,
-		const SendAction &action) {
+		const SendAction &action,
+		Fn<void()> done,
+		Fn<void()> fail) {
 	const auto userId = UserId(0);
-	sendSharedContact(phone, firstName, lastName, userId, action);
+	sendSharedContact(
+		phone,
+		firstName,
+		lastName,
+		userId,
+		action,
+		std::move(done),
+		std::move(fail));
 }
 
 void ApiWrap::shareContact(
@@ -4414,7 +4583,9 @@ void ApiWrap::sendSharedContact(
 		const QString &firstName,
 		const QString &lastName,
 		UserId userId,
-		const SendAction &action) {
+		const SendAction &action,
+		Fn<void()> done,
+		Fn<void()> fail) {
 	sendAction(action);
 
 	const auto history = action.history;
@@ -4479,7 +4650,12 @@ void ApiWrap::sendSharedContact(
 		MTP_string(firstName),
 		MTP_string(lastName),
 		MTP_string(vcard));
-	sendMedia(item, media, action.options);
+	sendMedia(
+		item,
+		media,
+		action.options,
+		std::move(done),
+		std::move(fail));
 
 	_session->data().sendHistoryChangeNotifications();
 	_session->changes().historyUpdated(
@@ -4636,7 +4812,8 @@ void ApiWrap::cancelLocalItem(not_null<HistoryItem*> item) {
 void ApiWrap::sendMessage(
 	MessageToSend &&message,
 	Fn<void(const MTPUpdates &, mtpRequestId)> doneCallback,
-	bool forwarding) {
+	bool forwarding,
+	Fn<void(const RPCError &)> failCallback) {
 	const auto history = message.action.history;
 	const auto peer = history->peer;
 	auto &textWithTags = message.textWithTags;
@@ -4778,6 +4955,9 @@ void ApiWrap::sendMessage(
 					sendMessageFail(error, peer, randomId, newId);
 				}
 				history->clearSentDraftText(QString());
+				if (failCallback) {
+					failCallback(error);
+				}
 				finish();
 			}).afterRequest(history->sendRequestId
 			).send();
@@ -4984,18 +5164,28 @@ void ApiWrap::uploadAlbumMedia(
 void ApiWrap::sendMedia(
 		not_null<HistoryItem*> item,
 		const MTPInputMedia &media,
-		Api::SendOptions options) {
+		Api::SendOptions options,
+		Fn<void()> done,
+		Fn<void()> fail) {
 	const auto randomId = rand_value<uint64>();
 	_session->data().registerMessageRandomId(randomId, item->fullId());
 
-	sendMediaWithRandomId(item, media, options, randomId);
+	sendMediaWithRandomId(
+		item,
+		media,
+		options,
+		randomId,
+		std::move(done),
+		std::move(fail));
 }
 
 void ApiWrap::sendMediaWithRandomId(
 		not_null<HistoryItem*> item,
 		const MTPInputMedia &media,
 		Api::SendOptions options,
-		uint64 randomId) {
+		uint64 randomId,
+		Fn<void()> done,
+		Fn<void()> fail) {
 	const auto history = item->history();
 	const auto replyTo = item->replyToId();
 
@@ -5037,9 +5227,15 @@ void ApiWrap::sendMediaWithRandomId(
 			MTP_int(options.scheduled)
 		)).done([=](const MTPUpdates &result) {
 			applyUpdates(result);
+			if (done) {
+				done();
+			}
 			finish();
 		}).fail([=](const RPCError &error) {
 			sendMessageFail(error, peer, randomId, itemId);
+			if (fail) {
+				fail();
+			}
 			finish();
 		}).afterRequest(
 			history->sendRequestId
@@ -382,7 +382,9 @@ public:
 		const QString &phone,
 		const QString &firstName,
 		const QString &lastName,
-		const SendAction &action);
+		const SendAction &action,
+		Fn<void()> done = nullptr,
+		Fn<void()> fail = nullptr);
 	void shareContact(not_null<UserData*> user, const SendAction &action);
 	//void readFeed( // #feed
 	//	not_null<Data::Feed*> feed,
@@ -429,7 +431,8 @@ public:
 	void sendMessage(
 		MessageToSend &&message,
 		Fn<void(const MTPUpdates &, mtpRequestId)> doneCallback = nullptr,
-		bool forwarding = false);
+		bool forwarding = false,
+		Fn<void(const RPCError &)> failCallback = nullptr);
 	void sendBotStart(not_null<UserData*> bot, PeerData *chat = nullptr);
 	void sendInlineResult(
 		not_null<UserData*> bot,
@@ -526,6 +529,10 @@ private:
 		mtpRequestId requestId);
 
 	QVector<MTPInputMessage> collectMessageIds(const MessageDataRequests &requests);
+	void markMessageDataRequests(
+		MessageDataRequests &requests,
+		const QVector<MTPInputMessage> &ids,
+		mtpRequestId requestId);
 	MessageDataRequests *messageDataRequests(ChannelData *channel, bool onlyExisting = false);
 
 	void gotChatFull(
@@ -603,7 +610,9 @@ private:
 		const QString &firstName,
 		const QString &lastName,
 		UserId userId,
-		const SendAction &action);
+		const SendAction &action,
+		Fn<void()> done = nullptr,
+		Fn<void()> fail = nullptr);
 
 	void deleteHistory(
 		not_null<PeerData*> peer,
@@ -630,12 +639,16 @@ private:
 	void sendMedia(
 		not_null<HistoryItem*> item,
 		const MTPInputMedia &media,
-		Api::SendOptions options);
+		Api::SendOptions options,
+		Fn<void()> done = nullptr,
+		Fn<void()> fail = nullptr);
 	void sendMediaWithRandomId(
 		not_null<HistoryItem*> item,
 		const MTPInputMedia &media,
 		Api::SendOptions options,
-		uint64 randomId);
+		uint64 randomId,
+		Fn<void()> done = nullptr,
+		Fn<void()> fail = nullptr);
 	FileLoadTo fileLoadTaskOptions(const SendAction &action) const;
 
 	//void readFeeds(); // #feed
@@ -644,6 +657,11 @@ private:
 	void topPromotionDone(const MTPhelp_PromoData &proxy);
 
 	void sendNotifySettingsUpdates();
+	void sendPeersRequests();
+	void sendPeersRequests(
+		const std::vector<not_null<PeerData*>> &peers,
+		int perRequest);
+	void peersRequestFailed(const std::vector<not_null<PeerData*>> &peers);
 
 	template <typename Request>
 	void requestFileReference(
@@ -675,6 +693,9 @@ private:
 	using PeerRequests = QMap<PeerData*, mtpRequestId>;
 	PeerRequests _fullPeerRequests;
 	PeerRequests _peerRequests;
+	std::vector<not_null<PeerData*>> _peersToRequest;
+	std::vector<not_null<PeerData*>> _peersToRequestSingly;
+	SingleQueuedInvokation _peersRequestDelayed;
 	base::flat_set<not_null<PeerData*>> _requestedPeerSettings;
 
 	PeerRequests _participantsRequests;
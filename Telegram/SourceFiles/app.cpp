@@ -206,7 +206,7 @@ namespace App {
 		App::quit();
 	}
 
-	QImage readImage(QByteArray data, QByteArray *format, bool opaque, bool *animated) {
+	QImage readImage(QByteArray data, QByteArray *format, bool opaque, bool *animated, int maxSide) {
 		if (data.isEmpty()) {
 			return QImage();
 		}
@@ -228,6 +228,17 @@ namespace App {
 			const auto imageSize = reader.size();
 			if (imageSize.width() * imageSize.height() > kImageAreaLimit) {
 				return QImage();
+			} else if (maxSide > 0
+				&& (imageSize.width() > maxSide
+					|| imageSize.height() > maxSide)) {
+				// JPEG decoder uses DCT scaling for that.
+				const auto scaled = imageSize.scaled(
+					maxSide,
+					maxSide,
+					Qt::KeepAspectRatio);
+				if (!scaled.isEmpty()) {
+					reader.setScaledSize(scaled);
+				}
 			}
 			QByteArray fmt = reader.format();
 			if (!fmt.isEmpty()) *format = fmt;
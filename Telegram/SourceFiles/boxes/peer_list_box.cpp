@@ -1662,12 +1662,12 @@ void PeerListContent::searchQueryChanged(QString query) {
 				auto searchWordInNames = [](
 						not_null<PeerData*> peer,
 						const QString &searchWord) {
-					for (auto &nameWord : peer->nameWords()) {
-						if (nameWord.startsWith(searchWord)) {
-							return true;
-						}
-					}
-					return false;
+					// Name words are sorted, so only the first word not
+					// less than the search word may start with it.
+					const auto &nameWords = peer->nameWords();
+					const auto i = nameWords.lower_bound(searchWord);
+					return (i != nameWords.end())
+						&& i->startsWith(searchWord);
 				};
 				auto allSearchWordsInNames = [&](
 						not_null<PeerData*> peer) {
@@ -60,6 +60,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 namespace {
 
+constexpr auto kPrepareParallel = 4;
+
 using Ui::SendFilesWay;
 
 inline bool CanAddUrls(const QList<QUrl> &urls) {
@@ -275,30 +277,39 @@ void SendFilesBox::initPreview() {
 }
 
 void SendFilesBox::enqueueNextPrepare() {
-	if (_preparing) {
-		return;
-	}
-	while (!_list.filesToProcess.empty()
-		&& _list.filesToProcess.front().information) {
+	while (_preparing < kPrepareParallel
+		&& !_list.filesToProcess.empty()) {
 		auto file = std::move(_list.filesToProcess.front());
 		_list.filesToProcess.pop_front();
-		addFile(std::move(file));
-	}
-	if (_list.filesToProcess.empty()) {
-		return;
-	}
-	auto file = std::move(_list.filesToProcess.front());
-	_list.filesToProcess.pop_front();
-	const auto weak = Ui::MakeWeak(this);
-	_preparing = true;
-	crl::async([weak, file = std::move(file)]() mutable {
-		Storage::PrepareDetails(file, st::sendMediaPreviewSize);
-		crl::on_main([weak, file = std::move(file)]() mutable {
-			if (weak) {
-				weak->addPreparedAsyncFile(std::move(file));
+		const auto index = _prepareQueuedIndex++;
+		if (file.information) {
+			_preparedAhead.emplace(index, std::move(file));
+			continue;
+		}
+		const auto weak = Ui::MakeWeak(this);
+		const auto cancelled = _prepareCancelled;
+		++_preparing;
+		crl::async([=, file = std::move(file)]() mutable {
+			if (*cancelled) {
+				return;
 			}
+			Storage::PrepareDetails(file, st::sendMediaPreviewSize);
+			crl::on_main([=, file = std::move(file)]() mutable {
+				if (weak) {
+					weak->addPreparedAsyncFile(index, std::move(file));
+				}
+			});
 		});
-	});
+	}
+
+	// Files are prepared in parallel, but added in the original order.
+	while (!_preparedAhead.empty()
+		&& _preparedAhead.begin()->first == _prepareAddedIndex) {
+		auto file = std::move(_preparedAhead.begin()->second);
+		_preparedAhead.erase(_preparedAhead.begin());
+		++_prepareAddedIndex;
+		addFile(std::move(file));
+	}
 }
 
 void SendFilesBox::setupShadows() {
@@ -803,12 +814,15 @@ bool SendFilesBox::addFiles(Ui::PreparedList list) {
 	return true;
 }
 
-void SendFilesBox::addPreparedAsyncFile(Ui::PreparedFile &&file) {
+void SendFilesBox::addPreparedAsyncFile(
+		int index,
+		Ui::PreparedFile &&file) {
 	Expects(file.information != nullptr);
+	Expects(_preparing > 0);
 
-	_preparing = false;
+	--_preparing;
 	const auto count = int(_list.files.size());
-	addFile(std::move(file));
+	_preparedAhead.emplace(index, std::move(file));
 	enqueueNextPrepare();
 	if (_list.files.size() > count) {
 		refreshAllAfterChanges(count);
@@ -1007,4 +1021,6 @@ void SendFilesBox::sendScheduled() {
 		Ui::LayerOption::KeepOther);
 }
 
-SendFilesBox::~SendFilesBox() = default;
+SendFilesBox::~SendFilesBox() {
+	*_prepareCancelled = true;
+}
@@ -153,7 +153,7 @@ private:
 	void refreshAllAfterChanges(int fromItem);
 
 	void enqueueNextPrepare();
-	void addPreparedAsyncFile(Ui::PreparedFile &&file);
+	void addPreparedAsyncFile(int index, Ui::PreparedFile &&file);
 
 	const not_null<Window::SessionController*> _controller;
 	const Api::SendType _sendType = Api::SendType();
@@ -192,7 +192,12 @@ private:
 	QPointer<Ui::VerticalLayout> _inner;
 	std::vector<Block> _blocks;
 	Fn<void()> _whenReadySend;
-	bool _preparing = false;
+	base::flat_map<int, Ui::PreparedFile> _preparedAhead;
+	std::shared_ptr<std::atomic<bool>> _prepareCancelled
+		= std::make_shared<std::atomic<bool>>(false);
+	int _prepareQueuedIndex = 0;
+	int _prepareAddedIndex = 0;
+	int _preparing = 0;
 
 	QPointer<Ui::RoundButton> _send;
 	QPointer<Ui::RoundButton> _addFile;
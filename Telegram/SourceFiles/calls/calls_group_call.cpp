@@ -31,6 +31,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonArray>
+#include <QtCore/QMutex>
 
 namespace tgcalls {
 class GroupInstanceImpl;
@@ -45,6 +46,14 @@ constexpr auto kCheckJoinedTimeout = 4 * crl::time(1000);
 constexpr auto kUpdateSendActionEach = crl::time(500);
 constexpr auto kPlayConnectingEach = crl::time(1056) + 2 * crl::time(1000);
 
+// Levels arrive on the tgcalls thread much more often than we repaint,
+// so they are merged there and handed to the main thread in batches.
+struct PendingLevels {
+	QMutex mutex;
+	base::flat_map<uint32, tgcalls::GroupLevelValue> values;
+	bool scheduled = false;
+};
+
 [[nodiscard]] std::unique_ptr<Webrtc::MediaDevices> CreateMediaDevices() {
 	const auto &settings = Core::App().settings();
 	return Webrtc::CreateMediaDevices(
@@ -558,6 +567,7 @@ void GroupCall::createAndStartController() {
 
 	const auto weak = base::make_weak(this);
 	const auto myLevel = std::make_shared<tgcalls::GroupLevelValue>();
+	const auto pending = std::make_shared<PendingLevels>();
 	tgcalls::GroupInstanceDescriptor descriptor = {
 		.config = tgcalls::GroupConfig{
 		},
@@ -568,16 +578,50 @@ void GroupCall::createAndStartController() {
 			const auto &updates = data.updates;
 			if (updates.empty()) {
 				return;
-			} else if (updates.size() == 1 && !updates.front().ssrc) {
-				const auto &value = updates.front().value;
-				// Don't send many 0 while we're muted.
-				if (myLevel->level == value.level
-					&& myLevel->voice == value.voice) {
-					return;
+			}
+			auto schedule = false;
+			{
+				QMutexLocker lock(&pending->mutex);
+				for (const auto &[ssrc, value] : updates) {
+					auto &merged = pending->values[ssrc];
+					if (!ssrc) {
+						// Our own level is compared with the delivered one.
+						merged = value;
+						continue;
+					}
+					// Keep the loudest value, so that no speech is lost.
+					merged.level = std::max(merged.level, value.level);
+					merged.voice = merged.voice || value.voice;
 				}
-				*myLevel = updates.front().value;
+				schedule = !pending->scheduled;
+				pending->scheduled = true;
+			}
+			if (!schedule) {
+				return;
 			}
-			crl::on_main(weak, [=] { audioLevelsUpdated(data); });
+			crl::on_main(weak, [=] {
+				auto data = tgcalls::GroupLevelsUpdate();
+				{
+					QMutexLocker lock(&pending->mutex);
+					pending->scheduled = false;
+					const auto values = base::take(pending->values);
+					data.updates.reserve(values.size());
+					for (const auto &[ssrc, value] : values) {
+						if (!ssrc) {
+							// Don't send many 0 while we're muted.
+							if (myLevel->level == value.level
+								&& myLevel->voice == value.voice) {
+								continue;
+							}
+							*myLevel = value;
+						}
+						data.updates.push_back({ ssrc, value });
+					}
+				}
+				if (!data.updates.empty()) {
+					audioLevelsUpdated(data);
+				}
+			});
 		},
 		.initialInputDeviceId = _audioInputId.toStdString(),
 		.initialOutputDeviceId = _audioOutputId.toStdString(),
@@ -254,6 +254,7 @@ private:
 	void removeRow(not_null<Row*> row);
 	void updateRowLevel(not_null<Row*> row, float level);
 	void checkSpeakingRowPosition(not_null<Row*> row);
+	void checkSpeakingRowsPositions();
 	Row *findRow(not_null<UserData*> user) const;
 
 	[[nodiscard]] Data::GroupCall *resolvedRealCall() const;
@@ -274,6 +275,7 @@ private:
 	not_null<QWidget*> _menuParent;
 	base::unique_qptr<Ui::PopupMenu> _menu;
 	base::flat_set<not_null<PeerData*>> _menuCheckRowsAfterHidden;
+	std::vector<not_null<PeerData*>> _speakingRowsToCheck;
 
 	base::flat_map<uint32, not_null<Row*>> _soundingRowBySsrc;
 	Ui::Animations::Basic _soundingAnimation;
@@ -762,27 +764,59 @@ void MembersController::checkSpeakingRowPosition(not_null<Row*> row) {
 		_menuCheckRowsAfterHidden.emplace(row->peer());
 		return;
 	}
-	// Check if there are non-speaking rows above this one.
+	// Many participants may start speaking in one batch of updates,
+	// reorder the list once for all of them.
+	if (_speakingRowsToCheck.empty()) {
+		crl::on_main(this, [=] {
+			checkSpeakingRowsPositions();
+		});
+	}
+	_speakingRowsToCheck.push_back(row->peer());
+}
+
+void MembersController::checkSpeakingRowsPositions() {
+	auto list = base::take(_speakingRowsToCheck);
+	if (_menu) {
+		for (const auto peer : list) {
+			_menuCheckRowsAfterHidden.emplace(peer);
+		}
+		return;
+	}
+
+	// Skip the ones that have only speaking rows above them.
+	auto top = base::flat_set<not_null<const PeerListRow*>>();
 	const auto count = delegate()->peerListFullRowsCount();
 	for (auto i = 0; i != count; ++i) {
 		const auto above = delegate()->peerListRowAt(i);
-		if (above == row) {
-			// All rows above are speaking.
-			return;
-		} else if (!static_cast<Row*>(above.get())->speaking()) {
+		if (!static_cast<Row*>(above.get())->speaking()) {
 			break;
 		}
+		top.emplace(above);
+	}
+
+	// The last one who started speaking goes to the very top.
+	auto order = base::flat_map<not_null<const PeerListRow*>, int>();
+	for (auto i = list.rbegin(); i != list.rend(); ++i) {
+		const auto row = findRow((*i)->asUser());
+		if (row && row->speaking() && !top.contains(row)) {
+			order.emplace(row, int(order.size()));
+		}
+	}
+	if (order.empty()) {
+		return;
 	}
 	// Someone started speaking and has a non-speaking row above him. Sort.
+	const auto speaking = int(order.size());
 	const auto proj = [&](const PeerListRow &other) {
-		if (&other == row.get()) {
-			// Bring this new one to the top.
-			return 0;
+		const auto i = order.find(&other);
+		if (i != end(order)) {
+			// Bring the new ones to the top.
+			return i->second;
 		} else if (static_cast<const Row&>(other).speaking()) {
-			// Bring all the speaking ones below him.
-			return 1;
+			// Bring all the speaking ones below them.
+			return speaking;
 		} else {
-			return 2;
+			return speaking + 1;
 		}
 	};
 	delegate()->peerListSortRows([&](
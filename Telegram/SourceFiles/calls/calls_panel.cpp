@@ -98,11 +98,16 @@ Panel::Incoming::Incoming(
 void Panel::Incoming::paintEvent(QPaintEvent *e) {
 	QPainter p(this);
 
-	const auto frame = _track->frame(Webrtc::FrameRequest());
+	// Let the track convert the frame right to the widget size, so that
+	// we don't scale a full resolution image here on each frame.
+	const auto size = this->size() * cIntRetinaFactor();
+	const auto frame = _track->frame(Webrtc::FrameRequest{
+		.resize = size,
+		.outer = size,
+	});
 	if (frame.isNull()) {
 		p.fillRect(e->rect(), Qt::black);
 	} else {
-		auto hq = PainterHighQualityEnabler(p);
 		p.drawImage(rect(), frame);
 		fillBottomShadow(p);
 		fillTopShadow(p);
@@ -127,12 +127,14 @@ void VideoBubble::paint() {
 		const auto inner = _content.rect().marginsRemoved(padding);
 		Ui::Shadow::paint(p, inner, _content.width(), st::boxRoundShadow);
 		const auto factor = cIntRetinaFactor();
+
+		// Mirror while painting instead of copying the frame each time.
+		p.translate(inner.x() + inner.width(), inner.y());
+		p.scale(-1., 1.);
 		p.drawImage(
-			inner,
+			QRect(QPoint(), inner.size()),
 			_frame,
-			QRect(
-				QPoint(_frame.width() - (inner.width() * factor), 0),
-				inner.size() * factor));
+			QRect(QPoint(), inner.size() * factor));
 	}
 	_track->markFrameShown();
 }
@@ -154,9 +156,7 @@ void VideoBubble::prepareFrame() {
 	};
 	const auto frame = _track->frame(request);
 	if (_frame.width() < size.width() || _frame.height() < size.height()) {
-		_frame = QImage(
-			size * cIntRetinaFactor(),
-			QImage::Format_ARGB32_Premultiplied);
+		_frame = QImage(size, QImage::Format_ARGB32_Premultiplied);
 	}
 	Assert(_frame.width() >= frame.width()
 		&& _frame.height() >= frame.height());
@@ -174,7 +174,6 @@ void VideoBubble::prepareFrame() {
 		ImageRoundRadius::Large,
 		RectPart::AllCorners,
 		QRect(QPoint(), size));
-	_frame = std::move(_frame).mirrored(true, false);
 }
 
 void VideoBubble::setState(Webrtc::VideoState state) {
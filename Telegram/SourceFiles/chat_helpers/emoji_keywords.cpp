@@ -13,6 +13,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/application.h"
 #include "base/platform/base_platform_info.h"
 #include "ui/emoji_config.h"
+#include "base/flat_set.h"
 #include "main/main_domain.h"
 #include "main/main_session.h"
 #include "apiwrap.h"
@@ -172,26 +173,14 @@ void WriteLocalCache(const QString &id, const LangPackData &data) {
 
 void AppendFoundEmoji(
 		std::vector<Result> &result,
+		base::flat_set<EmojiPtr> &added,
 		const QString &label,
 		const std::vector<LangPackEmoji> &list) {
-	// It is important that the 'result' won't relocate while inserting.
-	result.reserve(result.size() + list.size());
-	const auto alreadyBegin = begin(result);
-	const auto alreadyEnd = alreadyBegin + result.size();
-
-	auto &&add = ranges::view::all(
-		list
-	) | ranges::view::filter([&](const LangPackEmoji &entry) {
-		const auto i = ranges::find(
-			alreadyBegin,
-			alreadyEnd,
-			entry.emoji,
-			&Result::emoji);
-		return (i == alreadyEnd);
-	}) | ranges::view::transform([&](const LangPackEmoji &entry) {
-		return Result{ entry.emoji, label, entry.text };
-	});
-	result.insert(end(result), add.begin(), add.end());
+	for (const auto &entry : list) {
+		if (added.emplace(entry.emoji).second) {
+			result.push_back({ entry.emoji, label, entry.text });
+		}
+	}
 }
 
 void AppendLegacySuggestions(
@@ -485,8 +474,9 @@ std::vector<Result> EmojiKeywords::LangPack::query(
 	});
 
 	auto result = std::vector<Result>();
+	auto added = base::flat_set<EmojiPtr>();
 	for (const auto &[key, list] : chosen) {
-		AppendFoundEmoji(result, key, list);
+		AppendFoundEmoji(result, added, key, list);
 	}
 	return result;
 }
@@ -610,27 +600,26 @@ std::vector<Result> EmojiKeywords::query(
 		return {};
 	}
 	auto result = std::vector<Result>();
+	auto added = base::flat_set<EmojiPtr>();
 	for (const auto &[language, item] : _data) {
 		const auto list = item->query(normalized, exact);
+		if (result.empty()) {
+			result = list;
+			added.reserve(list.size());
+			for (const auto &entry : list) {
+				added.emplace(entry.emoji);
+			}
+			continue;
+		}
 
-		// It is important that the 'result' won't relocate while inserting.
+		// In each item->query() result the list has no duplicates.
+		// So we need to check only for duplicates between queries.
 		result.reserve(result.size() + list.size());
-		const auto alreadyBegin = begin(result);
-		const auto alreadyEnd = alreadyBegin + result.size();
-
-		auto &&add = ranges::view::all(
-			list
-		) | ranges::view::filter([&](Result entry) {
-			// In each item->query() result the list has no duplicates.
-			// So we need to check only for duplicates between queries.
-			const auto i = ranges::find(
-				alreadyBegin,
-				alreadyEnd,
-				entry.emoji,
-				&Result::emoji);
-			return (i == alreadyEnd);
-		});
-		result.insert(end(result), add.begin(), add.end());
+		for (const auto &entry : list) {
+			if (added.emplace(entry.emoji).second) {
+				result.push_back(entry);
+			}
+		}
 	}
 	if (!exact) {
 		AppendLegacySuggestions(result, query);
@@ -293,7 +293,7 @@ bool FieldAutocomplete::clearFilteredBotCommands() {
 namespace {
 template <typename T, typename U>
 inline int indexOfInFirstN(const T &v, const U &elem, int last) {
-	for (auto b = v.cbegin(), i = b, e = b + std::max(int(v.size()), last); i != e; ++i) {
+	for (auto b = v.cbegin(), i = b, e = b + std::min(int(v.size()), last); i != e; ++i) {
 		if (i->user == elem) {
 			return (i - b);
 		}
@@ -358,12 +358,15 @@ void FieldAutocomplete::updateFiltered(bool resetScroll) {
 			}
 			return true;
 		};
+		// Name words are lowercase and sorted, so the first word not less
+		// than the filter is the only candidate to start with it.
+		const auto filterLower = _filter.toLower();
 		auto filterNotPassedByName = [&](UserData *user) -> bool {
-			for (const auto &nameWord : user->nameWords()) {
-				if (nameWord.startsWith(_filter, Qt::CaseInsensitive)) {
-					auto exactUsername = (user->username.compare(_filter, Qt::CaseInsensitive) == 0);
-					return exactUsername;
-				}
+			const auto &nameWords = user->nameWords();
+			const auto i = nameWords.lower_bound(filterLower);
+			if (i != nameWords.end() && i->startsWith(filterLower)) {
+				auto exactUsername = (user->username.compare(_filter, Qt::CaseInsensitive) == 0);
+				return exactUsername;
 			}
 			return filterNotPassedByUsername(user);
 		};
@@ -532,9 +532,14 @@ void MessageLinksParser::parse() {
 	const auto &tags = textWithTags.tags;
 	const auto &markdownTags = _field->getMarkdownTags();
 	if (text.isEmpty()) {
+		_lastParsed = TextWithTags();
 		_list = QStringList();
 		return;
+	} else if (textWithTags == _lastParsed) {
+		// Timer fired on a key press or drop without any text change.
+		return;
 	}
+	_lastParsed = textWithTags;
 	const auto tagCanIntersectWithLink = [](const QString &tag) {
 		return (tag == Ui::InputField::kTagBold)
 			|| (tag == Ui::InputField::kTagItalic)
@@ -96,6 +96,7 @@ private:
 
 	not_null<Ui::InputField*> _field;
 	rpl::variable<QStringList> _list;
+	TextWithTags _lastParsed;
 	int _lastLength = 0;
 	base::Timer _timer;
 	base::qt_connection _connection;
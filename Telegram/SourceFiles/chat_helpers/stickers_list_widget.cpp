@@ -16,6 +16,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_changes.h"
 #include "chat_helpers/send_context_menu.h" // SendMenu::FillSendMenu
 #include "chat_helpers/stickers_lottie.h"
+#include "base/call_delayed.h"
 #include "ui/widgets/buttons.h"
 #include "ui/widgets/popup_menu.h"
 #include "ui/effects/animations.h"
@@ -39,6 +40,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "main/main_session_settings.h"
 #include "apiwrap.h"
 #include "api/api_toggling_media.h" // Api::ToggleFavedSticker
+#include "core/paint_stats.h"
 #include "styles/style_chat_helpers.h"
 #include "styles/style_window.h"
 
@@ -51,6 +53,7 @@ constexpr auto kInlineItemsMaxPerRow = 5;
 constexpr auto kSearchRequestDelay = 400;
 constexpr auto kPreloadOfficialPages = 4;
 constexpr auto kOfficialLoadLimit = 40;
+constexpr auto kClearHeavyTimeout = 3 * crl::time(1000);
 
 using Data::StickersSet;
 using Data::StickersPack;
@@ -880,6 +883,7 @@ StickersListWidget::StickersListWidget(
 , _addWidth(st::stickersTrendingAdd.font->width(_addText))
 , _settings(this, tr::lng_stickers_you_have(tr::now))
 , _previewTimer([=] { showPreview(); })
+, _clearHeavyTimer([=] { checkVisibleLottie(); })
 , _searchRequestTimer([=] { sendSearchRequest(); }) {
 	setMouseTracking(true);
 	setAttribute(Qt::WA_OpaquePaintEvent);
@@ -1496,6 +1500,7 @@ QRect StickersListWidget::stickerRect(int section, int sel) {
 }
 
 void StickersListWidget::paintEvent(QPaintEvent *e) {
+	const auto stats = Core::PaintStats::Span("StickersListWidget");
 	Painter p(this);
 	auto clip = e->rect();
 	p.fillRect(clip, st::emojiPanBg);
@@ -1657,14 +1662,26 @@ void StickersListWidget::markLottieFrameShown(Set &set) {
 	if (const auto player = set.lottiePlayer.get()) {
 		const auto paused = controller()->isGifPausedAtLeastFor(
 			Window::GifPauseReason::SavedGifs);
-		if (!paused) {
+		if (paused) {
+			return;
+		}
+		const auto delay = ChatHelpers::LottieFrameShowDelay(
+			player,
+			boundingBoxSize() * cIntRetinaFactor());
+		if (!delay) {
 			player->markFrameShown();
+		} else if (!_lottieRepaintScheduled) {
+			_lottieRepaintScheduled = true;
+			base::call_delayed(delay, this, [=] {
+				_lottieRepaintScheduled = false;
+				update();
+			});
 		}
 	}
 }
 
 void StickersListWidget::checkVisibleLottie() {
-	if (shownSets().empty()) {
+	if (_section == Section::Featured || shownSets().empty()) {
 		return;
 	}
 	const auto visibleTop = getVisibleTop();
@@ -1672,20 +1689,54 @@ void StickersListWidget::checkVisibleLottie() {
 	const auto destroyAfterDistance = (visibleBottom - visibleTop) * 2;
 	const auto destroyAbove = visibleTop - destroyAfterDistance;
 	const auto destroyBelow = visibleBottom + destroyAfterDistance;
+	const auto now = crl::now();
+	auto nextCheck = crl::time(0);
 	enumerateSections([&](const SectionInfo &info) {
+		auto &set = shownSets()[info.section];
 		if (destroyBelow <= info.rowsTop
 			|| destroyAbove >= info.rowsBottom) {
-			clearHeavyIn(shownSets()[info.section]);
-		} else if ((visibleTop > info.rowsTop && visibleTop < info.rowsBottom)
+			// Keep the heavy data for a while, so that scrolling back and
+			// forth doesn't recreate media views and players each time.
+			if (!hasHeavyIn(set)) {
+				set.offscreenSince = 0;
+			} else if (set.offscreenSince
+				&& now - set.offscreenSince >= kClearHeavyTimeout) {
+				clearHeavyIn(set);
+			} else {
+				if (!set.offscreenSince) {
+					set.offscreenSince = now;
+				}
+				const auto left = set.offscreenSince
+					+ kClearHeavyTimeout
+					- now;
+				nextCheck = nextCheck ? std::min(nextCheck, left) : left;
+			}
+			return true;
+		}
+		set.offscreenSince = 0;
+		if ((visibleTop > info.rowsTop && visibleTop < info.rowsBottom)
 			|| (visibleBottom > info.rowsTop
 				&& visibleBottom < info.rowsBottom)) {
 			pauseInvisibleLottieIn(info);
 		}
 		return true;
 	});
+	if (nextCheck) {
+		_clearHeavyTimer.callOnce(nextCheck);
+	} else {
+		_clearHeavyTimer.cancel();
+	}
+}
+
+bool StickersListWidget::hasHeavyIn(const Set &set) const {
+	return (set.lottiePlayer != nullptr)
+		|| ranges::any_of(set.stickers, [](const Sticker &sticker) {
+			return (sticker.documentMedia != nullptr);
+		});
 }
 
 void StickersListWidget::clearHeavyIn(Set &set, bool clearSavedFrames) {
+	set.offscreenSince = 0;
 	const auto player = base::take(set.lottiePlayer);
 	const auto lifetime = base::take(set.lottieLifetime);
 	for (auto &sticker : set.stickers) {
@@ -2321,6 +2372,7 @@ void StickersListWidget::setSection(Section section) {
 }
 
 void StickersListWidget::clearHeavyData() {
+	_clearHeavyTimer.cancel();
 	for (auto &set : shownSets()) {
 		clearHeavyIn(set, false);
 	}
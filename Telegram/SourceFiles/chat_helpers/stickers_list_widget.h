@@ -208,6 +208,7 @@ private:
 
 		std::unique_ptr<Lottie::MultiPlayer> lottiePlayer;
 		rpl::lifetime lottieLifetime;
+		crl::time offscreenSince = 0;
 
 		int count = 0;
 		bool externalLayout = false;
@@ -287,6 +288,7 @@ private:
 	void takeHeavyData(std::vector<Set> &to, std::vector<Set> &from);
 	void takeHeavyData(Set &to, Set &from);
 	void takeHeavyData(Sticker &to, Sticker &from);
+	[[nodiscard]] bool hasHeavyIn(const Set &set) const;
 	void clearHeavyIn(Set &set, bool clearSavedFrames = true);
 	void clearHeavyData();
 
@@ -374,6 +376,8 @@ private:
 
 	base::Timer _previewTimer;
 	bool _previewShown = false;
+	bool _lottieRepaintScheduled = false;
+	base::Timer _clearHeavyTimer;
 
 	std::map<QString, std::vector<uint64>> _searchCache;
 	std::vector<std::pair<uint64, QStringList>> _searchIndex;
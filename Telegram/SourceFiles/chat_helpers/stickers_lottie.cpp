@@ -22,6 +22,29 @@ namespace {
 
 constexpr auto kDontCacheLottieAfterArea = 512 * 512;
 
+// Animations that showed a frame during that period count as playing.
+constexpr auto kLottieActivePeriod = crl::time(1000);
+constexpr auto kLottieFullRateLimit = 4;
+constexpr auto kLottieHalfRateLimit = 12;
+constexpr auto kLottieSmallArea = 160 * 160;
+constexpr auto kLottieFullRate = 60;
+
+using SharedLottieKey = std::tuple<
+	not_null<DocumentData*>,
+	const Lottie::ColorReplacements*,
+	StickerLottieSize,
+	int,
+	int,
+	Lottie::Quality>;
+
+[[nodiscard]] auto SharedLottiePlayers()
+-> base::flat_map<SharedLottieKey, std::weak_ptr<Lottie::SinglePlayer>>& {
+	static auto result = base::flat_map<
+		SharedLottieKey,
+		std::weak_ptr<Lottie::SinglePlayer>>();
+	return result;
+}
+
 } // namespace
 
 template <typename Method>
@@ -117,6 +140,78 @@ std::unique_ptr<Lottie::SinglePlayer> LottiePlayerFromDocument(
 	return LottieFromDocument(method, media, uint8(keyShift), box);
 }
 
+std::shared_ptr<Lottie::SinglePlayer> SharedLottiePlayerFromDocument(
+		not_null<Data::DocumentMedia*> media,
+		const Lottie::ColorReplacements *replacements,
+		StickerLottieSize sizeTag,
+		QSize box,
+		Lottie::Quality quality) {
+	auto &players = SharedLottiePlayers();
+	const auto key = SharedLottieKey{
+		media->owner(),
+		replacements,
+		sizeTag,
+		box.width(),
+		box.height(),
+		quality,
+	};
+	const auto i = players.find(key);
+	if (i != end(players)) {
+		if (auto result = i->second.lock()) {
+			return result;
+		}
+	}
+	for (auto j = begin(players); j != end(players);) {
+		if (j->second.expired()) {
+			j = players.erase(j);
+		} else {
+			++j;
+		}
+	}
+	auto result = std::shared_ptr<Lottie::SinglePlayer>(
+		LottiePlayerFromDocument(
+			media,
+			replacements,
+			sizeTag,
+			box,
+			quality));
+	players.emplace_or_assign(key, result);
+	return result;
+}
+
+crl::time LottieFrameShowDelay(const void *animation, QSize box) {
+	static auto shown = base::flat_map<const void*, crl::time>();
+
+	const auto now = crl::now();
+	auto playing = 0;
+	for (auto i = begin(shown); i != end(shown);) {
+		if (now - i->second >= kLottieActivePeriod) {
+			i = shown.erase(i);
+		} else {
+			if (i->first != animation) {
+				++playing;
+			}
+			++i;
+		}
+	}
+	const auto small = (box.width() * box.height() <= kLottieSmallArea);
+	const auto fps = (playing < kLottieFullRateLimit)
+		? kLottieFullRate
+		: (playing < kLottieHalfRateLimit)
+		? (small ? (kLottieFullRate / 2) : kLottieFullRate)
+		: (small ? (kLottieFullRate / 4) : (kLottieFullRate / 2));
+	const auto i = shown.find(animation);
+	if (i != end(shown) && fps < kLottieFullRate) {
+		const auto period = crl::time(1000) / fps;
+		const auto passed = now - i->second;
+		if (passed < period) {
+			return period - passed;
+		}
+	}
+	shown.emplace_or_assign(animation, now);
+	return 0;
+}
+
 not_null<Lottie::Animation*> LottieAnimationFromDocument(
 		not_null<Lottie::MultiPlayer*> player,
 		not_null<Data::DocumentMedia*> media,
@@ -55,6 +55,23 @@ enum class StickerLottieSize : uchar {
 	QSize box,
 	Lottie::Quality quality = Lottie::Quality(),
 	std::shared_ptr<Lottie::FrameRenderer> renderer = nullptr);
+
+// All the views requesting the same document in the same size share one
+// player, so its frames are rendered once and painted by all of them.
+[[nodiscard]] std::shared_ptr<Lottie::SinglePlayer> SharedLottiePlayerFromDocument(
+	not_null<Data::DocumentMedia*> media,
+	const Lottie::ColorReplacements *replacements,
+	StickerLottieSize sizeTag,
+	QSize box,
+	Lottie::Quality quality = Lottie::Quality());
+
+// When many animations are playing, small ones drop to a lower frame rate
+// and large ones follow when there are even more of them. Returns zero if
+// the next frame may be shown right now or the delay to try again after.
+[[nodiscard]] crl::time LottieFrameShowDelay(
+	const void *animation,
+	QSize box);
+
 [[nodiscard]] not_null<Lottie::Animation*> LottieAnimationFromDocument(
 	not_null<Lottie::MultiPlayer*> player,
 	not_null<Data::DocumentMedia*> media,
@@ -20,6 +20,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/sandbox.h"
 #include "core/local_url_handlers.h"
 #include "core/launcher.h"
+#include "core/startup_trace.h"
+#include "core/stall_watchdog.h"
 #include "kotato/json_settings.h"
 #include "core/ui_integration.h"
 #include "core/core_settings.h"
@@ -173,6 +175,8 @@ Application::Application(not_null<Launcher*> launcher)
 }
 
 Application::~Application() {
+	_stallWatchdog = nullptr;
+
 	// Depend on activeWindow() for now :(
 	Shortcuts::Finish();
 
@@ -214,9 +218,15 @@ void Application::run() {
 	// Depends on notifications settings.
 	_notifications = std::make_unique<Window::Notifications::System>();
 
-	startLocalStorage();
-	Lang::GetInstance().fillDefaultJson();
-	Lang::GetInstance().fillFromJson();
+	{
+		const auto span = StartupTrace::Span("Local::start");
+		startLocalStorage();
+	}
+	{
+		const auto span = StartupTrace::Span("Lang::fillFromJson");
+		Lang::GetInstance().fillDefaultJson();
+		Lang::GetInstance().fillFromJson();
+	}
 	ValidateScale();
 
 	if (Local::oldSettingsVersion() < AppVersion) {
@@ -240,7 +250,10 @@ void Application::run() {
 
 	style::startManager(cScale());
 	Ui::InitTextOptions();
-	Ui::Emoji::Init();
+	{
+		const auto span = StartupTrace::Span("Ui::Emoji::Init");
+		Ui::Emoji::Init();
+	}
 	startEmojiImageLoader();
 	startSystemDarkModeViewer();
 	Media::Player::start(_audio.get());
@@ -263,7 +276,10 @@ void Application::run() {
 	// Create mime database, so it won't be slow later.
 	QMimeDatabase().mimeTypeForName(qsl("text/plain"));
 
-	_window = std::make_unique<Window::Controller>();
+	{
+		const auto span = StartupTrace::Span("Window::Controller");
+		_window = std::make_unique<Window::Controller>();
+	}
 
 	_domain->activeChanges(
 	) | rpl::start_with_next([=](not_null<Main::Account*> account) {
@@ -286,12 +302,18 @@ void Application::run() {
 	// Depend on activeWindow() for now :(
 	startShortcuts();
 	App::initMedia();
-	startDomain();
+	{
+		const auto span = StartupTrace::Span("Storage::Domain::start");
+		startDomain();
+	}
 
 	_window->widget()->show();
 
 	const auto currentGeometry = _window->widget()->geometry();
-	_mediaView = std::make_unique<Media::View::OverlayWidget>();
+	{
+		const auto span = StartupTrace::Span("Media::View::OverlayWidget");
+		_mediaView = std::make_unique<Media::View::OverlayWidget>();
+	}
 	_window->widget()->setGeometry(currentGeometry);
 
 	DEBUG_LOG(("Application Info: showing."));
@@ -306,6 +328,9 @@ void Application::run() {
 	for (const auto &error : Shortcuts::Errors()) {
 		LOG(("Shortcuts Error: %1").arg(error));
 	}
+
+	_stallWatchdog = std::make_unique<StallWatchdog>(
+		appDeactivatedValue() | rpl::map(!rpl::mappers::_1));
 }
 
 void Application::startDomain() {
@@ -677,6 +702,12 @@ void Application::handleAppDeactivated() {
 	Ui::Tooltip::Hide();
 }
 
+bool Application::appDeactivated() const {
+	const auto &app =
+		static_cast<QGuiApplication*>(QCoreApplication::instance());
+	return (app->applicationState() != Qt::ApplicationActive);
+}
+
 rpl::producer<bool> Application::appDeactivatedValue() const {
 	const auto &app =
 		static_cast<QGuiApplication*>(QCoreApplication::instance());
@@ -102,6 +102,7 @@ class Instance;
 namespace Core {
 
 class Launcher;
+class StallWatchdog;
 struct LocalUrlHandler;
 
 class Application final : public QObject, private base::Subscriber {
@@ -287,6 +288,7 @@ public:
 
 	void handleAppActivated();
 	void handleAppDeactivated();
+	[[nodiscard]] bool appDeactivated() const;
 	[[nodiscard]] rpl::producer<bool> appDeactivatedValue() const;
 
 	void switchDebugMode();
@@ -395,6 +397,8 @@ private:
 
 	base::Timer _saveSettingsTimer;
 
+	std::unique_ptr<StallWatchdog> _stallWatchdog;
+
 	struct LeaveSubscription {
 		LeaveSubscription(
 			QPointer<QWidget> pointer,
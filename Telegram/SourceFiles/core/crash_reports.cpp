@@ -14,6 +14,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include <signal.h>
 #include <new>
 #include <mutex>
+#include <atomic>
 
 #ifndef DESKTOP_APP_DISABLE_CRASH_REPORTS
 
@@ -59,9 +60,23 @@ using AnnotationRefs = std::map<std::string, const QString*>;
 
 Annotations ProcessAnnotations;
 AnnotationRefs ProcessAnnotationRefs;
+QMutex AnnotationsMutex;
+
+constexpr auto kAnnotationSlotsCount = int(AnnotationSlot::kCount);
+std::array<std::atomic<uint64>, kAnnotationSlotsCount> AnnotationSlots;
 
 #ifndef DESKTOP_APP_DISABLE_CRASH_REPORTS
 
+const char *AnnotationSlotName(int index) {
+	switch (AnnotationSlot(index)) {
+	case AnnotationSlot::MtpDcId: return "MtpDcId";
+	case AnnotationSlot::MtpRequest: return "MtpRequest";
+	case AnnotationSlot::StreamingPosition: return "StreamingPosition";
+	case AnnotationSlot::kCount: break;
+	}
+	Unexpected("Slot in AnnotationSlotName.");
+}
+
 QString ReportPath;
 FILE *ReportFile = nullptr;
 int ReportFileNo = 0;
@@ -193,6 +208,17 @@ void SignalHandler(int signum) {
 		for (const auto &i : ProcessAnnotations) {
 			dump() << i.first.c_str() << ": " << i.second.c_str() << "\n";
 		}
+		for (auto i = 0; i != kAnnotationSlotsCount; ++i) {
+			const auto value = AnnotationSlots[i].load(
+				std::memory_order_relaxed);
+			if (value) {
+				dump()
+					<< AnnotationSlotName(i)
+					<< ": "
+					<< (unsigned long long)value
+					<< "\n";
+			}
+		}
 		psWriteDump();
 		dump() << "\n";
 	}
@@ -517,8 +543,7 @@ void Finish() {
 }
 
 void SetAnnotation(const std::string &key, const QString &value) {
-	static QMutex mutex;
-	QMutexLocker lock(&mutex);
+	QMutexLocker lock(&AnnotationsMutex);
 
 	if (!value.trimmed().isEmpty()) {
 		ProcessAnnotations[key] = value.toUtf8().constData();
@@ -549,6 +574,8 @@ void SetAnnotationHex(const std::string &key, const QString &value) {
 	for (const auto ch : utf) {
 		appendHex(ch);
 	}
+
+	QMutexLocker lock(&AnnotationsMutex);
 	ProcessAnnotations[key] = std::move(buffer);
 }
 
@@ -563,6 +590,12 @@ void SetAnnotationRef(const std::string &key, const QString *valuePtr) {
 	}
 }
 
+void SetAnnotationSlot(AnnotationSlot slot, uint64 value) {
+	Expects(int(slot) >= 0 && int(slot) < kAnnotationSlotsCount);
+
+	AnnotationSlots[int(slot)].store(value, std::memory_order_relaxed);
+}
+
 #ifndef DESKTOP_APP_DISABLE_CRASH_REPORTS
 
 dump::~dump() {
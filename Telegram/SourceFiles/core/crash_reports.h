@@ -53,6 +53,17 @@ inline void ClearAnnotationRef(const std::string &key) {
 	SetAnnotationRef(key, nullptr);
 }
 
+// Preallocated numeric annotations, lock-free and cheap enough to be
+// updated from hot paths on any thread. Zero values are not reported.
+enum class AnnotationSlot {
+	MtpDcId,
+	MtpRequest,
+	StreamingPosition,
+
+	kCount,
+};
+void SetAnnotationSlot(AnnotationSlot slot, uint64 value);
+
 void StartCatching(not_null<Core::Launcher*> launcher);
 void FinishCatching();
 
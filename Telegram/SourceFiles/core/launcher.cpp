@@ -16,6 +16,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/crash_reports.h"
 #include "core/update_checker.h"
 #include "core/sandbox.h"
+#include "core/startup_trace.h"
 #include "base/concurrent_timer.h"
 
 namespace Core {
@@ -344,6 +345,7 @@ int Launcher::exec() {
 	}
 
 	auto result = executeApplication();
+	StartupTrace::Finish();
 
 	DEBUG_LOG(("Kotatogram finished, result: %1").arg(result));
 
@@ -468,6 +470,7 @@ void Launcher::processArguments() {
 		{ "-no-env-api"     , KeyFormat::NoValues },
 		{ "-api-id"         , KeyFormat::OneValue },
 		{ "-api-hash"       , KeyFormat::OneValue },
+		{ "-starttrace"     , KeyFormat::OneValue },
 	};
 	auto parseResult = QMap<QByteArray, QStringList>();
 	auto parsingKey = QByteArray();
@@ -517,6 +520,8 @@ void Launcher::processArguments() {
 		}
 	}
 	gStartUrl = parseResult.value("--", {}).join(QString());
+	StartupTrace::Start(
+		parseResult.value("-starttrace", {}).join(QString()));
 
 	const auto scaleKey = parseResult.value("-scale", {});
 	if (scaleKey.size() > 0) {
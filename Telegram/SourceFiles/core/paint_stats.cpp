@@ -0,0 +1,73 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "core/paint_stats.h"
+
+namespace Core::PaintStats {
+namespace {
+
+constexpr auto kDumpPeriod = 60 * crl::time(1000);
+constexpr auto kSlowFrame = int64(16'000); // Microseconds.
+
+struct Stats {
+	int count = 0;
+	int slow = 0;
+	int64 total = 0;
+	int64 max = 0;
+};
+
+base::flat_map<const char*, Stats> Collected;
+crl::time CollectedStart = 0;
+
+void Dump(crl::time now) {
+	const auto period = now - base::take(CollectedStart, now);
+	const auto stats = base::take(Collected);
+	auto result = QStringList();
+	for (const auto &[name, data] : stats) {
+		result.push_back(QString("%1 n:%2 slow:%3 avg:%4us max:%5us"
+			).arg(name
+			).arg(data.count
+			).arg(data.slow
+			).arg(data.total / data.count
+			).arg(data.max));
+	}
+	DEBUG_LOG(("Paint Stats: in %1 ms\n%2"
+		).arg(period
+		).arg(result.join('\n')));
+}
+
+void Count(const char *name, int64 duration) {
+	auto &stats = Collected[name];
+	++stats.count;
+	if (duration > kSlowFrame) {
+		++stats.slow;
+	}
+	stats.total += duration;
+	accumulate_max(stats.max, duration);
+
+	const auto now = crl::now();
+	if (!CollectedStart) {
+		CollectedStart = now;
+	} else if (now - CollectedStart >= kDumpPeriod) {
+		Dump(now);
+	}
+}
+
+} // namespace
+
+Span::Span(const char *name)
+: _name(name)
+, _start(Logs::DebugEnabled() ? crl::profile() : 0) {
+}
+
+Span::~Span() {
+	if (_start) {
+		Count(_name, crl::profile() - _start);
+	}
+}
+
+} // namespace Core::PaintStats
@@ -0,0 +1,27 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+namespace Core::PaintStats {
+
+// Collected only with debug logs enabled, main thread only.
+// The name must be a string literal, it is used as a key.
+class Span final {
+public:
+	explicit Span(const char *name);
+	Span(const Span &other) = delete;
+	Span &operator=(const Span &other) = delete;
+	~Span();
+
+private:
+	const char *_name = nullptr;
+	int64 _start = 0;
+
+};
+
+} // namespace Core::PaintStats
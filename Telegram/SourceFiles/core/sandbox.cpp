@@ -16,6 +16,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/crash_report_window.h"
 #include "core/application.h"
 #include "core/launcher.h"
+#include "core/startup_trace.h"
 #include "core/local_url_handlers.h"
 #include "core/update_checker.h"
 #include "base/timer.h"
@@ -169,7 +170,10 @@ void Sandbox::launchApplication() {
 			Instance()._handleObservables.call();
 		});
 
-		_application = std::make_unique<Application>(_launcher);
+		_application = [&] {
+			const auto span = StartupTrace::Span("Application::Application");
+			return std::make_unique<Application>(_launcher);
+		}();
 
 		// Ideally this should go to constructor.
 		// But we want to catch all native events and Application installs
@@ -177,6 +181,7 @@ void Sandbox::launchApplication() {
 		// our filter after the Application constructor installs his.
 		installNativeEventFilter(this);
 
+		const auto span = StartupTrace::Span("Application::run");
 		_application->run();
 	});
 }
@@ -0,0 +1,106 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "core/stall_watchdog.h"
+
+#include <QtCore/QDateTime>
+
+namespace Core {
+namespace {
+
+constexpr auto kBeatPeriod = crl::time(1000);
+constexpr auto kStallTimeout = 5 * crl::time(1000);
+
+// If the watchdog itself woke up that late the system was most likely
+// suspended, so the main thread didn't have a chance to beat either.
+// The monotonic clock may not advance while suspended, the wall one does.
+constexpr auto kSuspendTimeout = 3 * kBeatPeriod;
+
+} // namespace
+
+StallWatchdog::StallWatchdog(rpl::producer<bool> active)
+: _beatTimer([=] { beat(); })
+, _lastBeat(crl::now()) {
+	_thread = std::thread([=] { watch(); });
+
+	std::move(
+		active
+	) | rpl::start_with_next([=](bool active) {
+		setActive(active);
+	}, _lifetime);
+}
+
+StallWatchdog::~StallWatchdog() {
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_finished = true;
+	}
+	_stateChanged.notify_one();
+	_thread.join();
+}
+
+void StallWatchdog::setActive(bool active) {
+	if (active) {
+		_lastBeat = crl::now();
+		if (!_beatTimer.isActive()) {
+			_beatTimer.callEach(kBeatPeriod);
+		}
+	} else {
+		_beatTimer.cancel();
+	}
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		_active = active;
+	}
+	_stateChanged.notify_one();
+}
+
+void StallWatchdog::beat() {
+	const auto now = crl::now();
+	const auto was = _lastBeat.exchange(now);
+	if (_stallReported.exchange(false)) {
+		LOG(("Watchdog: Main thread responded after %1 ms."
+			).arg(now - was));
+	}
+}
+
+void StallWatchdog::watch() {
+	auto lock = std::unique_lock<std::mutex>(_mutex);
+	while (true) {
+		_stateChanged.wait(lock, [&] { return _finished || _active; });
+		if (_finished) {
+			return;
+		}
+		watchWhileActive(lock);
+	}
+}
+
+void StallWatchdog::watchWhileActive(std::unique_lock<std::mutex> &lock) {
+	auto lastCheck = crl::now();
+	auto lastWallCheck = QDateTime::currentMSecsSinceEpoch();
+	while (!_stateChanged.wait_for(
+			lock,
+			std::chrono::milliseconds(kBeatPeriod),
+			[&] { return _finished || !_active; })) {
+		const auto now = crl::now();
+		const auto wallNow = QDateTime::currentMSecsSinceEpoch();
+		const auto passed = now - base::take(lastCheck, now);
+		const auto wallPassed = wallNow - base::take(lastWallCheck, wallNow);
+		if (passed > kSuspendTimeout
+			|| wallPassed - passed > kSuspendTimeout) {
+			_lastBeat = now;
+			continue;
+		}
+		const auto stall = now - _lastBeat;
+		if (stall > kStallTimeout && !_stallReported.exchange(true)) {
+			LOG(("Watchdog: Main thread is not responding for %1 ms."
+				).arg(stall));
+		}
+	}
+}
+
+} // namespace Core
@@ -0,0 +1,47 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/timer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace Core {
+
+// Logs main thread event loop stalls from a separate thread,
+// so that a hang is visible in the log even if the app gets killed.
+// It checks only while the app is active, to not wake up the system.
+class StallWatchdog final {
+public:
+	explicit StallWatchdog(rpl::producer<bool> active);
+	~StallWatchdog();
+
+private:
+	void setActive(bool active);
+	void beat();
+	void watch();
+	void watchWhileActive(std::unique_lock<std::mutex> &lock);
+
+	base::Timer _beatTimer;
+	std::atomic<crl::time> _lastBeat = 0;
+	std::atomic<bool> _stallReported = false;
+
+	std::thread _thread;
+	std::mutex _mutex;
+	std::condition_variable _stateChanged;
+	bool _active = false;
+	bool _finished = false;
+
+	rpl::lifetime _lifetime;
+
+};
+
+} // namespace Core
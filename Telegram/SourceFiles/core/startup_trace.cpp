@@ -0,0 +1,156 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "core/startup_trace.h"
+
+#include <QtCore/QMutex>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace Core::StartupTrace {
+namespace {
+
+struct Event {
+	const char *name = nullptr;
+	int64 start = 0;
+	int64 duration = -1; // Instant events have no duration.
+	int thread = 0;
+};
+
+std::atomic<bool> TraceEnabled = false;
+std::chrono::steady_clock::time_point TraceStart;
+QString TracePath;
+QMutex TraceMutex;
+std::vector<Event> TraceEvents;
+std::vector<std::thread::id> TraceThreads;
+
+[[nodiscard]] int64 Now() {
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now() - TraceStart).count();
+}
+
+// Must be called with the TraceMutex locked.
+[[nodiscard]] int CurrentThreadIndex() {
+	const auto id = std::this_thread::get_id();
+	const auto i = ranges::find(TraceThreads, id);
+	if (i != end(TraceThreads)) {
+		return int(i - begin(TraceThreads));
+	}
+	TraceThreads.push_back(id);
+	return int(TraceThreads.size()) - 1;
+}
+
+void AddEvent(const char *name, int64 start, int64 duration) {
+	QMutexLocker lock(&TraceMutex);
+	TraceEvents.push_back({
+		.name = name,
+		.start = start,
+		.duration = duration,
+		.thread = CurrentThreadIndex(),
+	});
+}
+
+[[nodiscard]] QByteArray Serialize(
+		const std::vector<Event> &events,
+		int threads) {
+	auto list = QJsonArray();
+	for (auto i = 0; i != threads; ++i) {
+		list.push_back(QJsonObject{
+			{ "name", "thread_name" },
+			{ "ph", "M" },
+			{ "pid", 1 },
+			{ "tid", i },
+			{ "args", QJsonObject{
+				{ "name", i ? QString("worker %1").arg(i) : QString("main") },
+			} },
+		});
+	}
+	for (const auto &event : events) {
+		auto object = QJsonObject{
+			{ "name", QString::fromLatin1(event.name) },
+			{ "ts", double(event.start) },
+			{ "pid", 1 },
+			{ "tid", event.thread },
+		};
+		if (event.duration >= 0) {
+			object.insert("ph", "X");
+			object.insert("dur", double(event.duration));
+		} else {
+			object.insert("ph", "i");
+			object.insert("s", "g");
+		}
+		list.push_back(object);
+	}
+	return QJsonDocument(
+		QJsonObject{ { "traceEvents", list } }
+	).toJson(QJsonDocument::Compact);
+}
+
+} // namespace
+
+void Start(const QString &path) {
+	if (path.isEmpty() || TraceEnabled) {
+		return;
+	}
+	TraceStart = std::chrono::steady_clock::now();
+	TracePath = path;
+	{
+		QMutexLocker lock(&TraceMutex);
+		TraceThreads.push_back(std::this_thread::get_id());
+	}
+	TraceEnabled = true;
+}
+
+void Finish() {
+	if (!TraceEnabled.exchange(false)) {
+		return;
+	}
+	AddEvent("StartupTrace::Finish", Now(), -1);
+
+	QMutexLocker lock(&TraceMutex);
+	const auto events = base::take(TraceEvents);
+	const auto threads = int(TraceThreads.size());
+	lock.unlock();
+
+	auto file = QFile(TracePath);
+	if (!file.open(QIODevice::WriteOnly)
+		|| file.write(Serialize(events, threads)) < 0) {
+		LOG(("Startup Trace Error: could not write '%1'.").arg(TracePath));
+	} else {
+		LOG(("Startup Trace: written %1 events to '%2'."
+			).arg(events.size()
+			).arg(TracePath));
+	}
+}
+
+bool Enabled() {
+	return TraceEnabled;
+}
+
+void Mark(const char *name) {
+	if (Enabled()) {
+		AddEvent(name, Now(), -1);
+	}
+}
+
+Span::Span(const char *name)
+: _name(name)
+, _start(Enabled() ? Now() : -1) {
+}
+
+Span::~Span() {
+	if (_start >= 0 && Enabled()) {
+		AddEvent(_name, _start, Now() - _start);
+	}
+}
+
+} // namespace Core::StartupTrace
@@ -0,0 +1,35 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+namespace Core::StartupTrace {
+
+// Enabled by the -starttrace <path> launch flag. The collected spans
+// are written to the path in Chrome trace format (chrome://tracing)
+// when the chats list is painted for the first time or on quit.
+void Start(const QString &path);
+void Finish();
+[[nodiscard]] bool Enabled();
+
+// Thread safe, the names must be string literals.
+void Mark(const char *name);
+
+class Span final {
+public:
+	explicit Span(const char *name);
+	Span(const Span &other) = delete;
+	Span &operator=(const Span &other) = delete;
+	~Span();
+
+private:
+	const char *_name = nullptr;
+	int64 _start = -1;
+
+};
+
+} // namespace Core::StartupTrace
@@ -227,14 +227,16 @@ rpl::producer<EntryUpdate> Changes::realtimeEntryUpdates(
 void Changes::scheduleNotifications() {
 	if (!_notify) {
 		_notify = true;
-		crl::on_main(&session(), [=] {
-			sendNotifications();
-		});
+		if (!_batchDepth) {
+			crl::on_main(&session(), [=] {
+				sendNotifications();
+			});
+		}
 	}
 }
 
 void Changes::sendNotifications() {
-	if (!_notify) {
+	if (!_notify || _batchDepth > 0) {
 		return;
 	}
 	_notify = false;
@@ -244,4 +246,16 @@ void Changes::sendNotifications() {
 	_entryChanges.sendNotifications();
 }
 
+void Changes::startBatch() {
+	++_batchDepth;
+}
+
+void Changes::finishBatch() {
+	Expects(_batchDepth > 0);
+
+	if (!--_batchDepth) {
+		sendNotifications();
+	}
+}
+
 } // namespace Data
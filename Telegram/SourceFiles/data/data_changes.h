@@ -235,6 +235,11 @@ public:
 
 	void sendNotifications();
 
+	// Notifications scheduled between startBatch() and the outermost
+	// finishBatch() are sent once for each entity when the batch ends.
+	void startBatch();
+	void finishBatch();
+
 private:
 	template <typename DataType, typename UpdateType>
 	class Manager final {
@@ -279,6 +284,7 @@ private:
 	Manager<HistoryItem, MessageUpdate> _messageChanges;
 	Manager<Dialogs::Entry, EntryUpdate> _entryChanges;
 
+	int _batchDepth = 0;
 	bool _notify = false;
 
 };
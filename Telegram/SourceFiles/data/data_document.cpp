@@ -809,6 +809,10 @@ PhotoData *DocumentData::goodThumbnailPhoto() const {
 	return _goodThumbnailPhoto;
 }
 
+Storage::Cache::Key DocumentData::waveformCacheKey() const {
+	return Data::DocumentWaveformCacheKey(_dc, id);
+}
+
 Storage::Cache::Key DocumentData::bigFileBaseCacheKey() const {
 	return hasRemoteLocation()
 		? StorageFileLocation(
@@ -982,6 +986,9 @@ void DocumentData::save(
 		if (fromCloud == LoadFromCloudOrLocal) {
 			_loader->permitLoadFromCloud();
 		}
+		if (!autoLoading) {
+			_loader->stopAutoLoading();
+		}
 	} else {
 		status = FileReady;
 		auto reader = owner().streaming().sharedReader(this, origin, true);
@@ -1100,6 +1107,16 @@ bool DocumentData::cancelled() const {
 	return (_flags & Flag::DownloadCancelled);
 }
 
+void DocumentData::stopAutomaticLoad() {
+	if (!_loader
+		|| !_loader->autoLoading()
+		|| _loader->currentOffset() > 0) {
+		return;
+	}
+	destroyLoader();
+	_owner->documentLoadDone(this);
+}
+
 VoiceWaveform documentWaveformDecode(const QByteArray &encoded5bit) {
 	auto bitsCount = static_cast<int>(encoded5bit.size() * 8);
 	auto valuesCount = bitsCount / 5;
@@ -106,6 +106,10 @@ public:
 		bool autoLoading = false);
 	void cancel();
 	[[nodiscard]] bool cancelled() const;
+
+	// Stops an automatic load that didn't receive anything yet,
+	// without marking it as cancelled, so it can be started again.
+	void stopAutomaticLoad();
 	[[nodiscard]] float64 progress() const;
 	[[nodiscard]] int loadOffset() const;
 	[[nodiscard]] bool uploading() const;
@@ -196,6 +200,7 @@ public:
 	[[nodiscard]] PhotoData *goodThumbnailPhoto() const;
 
 	[[nodiscard]] Storage::Cache::Key bigFileBaseCacheKey() const;
+	[[nodiscard]] Storage::Cache::Key waveformCacheKey() const;
 
 	void setRemoteLocation(
 		int32 dc,
@@ -70,6 +70,15 @@ enum class FileType {
 	if (!reader.canRead()
 		|| (size.width() * size.height() > kReadAreaLimit)) {
 		return QImage();
+	} else if (size.width() > kWallPaperThumbnailLimit
+		|| size.height() > kWallPaperThumbnailLimit) {
+		const auto scaled = size.scaled(
+			kWallPaperThumbnailLimit,
+			kWallPaperThumbnailLimit,
+			Qt::KeepAspectRatio);
+		if (!scaled.isEmpty()) {
+			reader.setScaledSize(scaled);
+		}
 	}
 	auto result = reader.read();
 	if (!result.width() || !result.height()) {
@@ -23,12 +23,16 @@ namespace Data {
 namespace {
 
 constexpr auto kReadRequestTimeout = 3 * crl::time(1000);
+constexpr auto kReadRequestsInFlightLimit = 5;
+constexpr auto kUnloadHiddenTimeout = 10 * 60 * crl::time(1000);
+constexpr auto kUnloadCheckTimeout = 60 * crl::time(1000);
 
 } // namespace
 
 Histories::Histories(not_null<Session*> owner)
 : _owner(owner)
-, _readRequestsTimer([=] { sendReadRequests(); }) {
+, _readRequestsTimer([=] { sendReadRequests(); })
+, _unloadTimer([=] { unloadHidden(); }) {
 }
 
 Session &Histories::owner() const {
@@ -57,15 +61,57 @@ not_null<History*> Histories::findOrCreate(PeerId peerId) {
 }
 
 void Histories::unloadAll() {
+	_unloadScheduled.clear();
+	_unloadTimer.cancel();
 	for (const auto &[peerId, history] : _map) {
 		history->clear(History::ClearType::Unload);
 	}
 }
 
 void Histories::clearAll() {
+	_unloadScheduled.clear();
+	_unloadTimer.cancel();
 	_map.clear();
 }
 
+void Histories::scheduleUnload(not_null<History*> history) {
+	if (history->isEmpty()) {
+		return;
+	}
+	_unloadScheduled[history] = crl::now() + kUnloadHiddenTimeout;
+	if (!_unloadTimer.isActive()) {
+		_unloadTimer.callEach(kUnloadCheckTimeout);
+	}
+}
+
+void Histories::cancelUnload(not_null<History*> history) {
+	_unloadScheduled.remove(history);
+	if (_unloadScheduled.empty()) {
+		_unloadTimer.cancel();
+	}
+}
+
+void Histories::unloadHidden() {
+	const auto now = crl::now();
+	for (auto i = begin(_unloadScheduled); i != end(_unloadScheduled);) {
+		const auto history = i->first;
+		if (i->second > now || lookup(history)) {
+			// Wait for the pending requests to finish.
+			++i;
+			continue;
+		}
+		i = _unloadScheduled.erase(i);
+		if (!history->isEmpty()) {
+			DEBUG_LOG(("Histories: unloading hidden %1."
+				).arg(history->peer->id));
+			history->clear(History::ClearType::Unload);
+		}
+	}
+	if (_unloadScheduled.empty()) {
+		_unloadTimer.cancel();
+	}
+}
+
 void Histories::readInbox(not_null<History*> history) {
 	DEBUG_LOG(("Reading: readInbox called."));
 	if (history->lastServerMessageKnown()) {
@@ -460,6 +506,11 @@ void Histories::sendReadRequests() {
 			DEBUG_LOG(("Reading: skipping zero till."));
 			continue;
 		} else if (state.willReadWhen <= now) {
+			if (_readRequestsInFlight >= kReadRequestsInFlightLimit) {
+				// Marking a whole folder as read, send when some finish.
+				DEBUG_LOG(("Reading: too many requests, waiting."));
+				continue;
+			}
 			DEBUG_LOG(("Reading: sending with till %1."
 				).arg(state.willReadTill));
 			sendReadRequest(history, state);
@@ -481,6 +532,7 @@ void Histories::sendReadRequest(not_null<History*> history, State &state) {
 	const auto tillId = state.sentReadTill = base::take(state.willReadTill);
 	state.willReadWhen = 0;
 	state.sentReadDone = false;
+	++_readRequestsInFlight;
 	DEBUG_LOG(("Reading: sending request now with till %1."
 		).arg(tillId));
 	sendRequest(history, RequestType::ReadInbox, [=](Fn<void()> finish) {
@@ -490,6 +542,8 @@ void Histories::sendReadRequest(not_null<History*> history, State &state) {
 			const auto state = lookup(history);
 			Assert(state != nullptr);
 
+			--_readRequestsInFlight;
+
 			if (state->sentReadTill == tillId) {
 				state->sentReadDone = true;
 				if (history->unreadCountRefreshNeeded(tillId)) {
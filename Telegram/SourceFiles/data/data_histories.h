@@ -44,6 +44,10 @@ public:
 	void unloadAll();
 	void clearAll();
 
+	// Views of the histories that were not shown for a while are unloaded.
+	void scheduleUnload(not_null<History*> history);
+	void cancelUnload(not_null<History*> history);
+
 	void readInbox(not_null<History*> history);
 	void readInboxTill(not_null<HistoryItem*> item);
 	void readInboxTill(not_null<History*> history, MsgId tillId);
@@ -112,6 +116,7 @@ private:
 	void postponeRequestDialogEntries();
 
 	void sendDialogRequests();
+	void unloadHidden();
 
 	const not_null<Session*> _owner;
 
@@ -120,6 +125,7 @@ private:
 	base::flat_map<int, not_null<History*>> _historyByRequest;
 	int _requestAutoincrement = 0;
 	base::Timer _readRequestsTimer;
+	int _readRequestsInFlight = 0;
 
 	base::flat_set<not_null<Data::Folder*>> _dialogFolderRequests;
 	base::flat_map<
@@ -131,6 +137,9 @@ private:
 
 	base::flat_set<not_null<History*>> _fakeChatListRequests;
 
+	base::flat_map<not_null<History*>, crl::time> _unloadScheduled;
+	base::Timer _unloadTimer;
+
 };
 
 } // namespace Data
@@ -0,0 +1,103 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "data/data_messages_index.h"
+
+#include "history/history.h"
+#include "history/history_item.h"
+
+namespace Data {
+
+void MessagesIndex::add(not_null<HistoryItem*> item) {
+	if (_words.find(item) != end(_words)) {
+		return;
+	}
+	auto words = TextUtilities::PrepareSearchWords(
+		item->originalText().text);
+	if (words.isEmpty()) {
+		return;
+	}
+	words.removeDuplicates();
+	for (const auto &word : words) {
+		_items[word].emplace(item);
+	}
+	_words.emplace(item, std::move(words));
+}
+
+void MessagesIndex::refresh(not_null<HistoryItem*> item) {
+	// An item without text could get one, f.e. when edited.
+	remove(item);
+	add(item);
+}
+
+void MessagesIndex::remove(not_null<HistoryItem*> item) {
+	const auto i = _words.find(item);
+	if (i == end(_words)) {
+		return;
+	}
+	for (const auto &word : i->second) {
+		const auto j = _items.find(word);
+		if (j != end(_items)) {
+			j->second.erase(item);
+			if (j->second.empty()) {
+				_items.erase(j);
+			}
+		}
+	}
+	_words.erase(i);
+}
+
+void MessagesIndex::clear() {
+	_items.clear();
+	_words.clear();
+}
+
+std::vector<not_null<HistoryItem*>> MessagesIndex::search(
+		const QString &query,
+		PeerData *peer,
+		int limit) const {
+	const auto words = TextUtilities::PrepareSearchWords(query);
+	auto result = std::vector<not_null<HistoryItem*>>();
+	auto first = true;
+	for (const auto &word : words) {
+		auto found = std::vector<not_null<HistoryItem*>>();
+		for (auto i = _items.lower_bound(word)
+			; i != end(_items) && i->first.startsWith(word)
+			; ++i) {
+			for (const auto item : i->second) {
+				if (!peer || item->history()->peer == peer) {
+					found.push_back(item);
+				}
+			}
+		}
+		ranges::sort(found);
+		found.erase(ranges::unique(found), end(found));
+		if (first) {
+			result = std::move(found);
+			first = false;
+		} else {
+			auto both = std::vector<not_null<HistoryItem*>>();
+			ranges::set_intersection(
+				result,
+				found,
+				ranges::back_inserter(both));
+			result = std::move(both);
+		}
+		if (result.empty()) {
+			return result;
+		}
+	}
+	ranges::sort(result, std::greater<>(), [](not_null<HistoryItem*> item) {
+		return std::make_pair(item->date(), item->id);
+	});
+	if (limit > 0 && result.size() > limit) {
+		result.erase(begin(result) + limit, end(result));
+	}
+	return result;
+}
+
+} // namespace Data
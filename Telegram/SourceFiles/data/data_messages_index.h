@@ -0,0 +1,36 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+class HistoryItem;
+class PeerData;
+
+namespace Data {
+
+// Word prefix index over the texts of all the loaded messages,
+// used to show local search results before the server answers.
+class MessagesIndex final {
+public:
+	void add(not_null<HistoryItem*> item);
+	void refresh(not_null<HistoryItem*> item);
+	void remove(not_null<HistoryItem*> item);
+	void clear();
+
+	// Newest first, only from the given peer if it is not nullptr.
+	[[nodiscard]] std::vector<not_null<HistoryItem*>> search(
+		const QString &query,
+		PeerData *peer,
+		int limit) const;
+
+private:
+	std::map<QString, std::unordered_set<not_null<HistoryItem*>>> _items;
+	std::unordered_map<not_null<HistoryItem*>, QStringList> _words;
+
+};
+
+} // namespace Data
@@ -127,7 +127,6 @@ void PeerClickHandler::onClick(ClickContext context) const {
 PeerData::PeerData(not_null<Data::Session*> owner, PeerId id)
 : id(id)
 , _owner(owner) {
-	_nameText.setText(st::msgNameStyle, QString(), Ui::NameTextOptions());
 }
 
 Data::Session &PeerData::owner() const {
@@ -160,10 +159,6 @@ void PeerData::updateNameDelayed(
 			return;
 		}
 	}
-	name = newName;
-	_nameText.setText(st::msgNameStyle, name, Ui::NameTextOptions());
-	_userpicEmpty = nullptr;
-
 	auto flags = UpdateFlag::None | UpdateFlag::None;
 	auto oldFirstLetters = base::flat_set<QChar>();
 	const auto nameUpdated = (nameVersion++ > 1);
@@ -171,6 +166,10 @@ void PeerData::updateNameDelayed(
 		oldFirstLetters = nameFirstLetters();
 		flags |= UpdateFlag::Name;
 	}
+	name = newName;
+	_nameTextValid = _nameWordsValid = false;
+	_userpicEmpty = nullptr;
+
 	if (isUser()) {
 		if (asUser()->username != newUsername) {
 			asUser()->username = newUsername;
@@ -189,7 +188,6 @@ void PeerData::updateNameDelayed(
 			flags |= UpdateFlag::Username;
 		}
 	}
-	fillNames();
 	if (nameUpdated) {
 		session().changes().nameUpdated(this, std::move(oldFirstLetters));
 	}
@@ -555,7 +553,22 @@ void PeerData::checkFolder(FolderId folderId) {
 	}
 }
 
-void PeerData::fillNames() {
+const base::flat_set<QString> &PeerData::nameWords() const {
+	if (!_nameWordsValid) {
+		fillNames();
+	}
+	return _nameWords;
+}
+
+const base::flat_set<QChar> &PeerData::nameFirstLetters() const {
+	if (!_nameWordsValid) {
+		fillNames();
+	}
+	return _nameFirstLetters;
+}
+
+void PeerData::fillNames() const {
+	_nameWordsValid = true;
 	_nameWords.clear();
 	_nameFirstLetters.clear();
 	auto toIndexList = QStringList();
@@ -740,6 +753,7 @@ const Ui::Text::String &PeerData::topBarNameText() const {
 			return user->phoneText;
 		}
 	}
+	validateNameText();
 	return _nameText;
 }
 
@@ -747,9 +761,17 @@ const Ui::Text::String &PeerData::nameText() const {
 	if (const auto to = migrateTo()) {
 		return to->nameText();
 	}
+	validateNameText();
 	return _nameText;
 }
 
+void PeerData::validateNameText() const {
+	if (!_nameTextValid) {
+		_nameTextValid = true;
+		_nameText.setText(st::msgNameStyle, name, Ui::NameTextOptions());
+	}
+}
+
 const QString &PeerData::shortName() const {
 	if (const auto user = asUser()) {
 		return user->firstName.isEmpty() ? user->lastName : user->firstName;
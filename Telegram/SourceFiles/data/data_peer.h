@@ -241,12 +241,8 @@ public:
 		return int32(uint32(id & 0xFFFFFFFFULL));
 	}
 
-	[[nodiscard]] const base::flat_set<QString> &nameWords() const {
-		return _nameWords;
-	}
-	[[nodiscard]] const base::flat_set<QChar> &nameFirstLetters() const {
-		return _nameFirstLetters;
-	}
+	[[nodiscard]] const base::flat_set<QString> &nameWords() const;
+	[[nodiscard]] const base::flat_set<QChar> &nameFirstLetters() const;
 
 	void setUserpic(PhotoId photoId, const ImageLocation &location);
 	void setUserpicPhoto(const MTPPhoto &data);
@@ -417,7 +413,8 @@ protected:
 	void clearUserpic();
 
 private:
-	void fillNames();
+	void fillNames() const;
+	void validateNameText() const;
 	[[nodiscard]] not_null<Ui::EmptyUserpic*> ensureEmptyUserpic() const;
 	[[nodiscard]] virtual auto unavailableReasons() const
 		-> const std::vector<Data::UnavailableReason> &;
@@ -431,13 +428,18 @@ private:
 	mutable Data::CloudImage _userpic;
 	PhotoId _userpicPhotoId = kUnknownPhotoId;
 	mutable std::unique_ptr<Ui::EmptyUserpic> _userpicEmpty;
-	Ui::Text::String _nameText;
+	mutable Ui::Text::String _nameText;
 
 	Data::NotifySettings _notify;
 
 	ClickHandlerPtr _openLink;
-	base::flat_set<QString> _nameWords; // for filtering
-	base::flat_set<QChar> _nameFirstLetters;
+
+	// Most peers (participants in big groups) are never drawn by name or
+	// searched for, so the name layout and index are built on demand.
+	mutable base::flat_set<QString> _nameWords; // for filtering
+	mutable base::flat_set<QChar> _nameFirstLetters;
+	mutable bool _nameTextValid = false;
+	mutable bool _nameWordsValid = false;
 
 	crl::time _lastFullUpdate = 0;
 	bool _hasPinnedMessages = false;
@@ -174,6 +174,16 @@ float64 PhotoData::progress() const {
 	return loading() ? _images[index].loader->currentProgress() : 0.;
 }
 
+void PhotoData::stopAutomaticLoad() {
+	auto &file = _images[PhotoSizeIndex(PhotoSize::Large)];
+	if (file.loader
+		&& file.loader->autoLoading()
+		&& !file.loader->currentOffset()) {
+		file.loader = nullptr;
+		_owner->photoLoadDone(this);
+	}
+}
+
 bool PhotoData::cancelled() const {
 	const auto index = PhotoSizeIndex(PhotoSize::Large);
 	return (_images[index].flags & Data::CloudFile::Flag::Cancelled);
@@ -56,6 +56,10 @@ public:
 	[[nodiscard]] bool loading() const;
 	[[nodiscard]] bool displayLoading() const;
 	void cancel();
+
+	// Stops an automatic load that didn't receive anything yet,
+	// without marking it as cancelled, so it can be started again.
+	void stopAutomaticLoad();
 	[[nodiscard]] float64 progress() const;
 	[[nodiscard]] int32 loadOffset() const;
 	[[nodiscard]] bool uploading() const;
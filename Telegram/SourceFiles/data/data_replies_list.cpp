@@ -51,6 +51,15 @@ struct RepliesList::Viewer {
 RepliesList::RepliesList(not_null<History*> history, MsgId rootId)
 : _history(history)
 , _rootId(rootId) {
+	// Keep the list actual even without viewers, so that it can be
+	// reused when the thread is opened again.
+	_history->session().changes().messageUpdates(
+		MessageUpdate::Flag::NewAdded
+		| MessageUpdate::Flag::NewMaybeAdded
+		| MessageUpdate::Flag::Destroyed
+	) | rpl::filter([=](const MessageUpdate &update) {
+		return applyUpdate(update);
+	}) | rpl::to_empty | rpl::start_to_stream(_listChanged, _lifetime);
 }
 
 RepliesList::~RepliesList() {
@@ -61,6 +70,12 @@ RepliesList::~RepliesList() {
 	}
 }
 
+void RepliesList::markNewestStale() {
+	if (_skippedAfter == 0) {
+		_skippedAfter = std::nullopt;
+	}
+}
+
 rpl::producer<MessagesSlice> RepliesList::source(
 		MessagePosition aroundId,
 		int limitBefore,
@@ -108,14 +123,14 @@ rpl::producer<MessagesSlice> RepliesList::sourceFromServer(
 		viewer->limitAfter = limitAfter;
 
 		_history->session().changes().messageUpdates(
-			MessageUpdate::Flag::NewAdded
-			| MessageUpdate::Flag::NewMaybeAdded
-			| MessageUpdate::Flag::Destroyed
+			MessageUpdate::Flag::Destroyed
 		) | rpl::filter([=](const MessageUpdate &update) {
-			return applyUpdate(viewer, update);
+			return injectedDestroyed(viewer, update);
 		}) | rpl::start_with_next(pushDelayed, lifetime);
 
-		_partLoaded.events(
+		rpl::merge(
+			_listChanged.events(),
+			_partLoaded.events()
 		) | rpl::start_with_next(pushDelayed, lifetime);
 
 		push();
@@ -316,22 +331,27 @@ bool RepliesList::buildFromData(not_null<Viewer*> viewer) {
 	return true;
 }
 
-bool RepliesList::applyUpdate(
+bool RepliesList::injectedDestroyed(
 		not_null<Viewer*> viewer,
-		const MessageUpdate &update) {
+		const MessageUpdate &update) const {
 	if (update.item->history() != _history
 		|| !IsServerMsgId(update.item->id)) {
 		return false;
 	}
-	if (update.flags & MessageUpdate::Flag::Destroyed) {
-		const auto id = update.item->fullId();
-		for (auto i = 0; i != viewer->injectedForRoot; ++i) {
-			if (viewer->slice.ids[i] == id) {
-				return true;
-			}
+	const auto id = update.item->fullId();
+	for (auto i = 0; i != viewer->injectedForRoot; ++i) {
+		if (viewer->slice.ids[i] == id) {
+			return true;
 		}
 	}
-	if (update.item->replyToTop() != _rootId) {
+	return false;
+}
+
+bool RepliesList::applyUpdate(const MessageUpdate &update) {
+	if (update.item->history() != _history
+		|| !IsServerMsgId(update.item->id)) {
+		return false;
+	} else if (update.item->replyToTop() != _rootId) {
 		return false;
 	}
 	const auto id = update.item->id;
@@ -31,6 +31,17 @@ public:
 
 	[[nodiscard]] rpl::producer<int> fullCount() const;
 
+	[[nodiscard]] not_null<History*> history() const {
+		return _history;
+	}
+	[[nodiscard]] MsgId rootId() const {
+		return _rootId;
+	}
+
+	// Updates may not come while no one views the thread, so a reused
+	// list requests the newest messages again on the next build.
+	void markNewestStale();
+
 private:
 	struct Viewer;
 
@@ -44,9 +55,10 @@ private:
 	void appendLocalMessages(MessagesSlice &slice);
 
 	[[nodiscard]] bool buildFromData(not_null<Viewer*> viewer);
-	[[nodiscard]] bool applyUpdate(
+	[[nodiscard]] bool applyUpdate(const MessageUpdate &update);
+	[[nodiscard]] bool injectedDestroyed(
 		not_null<Viewer*> viewer,
-		const MessageUpdate &update);
+		const MessageUpdate &update) const;
 	void injectRootMessageAndReverse(not_null<Viewer*> viewer);
 	void injectRootMessage(not_null<Viewer*> viewer);
 	void injectRootDivider(
@@ -64,12 +76,15 @@ private:
 	std::optional<int> _skippedAfter;
 	rpl::variable<std::optional<int>> _fullCount;
 	rpl::event_stream<> _partLoaded;
+	rpl::event_stream<> _listChanged;
 	std::optional<MsgId> _loadingAround;
 	HistoryService *_divider = nullptr;
 	bool _dividerWithComments = false;
 	int _beforeId = 0;
 	int _afterId = 0;
 
+	rpl::lifetime _lifetime;
+
 };
 
 } // namespace Data
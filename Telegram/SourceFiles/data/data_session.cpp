@@ -29,6 +29,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/view/history_view_send_action.h"
 #include "inline_bots/inline_bot_layout_item.h"
 #include "storage/storage_account.h"
+#include "storage/storage_cache_hot_set.h"
 #include "storage/storage_encrypted_file.h"
 #include "media/player/media_player_instance.h" // instance()->play()
 #include "media/audio/media_audio.h"
@@ -56,6 +57,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_streaming.h"
 #include "data/data_media_rotation.h"
 #include "data/data_histories.h"
+#include "data/data_replies_list.h"
+#include "data/data_messages_index.h"
 #include "base/platform/base_platform_info.h"
 #include "base/unixtime.h"
 #include "base/call_delayed.h"
@@ -68,6 +71,11 @@ namespace {
 
 constexpr auto kMaxNotifyCheckDelay = 24 * 3600 * crl::time(1000);
 constexpr auto kMaxWallpaperSize = 10 * 1024 * 1024;
+constexpr auto kInactiveSendActionsDelay = crl::time(1000);
+constexpr auto kWebPagePreviewCacheTimeout = 10 * 60 * crl::time(1000);
+constexpr auto kWebPagePreviewCacheLimit = 128;
+constexpr auto kRecentRepliesListsLimit = 8;
+constexpr auto kUnloadHeavyPartsPages = 2;
 
 using ViewElement = HistoryView::Element;
 
@@ -213,6 +221,10 @@ Session::Session(not_null<Main::Session*> session)
 , _bigFileCache(Core::App().databases().get(
 	_session->local().cacheBigFilePath(),
 	_session->local().cacheBigFileSettings()))
+, _cacheHotSet(std::make_unique<Storage::CacheHotSet>())
+, _messagesIndex(cLocalMessagesIndex()
+	? std::make_unique<MessagesIndex>()
+	: nullptr)
 , _chatsList(
 	session,
 	FilterId(),
@@ -223,6 +235,7 @@ Session::Session(not_null<Main::Session*> session)
 , _sendActionsAnimation([=](crl::time now) {
 	return sendActionsAnimationCallback(now);
 })
+, _sendActionsInactiveTimer([=] { sendActionsInactiveCallback(); })
 , _pollsClosingTimer([=] { checkPollsClosings(); })
 , _unmuteByFinishedTimer([=] { unmuteByFinished(); })
 , _groups(this)
@@ -254,6 +267,16 @@ Session::Session(not_null<Main::Session*> session)
 		notifyUnreadBadgeChanged();
 	}, _lifetime);
 
+	Core::App().appDeactivatedValue(
+	) | rpl::filter([](bool deactivated) {
+		return !deactivated;
+	}) | rpl::start_with_next([=] {
+		if (_sendActionsInactiveTimer.isActive()) {
+			_sendActionsInactiveTimer.cancel();
+			_sendActionsAnimation.start();
+		}
+	}, _lifetime);
+
 	_chatsFilters->changed(
 	) | rpl::start_with_next([=] {
 		const auto enabled = !_chatsFilters->list().empty();
@@ -270,12 +293,15 @@ void Session::clear() {
 	Core::App().notifications().clearFromSession(_session);
 
 	_sendActions.clear();
+	_recentRepliesLists.clear();
 
 	_histories->unloadAll();
 	_scheduledMessages = nullptr;
 	_dependentMessages.clear();
 	base::take(_messages);
-	base::take(_channelMessages);
+	if (_messagesIndex) {
+		_messagesIndex->clear();
+	}
 	_messageByRandomId.clear();
 	_sentMessagesData.clear();
 	cSetRecentInlineBots(RecentInlineBots());
@@ -909,6 +935,28 @@ History *Session::historyLoaded(const PeerData *peer) {
 	return peer ? historyLoaded(peer->id) : nullptr;
 }
 
+std::shared_ptr<RepliesList> Session::repliesList(
+		not_null<History*> history,
+		MsgId rootId) {
+	const auto i = ranges::find_if(_recentRepliesLists, [&](
+			const std::shared_ptr<RepliesList> &list) {
+		return (list->history() == history) && (list->rootId() == rootId);
+	});
+	auto result = std::shared_ptr<RepliesList>();
+	if (i != end(_recentRepliesLists)) {
+		result = *i;
+		result->markNewestStale();
+		_recentRepliesLists.erase(i);
+	} else {
+		result = std::make_shared<RepliesList>(history, rootId);
+		if (int(_recentRepliesLists.size()) >= kRecentRepliesListsLimit) {
+			_recentRepliesLists.erase(begin(_recentRepliesLists));
+		}
+	}
+	_recentRepliesLists.push_back(result);
+	return result;
+}
+
 void Session::deleteConversationLocally(not_null<PeerData*> peer) {
 	const auto history = historyLoaded(peer);
 	if (history) {
@@ -983,7 +1031,9 @@ void Session::registerSendAction(
 		const auto i = _sendActions.find(std::pair{ history, rootId });
 		if (!_sendActions.contains(std::pair{ history, rootId })) {
 			_sendActions.emplace(std::pair{ history, rootId }, crl::now());
-			_sendActionsAnimation.start();
+			if (!_sendActionsInactiveTimer.isActive()) {
+				_sendActionsAnimation.start();
+			}
 		}
 	}
 }
@@ -1046,7 +1096,20 @@ bool Session::sendActionsAnimationCallback(crl::time now) {
 			i = _sendActions.erase(i);
 		}
 	}
-	return !_sendActions.empty();
+	if (_sendActions.empty()) {
+		return false;
+	} else if (Core::App().appDeactivated()) {
+		// Typing animations are not looked at, only expire them in time.
+		_sendActionsInactiveTimer.callOnce(kInactiveSendActionsDelay);
+		return false;
+	}
+	return true;
+}
+
+void Session::sendActionsInactiveCallback() {
+	if (sendActionsAnimationCallback(crl::now())) {
+		_sendActionsAnimation.start();
+	}
 }
 
 bool Session::chatsListLoaded(Data::Folder *folder) {
@@ -1097,6 +1160,14 @@ Storage::Cache::Database &Session::cacheBigFile() {
 	return *_bigFileCache;
 }
 
+Storage::CacheHotSet &Session::cacheHotSet() {
+	return *_cacheHotSet;
+}
+
+MessagesIndex *Session::messagesIndex() const {
+	return _messagesIndex.get();
+}
+
 void Session::suggestStartExport(TimeId availableAt) {
 	_exportAvailableAt = availableAt;
 	suggestStartExport();
@@ -1382,12 +1453,13 @@ rpl::producer<not_null<HistoryItem*>> Session::unreadItemAdded() const {
 }
 
 void Session::changeMessageId(ChannelId channel, MsgId wasId, MsgId nowId) {
-	const auto list = messagesListForInsert(channel);
-	auto i = list->find(wasId);
-	Assert(i != list->end());
+	auto i = _messages.find(FullMsgId(channel, wasId));
+	Assert(i != end(_messages));
 	auto owned = std::move(i->second);
-	list->erase(i);
-	const auto [j, ok] = list->emplace(nowId, std::move(owned));
+	_messages.erase(i);
+	const auto [j, ok] = _messages.emplace(
+		FullMsgId(channel, nowId),
+		std::move(owned));
 
 	Ensures(ok);
 }
@@ -1605,6 +1677,18 @@ void Session::unloadHeavyViewParts(
 	}
 }
 
+void Session::unloadHeavyViewPartsAround(
+		not_null<HistoryView::ElementDelegate*> delegate,
+		int visibleTop,
+		int visibleBottom) {
+	// Unload lottie animations.
+	const auto pages = kUnloadHeavyPartsPages;
+	const auto visibleHeight = (visibleBottom - visibleTop);
+	const auto from = visibleTop - pages * visibleHeight;
+	const auto till = visibleBottom + pages * visibleHeight;
+	unloadHeavyViewParts(delegate, from, till);
+}
+
 void Session::removeMegagroupParticipant(
 		not_null<ChannelData*> channel,
 		not_null<UserData*> user) {
@@ -1921,47 +2005,30 @@ void Session::processMessages(
 	processMessages(data.v, type);
 }
 
-const Session::Messages *Session::messagesList(ChannelId channelId) const {
-	if (channelId == NoChannel) {
-		return &_messages;
-	}
-	const auto i = _channelMessages.find(channelId);
-	return (i != end(_channelMessages)) ? &i->second : nullptr;
-}
-
-auto Session::messagesListForInsert(ChannelId channelId)
--> not_null<Messages*> {
-	return (channelId == NoChannel)
-		? &_messages
-		: &_channelMessages[channelId];
-}
-
 void Session::registerMessage(not_null<HistoryItem*> item) {
-	const auto list = messagesListForInsert(item->channelId());
-	const auto itemId = item->id;
-	const auto i = list->find(itemId);
-	if (i != list->end()) {
+	const auto itemId = FullMsgId(item->channelId(), item->id);
+	const auto i = _messages.find(itemId);
+	if (i != end(_messages)) {
 		LOG(("App Error: Trying to re-registerMessage()."));
 		i->second->destroy();
 	}
-	list->emplace(itemId, item);
+	_messages.emplace(itemId, item);
+	if (_messagesIndex) {
+		_messagesIndex->add(item);
+	}
 }
 
 void Session::processMessagesDeleted(
 		ChannelId channelId,
 		const QVector<MTPint> &data) {
-	const auto list = messagesList(channelId);
 	const auto affected = (channelId != NoChannel)
 		? historyLoaded(peerFromChannel(channelId))
 		: nullptr;
-	if (!list && !affected) {
-		return;
-	}
 
 	auto historiesToCheck = base::flat_set<not_null<History*>>();
 	for (const auto messageId : data) {
-		const auto i = list ? list->find(messageId.v) : Messages::iterator();
-		if (list && i != list->end()) {
+		const auto i = _messages.find(FullMsgId(channelId, messageId.v));
+		if (i != end(_messages)) {
 			const auto history = i->second->history();
 			i->second->destroy();
 			if (!history->chatListMessageKnown()) {
@@ -1997,7 +2064,10 @@ void Session::unregisterMessage(not_null<HistoryItem*> item) {
 		Data::MessageUpdate::Flag::Destroyed);
 	groups().unregisterMessage(item);
 	removeDependencyMessage(item);
-	messagesListForInsert(peerToChannel(peerId))->erase(item->id);
+	if (_messagesIndex) {
+		_messagesIndex->remove(item);
+	}
+	_messages.erase(FullMsgId(peerToChannel(peerId), item->id));
 }
 
 MsgId Session::nextLocalMessageId() {
@@ -2011,13 +2081,8 @@ HistoryItem *Session::message(ChannelId channelId, MsgId itemId) const {
 		return nullptr;
 	}
 
-	const auto data = messagesList(channelId);
-	if (!data) {
-		return nullptr;
-	}
-
-	const auto i = data->find(itemId);
-	return (i != data->end()) ? i->second.get() : nullptr;
+	const auto i = _messages.find(FullMsgId(channelId, itemId));
+	return (i != end(_messages)) ? i->second.get() : nullptr;
 }
 
 HistoryItem *Session::message(
@@ -2064,7 +2129,7 @@ void Session::registerMessageRandomId(uint64 randomId, FullMsgId itemId) {
 }
 
 void Session::unregisterMessageRandomId(uint64 randomId) {
-	_messageByRandomId.remove(randomId);
+	_messageByRandomId.erase(randomId);
 }
 
 FullMsgId Session::messageIdByRandomId(uint64 randomId) const {
@@ -2578,6 +2643,11 @@ not_null<DocumentData*> Session::document(DocumentId id) {
 	return i->second.get();
 }
 
+DocumentData *Session::documentLoaded(DocumentId id) const {
+	const auto i = _documents.find(id);
+	return (i != _documents.cend()) ? i->second.get() : nullptr;
+}
+
 not_null<DocumentData*> Session::processDocument(const MTPDocument &data) {
 	return data.match([&](const MTPDdocument &data) {
 		return processDocument(data);
@@ -2798,6 +2868,36 @@ void Session::documentApplyFields(
 	}
 }
 
+std::optional<WebPageId> Session::webpagePreviewCached(
+		const QString &links) const {
+	const auto i = _webpagePreviews.find(links);
+	if (i == end(_webpagePreviews)
+		|| crl::now() - i->second.second >= kWebPagePreviewCacheTimeout) {
+		return std::nullopt;
+	}
+	return i->second.first;
+}
+
+void Session::webpagePreviewRemember(const QString &links, WebPageId id) {
+	const auto now = crl::now();
+	if (int(_webpagePreviews.size()) >= kWebPagePreviewCacheLimit) {
+		for (auto i = begin(_webpagePreviews); i != end(_webpagePreviews);) {
+			if (now - i->second.second >= kWebPagePreviewCacheTimeout) {
+				i = _webpagePreviews.erase(i);
+			} else {
+				++i;
+			}
+		}
+		if (int(_webpagePreviews.size()) >= kWebPagePreviewCacheLimit) {
+			_webpagePreviews.erase(ranges::min_element(
+				_webpagePreviews,
+				ranges::less(),
+				[](const auto &entry) { return entry.second.second; }));
+		}
+	}
+	_webpagePreviews[links] = std::make_pair(id, now);
+}
+
 not_null<WebPageData*> Session::webpage(WebPageId id) {
 	auto i = _webpages.find(id);
 	if (i == _webpages.cend()) {
@@ -3524,7 +3624,12 @@ void Session::sendWebPageGamePollNotifications() {
 	for (const auto poll : base::take(_pollsUpdated)) {
 		if (const auto i = _pollViews.find(poll); i != _pollViews.end()) {
 			for (const auto view : i->second) {
-				requestViewResize(view);
+				const auto media = view->media();
+				if (media && media->updateInPlace()) {
+					requestViewRepaint(view);
+				} else {
+					requestViewResize(view);
+				}
 			}
 		}
 	}
@@ -4065,6 +4170,7 @@ int32 Session::wallpapersHash() const {
 }
 
 void Session::clearLocalStorage() {
+	_cacheHotSet->clear();
 	_cache->close();
 	_cache->clear();
 	_bigFileCache->close();
@@ -42,6 +42,10 @@ namespace Ui {
 class BoxContent;
 } // namespace Ui
 
+namespace Storage {
+class CacheHotSet;
+} // namespace Storage
+
 namespace Passport {
 struct SavedCredentials;
 } // namespace Passport
@@ -54,9 +58,11 @@ class WallPaper;
 class ScheduledMessages;
 class ChatFilters;
 class CloudThemes;
+class MessagesIndex;
 class Streaming;
 class MediaRotation;
 class Histories;
+class RepliesList;
 class DocumentMedia;
 class PhotoMedia;
 class Stickers;
@@ -126,6 +132,10 @@ public:
 
 	[[nodiscard]] Storage::Cache::Database &cache();
 	[[nodiscard]] Storage::Cache::Database &cacheBigFile();
+	[[nodiscard]] Storage::CacheHotSet &cacheHotSet();
+
+	// nullptr if the local messages index is disabled.
+	[[nodiscard]] MessagesIndex *messagesIndex() const;
 
 	[[nodiscard]] not_null<PeerData*> peer(PeerId id);
 	[[nodiscard]] not_null<PeerData*> peer(UserId id) = delete;
@@ -186,6 +196,11 @@ public:
 	[[nodiscard]] not_null<History*> history(not_null<const PeerData*> peer);
 	[[nodiscard]] History *historyLoaded(const PeerData *peer);
 
+	// Recently opened threads are kept alive for a quick reopen.
+	[[nodiscard]] std::shared_ptr<RepliesList> repliesList(
+		not_null<History*> history,
+		MsgId rootId);
+
 	void deleteConversationLocally(not_null<PeerData*> peer);
 
 	void cancelForwarding(not_null<History*> history);
@@ -274,6 +289,12 @@ public:
 		int from,
 		int till);
 
+	// Keeps the heavy parts only for a few screens around the visible one.
+	void unloadHeavyViewPartsAround(
+		not_null<HistoryView::ElementDelegate*> delegate,
+		int visibleTop,
+		int visibleBottom);
+
 	using MegagroupParticipant = std::tuple<
 		not_null<ChannelData*>,
 		not_null<UserData*>>;
@@ -453,6 +474,7 @@ public:
 		const ImageLocation &thumbnailLocation);
 
 	[[nodiscard]] not_null<DocumentData*> document(DocumentId id);
+	[[nodiscard]] DocumentData *documentLoaded(DocumentId id) const;
 	not_null<DocumentData*> processDocument(const MTPDocument &data);
 	not_null<DocumentData*> processDocument(const MTPDdocument &data);
 	not_null<DocumentData*> processDocument(
@@ -501,6 +523,12 @@ public:
 		const QString &author,
 		TimeId pendingTill);
 
+	// Results of messages.getWebPagePreview by the links text,
+	// zero id if there is no preview for them.
+	[[nodiscard]] std::optional<WebPageId> webpagePreviewCached(
+		const QString &links) const;
+	void webpagePreviewRemember(const QString &links, WebPageId id);
+
 	[[nodiscard]] not_null<GameData*> game(GameId id);
 	not_null<GameData*> processGame(const MTPDgame &data);
 	[[nodiscard]] not_null<GameData*> game(
@@ -671,7 +699,7 @@ public:
 	void clearLocalStorage();
 
 private:
-	using Messages = std::unordered_map<MsgId, not_null<HistoryItem*>>;
+	using Messages = std::unordered_map<FullMsgId, not_null<HistoryItem*>>;
 
 	void suggestStartExport();
 
@@ -690,8 +718,6 @@ private:
 		Data::Folder *requestFolder,
 		const MTPDdialogFolder &data);
 
-	const Messages *messagesList(ChannelId channelId) const;
-	not_null<Messages*> messagesListForInsert(ChannelId channelId);
 	not_null<HistoryItem*> registerMessage(
 		std::unique_ptr<HistoryItem> item);
 	void changeMessageId(ChannelId channel, MsgId wasId, MsgId nowId);
@@ -798,6 +824,7 @@ private:
 		TimeId date);
 
 	bool sendActionsAnimationCallback(crl::time now);
+	void sendActionsInactiveCallback();
 	[[nodiscard]] SendActionPainter *lookupSendActionPainter(
 		not_null<History*> history,
 		MsgId rootId);
@@ -810,6 +837,8 @@ private:
 
 	Storage::DatabasePointer _cache;
 	Storage::DatabasePointer _bigFileCache;
+	std::unique_ptr<Storage::CacheHotSet> _cacheHotSet;
+	std::unique_ptr<MessagesIndex> _messagesIndex;
 
 	TimeId _exportAvailableAt = 0;
 	QPointer<Ui::BoxContent> _exportSuggestion;
@@ -849,12 +878,11 @@ private:
 
 	MsgId _localMessageIdCounter = StartClientMsgId;
 	Messages _messages;
-	std::map<ChannelId, Messages> _channelMessages;
-	std::map<
+	std::unordered_map<
 		not_null<HistoryItem*>,
 		base::flat_set<not_null<HistoryItem*>>> _dependentMessages;
 
-	base::flat_map<uint64, FullMsgId> _messageByRandomId;
+	std::unordered_map<uint64, FullMsgId> _messageByRandomId;
 	base::flat_map<uint64, SentData> _sentMessagesData;
 
 	base::Timer _selfDestructTimer;
@@ -865,6 +893,7 @@ private:
 		std::pair<not_null<History*>, MsgId>,
 		crl::time> _sendActions;
 	Ui::Animations::Basic _sendActionsAnimation;
+	base::Timer _sendActionsInactiveTimer;
 
 	std::unordered_map<
 		PhotoId,
@@ -887,6 +916,9 @@ private:
 	std::unordered_map<
 		not_null<const WebPageData*>,
 		base::flat_set<not_null<ViewElement*>>> _webpageViews;
+	base::flat_map<
+		QString,
+		std::pair<WebPageId, crl::time>> _webpagePreviews;
 	std::unordered_map<
 		LocationPoint,
 		std::unique_ptr<Data::CloudImage>> _locations;
@@ -972,6 +1004,7 @@ private:
 		base::flat_map<
 			MsgId,
 			std::weak_ptr<SendActionPainter>>> _sendActionPainters;
+	std::vector<std::shared_ptr<RepliesList>> _recentRepliesLists;
 	std::unique_ptr<Stickers> _stickers;
 	MsgId _nonHistoryEntryId = ServerMaxMsgId;
 
@@ -205,6 +205,30 @@ bool SparseIdsSliceBuilder::applyUpdate(
 	auto skippedAfter = (update.range.till == ServerMaxMsgId)
 		? 0
 		: std::optional<int> {};
+	if (needMergeMessages && _key) {
+		// Don't copy the whole (possibly huge) slice, only the ids that
+		// can survive sliceToLimits() around our key.
+		const auto &all = *update.messages;
+		const auto around = ranges::lower_bound(all, _key);
+		const auto from = around
+			- std::min(int(around - all.begin()), _limitBefore);
+		const auto till = around
+			+ std::min(int(all.end() - around), _limitAfter + 1);
+		if (from < till && (from != all.begin() || till != all.end())) {
+			if (skippedBefore) {
+				*skippedBefore += int(from - all.begin());
+			}
+			if (skippedAfter) {
+				*skippedAfter += int(all.end() - till);
+			}
+			mergeSliceData(
+				update.count,
+				base::flat_set<MsgId>(from, till),
+				skippedBefore,
+				skippedAfter);
+			return true;
+		}
+	}
 	mergeSliceData(
 		update.count,
 		needMergeMessages
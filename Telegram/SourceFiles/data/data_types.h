@@ -48,6 +48,7 @@ struct UploadState {
 
 Storage::Cache::Key DocumentCacheKey(int32 dcId, uint64 id);
 Storage::Cache::Key DocumentThumbCacheKey(int32 dcId, uint64 id);
+Storage::Cache::Key DocumentWaveformCacheKey(int32 dcId, uint64 id);
 Storage::Cache::Key WebDocumentCacheKey(const WebFileLocation &location);
 Storage::Cache::Key UrlCacheKey(const QString &location);
 Storage::Cache::Key GeoPointCacheKey(const GeoPointLocation &location);
@@ -252,6 +253,19 @@ struct FullMsgId {
 
 Q_DECLARE_METATYPE(FullMsgId);
 
+namespace std {
+
+template<>
+struct hash<FullMsgId> {
+	size_t operator()(FullMsgId value) const {
+		return hash<uint64>()((uint64(uint32(value.channel)) << 32)
+			| uint64(uint32(value.msg)));
+	}
+
+};
+
+} // namespace std
+
 using MessageIdsList = std::vector<FullMsgId>;
 
 PeerId PeerFromMessage(const MTPmessage &message);
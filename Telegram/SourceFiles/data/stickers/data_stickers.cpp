@@ -25,6 +25,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/toast/toast.h"
 #include "ui/image/image_location_factory.h"
 #include "base/unixtime.h"
+#include "base/flat_set.h"
 #include "styles/style_chat_helpers.h"
 
 namespace Data {
@@ -950,13 +951,12 @@ std::vector<not_null<DocumentData*>> Stickers::getListByEmoji(
 		TimeId date = 0;
 	};
 	auto result = std::vector<StickerWithDate>();
+	auto added = base::flat_set<not_null<DocumentData*>>();
 	auto &sets = setsRef();
 	auto setsToRequest = base::flat_map<uint64, uint64>();
 
 	const auto add = [&](not_null<DocumentData*> document, TimeId date) {
-		if (ranges::find(result, document, [](const StickerWithDate &data) {
-			return data.document;
-		}) == result.end()) {
+		if (added.emplace(document).second) {
 			result.push_back({ document, date });
 		}
 	};
@@ -1013,22 +1013,25 @@ std::vector<not_null<DocumentData*>> Stickers::getListByEmoji(
 		const auto recent = recentIt->second.get();
 		auto i = recent->emoji.constFind(original);
 		if (i != recent->emoji.cend()) {
+			auto dates = base::flat_map<not_null<DocumentData*>, TimeId>();
+			if (!recent->dates.empty()) {
+				Assert(recent->stickers.size() <= recent->dates.size());
+				dates.reserve(recent->stickers.size());
+				for (auto j = 0; j != recent->stickers.size(); ++j) {
+					dates.emplace(recent->stickers[j], recent->dates[j]);
+				}
+			}
 			result.reserve(i->size());
+			added.reserve(i->size());
 			for (const auto document : *i) {
-				const auto usageDate = [&] {
-					if (recent->dates.empty()) {
-						return TimeId(0);
-					}
-					const auto index = recent->stickers.indexOf(document);
-					if (index < 0) {
-						return TimeId(0);
-					}
-					Assert(index < recent->dates.size());
-					return recent->dates[index];
-				}();
+				const auto j = dates.find(document);
+				const auto usageDate = (j != end(dates))
+					? j->second
+					: TimeId(0);
 				const auto date = usageDate
 					? usageDate
 					: InstallDate(document);
+				added.emplace(document);
 				result.push_back({
 					document,
 					date ? date : CreateRecentSortKey(document) });
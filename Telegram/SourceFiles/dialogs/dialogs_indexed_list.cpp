@@ -12,6 +12,45 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/history.h"
 
 namespace Dialogs {
+namespace {
+
+[[nodiscard]] bool MatchesWords(
+		not_null<Row*> row,
+		const QStringList &words) {
+	const auto &nameWords = row->entry()->chatListNameWords();
+	const auto found = [&](const QString &word) {
+		for (const auto &name : nameWords) {
+			if (name.startsWith(word)) {
+				return true;
+			}
+		}
+		return false;
+	};
+	for (const auto &word : words) {
+		if (!found(word)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+// Each word of the previous query is a prefix of some word of the new
+// one, so every row matching the new query matches the previous one.
+[[nodiscard]] bool IsNarrowing(
+		const QStringList &was,
+		const QStringList &now) {
+	for (const auto &wasWord : was) {
+		const auto extended = ranges::any_of(now, [&](const QString &word) {
+			return word.startsWith(wasWord);
+		});
+		if (!extended) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
 
 IndexedList::IndexedList(SortMode sortMode, FilterId filterId)
 : _sortMode(sortMode)
@@ -24,6 +63,7 @@ RowsByLetter IndexedList::addToEnd(Key key) {
 	if (const auto row = _list.getRow(key)) {
 		return { row };
 	}
+	invalidateFiltered();
 
 	auto result = RowsByLetter{ _list.addToEnd(key) };
 	for (const auto ch : key.entry()->chatListFirstLetters()) {
@@ -40,6 +80,7 @@ Row *IndexedList::addByName(Key key) {
 	if (const auto row = _list.getRow(key)) {
 		return row;
 	}
+	invalidateFiltered();
 
 	const auto result = _list.addByName(key);
 	for (const auto ch : key.entry()->chatListFirstLetters()) {
@@ -53,6 +94,7 @@ Row *IndexedList::addByName(Key key) {
 }
 
 void IndexedList::adjustByDate(const RowsByLetter &links) {
+	invalidateFiltered();
 	_list.adjustByDate(links.main);
 	for (const auto [ch, row] : links.letters) {
 		if (auto it = _index.find(ch); it != _index.cend()) {
@@ -63,6 +105,7 @@ void IndexedList::adjustByDate(const RowsByLetter &links) {
 
 void IndexedList::moveToTop(Key key) {
 	if (_list.moveToTop(key)) {
+		invalidateFiltered();
 		for (const auto ch : key.entry()->chatListFirstLetters()) {
 			if (auto it = _index.find(ch); it != _index.cend()) {
 				it->second.moveToTop(key);
@@ -91,6 +134,7 @@ void IndexedList::peerNameChanged(
 		const base::flat_set<QChar> &oldLetters) {
 	Expects(_sortMode != SortMode::Date);
 
+	invalidateFiltered();
 	if (const auto history = peer->owner().historyLoaded(peer)) {
 		if (_sortMode == SortMode::Name) {
 			adjustByName(history, oldLetters);
@@ -106,6 +150,7 @@ void IndexedList::peerNameChanged(
 		const base::flat_set<QChar> &oldLetters) {
 	Expects(_sortMode == SortMode::Date);
 
+	invalidateFiltered();
 	if (const auto history = peer->owner().historyLoaded(peer)) {
 		adjustNames(filterId, history, oldLetters);
 	}
@@ -188,6 +233,7 @@ void IndexedList::adjustNames(
 
 void IndexedList::del(Key key, Row *replacedBy) {
 	if (_list.del(key, replacedBy)) {
+		invalidateFiltered();
 		for (const auto ch : key.entry()->chatListFirstLetters()) {
 			if (auto it = _index.find(ch); it != _index.cend()) {
 				it->second.del(key, replacedBy);
@@ -197,11 +243,30 @@ void IndexedList::del(Key key, Row *replacedBy) {
 }
 
 void IndexedList::clear() {
+	invalidateFiltered();
 	_index.clear();
 }
 
+void IndexedList::invalidateFiltered() {
+	_filteredWords.clear();
+	_filteredRows.clear();
+}
+
 std::vector<not_null<Row*>> IndexedList::filtered(
 		const QStringList &words) const {
+	if (!_filteredWords.isEmpty() && IsNarrowing(_filteredWords, words)) {
+		auto result = std::vector<not_null<Row*>>();
+		result.reserve(_filteredRows.size());
+		for (const auto row : _filteredRows) {
+			if (MatchesWords(row, words)) {
+				result.push_back(row);
+			}
+		}
+		_filteredWords = words;
+		_filteredRows = result;
+		return result;
+	}
+
 	const auto minimal = [&]() -> const Dialogs::List* {
 		if (empty()) {
 			return nullptr;
@@ -221,32 +286,16 @@ std::vector<not_null<Row*>> IndexedList::filtered(
 		return result;
 	}();
 	auto result = std::vector<not_null<Row*>>();
-	if (!minimal || minimal->empty()) {
-		return result;
-	}
-	result.reserve(minimal->size());
-	for (const auto row : *minimal) {
-		const auto &nameWords = row->entry()->chatListNameWords();
-		const auto found = [&](const QString &word) {
-			for (const auto &name : nameWords) {
-				if (name.startsWith(word)) {
-					return true;
-				}
-			}
-			return false;
-		};
-		const auto allFound = [&] {
-			for (const auto &word : words) {
-				if (!found(word)) {
-					return false;
-				}
+	if (minimal && !minimal->empty()) {
+		result.reserve(minimal->size());
+		for (const auto row : *minimal) {
+			if (MatchesWords(row, words)) {
+				result.push_back(row);
 			}
-			return true;
-		}();
-		if (allFound) {
-			result.push_back(row);
 		}
 	}
+	_filteredWords = words;
+	_filteredRows = result;
 	return result;
 }
 
@@ -79,12 +79,17 @@ private:
 		FilterId filterId,
 		not_null<History*> history,
 		const base::flat_set<QChar> &oldChars);
+	void invalidateFiltered();
 
 	SortMode _sortMode = SortMode();
 	FilterId _filterId = 0;
 	List _list, _empty;
 	base::flat_map<QChar, List> _index;
 
+	// Last filtered(words) result, narrowed while the query is typed.
+	mutable QStringList _filteredWords;
+	mutable std::vector<not_null<Row*>> _filteredRows;
+
 };
 
 } // namespace Dialogs
@@ -16,6 +16,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/history_item.h"
 #include "core/shortcuts.h"
 #include "core/application.h"
+#include "core/startup_trace.h"
+#include "core/paint_stats.h"
 #include "ui/widgets/buttons.h"
 #include "ui/widgets/popup_menu.h"
 #include "ui/text/text_utilities.h"
@@ -430,6 +432,11 @@ void InnerWidget::paintEvent(QPaintEvent *e) {
 	if (App::wnd()->contentOverlapped(this, r)) {
 		return;
 	}
+	const auto stats = Core::PaintStats::Span("Dialogs::InnerWidget");
+	if (Core::StartupTrace::Enabled()) {
+		Core::StartupTrace::Mark("Dialogs::InnerWidget first paint");
+		Core::StartupTrace::Finish();
+	}
 	const auto activeEntry = _controller->activeChatEntryCurrent();
 	auto fullWidth = width();
 	auto dialogsClip = r;
@@ -2153,6 +2160,23 @@ bool InnerWidget::searchReceived(
 	return lastDateFound != 0;
 }
 
+void InnerWidget::localSearchReceived(
+		const std::vector<not_null<HistoryItem*>> &items) {
+	const auto uniquePeers = uniqueSearchResults();
+	clearSearchResults(false);
+	for (const auto item : items) {
+		const auto history = item->history();
+		if (!uniquePeers || !hasHistoryInResults(history)) {
+			_searchResults.push_back(
+				std::make_unique<FakeRow>(
+					_searchInChat,
+					item));
+		}
+	}
+	_searchedCount = _searchResults.size();
+	refresh();
+}
+
 void InnerWidget::peerSearchReceived(
 		const QString &query,
 		const QVector<MTPPeer> &my,
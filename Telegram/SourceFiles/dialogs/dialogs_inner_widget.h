@@ -73,6 +73,9 @@ public:
 		HistoryItem *inject,
 		SearchRequestType type,
 		int fullCount);
+	// Shown until the first page of the server results is received.
+	void localSearchReceived(
+		const std::vector<not_null<HistoryItem*>> &items);
 	void peerSearchReceived(
 		const QString &query,
 		const QVector<MTPPeer> &my,
@@ -127,3 +127,15 @@ struct EntryState {
 };
 
 } // namespace Dialogs
+
+namespace std {
+
+template <>
+struct hash<Dialogs::Key> {
+	size_t operator()(const Dialogs::Key &key) const {
+		return hash<Dialogs::Entry*>()(key.entry());
+	}
+
+};
+
+} // namespace std
@@ -37,6 +37,7 @@ namespace {
 
 // Show all dates that are in the last 20 hours in time format.
 constexpr int kRecentlyInSeconds = 20 * 3600;
+constexpr auto kRowDateTextCacheLimit = 1024;
 const auto kPsaBadgePrefix = "cloud_lng_badge_psa_";
 
 [[nodiscard]] bool ShowUserBotIcon(not_null<UserData*> user) {
@@ -57,16 +58,47 @@ void PaintRowTopRight(Painter &p, const QString &text, QRect &rectForName, bool
 	p.drawText(rectForName.left() + rectForName.width() + st::dialogsDateSkip, rectForName.top() + st::msgNameFont->height - st::msgDateFont->descent, text);
 }
 
-void PaintRowDate(Painter &p, QDateTime date, QRect &rectForName, bool active, bool selected) {
+struct RowDateText {
+	QString text;
+	qint64 validTill = 0;
+};
+
+[[nodiscard]] QString ComputeRowDateText(QDateTime date) {
+	static auto Cache = base::flat_map<qint64, RowDateText>();
+	static auto CacheTimeFormat = QString();
+	static auto CacheLanguageId = QString();
+
+	const auto nowSecs = QDateTime::currentSecsSinceEpoch();
+	if (CacheTimeFormat != cTimeFormat()
+		|| CacheLanguageId != Lang::Id()
+		|| Cache.size() > kRowDateTextCacheLimit) {
+		Cache.clear();
+		CacheTimeFormat = cTimeFormat();
+		CacheLanguageId = Lang::Id();
+	}
+	const auto key = date.toSecsSinceEpoch();
+	const auto i = Cache.find(key);
+	if (i != end(Cache) && i->second.validTill > nowSecs) {
+		return i->second.text;
+	}
+
 	const auto now = QDateTime::currentDateTime();
 	const auto &lastTime = date;
 	const auto nowDate = now.date();
 	const auto lastDate = lastTime.date();
 
+	// The text may change only at midnight or when the date stops
+	// being recent, so it is reused until then.
+	auto validTill = QDateTime(
+		nowDate.addDays(1),
+		QTime(0, 0)).toSecsSinceEpoch();
 	const auto dt = [&] {
 		const auto wasSameDay = (lastDate == nowDate);
 		const auto wasRecently = qAbs(lastTime.secsTo(now)) < kRecentlyInSeconds;
 		if (wasSameDay || wasRecently) {
+			if (!wasSameDay && key + kRecentlyInSeconds > nowSecs) {
+				validTill = std::min(validTill, key + kRecentlyInSeconds);
+			}
 			return lastTime.toString(cTimeFormat());
 		} else if (lastDate.year() == nowDate.year()
 			&& lastDate.weekNumber() == nowDate.weekNumber()) {
@@ -75,7 +107,12 @@ void PaintRowDate(Painter &p, QDateTime date, QRect &rectForName, bool active, b
 			return lastDate.toString(qsl("d.MM.yy"));
 		}
 	}();
-	PaintRowTopRight(p, dt, rectForName, active, selected);
+	Cache[key] = RowDateText{ dt, validTill };
+	return dt;
+}
+
+void PaintRowDate(Painter &p, QDateTime date, QRect &rectForName, bool active, bool selected) {
+	PaintRowTopRight(p, ComputeRowDateText(date), rectForName, active, selected);
 }
 
 void PaintNarrowCounter(
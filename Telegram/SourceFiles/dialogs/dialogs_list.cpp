@@ -86,19 +86,21 @@ void List::adjustByName(not_null<Row*> row) {
 void List::adjustByDate(not_null<Row*> row) {
 	Expects(_sortMode == SortMode::Date);
 
+	// All the other rows are sorted by sortKey, so we can binary search.
 	const auto key = row->sortKey(_filterId);
 	const auto index = row->pos();
 	const auto i = _rows.begin() + index;
-	const auto before = std::find_if(i + 1, _rows.end(), [&](Row *row) {
-		return (row->sortKey(_filterId) <= key);
+	const auto before = std::partition_point(i + 1, _rows.end(), [&](
+			not_null<Row*> row) {
+		return (row->sortKey(_filterId) > key);
 	});
 	if (before != i + 1) {
 		rotate(i, i + 1, before);
 	} else {
-		const auto from = std::make_reverse_iterator(i);
-		const auto after = std::find_if(from, _rows.rend(), [&](Row *row) {
+		const auto after = std::partition_point(_rows.begin(), i, [&](
+				not_null<Row*> row) {
 			return (row->sortKey(_filterId) >= key);
-		}).base();
+		});
 		if (after != i) {
 			rotate(after, i, i + 1);
 		}
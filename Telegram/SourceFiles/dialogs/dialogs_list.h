@@ -80,7 +80,7 @@ private:
 	SortMode _sortMode = SortMode();
 	FilterId _filterId = 0;
 	std::vector<not_null<Row*>> _rows;
-	std::map<Key, std::unique_ptr<Row>> _rowByKey;
+	std::unordered_map<Key, std::unique_ptr<Row>> _rowByKey;
 
 };
 
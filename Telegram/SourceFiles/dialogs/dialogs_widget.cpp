@@ -43,6 +43,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_folder.h"
 #include "data/data_histories.h"
 #include "data/data_changes.h"
+#include "data/data_messages_index.h"
 #include "facades.h"
 #include "app.h"
 #include "styles/style_dialogs.h"
@@ -826,6 +827,7 @@ bool Widget::onSearchMessages(bool searchCache) {
 		_searchNextRate = 0;
 		_searchFull = _searchFullMigrated = false;
 		cancelSearchRequest();
+		showLocalSearchResults();
 		if (const auto peer = _searchInChat.peer()) {
 			auto &histories = session().data().histories();
 			const auto type = Data::Histories::RequestType::History;
@@ -950,6 +952,7 @@ bool Widget::searchForPeersRequired(const QString &query) const {
 
 void Widget::onNeedSearchMessages() {
 	if (!onSearchMessages(true)) {
+		cancelStaleSearchRequests(_filter->getLastText().trimmed());
 		_searchTimer.start(AutoSearchTimeout);
 	}
 }
@@ -1777,6 +1780,37 @@ void Widget::cancelSearchRequest() {
 		base::take(_searchInHistoryRequest));
 }
 
+void Widget::cancelStaleSearchRequests(const QString &query) {
+	// Don't wait for the search timer, results for the previous query
+	// would be shown in the meantime and waste the connection.
+	if ((_searchRequest || _searchInHistoryRequest) && _searchQuery != query) {
+		_searchQueries.remove(_searchRequest);
+		cancelSearchRequest();
+		_searchQuery = QString();
+		_searchFull = _searchFullMigrated = true;
+	}
+	const auto peerQuery = Api::ConvertPeerSearchQuery(query);
+	if (_peerSearchRequest && _peerSearchQuery != peerQuery) {
+		_peerSearchQueries.remove(_peerSearchRequest);
+		_api.request(base::take(_peerSearchRequest)).cancel();
+		_peerSearchQuery = QString();
+	}
+}
+
+void Widget::showLocalSearchResults() {
+	const auto index = session().data().messagesIndex();
+	if (!index || _searchQueryFrom || _searchQuery.isEmpty()) {
+		return;
+	}
+	const auto items = index->search(
+		_searchQuery,
+		_searchInChat.peer(),
+		SearchPerPage);
+	if (!items.empty()) {
+		_inner->localSearchReceived(items);
+	}
+}
+
 bool Widget::onCancelSearch() {
 	bool clearing = !_filter->getLastText().isEmpty();
 	cancelSearchRequest();
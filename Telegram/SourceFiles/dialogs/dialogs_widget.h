@@ -136,6 +136,8 @@ private:
 		mtpRequestId requestId);
 	void escape();
 	void cancelSearchRequest();
+	void cancelStaleSearchRequests(const QString &query);
+	void showLocalSearchResults();
 
 	void setupSupportMode();
 	void setupConnectingWidget();
@@ -11,11 +11,17 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "export/data/export_data_types.h"
 #include "export/output/export_output_result.h"
 #include "export/output/export_output_file.h"
+#include "export/output/export_output_abstract.h"
 #include "mtproto/mtproto_rpc_sender.h"
 #include "base/value_ordering.h"
+#include "base/call_delayed.h"
 #include "base/bytes.h"
 #include <set>
 #include <deque>
+#include <list>
+
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
 
 namespace Export {
 namespace {
@@ -23,12 +29,13 @@ namespace {
 constexpr auto kUserpicsSliceLimit = 100;
 constexpr auto kFileChunkSize = 128 * 1024;
 constexpr auto kFileRequestsCount = 2;
+constexpr auto kMessageFilesParallel = 4;
 constexpr auto kFileNextRequestDelay = crl::time(20);
 constexpr auto kChatsSliceLimit = 100;
 constexpr auto kMessagesSliceLimit = 100;
 constexpr auto kTopPeerSliceLimit = 100;
 constexpr auto kFileMaxSize = 2000 * 1024 * 1024;
-constexpr auto kLocationCacheSize = 100'000;
+constexpr auto kLocationCacheBytes = 16 * 1024 * 1024;
 
 struct LocationKey {
 	uint64 type;
@@ -119,15 +126,38 @@ class ApiWrap::LoadedFileCache {
 public:
 	using Location = Data::FileLocation;
 
-	LoadedFileCache(int limit);
+	explicit LoadedFileCache(int64 limit);
+
+	// Reuses the files listed in the folder manifest if it was written
+	// for the same settings and appends to it, otherwise starts a new one.
+	void restore(const Settings &settings);
+	void finish();
 
 	void save(const Location &location, const QString &relativePath);
-	std::optional<QString> find(const Location &location) const;
+	std::optional<QString> find(const Location &location);
+
+	// Messages up to this id were written by the previous export.
+	[[nodiscard]] int32 lastMessageId(Data::PeerId peerId, int split) const;
+	void saveLastMessageId(Data::PeerId peerId, int split, int32 id);
 
 private:
-	int _limit = 0;
-	std::map<LocationKey, QString> _map;
-	std::deque<LocationKey> _list;
+	struct Entry {
+		QString relativePath;
+		std::list<LocationKey>::iterator usage;
+	};
+
+	void remember(const LocationKey &key, const QString &relativePath);
+	bool restoreMessageId(const QStringList &parts, const QString &type);
+	void restoreMessageIds(const QString &folder);
+	[[nodiscard]] static int64 EntryBytes(const QString &relativePath);
+
+	int64 _limit = 0;
+	int64 _bytes = 0;
+	std::map<LocationKey, Entry> _map;
+	std::list<LocationKey> _usage; // Least recently used first.
+	std::map<std::pair<Data::PeerId, int>, int32> _lastMessageIds;
+	QString _folder;
+	std::unique_ptr<QFile> _manifest;
 
 };
 
@@ -180,6 +210,9 @@ struct ApiWrap::FileProcess {
 	Fn<bool(FileProgress)> progress;
 	FnMut<void(const QString &relativePath)> done;
 
+	// Other messages with the same file, waiting for this download.
+	std::vector<FnMut<void(const QString &relativePath)>> waiters;
+
 	Data::FileLocation location;
 	Data::FileOrigin origin;
 	int offset = 0;
@@ -192,9 +225,17 @@ struct ApiWrap::FileProcess {
 	std::deque<Request> requests;
 };
 
+struct ApiWrap::FileLookup {
+	Data::File file;
+	Data::FileOrigin origin;
+	Fn<bool(FileProgress)> progress;
+	FnMut<void(QString)> done;
+};
+
 struct ApiWrap::FileProgress {
 	int ready = 0;
 	int total = 0;
+	QString relativePath;
 };
 
 struct ApiWrap::ChatsProcess {
@@ -236,6 +277,8 @@ struct ApiWrap::ChatProcess {
 	std::optional<Data::MessagesSlice> slice;
 	bool lastSlice = false;
 	int fileIndex = 0;
+	int filesLoading = 0;
+	bool thumbPending = false;
 };
 
 
@@ -254,6 +297,7 @@ public:
 		FnMut<void(Response &&)> &&handler);
 	[[nodiscard]] RequestBuilder &fail(
 		FnMut<bool(const RPCError &)> &&handler);
+	[[nodiscard]] RequestBuilder &handleFloodErrors();
 
 	mtpRequestId send();
 
@@ -308,6 +352,13 @@ auto ApiWrap::RequestBuilder<Request>::fail(
 	return *this;
 }
 
+template <typename Request>
+auto ApiWrap::RequestBuilder<Request>::handleFloodErrors()
+-> RequestBuilder& {
+	auto &silence_warning = _builder.handleFloodErrors();
+	return *this;
+}
+
 template <typename Request>
 mtpRequestId ApiWrap::RequestBuilder<Request>::send() {
 	return _commonFailHandler
@@ -315,10 +366,130 @@ mtpRequestId ApiWrap::RequestBuilder<Request>::send() {
 		: _builder.send();
 }
 
-ApiWrap::LoadedFileCache::LoadedFileCache(int limit) : _limit(limit) {
+ApiWrap::LoadedFileCache::LoadedFileCache(int64 limit) : _limit(limit) {
 	Expects(limit >= 0);
 }
 
+void ApiWrap::LoadedFileCache::restore(const Settings &settings) {
+	const auto &folder = settings.path;
+	_folder = folder;
+	_manifest = std::make_unique<QFile>(Output::ManifestPath(folder));
+	const auto resume = Output::CanResumeFromManifest(folder, settings);
+	if (resume && _manifest->open(QIODevice::ReadOnly)) {
+		auto restored = 0;
+		while (!_manifest->atEnd()) {
+			const auto line = QString::fromUtf8(
+				_manifest->readLine()).trimmed();
+			const auto parts = line.split(' ');
+			if (restoreMessageId(parts, "since")
+				|| parts.size() < 5
+				|| parts[0] != "file") {
+				continue;
+			}
+			const auto key = LocationKey{
+				parts[1].toULongLong(),
+				parts[2].toULongLong()
+			};
+			const auto size = parts[3].toLongLong();
+			const auto relativePath = QStringList(
+				parts.mid(4)).join(' ');
+			const auto info = QFileInfo(folder + relativePath);
+			if (info.isFile() && info.size() == size) {
+				remember(key, relativePath);
+				++restored;
+			}
+		}
+		_manifest->close();
+		if (restored) {
+			LOG(("Export Info: Reusing %1 files from %2."
+				).arg(restored
+				).arg(folder));
+		}
+	} else if (!resume && settings.onlyNewMessages) {
+		restoreMessageIds(Output::FindPreviousExport(folder, settings));
+	}
+	const auto mode = resume
+		? (QIODevice::WriteOnly | QIODevice::Append)
+		: (QIODevice::WriteOnly | QIODevice::Truncate);
+	if (!QDir().mkpath(folder) || !_manifest->open(mode)) {
+		LOG(("Export Error: Could not open manifest in %1.").arg(folder));
+		_manifest = nullptr;
+	} else if (!resume) {
+		_manifest->write(Output::ManifestSettingsLine(settings) + '\n');
+
+		// A resumed export should start from the same messages.
+		for (const auto &[key, id] : _lastMessageIds) {
+			_manifest->write(QString("since %1 %2 %3\n"
+				).arg(key.first
+				).arg(key.second
+				).arg(id).toUtf8());
+		}
+		_manifest->flush();
+	}
+}
+
+bool ApiWrap::LoadedFileCache::restoreMessageId(
+		const QStringList &parts,
+		const QString &type) {
+	if (parts.size() != 4 || parts[0] != type) {
+		return false;
+	}
+	const auto key = std::make_pair(
+		Data::PeerId(parts[1].toULongLong()),
+		parts[2].toInt());
+	_lastMessageIds[key] = parts[3].toInt();
+	return true;
+}
+
+void ApiWrap::LoadedFileCache::restoreMessageIds(const QString &folder) {
+	if (folder.isEmpty()) {
+		return;
+	}
+	QFile file(Output::ManifestPath(folder));
+	if (!file.open(QIODevice::ReadOnly)) {
+		return;
+	}
+	while (!file.atEnd()) {
+		const auto line = QString::fromUtf8(file.readLine()).trimmed();
+		const auto parts = line.split(' ');
+
+		// The ids reached by that export override the ones it started from.
+		if (!restoreMessageId(parts, "since")) {
+			restoreMessageId(parts, "last");
+		}
+	}
+	LOG(("Export Info: Exporting messages after %1 chat parts from %2."
+		).arg(_lastMessageIds.size()
+		).arg(folder));
+}
+
+int32 ApiWrap::LoadedFileCache::lastMessageId(
+		Data::PeerId peerId,
+		int split) const {
+	const auto i = _lastMessageIds.find(std::make_pair(peerId, split));
+	return (i != end(_lastMessageIds)) ? i->second : 0;
+}
+
+void ApiWrap::LoadedFileCache::saveLastMessageId(
+		Data::PeerId peerId,
+		int split,
+		int32 id) {
+	if (_manifest && id > lastMessageId(peerId, split)) {
+		_manifest->write(QString("last %1 %2 %3\n"
+			).arg(peerId
+			).arg(split
+			).arg(id).toUtf8());
+		_manifest->flush();
+	}
+}
+
+void ApiWrap::LoadedFileCache::finish() {
+	if (_manifest) {
+		_manifest->write(Output::ManifestFinishedLine() + '\n');
+		_manifest = nullptr;
+	}
+}
+
 void ApiWrap::LoadedFileCache::save(
 		const Location &location,
 		const QString &relativePath) {
@@ -326,25 +497,56 @@ void ApiWrap::LoadedFileCache::save(
 		return;
 	}
 	const auto key = ComputeLocationKey(location);
-	_map[key] = relativePath;
-	_list.push_back(key);
-	if (_list.size() > _limit) {
-		const auto key = _list.front();
-		_list.pop_front();
-		_map.erase(key);
+	remember(key, relativePath);
+	if (_manifest) {
+		const auto size = QFileInfo(_folder + relativePath).size();
+		_manifest->write(QString("file %1 %2 %3 %4\n"
+			).arg(key.type
+			).arg(key.id
+			).arg(size
+			).arg(relativePath).toUtf8());
+		_manifest->flush();
+	}
+}
+
+int64 ApiWrap::LoadedFileCache::EntryBytes(const QString &relativePath) {
+	// Map node and list node overhead with the path characters.
+	constexpr auto kEntryOverhead = int64(128);
+	return kEntryOverhead + relativePath.size() * int64(sizeof(QChar));
+}
+
+void ApiWrap::LoadedFileCache::remember(
+		const LocationKey &key,
+		const QString &relativePath) {
+	if (const auto i = _map.find(key); i != end(_map)) {
+		_bytes -= EntryBytes(i->second.relativePath);
+		_usage.erase(i->second.usage);
+		_map.erase(i);
+	}
+	_usage.push_back(key);
+	_map.emplace(key, Entry{ relativePath, std::prev(end(_usage)) });
+	_bytes += EntryBytes(relativePath);
+	while (_bytes > _limit && !_usage.empty()) {
+		const auto i = _map.find(_usage.front());
+		Assert(i != end(_map));
+		_bytes -= EntryBytes(i->second.relativePath);
+		_map.erase(i);
+		_usage.pop_front();
 	}
 }
 
 std::optional<QString> ApiWrap::LoadedFileCache::find(
-		const Location &location) const {
+		const Location &location) {
 	if (!location) {
 		return std::nullopt;
 	}
 	const auto key = ComputeLocationKey(location);
-	if (const auto i = _map.find(key); i != end(_map)) {
-		return i->second;
+	const auto i = _map.find(key);
+	if (i == end(_map)) {
+		return std::nullopt;
 	}
-	return std::nullopt;
+	_usage.splice(end(_usage), _usage, i->second.usage);
+	return i->second.relativePath;
 }
 
 ApiWrap::FileProcess::FileProcess(const QString &path, Output::Stats *stats)
@@ -377,7 +579,10 @@ auto ApiWrap::splitRequest(int index, Request &&request) {
 		std::forward<Request>(request)));
 }
 
-auto ApiWrap::fileRequest(const Data::FileLocation &location, int offset) {
+auto ApiWrap::fileRequest(
+		uint64 fileId,
+		const Data::FileLocation &location,
+		int offset) {
 	Expects(location.dcId != 0
 		|| location.data.type() == mtpc_inputTakeoutFileLocation);
 	Expects(_takeoutId.has_value());
@@ -390,9 +595,13 @@ auto ApiWrap::fileRequest(const Data::FileLocation &location, int offset) {
 			MTP_int(offset),
 			MTP_int(kFileChunkSize))
 	)).fail([=](RPCError &&result) {
-		if (result.type() == qstr("TAKEOUT_FILE_EMPTY")
+		if (MTP::isFloodError(result)) {
+			_filePacer.flooded(crl::now(), RequestPacer::FloodWait(result));
+			sendFilePartRequest(fileId, offset);
+		} else if (result.type() == qstr("TAKEOUT_FILE_EMPTY")
 			&& _otherDataProcess != nullptr) {
 			filePartDone(
+				fileId,
 				0,
 				MTP_upload_file(
 					MTP_storage_filePartial(),
@@ -400,19 +609,33 @@ auto ApiWrap::fileRequest(const Data::FileLocation &location, int offset) {
 					MTP_bytes()));
 		} else if (result.type() == qstr("LOCATION_INVALID")
 			|| result.type() == qstr("VERSION_INVALID")) {
-			filePartUnavailable();
+			filePartUnavailable(fileId);
 		} else if (result.code() == 400
 			&& result.type().startsWith(qstr("FILE_REFERENCE_"))) {
-			filePartRefreshReference(offset);
+			filePartRefreshReference(fileId, offset);
 		} else {
 			error(std::move(result));
 		}
-	}).toDC(MTP::ShiftDcId(location.dcId, MTP::kExportMediaDcShift)));
+	}).handleFloodErrors(
+	).toDC(MTP::ShiftDcId(location.dcId, MTP::kExportMediaDcShift)));
+}
+
+void ApiWrap::callDelayed(crl::time delay, Fn<void()> callback) {
+	crl::on_main([=, runner = _runner] {
+		base::call_delayed(delay, [=] {
+			runner(callback);
+		});
+	});
 }
 
 ApiWrap::ApiWrap(QPointer<MTP::Instance> weak, Fn<void(FnMut<void()>)> runner)
-: _mtp(weak, std::move(runner))
-, _fileCache(std::make_unique<LoadedFileCache>(kLocationCacheSize)) {
+: _mtp(weak, runner)
+, _runner(std::move(runner))
+, _fileCache(std::make_unique<LoadedFileCache>(kLocationCacheBytes)) {
+}
+
+void ApiWrap::setLocalFileLookup(LocalFileLookup lookup) {
+	_localFileLookup = std::move(lookup);
 }
 
 rpl::producer<RPCError> ApiWrap::errors() const {
@@ -432,6 +655,7 @@ void ApiWrap::startExport(
 
 	_settings = std::make_unique<Settings>(settings);
 	_stats = stats;
+	_fileCache->restore(*_settings);
 	_startProcess = std::make_unique<StartProcess>();
 	_startProcess->done = std::move(done);
 
@@ -842,7 +1066,6 @@ void ApiWrap::finishUserpicsSlice() {
 }
 
 bool ApiWrap::loadUserpicProgress(FileProgress progress) {
-	Expects(_fileProcess != nullptr);
 	Expects(_userpicsProcess != nullptr);
 	Expects(_userpicsProcess->slice.has_value());
 	Expects((_userpicsProcess->fileIndex >= 0)
@@ -850,7 +1073,7 @@ bool ApiWrap::loadUserpicProgress(FileProgress progress) {
 			< _userpicsProcess->slice->list.size()));
 
 	return _userpicsProcess->fileProgress(DownloadProgress{
-		_fileProcess->relativePath,
+		progress.relativePath,
 		_userpicsProcess->fileIndex,
 		progress.ready,
 		progress.total });
@@ -971,6 +1194,7 @@ void ApiWrap::requestMessages(
 	_chatProcess->fileProgress = std::move(progress);
 	_chatProcess->handleSlice = std::move(slice);
 	_chatProcess->done = std::move(done);
+	_chatProcess->largestIdPlusOne = splitFirstMessageId();
 
 	requestMessagesCount(0);
 }
@@ -1053,6 +1277,8 @@ void ApiWrap::messagesCountLoaded(int localSplitIndex, int count) {
 void ApiWrap::finishExport(FnMut<void()> done) {
 	const auto guard = gsl::finally([&] { _takeoutId = std::nullopt; });
 
+	_fileCache->finish();
+
 	mainRequest(MTPaccount_FinishTakeoutSession(
 		MTP_flags(MTPaccount_FinishTakeoutSession::Flag::f_success)
 	)).done(std::move(done)).send();
@@ -1370,6 +1596,18 @@ void ApiWrap::appendChatsSlice(
 	}
 }
 
+int32 ApiWrap::splitFirstMessageId() const {
+	Expects(_chatProcess != nullptr);
+
+	const auto &info = _chatProcess->info;
+	if (_chatProcess->localSplitIndex >= info.splits.size()) {
+		return 1;
+	}
+	return _fileCache->lastMessageId(
+		info.peerId,
+		info.splits[_chatProcess->localSplitIndex]) + 1;
+}
+
 void ApiWrap::requestMessagesSlice() {
 	Expects(_chatProcess != nullptr);
 
@@ -1412,10 +1650,42 @@ void ApiWrap::requestChatMessages(
 	Expects(_chatProcess != nullptr);
 
 	_chatProcess->requestDone = std::move(done);
+	const auto delay = _historyPacer.acquire(crl::now());
+	if (delay > 0) {
+		callDelayed(delay, [=] {
+			if (_chatProcess) {
+				sendChatMessagesRequest(
+					splitIndex,
+					offsetId,
+					addOffset,
+					limit);
+			}
+		});
+	} else {
+		sendChatMessagesRequest(splitIndex, offsetId, addOffset, limit);
+	}
+}
+
+void ApiWrap::sendChatMessagesRequest(
+		int splitIndex,
+		int offsetId,
+		int addOffset,
+		int limit) {
+	Expects(_chatProcess != nullptr);
+
+	const auto sent = crl::now();
 	const auto doneHandler = [=](MTPmessages_Messages &&result) {
 		Expects(_chatProcess != nullptr);
 
-		base::take(_chatProcess->requestDone)(std::move(result));
+		_historyPacer.succeeded();
+		if (_stats) {
+			_stats->addRequestTime(crl::now() - sent);
+		}
+
+		// Could be reset if writing of the previous slice has failed.
+		if (auto done = base::take(_chatProcess->requestDone)) {
+			done(std::move(result));
+		}
 	};
 	const auto splitsCount = int(_splits.size());
 	const auto realPeerInput = (splitIndex >= 0)
@@ -1424,6 +1694,38 @@ void ApiWrap::requestChatMessages(
 	const auto realSplitIndex = (splitIndex >= 0)
 		? splitIndex
 		: (splitsCount + splitIndex);
+	const auto failHandler = [=](const RPCError &error) {
+		Expects(_chatProcess != nullptr);
+
+		if (MTP::isFloodError(error)) {
+			_historyPacer.flooded(
+				crl::now(),
+				RequestPacer::FloodWait(error));
+			requestChatMessages(
+				splitIndex,
+				offsetId,
+				addOffset,
+				limit,
+				base::take(_chatProcess->requestDone));
+			return true;
+		} else if (error.type() == qstr("CHANNEL_PRIVATE")) {
+			if (realPeerInput.type() == mtpc_inputPeerChannel
+				&& !_chatProcess->info.onlyMyMessages) {
+
+				// Perhaps we just left / were kicked from channel.
+				// Just switch to only my messages.
+				_chatProcess->info.onlyMyMessages = true;
+				requestChatMessages(
+					splitIndex,
+					offsetId,
+					addOffset,
+					limit,
+					base::take(_chatProcess->requestDone));
+				return true;
+			}
+		}
+		return false;
+	};
 	if (_chatProcess->info.onlyMyMessages) {
 		splitRequest(realSplitIndex, MTPmessages_Search(
 			MTP_flags(MTPmessages_Search::Flag::f_from_id),
@@ -1440,7 +1742,7 @@ void ApiWrap::requestChatMessages(
 			MTP_int(0), // max_id
 			MTP_int(0), // min_id
 			MTP_int(0) // hash
-		)).done(doneHandler).send();
+		)).fail(failHandler).handleFloodErrors().done(doneHandler).send();
 	} else {
 		splitRequest(realSplitIndex, MTPmessages_GetHistory(
 			realPeerInput,
@@ -1451,27 +1753,7 @@ void ApiWrap::requestChatMessages(
 			MTP_int(0), // max_id
 			MTP_int(0), // min_id
 			MTP_int(0)  // hash
-		)).fail([=](const RPCError &error) {
-			Expects(_chatProcess != nullptr);
-
-			if (error.type() == qstr("CHANNEL_PRIVATE")) {
-				if (realPeerInput.type() == mtpc_inputPeerChannel
-					&& !_chatProcess->info.onlyMyMessages) {
-
-					// Perhaps we just left / were kicked from channel.
-					// Just switch to only my messages.
-					_chatProcess->info.onlyMyMessages = true;
-					requestChatMessages(
-						splitIndex,
-						offsetId,
-						addOffset,
-						limit,
-						base::take(_chatProcess->requestDone));
-					return true;
-				}
-			}
-			return false;
-		}).done(doneHandler).send();
+		)).fail(failHandler).handleFloodErrors().done(doneHandler).send();
 	}
 }
 
@@ -1488,21 +1770,15 @@ void ApiWrap::loadMessagesFiles(Data::MessagesSlice &&slice) {
 	loadNextMessageFile();
 }
 
-Data::Message *ApiWrap::currentFileMessage() const {
-	Expects(_chatProcess != nullptr);
-	Expects(_chatProcess->slice.has_value());
-
-	return &_chatProcess->slice->list[_chatProcess->fileIndex];
-}
-
-Data::FileOrigin ApiWrap::currentFileMessageOrigin() const {
+Data::FileOrigin ApiWrap::fileMessageOrigin(int index) const {
 	Expects(_chatProcess != nullptr);
 	Expects(_chatProcess->slice.has_value());
+	Expects((index >= 0) && (index < _chatProcess->slice->list.size()));
 
 	const auto splitIndex = _chatProcess->info.splits[
 		_chatProcess->localSplitIndex];
 	auto result = Data::FileOrigin();
-	result.messageId = currentFileMessage()->id;
+	result.messageId = _chatProcess->slice->list[index].id;
 	result.split = (splitIndex >= 0)
 		? splitIndex
 		: (int(_splits.size()) + splitIndex);
@@ -1516,39 +1792,53 @@ void ApiWrap::loadNextMessageFile() {
 	Expects(_chatProcess != nullptr);
 	Expects(_chatProcess->slice.has_value());
 
+	// Files of different messages are loaded in parallel, the slice is
+	// passed further in the original order once all of them are ready.
 	for (auto &list = _chatProcess->slice->list
 		; _chatProcess->fileIndex < list.size()
 		; ++_chatProcess->fileIndex) {
-		const auto &message = list[_chatProcess->fileIndex];
+		if (_chatProcess->filesLoading >= kMessageFilesParallel) {
+			return;
+		}
+		const auto index = _chatProcess->fileIndex;
+		auto &message = list[index];
 		if (Data::SkipMessageByDate(message, *_settings)) {
 			continue;
 		}
-		const auto fileProgress = [=](FileProgress value) {
-			return loadMessageFileProgress(value);
-		};
-		const auto ready = processFileLoad(
-			list[_chatProcess->fileIndex].file(),
-			currentFileMessageOrigin(),
-			fileProgress,
-			[=](const QString &path) { loadMessageFileDone(path); },
-			currentFileMessage());
-		if (!ready) {
-			return;
+		if (!_chatProcess->thumbPending) {
+			const auto fileProgress = [=](FileProgress value) {
+				return loadMessageFileProgress(index, value);
+			};
+			const auto ready = processFileLoad(
+				message.file(),
+				fileMessageOrigin(index),
+				fileProgress,
+				[=](const QString &path) { loadMessageFileDone(index, path); },
+				&message);
+			if (!ready
+				&& ++_chatProcess->filesLoading >= kMessageFilesParallel) {
+				// The thumbnail is requested when a slot is free.
+				_chatProcess->thumbPending = true;
+				return;
+			}
 		}
+		_chatProcess->thumbPending = false;
 		const auto thumbProgress = [=](FileProgress value) {
-			return loadMessageThumbProgress(value);
+			return loadMessageThumbProgress(index, value);
 		};
 		const auto thumbReady = processFileLoad(
-			list[_chatProcess->fileIndex].thumb().file,
-			currentFileMessageOrigin(),
+			message.thumb().file,
+			fileMessageOrigin(index),
 			thumbProgress,
-			[=](const QString &path) { loadMessageThumbDone(path); },
-			currentFileMessage());
+			[=](const QString &path) { loadMessageThumbDone(index, path); },
+			&message);
 		if (!thumbReady) {
-			return;
+			++_chatProcess->filesLoading;
 		}
 	}
-	finishMessagesSlice();
+	if (!_chatProcess->filesLoading) {
+		finishMessagesSlice();
+	}
 }
 
 void ApiWrap::finishMessagesSlice() {
@@ -1556,75 +1846,94 @@ void ApiWrap::finishMessagesSlice() {
 	Expects(_chatProcess->slice.has_value());
 
 	auto slice = *base::take(_chatProcess->slice);
+	const auto splitIndex = _chatProcess->info.splits[
+		_chatProcess->localSplitIndex];
 	if (!slice.list.empty()) {
 		_chatProcess->largestIdPlusOne = slice.list.back().id + 1;
-		const auto splitIndex = _chatProcess->info.splits[
-			_chatProcess->localSplitIndex];
 		if (splitIndex < 0) {
 			slice = AdjustMigrateMessageIds(std::move(slice));
 		}
-		if (!_chatProcess->handleSlice(std::move(slice))) {
-			return;
-		}
+	}
+	if (_chatProcess->lastSlice) {
+		_fileCache->saveLastMessageId(
+			_chatProcess->info.peerId,
+			splitIndex,
+			_chatProcess->largestIdPlusOne - 1);
 	}
 	if (_chatProcess->lastSlice
 		&& (++_chatProcess->localSplitIndex
 			< _chatProcess->info.splits.size())) {
 		_chatProcess->lastSlice = false;
-		_chatProcess->largestIdPlusOne = 1;
+		_chatProcess->largestIdPlusOne = splitFirstMessageId();
+	}
+
+	// Request the next slice before writing this one, so that the
+	// network request runs while the output is being generated. Empty
+	// splits are skipped synchronously, so leave them for after the write.
+	const auto more = !_chatProcess->lastSlice;
+	const auto requestFirst = more
+		&& (_chatProcess->info.messagesCountPerSplit[
+			_chatProcess->localSplitIndex] > 0);
+	if (requestFirst) {
+		requestMessagesSlice();
+	}
+	if (!slice.list.empty()
+		&& !_chatProcess->handleSlice(std::move(slice))) {
+		_chatProcess->requestDone = nullptr;
+		return;
 	}
-	if (!_chatProcess->lastSlice) {
+	if (requestFirst) {
+		return;
+	} else if (more) {
 		requestMessagesSlice();
 	} else {
 		finishMessages();
 	}
 }
 
-bool ApiWrap::loadMessageFileProgress(FileProgress progress) {
-	Expects(_fileProcess != nullptr);
+bool ApiWrap::loadMessageFileProgress(int index, FileProgress progress) {
 	Expects(_chatProcess != nullptr);
 	Expects(_chatProcess->slice.has_value());
-	Expects((_chatProcess->fileIndex >= 0)
-		&& (_chatProcess->fileIndex < _chatProcess->slice->list.size()));
+	Expects((index >= 0) && (index < _chatProcess->slice->list.size()));
 
 	return _chatProcess->fileProgress(DownloadProgress{
-		_fileProcess->relativePath,
-		_chatProcess->fileIndex,
+		progress.relativePath,
+		index,
 		progress.ready,
 		progress.total });
 }
 
-void ApiWrap::loadMessageFileDone(const QString &relativePath) {
+void ApiWrap::loadMessageFileDone(int index, const QString &relativePath) {
 	Expects(_chatProcess != nullptr);
 	Expects(_chatProcess->slice.has_value());
-	Expects((_chatProcess->fileIndex >= 0)
-		&& (_chatProcess->fileIndex < _chatProcess->slice->list.size()));
+	Expects((index >= 0) && (index < _chatProcess->slice->list.size()));
+	Expects(_chatProcess->filesLoading > 0);
 
-	const auto index = _chatProcess->fileIndex;
 	auto &file = _chatProcess->slice->list[index].file();
 	file.relativePath = relativePath;
 	if (relativePath.isEmpty()) {
 		file.skipReason = Data::File::SkipReason::Unavailable;
 	}
+	--_chatProcess->filesLoading;
 	loadNextMessageFile();
 }
 
-bool ApiWrap::loadMessageThumbProgress(FileProgress progress) {
-	return loadMessageFileProgress(progress);
+bool ApiWrap::loadMessageThumbProgress(int index, FileProgress progress) {
+	return loadMessageFileProgress(index, progress);
 }
 
-void ApiWrap::loadMessageThumbDone(const QString &relativePath) {
+void ApiWrap::loadMessageThumbDone(int index, const QString &relativePath) {
 	Expects(_chatProcess != nullptr);
 	Expects(_chatProcess->slice.has_value());
-	Expects((_chatProcess->fileIndex >= 0)
-		&& (_chatProcess->fileIndex < _chatProcess->slice->list.size()));
+	Expects((index >= 0) && (index < _chatProcess->slice->list.size()));
+	Expects(_chatProcess->filesLoading > 0);
 
-	const auto index = _chatProcess->fileIndex;
 	auto &file = _chatProcess->slice->list[index].thumb().file;
 	file.relativePath = relativePath;
 	if (relativePath.isEmpty()) {
 		file.skipReason = Data::File::SkipReason::Unavailable;
 	}
+	--_chatProcess->filesLoading;
 	loadNextMessageFile();
 }
 
@@ -1686,10 +1995,85 @@ bool ApiWrap::processFileLoad(
 		file.skipReason = SkipReason::FileSize;
 		return true;
 	}
-	loadFile(file, origin, std::move(progress), std::move(done));
+	if (_localFileLookup) {
+		lookupLocalFile(file, origin, std::move(progress), std::move(done));
+	} else {
+		loadFile(file, origin, std::move(progress), std::move(done));
+	}
 	return false;
 }
 
+void ApiWrap::lookupLocalFile(
+		const Data::File &file,
+		const Data::FileOrigin &origin,
+		Fn<bool(FileProgress)> progress,
+		FnMut<void(QString)> done) {
+	Expects(_localFileLookup != nullptr);
+
+	const auto id = ++_fileLookupId;
+	auto &lookup = _fileLookups.emplace(
+		id,
+		std::make_unique<FileLookup>()).first->second;
+	lookup->file = file;
+	lookup->origin = origin;
+	lookup->progress = std::move(progress);
+	lookup->done = std::move(done);
+
+	const auto runner = _runner;
+	_localFileLookup(file.location, file.size, [=](
+			QString path,
+			QByteArray bytes) {
+		runner([=] {
+			localFileLookupDone(id, path, bytes);
+		});
+	});
+}
+
+void ApiWrap::localFileLookupDone(
+		uint64 lookupId,
+		const QString &path,
+		const QByteArray &bytes) {
+	Expects(_settings != nullptr);
+
+	const auto i = _fileLookups.find(lookupId);
+	if (i == end(_fileLookups)) {
+		return;
+	}
+	auto lookup = std::move(i->second);
+	_fileLookups.erase(i);
+
+	if (!path.isEmpty() || !bytes.isEmpty()) {
+		const auto process = prepareFileProcess(lookup->file, lookup->origin);
+		const auto relativePath = process->relativePath;
+		if (!bytes.isEmpty()) {
+			const auto result = process->file.writeBlock(bytes);
+			if (!result) {
+				ioError(result);
+				return;
+			}
+		} else if (!Output::File::Copy(
+				path,
+				_settings->path + relativePath,
+				_stats)) {
+			// Fall back to the download if the local copy has failed.
+			loadFile(
+				lookup->file,
+				lookup->origin,
+				std::move(lookup->progress),
+				std::move(lookup->done));
+			return;
+		}
+		_fileCache->save(lookup->file.location, relativePath);
+		lookup->done(relativePath);
+		return;
+	}
+	loadFile(
+		lookup->file,
+		lookup->origin,
+		std::move(lookup->progress),
+		std::move(lookup->done));
+}
+
 bool ApiWrap::writePreloadedFile(
 		Data::File &file,
 		const Data::FileOrigin &origin) {
@@ -1718,25 +2102,32 @@ void ApiWrap::loadFile(
 		const Data::FileOrigin &origin,
 		Fn<bool(FileProgress)> progress,
 		FnMut<void(QString)> done) {
-	Expects(_fileProcess == nullptr);
 	Expects(file.location.dcId != 0
 		|| file.location.data.type() == mtpc_inputTakeoutFileLocation);
 
-	_fileProcess = prepareFileProcess(file, origin);
-	_fileProcess->progress = std::move(progress);
-	_fileProcess->done = std::move(done);
-
-	if (_fileProcess->progress) {
+	if (const auto loading = fileProcess(file.location)) {
+		loading->waiters.push_back(std::move(done));
+		return;
+	}
+	const auto id = ++_fileProcessId;
+	auto &process = _fileProcesses.emplace(
+		id,
+		prepareFileProcess(file, origin)).first->second;
+	process->progress = std::move(progress);
+	process->done = std::move(done);
+
+	if (process->progress) {
 		const auto progress = FileProgress{
-			_fileProcess->file.size(),
-			_fileProcess->size
+			process->file.size(),
+			process->size,
+			process->relativePath
 		};
-		if (!_fileProcess->progress(progress)) {
+		if (!process->progress(progress)) {
 			return;
 		}
 	}
 
-	loadFilePart();
+	loadFilePart(id);
 }
 
 auto ApiWrap::prepareFileProcess(
@@ -1745,9 +2136,15 @@ auto ApiWrap::prepareFileProcess(
 -> std::unique_ptr<FileProcess> {
 	Expects(_settings != nullptr);
 
+	// Files being loaded in parallel are not on the disk yet.
+	auto loading = base::flat_set<QString>();
+	for (const auto &[id, process] : _fileProcesses) {
+		loading.emplace(process->relativePath);
+	}
 	const auto relativePath = Output::File::PrepareRelativePath(
 		_settings->path,
-		file.suggestedPath);
+		file.suggestedPath,
+		loading);
 	auto result = std::make_unique<FileProcess>(
 		_settings->path + relativePath,
 		_stats);
@@ -1758,26 +2155,45 @@ auto ApiWrap::prepareFileProcess(
 	return result;
 }
 
-void ApiWrap::loadFilePart() {
-	if (!_fileProcess
-		|| _fileProcess->requests.size() >= kFileRequestsCount
-		|| (_fileProcess->size > 0
-			&& _fileProcess->offset >= _fileProcess->size)) {
+ApiWrap::FileProcess *ApiWrap::fileProcess(uint64 fileId) const {
+	const auto i = _fileProcesses.find(fileId);
+	return (i != end(_fileProcesses)) ? i->second.get() : nullptr;
+}
+
+ApiWrap::FileProcess *ApiWrap::fileProcess(
+		const Data::FileLocation &location) const {
+	if (!location) {
+		return nullptr;
+	}
+	const auto key = ComputeLocationKey(location);
+	for (const auto &[id, process] : _fileProcesses) {
+		if (!process->location) {
+			continue;
+		}
+		const auto other = ComputeLocationKey(process->location);
+		if (other.type == key.type && other.id == key.id) {
+			return process.get();
+		}
+	}
+	return nullptr;
+}
+
+void ApiWrap::loadFilePart(uint64 fileId) {
+	const auto process = fileProcess(fileId);
+	if (!process
+		|| process->requests.size() >= kFileRequestsCount
+		|| (process->size > 0
+			&& process->offset >= process->size)) {
 		return;
 	}
 
-	const auto offset = _fileProcess->offset;
-	_fileProcess->requests.push_back({ offset });
-	fileRequest(
-		_fileProcess->location,
-		_fileProcess->offset
-	).done([=](const MTPupload_File &result) {
-		filePartDone(offset, result);
-	}).send();
-	_fileProcess->offset += kFileChunkSize;
+	const auto offset = process->offset;
+	process->requests.push_back({ offset });
+	process->offset += kFileChunkSize;
+	sendFilePartRequest(fileId, offset);
 
-	if (_fileProcess->size > 0
-		&& _fileProcess->requests.size() < kFileRequestsCount) {
+	if (process->size > 0
+		&& process->requests.size() < kFileRequestsCount) {
 		//const auto runner = _runner;
 		//crl::on_main([=] {
 		//	QTimer::singleShot(kFileNextRequestDelay, [=] {
@@ -1789,9 +2205,46 @@ void ApiWrap::loadFilePart() {
 	}
 }
 
-void ApiWrap::filePartDone(int offset, const MTPupload_File &result) {
-	Expects(_fileProcess != nullptr);
-	Expects(!_fileProcess->requests.empty());
+void ApiWrap::sendFilePartRequest(uint64 fileId, int offset) {
+	const auto delay = _filePacer.acquire(crl::now());
+	if (delay > 0) {
+		callDelayed(delay, [=] {
+			sendFilePartRequestNow(fileId, offset);
+		});
+	} else {
+		sendFilePartRequestNow(fileId, offset);
+	}
+}
+
+void ApiWrap::sendFilePartRequestNow(uint64 fileId, int offset) {
+	const auto process = fileProcess(fileId);
+	if (!process) {
+		return;
+	}
+	const auto sent = crl::now();
+	fileRequest(
+		fileId,
+		process->location,
+		offset
+	).done([=](const MTPupload_File &result) {
+		_filePacer.succeeded();
+		if (_stats) {
+			_stats->addRequestTime(crl::now() - sent);
+		}
+		filePartDone(fileId, offset, result);
+	}).send();
+}
+
+void ApiWrap::filePartDone(
+		uint64 fileId,
+		int offset,
+		const MTPupload_File &result) {
+	const auto process = fileProcess(fileId);
+	if (!process) {
+		// The file was already finished as unavailable.
+		return;
+	}
+	Assert(!process->requests.empty());
 
 	if (result.type() == mtpc_upload_fileCdnRedirect) {
 		error("Cdn redirect is not supported.");
@@ -1799,18 +2252,18 @@ void ApiWrap::filePartDone(int offset, const MTPupload_File &result) {
 	}
 	const auto &data = result.c_upload_file();
 	if (data.vbytes().v.isEmpty()) {
-		if (_fileProcess->size > 0) {
+		if (process->size > 0) {
 			error("Empty bytes received in file part.");
 			return;
 		}
-		const auto result = _fileProcess->file.writeBlock({});
+		const auto result = process->file.writeBlock({});
 		if (!result) {
 			ioError(result);
 			return;
 		}
 	} else {
 		using Request = FileProcess::Request;
-		auto &requests = _fileProcess->requests;
+		auto &requests = process->requests;
 		const auto i = ranges::find(
 			requests,
 			offset,
@@ -1819,7 +2272,7 @@ void ApiWrap::filePartDone(int offset, const MTPupload_File &result) {
 
 		i->bytes = data.vbytes().v;
 
-		auto &file = _fileProcess->file;
+		auto &file = process->file;
 		while (!requests.empty() && !requests.front().bytes.isEmpty()) {
 			const auto &bytes = requests.front().bytes;
 			if (const auto result = file.writeBlock(bytes); !result) {
@@ -1829,30 +2282,47 @@ void ApiWrap::filePartDone(int offset, const MTPupload_File &result) {
 			requests.pop_front();
 		}
 
-		if (_fileProcess->progress) {
-			_fileProcess->progress(FileProgress{
+		if (process->progress) {
+			process->progress(FileProgress{
 				file.size(),
-				_fileProcess->size });
+				process->size,
+				process->relativePath });
 		}
 
 		if (!requests.empty()
-			|| !_fileProcess->size
-			|| _fileProcess->size > _fileProcess->offset) {
-			loadFilePart();
+			|| !process->size
+			|| process->size > process->offset) {
+			loadFilePart(fileId);
 			return;
 		}
 	}
 
-	auto process = base::take(_fileProcess);
-	const auto relativePath = process->relativePath;
-	_fileCache->save(process->location, relativePath);
-	process->done(process->relativePath);
+	auto taken = takeFileProcess(fileId);
+	const auto relativePath = taken->relativePath;
+	_fileCache->save(taken->location, relativePath);
+	taken->done(relativePath);
+	for (auto &waiter : taken->waiters) {
+		waiter(relativePath);
+	}
 }
 
-void ApiWrap::filePartRefreshReference(int offset) {
-	Expects(_fileProcess != nullptr);
+auto ApiWrap::takeFileProcess(uint64 fileId)
+-> std::unique_ptr<FileProcess> {
+	const auto i = _fileProcesses.find(fileId);
+	Assert(i != end(_fileProcesses));
 
-	const auto &origin = _fileProcess->origin;
+	auto result = std::move(i->second);
+	_fileProcesses.erase(i);
+	return result;
+}
+
+void ApiWrap::filePartRefreshReference(uint64 fileId, int offset) {
+	const auto process = fileProcess(fileId);
+	if (!process) {
+		return;
+	}
+
+	const auto &origin = process->origin;
 	if (!origin.messageId) {
 		error("FILE_REFERENCE error for non-message file.");
 		return;
@@ -1873,10 +2343,10 @@ void ApiWrap::filePartRefreshReference(int offset) {
 				1,
 				MTP_inputMessageID(MTP_int(origin.messageId)))
 		)).fail([=](const RPCError &error) {
-			filePartUnavailable();
+			filePartUnavailable(fileId);
 			return true;
 		}).done([=](const MTPmessages_Messages &result) {
-			filePartExtractReference(offset, result);
+			filePartExtractReference(fileId, offset, result);
 		}).send();
 	} else {
 		splitRequest(origin.split, MTPmessages_GetMessages(
@@ -1884,18 +2354,22 @@ void ApiWrap::filePartRefreshReference(int offset) {
 				1,
 				MTP_inputMessageID(MTP_int(origin.messageId)))
 		)).fail([=](const RPCError &error) {
-			filePartUnavailable();
+			filePartUnavailable(fileId);
 			return true;
 		}).done([=](const MTPmessages_Messages &result) {
-			filePartExtractReference(offset, result);
+			filePartExtractReference(fileId, offset, result);
 		}).send();
 	}
 }
 
 void ApiWrap::filePartExtractReference(
+		uint64 fileId,
 		int offset,
 		const MTPmessages_Messages &result) {
-	Expects(_fileProcess != nullptr);
+	const auto process = fileProcess(fileId);
+	if (!process) {
+		return;
+	}
 
 	result.match([&](const MTPDmessages_messagesNotModified &data) {
 		error("Unexpected messagesNotModified received.");
@@ -1911,35 +2385,36 @@ void ApiWrap::filePartExtractReference(
 			data.vchats(),
 			_chatProcess->info.relativePath);
 		for (const auto &message : messages.list) {
-			if (message.id == _fileProcess->origin.messageId) {
+			if (message.id == process->origin.messageId) {
 				const auto refresh1 = Data::RefreshFileReference(
-					_fileProcess->location,
+					process->location,
 					message.file().location);
 				const auto refresh2 = Data::RefreshFileReference(
-					_fileProcess->location,
+					process->location,
 					message.thumb().file.location);
 				if (refresh1 || refresh2) {
-					fileRequest(
-						_fileProcess->location,
-						offset
-					).done([=](const MTPupload_File &result) {
-						filePartDone(offset, result);
-					}).send();
+					sendFilePartRequest(fileId, offset);
 					return;
 				}
 			}
 		}
-		filePartUnavailable();
+		filePartUnavailable(fileId);
 	});
 }
 
-void ApiWrap::filePartUnavailable() {
-	Expects(_fileProcess != nullptr);
-	Expects(!_fileProcess->requests.empty());
+void ApiWrap::filePartUnavailable(uint64 fileId) {
+	if (!fileProcess(fileId)) {
+		return;
+	}
+	auto process = takeFileProcess(fileId);
+	Assert(!process->requests.empty());
 
 	LOG(("Export Error: File unavailable."));
 
-	base::take(_fileProcess)->done(QString());
+	process->done(QString());
+	for (auto &waiter : process->waiters) {
+		waiter(QString());
+	}
 }
 
 void ApiWrap::error(RPCError &&error) {
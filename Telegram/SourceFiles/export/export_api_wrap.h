@@ -7,7 +7,9 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #pragma once
 
+#include "export/export_request_pacer.h"
 #include "mtproto/mtproto_concurrent_sender.h"
+#include "base/flat_map.h"
 
 namespace Export {
 namespace Data {
@@ -33,10 +35,20 @@ class Stats;
 
 struct Settings;
 
+// Looks for an already downloaded file in the app, called on the export
+// thread. The done callback may be called on any thread, with empty path
+// and bytes if nothing was found.
+using LocalFileLookup = Fn<void(
+	const Data::FileLocation &location,
+	int size,
+	Fn<void(QString path, QByteArray bytes)> done)>;
+
 class ApiWrap {
 public:
 	ApiWrap(QPointer<MTP::Instance> weak, Fn<void(FnMut<void()>)> runner);
 
+	void setLocalFileLookup(LocalFileLookup lookup);
+
 	rpl::producer<RPCError> errors() const;
 	rpl::producer<Output::Result> ioErrors() const;
 
@@ -99,6 +111,7 @@ private:
 	struct LeftChannelsProcess;
 	struct DialogsProcess;
 	struct ChatProcess;
+	struct FileLookup;
 
 	void startMainSession(FnMut<void()> done);
 	void sendNextStartRequest();
@@ -146,6 +159,7 @@ private:
 	void requestMessagesCount(int localSplitIndex);
 	void checkFirstMessageDate(int localSplitIndex, int count);
 	void messagesCountLoaded(int localSplitIndex, int count);
+	[[nodiscard]] int32 splitFirstMessageId() const;
 	void requestMessagesSlice();
 	void requestChatMessages(
 		int splitIndex,
@@ -153,17 +167,21 @@ private:
 		int addOffset,
 		int limit,
 		FnMut<void(MTPmessages_Messages&&)> done);
+	void sendChatMessagesRequest(
+		int splitIndex,
+		int offsetId,
+		int addOffset,
+		int limit);
 	void loadMessagesFiles(Data::MessagesSlice &&slice);
 	void loadNextMessageFile();
-	bool loadMessageFileProgress(FileProgress value);
-	void loadMessageFileDone(const QString &relativePath);
-	bool loadMessageThumbProgress(FileProgress value);
-	void loadMessageThumbDone(const QString &relativePath);
+	bool loadMessageFileProgress(int index, FileProgress value);
+	void loadMessageFileDone(int index, const QString &relativePath);
+	bool loadMessageThumbProgress(int index, FileProgress value);
+	void loadMessageThumbDone(int index, const QString &relativePath);
 	void finishMessagesSlice();
 	void finishMessages();
 
-	[[nodiscard]] Data::Message *currentFileMessage() const;
-	[[nodiscard]] Data::FileOrigin currentFileMessageOrigin() const;
+	[[nodiscard]] Data::FileOrigin fileMessageOrigin(int index) const;
 
 	bool processFileLoad(
 		Data::File &file,
@@ -182,11 +200,31 @@ private:
 		const Data::FileOrigin &origin,
 		Fn<bool(FileProgress)> progress,
 		FnMut<void(QString)> done);
-	void loadFilePart();
-	void filePartDone(int offset, const MTPupload_File &result);
-	void filePartUnavailable();
-	void filePartRefreshReference(int offset);
+	[[nodiscard]] FileProcess *fileProcess(uint64 fileId) const;
+	[[nodiscard]] FileProcess *fileProcess(
+		const Data::FileLocation &location) const;
+	[[nodiscard]] std::unique_ptr<FileProcess> takeFileProcess(
+		uint64 fileId);
+	void lookupLocalFile(
+		const Data::File &file,
+		const Data::FileOrigin &origin,
+		Fn<bool(FileProgress)> progress,
+		FnMut<void(QString)> done);
+	void localFileLookupDone(
+		uint64 lookupId,
+		const QString &path,
+		const QByteArray &bytes);
+	void loadFilePart(uint64 fileId);
+	void sendFilePartRequest(uint64 fileId, int offset);
+	void sendFilePartRequestNow(uint64 fileId, int offset);
+	void filePartDone(
+		uint64 fileId,
+		int offset,
+		const MTPupload_File &result);
+	void filePartUnavailable(uint64 fileId);
+	void filePartRefreshReference(uint64 fileId, int offset);
 	void filePartExtractReference(
+		uint64 fileId,
 		int offset,
 		const MTPmessages_Messages &result);
 
@@ -200,17 +238,24 @@ private:
 	[[nodiscard]] auto splitRequest(int index, Request &&request);
 
 	[[nodiscard]] auto fileRequest(
+		uint64 fileId,
 		const Data::FileLocation &location,
 		int offset);
 
+	void callDelayed(crl::time delay, Fn<void()> callback);
+
 	void error(RPCError &&error);
 	void error(const QString &text);
 	void ioError(const Output::Result &result);
 
 	MTP::ConcurrentSender _mtp;
+	Fn<void(FnMut<void()>)> _runner;
+	LocalFileLookup _localFileLookup;
 	std::optional<uint64> _takeoutId;
 	std::optional<int32> _selfId;
 	Output::Stats *_stats = nullptr;
+	RequestPacer _historyPacer = RequestPacer("messages.getHistory");
+	RequestPacer _filePacer = RequestPacer("upload.getFile");
 
 	std::unique_ptr<Settings> _settings;
 	MTPInputUser _user = MTP_inputUserSelf();
@@ -220,7 +265,10 @@ private:
 	std::unique_ptr<ContactsProcess> _contactsProcess;
 	std::unique_ptr<UserpicsProcess> _userpicsProcess;
 	std::unique_ptr<OtherDataProcess> _otherDataProcess;
-	std::unique_ptr<FileProcess> _fileProcess;
+	base::flat_map<uint64, std::unique_ptr<FileProcess>> _fileProcesses;
+	uint64 _fileProcessId = 0;
+	base::flat_map<uint64, std::unique_ptr<FileLookup>> _fileLookups;
+	uint64 _fileLookupId = 0;
 	std::unique_ptr<LeftChannelsProcess> _leftChannelsProcess;
 	std::unique_ptr<DialogsProcess> _dialogsProcess;
 	std::unique_ptr<ChatProcess> _chatProcess;
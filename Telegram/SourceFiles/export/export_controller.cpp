@@ -12,6 +12,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "export/data/export_data_types.h"
 #include "export/output/export_output_abstract.h"
 #include "export/output/export_output_result.h"
+#include "export/output/export_output_file.h"
 #include "export/output/export_output_stats.h"
 #include "mtproto/mtp_instance.h"
 
@@ -36,7 +37,8 @@ public:
 	ControllerObject(
 		crl::weak_on_queue<ControllerObject> weak,
 		QPointer<MTP::Instance> mtproto,
-		const MTPInputPeer &peer);
+		const MTPInputPeer &peer,
+		LocalFileLookup localFileLookup);
 
 	rpl::producer<State> state() const;
 
@@ -134,9 +136,12 @@ private:
 ControllerObject::ControllerObject(
 	crl::weak_on_queue<ControllerObject> weak,
 	QPointer<MTP::Instance> mtproto,
-	const MTPInputPeer &peer)
+	const MTPInputPeer &peer,
+	LocalFileLookup localFileLookup)
 : _api(mtproto, weak.runner())
 , _state(PasswordCheckState{}) {
+	_api.setLocalFileLookup(std::move(localFileLookup));
+
 	_api.errors(
 	) | rpl::start_with_next([=](RPCError &&error) {
 		setState(ApiErrorState{ std::move(error) });
@@ -241,6 +246,7 @@ void ControllerObject::startExport(
 
 	_settings.path = Output::NormalizePath(_settings);
 	_writer = Output::CreateWriter(_settings.format);
+	_stats.start(crl::now());
 	fillExportSteps();
 	exportNext();
 }
@@ -461,6 +467,7 @@ void ControllerObject::exportNextDialog() {
 				return false;
 			}
 			_messagesWritten += result.list.size();
+			_stats.incrementMessages(result.list.size());
 			setState(stateDialogs(DownloadProgress()));
 			return true;
 		}, [=] {
@@ -492,6 +499,11 @@ ProcessingState ControllerObject::prepareState(
 	result.substepsPassed = _substepsPassed;
 	result.substepsNow = substepsInStep(_lastProcessingStep);
 	result.substepsTotal = _substepsTotal;
+
+	const auto now = crl::now();
+	result.elapsed = _stats.elapsed(now);
+	result.bytesPerSecond = _stats.bytesPerSecond(now);
+	result.messagesPerSecond = _stats.messagesPerSecond(now);
 	return result;
 }
 
@@ -585,6 +597,14 @@ int ControllerObject::substepsInStep(Step step) const {
 }
 
 void ControllerObject::setFinishedState() {
+	const auto summary = _stats.summary(crl::now());
+	LOG(("Export Info: Finished.\n%1").arg(QString::fromUtf8(summary)));
+
+	Output::File file(_settings.path + "export_stats.txt", nullptr);
+	if (const auto result = file.writeBlock(summary); !result) {
+		LOG(("Export Error: Could not write the export stats."));
+	}
+
 	setState(FinishedState{
 		_writer->mainFilePath(),
 		_stats.filesCount(),
@@ -593,8 +613,9 @@ void ControllerObject::setFinishedState() {
 
 Controller::Controller(
 	QPointer<MTP::Instance> mtproto,
-	const MTPInputPeer &peer)
-: _wrapped(std::move(mtproto), peer) {
+	const MTPInputPeer &peer,
+	LocalFileLookup localFileLookup)
+: _wrapped(std::move(mtproto), peer, std::move(localFileLookup)) {
 }
 
 rpl::producer<State> Controller::state() const {
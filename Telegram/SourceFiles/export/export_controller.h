@@ -9,6 +9,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "base/variant.h"
 #include "mtproto/mtproto_rpc_sender.h"
+#include "export/export_api_wrap.h"
 
 #include <QtCore/QPointer>
 #include <crl/crl_object_on_queue.h>
@@ -78,6 +79,10 @@ struct ProcessingState {
 	QString bytesName;
 	int bytesLoaded = 0;
 	int bytesCount = 0;
+
+	crl::time elapsed = 0;
+	int64 bytesPerSecond = 0;
+	int messagesPerSecond = 0;
 };
 
 struct ApiErrorState {
@@ -121,7 +126,8 @@ class Controller {
 public:
 	Controller(
 		QPointer<MTP::Instance> mtproto,
-		const MTPInputPeer &peer);
+		const MTPInputPeer &peer,
+		LocalFileLookup localFileLookup = nullptr);
 
 	rpl::producer<State> state() const;
 
@@ -9,13 +9,66 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "export/export_controller.h"
 #include "export/view/export_view_panel_controller.h"
+#include "export/data/export_data_types.h"
 #include "data/data_peer.h"
+#include "data/data_session.h"
+#include "data/data_document.h"
+#include "storage/cache/storage_cache_database.h"
 #include "main/main_session.h"
 #include "main/main_account.h"
 #include "ui/layers/box_content.h"
 #include "base/unixtime.h"
 
 namespace Export {
+namespace {
+
+[[nodiscard]] LocalFileLookup MakeLocalFileLookup(
+		not_null<Main::Session*> session) {
+	if (!cExportFromLocalCache()) {
+		return nullptr;
+	}
+	const auto weak = base::make_weak(session.get());
+	return [=](
+			const Data::FileLocation &location,
+			int size,
+			Fn<void(QString path, QByteArray bytes)> done) {
+		// Only whole documents are looked up, they have the same bytes
+		// in the media cache or in the file they were saved to.
+		if (size <= 0
+			|| location.data.type() != mtpc_inputDocumentFileLocation
+			|| !location.data.c_inputDocumentFileLocation(
+				).vthumb_size().v.isEmpty()) {
+			done(QString(), QByteArray());
+			return;
+		}
+		const auto dcId = location.dcId;
+		const auto id = location.data.c_inputDocumentFileLocation().vid().v;
+		crl::on_main([=] {
+			const auto strong = weak.get();
+			if (!strong) {
+				done(QString(), QByteArray());
+				return;
+			}
+			auto &owner = strong->data();
+			if (const auto document = owner.documentLoaded(id)) {
+				const auto &saved = document->location(true);
+				if (!saved.isEmpty() && saved.size == size) {
+					done(saved.name(), QByteArray());
+					return;
+				}
+			}
+			owner.cache().get(
+				::Data::DocumentCacheKey(dcId, id),
+				[=](QByteArray &&bytes) {
+					const auto good = (bytes.size() == size)
+						&& !bytes.startsWith("partial:");
+					done(QString(), good ? bytes : QByteArray());
+				});
+		});
+	};
+}
+
+} // namespace
 
 Manager::Manager() = default;
 
@@ -34,7 +87,8 @@ void Manager::start(
 	}
 	_controller = std::make_unique<Controller>(
 		&session->mtp(),
-		singlePeer);
+		singlePeer,
+		MakeLocalFileLookup(session));
 	_panel = std::make_unique<View::PanelController>(
 		session,
 		_controller.get());
@@ -0,0 +1,58 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "export/export_request_pacer.h"
+
+#include "mtproto/mtproto_rpc_sender.h"
+
+#include <algorithm>
+
+namespace Export {
+namespace {
+
+constexpr auto kMinInterval = crl::time(50);
+constexpr auto kMaxInterval = crl::time(5000);
+constexpr auto kSuccessesToSpeedUp = 50;
+
+} // namespace
+
+RequestPacer::RequestPacer(QString name) : _name(std::move(name)) {
+}
+
+crl::time RequestPacer::acquire(crl::time now) {
+	const auto start = std::max(now, _nextAllowed);
+	_nextAllowed = start + _interval;
+	return start - now;
+}
+
+void RequestPacer::succeeded() {
+	if (!_interval || ++_successes < kSuccessesToSpeedUp) {
+		return;
+	}
+	_successes = 0;
+	_interval -= _interval / 8;
+	if (_interval < kMinInterval) {
+		_interval = 0;
+	}
+}
+
+void RequestPacer::flooded(crl::time now, crl::time wait) {
+	_successes = 0;
+	_interval = std::clamp(_interval * 2, kMinInterval, kMaxInterval);
+	_nextAllowed = std::max(_nextAllowed, now + wait);
+	LOG(("Export Info: Flood wait %1 ms in %2, pacing by %3 ms."
+		).arg(wait
+		).arg(_name
+		).arg(_interval));
+}
+
+crl::time RequestPacer::FloodWait(const RPCError &error) {
+	const auto seconds = error.type().mid(qstr("FLOOD_WAIT_").size()).toInt();
+	return std::max(seconds, 1) * crl::time(1000);
+}
+
+} // namespace Export
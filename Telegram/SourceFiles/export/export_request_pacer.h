@@ -0,0 +1,36 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+class RPCError;
+
+namespace Export {
+
+// Learns an interval between requests of one method that doesn't hit
+// FLOOD_WAIT: doubles it on each flood wait, slowly shrinks on success.
+class RequestPacer final {
+public:
+	explicit RequestPacer(QString name);
+
+	// Reserves a slot for the next request, returns the delay before it.
+	[[nodiscard]] crl::time acquire(crl::time now);
+
+	void succeeded();
+	void flooded(crl::time now, crl::time wait);
+
+	[[nodiscard]] static crl::time FloodWait(const RPCError &error);
+
+private:
+	QString _name;
+	crl::time _interval = 0;
+	crl::time _nextAllowed = 0;
+	int _successes = 0;
+
+};
+
+} // namespace Export
@@ -81,6 +81,10 @@ struct Settings {
 	TimeId singlePeerFrom = 0;
 	TimeId singlePeerTill = 0;
 
+	// Export only messages newer than the ones in the previous export
+	// with the same settings to the same folder.
+	bool onlyNewMessages = false;
+
 	TimeId availableAt = 0;
 
 	bool onlySinglePeer() const {
@@ -11,12 +11,137 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "export/output/export_output_json.h"
 #include "export/output/export_output_stats.h"
 #include "export/output/export_output_result.h"
+#include "export/export_settings.h"
 
 #include <QtCore/QDir>
 #include <QtCore/QDate>
+#include <QtCore/QFile>
 
 namespace Export {
 namespace Output {
+namespace {
+
+constexpr auto kManifestName = "export_manifest.txt";
+
+QByteArray SinglePeerKey(const MTPInputPeer &peer) {
+	return peer.match([](const MTPDinputPeerEmpty &data) {
+		return QByteArray("all");
+	}, [](const MTPDinputPeerSelf &data) {
+		return QByteArray("self");
+	}, [](const MTPDinputPeerChat &data) {
+		return "chat" + QByteArray::number(data.vchat_id().v);
+	}, [](const MTPDinputPeerUser &data) {
+		return "user" + QByteArray::number(data.vuser_id().v);
+	}, [](const MTPDinputPeerChannel &data) {
+		return "channel" + QByteArray::number(data.vchannel_id().v);
+	}, [](const MTPDinputPeerUserFromMessage &data) {
+		return "user" + QByteArray::number(data.vuser_id().v);
+	}, [](const MTPDinputPeerChannelFromMessage &data) {
+		return "channel" + QByteArray::number(data.vchannel_id().v);
+	});
+}
+
+enum class ManifestState {
+	None,
+	Unfinished,
+	Finished,
+};
+
+ManifestState ReadManifestState(
+		const QString &folder,
+		const Settings &settings) {
+	QFile file(ManifestPath(folder));
+	if (!file.open(QIODevice::ReadOnly)
+		|| file.readLine().trimmed() != ManifestSettingsLine(settings)) {
+		return ManifestState::None;
+	}
+	const auto finished = ManifestFinishedLine();
+	while (!file.atEnd()) {
+		if (file.readLine().trimmed() == finished) {
+			return ManifestState::Finished;
+		}
+	}
+	return ManifestState::Unfinished;
+}
+
+QString FindUnfinishedSubPath(
+		const QDir &folder,
+		const QString &path,
+		const QString &prefix,
+		const Settings &settings) {
+	const auto list = folder.entryInfoList(
+		{ prefix + '*' },
+		QDir::Dirs | QDir::NoDotAndDotDot,
+		QDir::Time);
+	for (const auto &info : list) {
+		const auto result = path + info.fileName() + '/';
+		if (CanResumeFromManifest(result, settings)) {
+			return result;
+		}
+	}
+	return QString();
+}
+
+} // namespace
+
+QString ManifestPath(const QString &folder) {
+	return folder + kManifestName;
+}
+
+QByteArray ManifestFinishedLine() {
+	return "finished";
+}
+
+QByteArray ManifestSettingsLine(const Settings &settings) {
+	return "settings "
+		+ SinglePeerKey(settings.singlePeer)
+		+ ' ' + QByteArray::number(int(settings.format))
+		+ ' ' + QByteArray::number(quint32(settings.types))
+		+ ' ' + QByteArray::number(quint32(settings.fullChats))
+		+ ' ' + QByteArray::number(quint32(settings.media.types))
+		+ ' ' + QByteArray::number(settings.media.sizeLimit)
+		+ ' ' + QByteArray::number(settings.singlePeerFrom)
+		+ ' ' + QByteArray::number(settings.singlePeerTill)
+		+ ' ' + QByteArray::number(settings.onlyNewMessages ? 1 : 0);
+}
+
+bool CanResumeFromManifest(
+		const QString &folder,
+		const Settings &settings) {
+	return (ReadManifestState(folder, settings) == ManifestState::Unfinished);
+}
+
+QString FindPreviousExport(const QString &folder, const Settings &settings) {
+	auto parent = QDir(folder);
+	if (!parent.cdUp()) {
+		return QString();
+	}
+	const auto own = QDir(folder).absolutePath();
+	const auto path = parent.absolutePath().endsWith('/')
+		? parent.absolutePath()
+		: (parent.absolutePath() + '/');
+	const auto prefix = QString(settings.onlySinglePeer()
+		? "ChatExport_"
+		: "DataExport_");
+	const auto list = parent.entryInfoList(
+		{ prefix + '*' },
+		QDir::Dirs | QDir::NoDotAndDotDot,
+		QDir::Time);
+	for (const auto &info : list) {
+		if (info.absoluteFilePath() == own) {
+			continue;
+		}
+		const auto result = path + info.fileName() + '/';
+		if (ReadManifestState(result, settings) == ManifestState::Finished) {
+			return result;
+		}
+	}
+
+	// The first export could be written to the chosen folder itself.
+	return (ReadManifestState(path, settings) == ManifestState::Finished)
+		? path
+		: QString();
+}
 
 QString NormalizePath(const Settings &settings) {
 	QDir folder(settings.path);
@@ -29,12 +154,23 @@ QString NormalizePath(const Settings &settings) {
 	const auto list = folder.entryInfoList(mode);
 	if (list.isEmpty() && !settings.forceSubPath) {
 		return result;
+	} else if (!settings.forceSubPath
+		&& CanResumeFromManifest(result, settings)) {
+		return result;
+	}
+	const auto prefix = QString(settings.onlySinglePeer()
+		? "ChatExport_"
+		: "DataExport_");
+	const auto resume = FindUnfinishedSubPath(
+		folder,
+		result,
+		prefix,
+		settings);
+	if (!resume.isEmpty()) {
+		return resume;
 	}
 	const auto date = QDate::currentDate();
-	const auto base = QString(settings.onlySinglePeer()
-		? "ChatExport_%1"
-		: "DataExport_%1"
-	).arg(date.toString(Qt::ISODate));
+	const auto base = prefix + date.toString(Qt::ISODate);
 	const auto add = [&](int i) {
 		return base + (i ? " (" + QString::number(i) + ')' : QString());
 	};
@@ -50,6 +186,8 @@ std::unique_ptr<AbstractWriter> CreateWriter(Format format) {
 	switch (format) {
 	case Format::Html: return std::make_unique<HtmlWriter>();
 	case Format::Json: return std::make_unique<JsonWriter>();
+	case Format::JsonLines:
+		return std::make_unique<JsonWriter>(Format::JsonLines);
 	}
 	Unexpected("Format in Export::Output::CreateWriter.");
 }
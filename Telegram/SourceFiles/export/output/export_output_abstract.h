@@ -29,12 +29,29 @@ namespace Output {
 
 QString NormalizePath(const Settings &settings);
 
+// Files downloaded by an export are listed in a manifest in its folder,
+// so that an interrupted export with the same peer and settings could
+// reuse them. The first line of the manifest describes those settings.
+[[nodiscard]] QString ManifestPath(const QString &folder);
+[[nodiscard]] QByteArray ManifestSettingsLine(const Settings &settings);
+[[nodiscard]] QByteArray ManifestFinishedLine();
+[[nodiscard]] bool CanResumeFromManifest(
+	const QString &folder,
+	const Settings &settings);
+
+// Finds the latest finished export with the same settings next to the
+// folder. Its manifest has the last exported message id of each chat.
+[[nodiscard]] QString FindPreviousExport(
+	const QString &folder,
+	const Settings &settings);
+
 struct Result;
 class Stats;
 
 enum class Format {
 	Html,
 	Json,
+	JsonLines,
 };
 
 class AbstractWriter {
@@ -49,7 +49,12 @@ Result File::writeBlockAttempt(const QByteArray &block) {
 	if (!size) {
 		return Result::Success();
 	}
-	if (_file->write(block) == size && _file->flush()) {
+	const auto started = crl::now();
+	const auto written = (_file->write(block) == size) && _file->flush();
+	if (_stats) {
+		_stats->addDiskTime(crl::now() - started);
+	}
+	if (written) {
 		_offset += size;
 		if (_stats) {
 			_stats->incrementBytes(size);
@@ -95,8 +100,13 @@ Result File::fatalError() const {
 
 QString File::PrepareRelativePath(
 		const QString &folder,
-		const QString &suggested) {
-	if (!QFile::exists(folder + suggested)) {
+		const QString &suggested,
+		const base::flat_set<QString> &reserved) {
+	const auto exists = [&](const QString &relativePath) {
+		return reserved.contains(relativePath)
+			|| QFile::exists(folder + relativePath);
+	};
+	if (!exists(suggested)) {
 		return suggested;
 	}
 
@@ -114,7 +124,7 @@ QString File::PrepareRelativePath(
 	auto attempt = 0;
 	while (true) {
 		const auto relativePath = relativePart(++attempt);
-		if (!QFile::exists(folder + relativePath)) {
+		if (!exists(relativePath)) {
 			return relativePath;
 		}
 	}
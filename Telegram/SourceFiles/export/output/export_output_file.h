@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "base/optional.h"
+#include "base/flat_set.h"
 
 #include <QtCore/QFile>
 #include <QtCore/QString>
@@ -30,7 +31,8 @@ public:
 
 	[[nodiscard]] static QString PrepareRelativePath(
 		const QString &folder,
-		const QString &suggested);
+		const QString &suggested,
+		const base::flat_set<QString> &reserved = {});
 
 	[[nodiscard]] static Result Copy(
 		const QString &source,
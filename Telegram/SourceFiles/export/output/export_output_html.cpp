@@ -20,6 +20,8 @@ namespace Output {
 namespace {
 
 constexpr auto kMessagesInFile = 1000;
+constexpr auto kWriteBufferSize = 1024 * 1024;
+constexpr auto kMessageBlockReserve = 1024;
 constexpr auto kPersonalUserpicSize = 90;
 constexpr auto kEntryUserpicSize = 48;
 constexpr auto kServiceMessagePhotoSize = 60;
@@ -592,6 +594,7 @@ public:
 	~Wrap();
 
 private:
+	[[nodiscard]] Result flush();
 	[[nodiscard]] QByteArray composeStart();
 	[[nodiscard]] QByteArray pushGenericListEntry(
 		const QString &link,
@@ -634,6 +637,7 @@ private:
 	[[nodiscard]] QByteArray pushPoll(const Data::Poll &data);
 
 	File _file;
+	QByteArray _buffer;
 	QByteArray _composedStart;
 	bool _closed = false;
 	QByteArray _base;
@@ -707,7 +711,7 @@ HtmlWriter::Wrap::Wrap(
 }
 
 bool HtmlWriter::Wrap::empty() const {
-	return _file.empty();
+	return _file.empty() && _buffer.isEmpty();
 }
 
 QByteArray HtmlWriter::Wrap::pushTag(
@@ -860,14 +864,34 @@ QByteArray HtmlWriter::Wrap::pushGenericListEntry(
 Result HtmlWriter::Wrap::writeBlock(const QByteArray &block) {
 	Expects(!_closed);
 
-	const auto result = [&] {
-		if (block.isEmpty()) {
-			return _file.writeBlock(block);
-		} else if (_file.empty()) {
-			return _file.writeBlock(_composedStart + block);
+	if (block.isEmpty()) {
+		if (const auto result = flush(); !result) {
+			return result;
 		}
-		return _file.writeBlock(block);
-	}();
+		const auto result = _file.writeBlock(block);
+		if (!result) {
+			_closed = true;
+		}
+		return result;
+	} else if (empty()) {
+		_buffer.reserve(kWriteBufferSize + _composedStart.size());
+		_buffer.append(_composedStart);
+	}
+	_buffer.append(block);
+	return (_buffer.size() >= kWriteBufferSize)
+		? flush()
+		: Result::Success();
+}
+
+Result HtmlWriter::Wrap::flush() {
+	if (_buffer.isEmpty()) {
+		return Result::Success();
+	}
+	const auto result = _file.writeBlock(_buffer);
+
+	// Keeps the reserved capacity for the next blocks.
+	_buffer.resize(0);
+
 	if (!result) {
 		_closed = true;
 	}
@@ -1830,13 +1854,15 @@ bool HtmlWriter::Wrap::forwardedNeedsWrap(
 }
 
 Result HtmlWriter::Wrap::close() {
-	if (!std::exchange(_closed, true) && !_file.empty()) {
-		auto block = QByteArray();
+	if (!_closed && !empty()) {
 		while (!_context.empty()) {
-			block.append(_context.popTag());
+			_buffer.append(_context.popTag());
 		}
-		return _file.writeBlock(block);
+		const auto result = flush();
+		_closed = true;
+		return result;
 	}
+	_closed = true;
 	return Result::Success();
 }
 
@@ -2427,6 +2453,7 @@ Result HtmlWriter::writeDialogSlice(const Data::MessagesSlice &data) {
 	auto previous = _lastMessageInfo.get();
 	auto saved = std::optional<MessageInfo>();
 	auto block = QByteArray();
+	block.reserve(int(data.list.size()) * kMessageBlockReserve);
 	for (const auto &message : data.list) {
 		if (Data::SkipMessageByDate(message, _settings)) {
 			continue;
@@ -82,6 +82,26 @@ QByteArray StringAllowNull(const Data::Utf8String &data) {
 	return data.isEmpty() ? QByteArray("null") : SerializeString(data);
 }
 
+QByteArray Compact(const QByteArray &serialized) {
+	// All line breaks inside the serialized strings are escaped,
+	// so the remaining ones are only followed by the indentation.
+	const auto size = serialized.size();
+	const auto data = serialized.data();
+
+	auto result = QByteArray();
+	result.reserve(size);
+	for (auto i = 0; i != size; ++i) {
+		if (data[i] != '\n') {
+			result.append(data[i]);
+			continue;
+		}
+		while (i + 1 != size && data[i + 1] == ' ') {
+			++i;
+		}
+	}
+	return result;
+}
+
 QByteArray Indentation(int size) {
 	return QByteArray(size, ' ');
 }
@@ -647,6 +667,10 @@ QByteArray SerializeMessage(
 
 } // namespace
 
+JsonWriter::JsonWriter(Format format) : _format(format) {
+	Expects(format == Format::Json || format == Format::JsonLines);
+}
+
 Result JsonWriter::start(
 		const Settings &settings,
 		const Environment &environment,
@@ -1059,6 +1083,16 @@ Result JsonWriter::writeDialogStart(const Data::DialogInfo &data) {
 		+ StringAllowNull(TypeString(data.type)));
 	block.append(prepareObjectItemStart("id")
 		+ Data::NumberToString(data.peerId));
+	if (messagesInLines()) {
+		const auto relativePath = data.relativePath + "messages.jsonl";
+		block.append(prepareObjectItemStart("messages_file")
+			+ SerializeString(relativePath.toUtf8()));
+		_messages = fileWithRelativePath(relativePath);
+		if (const auto result = _messages->writeBlock({}); !result) {
+			return result;
+		}
+		return _output->writeBlock(block);
+	}
 	block.append(prepareObjectItemStart("messages"));
 	block.append(pushNesting(Context::kArray));
 	return _output->writeBlock(block);
@@ -1087,6 +1121,24 @@ Result JsonWriter::writeDialogSlice(const Data::MessagesSlice &data) {
 	Expects(_output != nullptr);
 
 	auto block = QByteArray();
+	if (messagesInLines()) {
+		Assert(_messages != nullptr);
+
+		for (const auto &message : data.list) {
+			if (Data::SkipMessageByDate(message, _settings)) {
+				continue;
+			}
+			block.append(Compact(SerializeMessage(
+				_context,
+				message,
+				data.peers,
+				_environment.internalLinksDomain)));
+			block.append('\n');
+		}
+		return block.isEmpty()
+			? Result::Success()
+			: _messages->writeBlock(block);
+	}
 	for (const auto &message : data.list) {
 		if (Data::SkipMessageByDate(message, _settings)) {
 			continue;
@@ -1103,6 +1155,11 @@ Result JsonWriter::writeDialogSlice(const Data::MessagesSlice &data) {
 Result JsonWriter::writeDialogEnd() {
 	Expects(_output != nullptr);
 
+	if (messagesInLines()) {
+		_messages = nullptr;
+		return _output->writeBlock(popNesting());
+	}
+
 	auto block = popNesting();
 	return _output->writeBlock(block + popNesting());
 }
@@ -1150,6 +1207,10 @@ QString JsonWriter::mainFilePath() {
 	return pathWithRelativePath(mainFileRelativePath());
 }
 
+bool JsonWriter::messagesInLines() const {
+	return (_format == Format::JsonLines);
+}
+
 QString JsonWriter::mainFileRelativePath() const {
 	return "result.json";
 }
@@ -29,8 +29,12 @@ struct JsonContext {
 
 class JsonWriter : public AbstractWriter {
 public:
+	// In the JsonLines format messages of each chat are written
+	// to a separate file, one compact JSON object per line.
+	explicit JsonWriter(Format format = Format::Json);
+
 	Format format() override {
-		return Format::Json;
+		return _format;
 	}
 
 	Result start(
@@ -73,6 +77,7 @@ private:
 	[[nodiscard]] QByteArray prepareArrayItemStart();
 	[[nodiscard]] QByteArray popNesting();
 
+	[[nodiscard]] bool messagesInLines() const;
 	[[nodiscard]] QString mainFileRelativePath() const;
 	[[nodiscard]] QString pathWithRelativePath(const QString &path) const;
 	[[nodiscard]] std::unique_ptr<File> fileWithRelativePath(
@@ -90,6 +95,7 @@ private:
 		const QByteArray &about);
 	[[nodiscard]] Result writeChatsEnd();
 
+	Format _format = Format::Json;
 	Settings _settings;
 	Environment _environment;
 	Stats *_stats = nullptr;
@@ -99,6 +105,7 @@ private:
 	DialogsMode _dialogsMode = DialogsMode::None;
 
 	std::unique_ptr<File> _output;
+	std::unique_ptr<File> _messages;
 
 };
 
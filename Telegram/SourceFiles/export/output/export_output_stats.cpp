@@ -12,7 +12,15 @@ namespace Output {
 
 Stats::Stats(const Stats &other)
 : _files(other._files.load())
-, _bytes(other._bytes.load()) {
+, _bytes(other._bytes.load())
+, _messages(other._messages.load())
+, _requestTime(other._requestTime.load())
+, _diskTime(other._diskTime.load())
+, _started(other._started.load()) {
+}
+
+void Stats::start(crl::time now) {
+	_started = now;
 }
 
 void Stats::incrementFiles() {
@@ -23,6 +31,18 @@ void Stats::incrementBytes(int count) {
 	_bytes += count;
 }
 
+void Stats::incrementMessages(int count) {
+	_messages += count;
+}
+
+void Stats::addRequestTime(crl::time duration) {
+	_requestTime += duration;
+}
+
+void Stats::addDiskTime(crl::time duration) {
+	_diskTime += duration;
+}
+
 int Stats::filesCount() const {
 	return _files;
 }
@@ -31,5 +51,52 @@ int64 Stats::bytesCount() const {
 	return _bytes;
 }
 
+int Stats::messagesCount() const {
+	return _messages;
+}
+
+crl::time Stats::requestTime() const {
+	return _requestTime;
+}
+
+crl::time Stats::diskTime() const {
+	return _diskTime;
+}
+
+crl::time Stats::elapsed(crl::time now) const {
+	const auto started = _started.load();
+	return (started > 0) ? std::max(now - started, crl::time(0)) : 0;
+}
+
+int64 Stats::bytesPerSecond(crl::time now) const {
+	const auto duration = elapsed(now);
+	return (duration > 0) ? (bytesCount() * 1000 / duration) : 0;
+}
+
+int Stats::messagesPerSecond(crl::time now) const {
+	const auto duration = elapsed(now);
+	return (duration > 0) ? int(messagesCount() * 1000LL / duration) : 0;
+}
+
+QByteArray Stats::summary(crl::time now) const {
+	return QString(
+		"Duration: %1 ms\n"
+		"Files: %2\n"
+		"Bytes: %3\n"
+		"Messages: %4\n"
+		"Bytes per second: %5\n"
+		"Messages per second: %6\n"
+		"Time in requests: %7 ms\n"
+		"Time writing to disk: %8 ms\n"
+	).arg(elapsed(now)
+	).arg(filesCount()
+	).arg(bytesCount()
+	).arg(messagesCount()
+	).arg(bytesPerSecond(now)
+	).arg(messagesPerSecond(now)
+	).arg(requestTime()
+	).arg(diskTime()).toUtf8();
+}
+
 } // namespace Output
 } // namespace Export
@@ -17,15 +17,35 @@ public:
 	Stats() = default;
 	Stats(const Stats &other);
 
+	void start(crl::time now);
+
 	void incrementFiles();
 	void incrementBytes(int count);
+	void incrementMessages(int count);
+
+	// Request time includes the flood waits done by MTP::Instance.
+	void addRequestTime(crl::time duration);
+	void addDiskTime(crl::time duration);
 
 	int filesCount() const;
 	int64 bytesCount() const;
+	int messagesCount() const;
+	crl::time requestTime() const;
+	crl::time diskTime() const;
+
+	crl::time elapsed(crl::time now) const;
+	int64 bytesPerSecond(crl::time now) const;
+	int messagesPerSecond(crl::time now) const;
+
+	[[nodiscard]] QByteArray summary(crl::time now) const;
 
 private:
-	std::atomic<int> _files;
-	std::atomic<int64> _bytes;
+	std::atomic<int> _files = 0;
+	std::atomic<int64> _bytes = 0;
+	std::atomic<int> _messages = 0;
+	std::atomic<crl::time> _requestTime = 0;
+	std::atomic<crl::time> _diskTime = 0;
+	std::atomic<crl::time> _started = 0;
 
 };
 
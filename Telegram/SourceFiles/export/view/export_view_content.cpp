@@ -14,6 +14,30 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace Export {
 namespace View {
 
+namespace {
+
+constexpr auto kEstimateMinProgress = 0.01;
+constexpr auto kEstimateMinElapsed = crl::time(10000);
+QString Separator() {
+	return QString::fromUtf8(" \xE2\x80\xA2 ");
+}
+
+QString SpeedText(const ProcessingState &state) {
+	auto result = QStringList();
+	if (state.bytesPerSecond > 0) {
+		result.push_back(Ui::FormatSizeText(state.bytesPerSecond) + "/s");
+	}
+	if (state.messagesPerSecond > 0) {
+		result.push_back(tr::ktg_export_state_messages_speed(
+			tr::now,
+			lt_count,
+			state.messagesPerSecond));
+	}
+	return result.join(Separator());
+}
+
+} // namespace
+
 const QString Content::kDoneId = "done";
 
 Content ContentFromState(
@@ -30,7 +54,7 @@ Content ContentFromState(
 		result.rows.push_back({ id, label, info, progress });
 	};
 	const auto pushMain = [&](const QString &label) {
-		const auto info = (state.entityCount > 0)
+		auto info = (state.entityCount > 0)
 			? (QString::number(state.entityIndex + 1)
 				+ " / "
 				+ QString::number(state.entityCount))
@@ -54,7 +78,23 @@ Content ContentFromState(
 			&& !state.entityIndex)
 			? addPart(state.itemIndex, state.itemCount)
 			: addPart(state.entityIndex, state.entityCount);
-		push("main", label, info, doneProgress + addProgress);
+		const auto progress = doneProgress + addProgress;
+		const auto speed = SpeedText(state);
+		if (!speed.isEmpty()) {
+			info = info.isEmpty() ? speed : (info + Separator() + speed);
+		}
+		if (progress >= kEstimateMinProgress
+			&& progress < 1.
+			&& state.elapsed >= kEstimateMinElapsed) {
+			const auto left = crl::time(state.elapsed
+				* (1. - progress)
+				/ progress);
+			info += Separator() + tr::ktg_export_state_time_left(
+				tr::now,
+				lt_time,
+				Ui::FormatDurationText(left / 1000));
+		}
+		push("main", label, info, progress);
 	};
 	const auto pushBytes = [&](const QString &id, const QString &label) {
 		if (!state.bytesCount) {
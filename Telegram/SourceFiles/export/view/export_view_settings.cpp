@@ -76,6 +76,9 @@ void ChooseFormatBox(
 	box->setTitle(tr::lng_export_option_choose_format());
 	addFormatOption(tr::lng_export_option_html(tr::now), Format::Html);
 	addFormatOption(tr::lng_export_option_json(tr::now), Format::Json);
+	addFormatOption(
+		tr::ktg_export_option_json_lines(tr::now),
+		Format::JsonLines);
 	box->addButton(tr::lng_settings_save(), [=] { done(group->value()); });
 	box->addButton(tr::lng_cancel(), [=] { box->closeBox(); });
 }
@@ -251,6 +254,7 @@ void SettingsWidget::setupPathAndFormat(
 	if (_singlePeerId != 0) {
 		addFormatAndLocationLabel(container);
 		addLimitsLabel(container);
+		addOnlyNewMessagesOption(container);
 		return;
 	}
 	const auto formatGroup = std::make_shared<Ui::RadioenumGroup<Format>>(
@@ -274,6 +278,33 @@ void SettingsWidget::setupPathAndFormat(
 	addLocationLabel(container);
 	addFormatOption(tr::lng_export_option_html(tr::now), Format::Html);
 	addFormatOption(tr::lng_export_option_json(tr::now), Format::Json);
+	addFormatOption(
+		tr::ktg_export_option_json_lines(tr::now),
+		Format::JsonLines);
+	addOnlyNewMessagesOption(container);
+}
+
+void SettingsWidget::addOnlyNewMessagesOption(
+		not_null<Ui::VerticalLayout*> container) {
+	const auto checkbox = container->add(
+		object_ptr<Ui::Checkbox>(
+			container,
+			tr::ktg_export_option_only_new(tr::now),
+			readData().onlyNewMessages,
+			st::defaultBoxCheckbox),
+		st::exportSettingPadding);
+	container->add(
+		object_ptr<Ui::FlatLabel>(
+			container,
+			tr::ktg_export_option_only_new_about(tr::now),
+			st::exportAboutOptionLabel),
+		st::exportAboutOptionPadding);
+	checkbox->checkedChanges(
+	) | rpl::start_with_next([=](bool checked) {
+		changeData([&](Settings &data) {
+			data.onlyNewMessages = checked;
+		});
+	}, checkbox->lifetime());
 }
 
 void SettingsWidget::addLocationLabel(
@@ -342,7 +373,11 @@ void SettingsWidget::addFormatAndLocationLabel(
 		return data.format;
 	}) | rpl::distinct_until_changed(
 	) | rpl::map([](Format format) {
-		const auto text = (format == Format::Html) ? "HTML" : "JSON";
+		const auto text = (format == Format::Html)
+			? "HTML"
+			: (format == Format::Json)
+			? "JSON"
+			: "JSON Lines";
 		return Ui::Text::Link(text, u"internal:edit_format"_q);
 	});
 	const auto label = container->add(
@@ -88,6 +88,8 @@ private:
 		not_null<Ui::VerticalLayout*> container);
 	void addLimitsLabel(
 		not_null<Ui::VerticalLayout*> container);
+	void addOnlyNewMessagesOption(
+		not_null<Ui::VerticalLayout*> container);
 	void chooseFolder();
 	void chooseFormat();
 	void refreshButtons(
@@ -18,6 +18,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 extern "C" {
 #include <libavutil/opt.h>
+#include <libavutil/hwcontext.h>
+#include <libavutil/pixdesc.h>
 } // extern "C"
 
 namespace FFmpeg {
@@ -48,6 +50,62 @@ void AlignedImageBufferCleanupHandler(void* data) {
 		&& !(image.bytesPerLine() % kAlignImageBy);
 }
 
+[[nodiscard]] AVHWDeviceType HwDeviceType(AVPixelFormat format) {
+	switch (format) {
+#ifdef Q_OS_WIN
+	case AV_PIX_FMT_D3D11: return AV_HWDEVICE_TYPE_D3D11VA;
+	case AV_PIX_FMT_DXVA2_VLD: return AV_HWDEVICE_TYPE_DXVA2;
+#elif defined Q_OS_MAC // Q_OS_WIN
+	case AV_PIX_FMT_VIDEOTOOLBOX: return AV_HWDEVICE_TYPE_VIDEOTOOLBOX;
+#else // Q_OS_WIN || Q_OS_MAC
+	case AV_PIX_FMT_VAAPI: return AV_HWDEVICE_TYPE_VAAPI;
+	case AV_PIX_FMT_VDPAU: return AV_HWDEVICE_TYPE_VDPAU;
+#endif // Q_OS_WIN || Q_OS_MAC
+	default: return AV_HWDEVICE_TYPE_NONE;
+	}
+}
+
+[[nodiscard]] bool IsHwFormat(AVPixelFormat format) {
+	const auto descriptor = av_pix_fmt_desc_get(format);
+	return descriptor && (descriptor->flags & AV_PIX_FMT_FLAG_HWACCEL);
+}
+
+AVPixelFormat GetHwFormat(
+		AVCodecContext *context,
+		const AVPixelFormat *formats) {
+	auto software = AV_PIX_FMT_NONE;
+	for (auto format = formats; *format != AV_PIX_FMT_NONE; ++format) {
+		if (!IsHwFormat(*format)) {
+			if (software == AV_PIX_FMT_NONE) {
+				software = *format;
+			}
+			continue;
+		}
+		const auto type = HwDeviceType(*format);
+		if (type == AV_HWDEVICE_TYPE_NONE) {
+			continue;
+		}
+		auto device = (AVBufferRef*)nullptr;
+		const auto error = AvErrorWrap(
+			av_hwdevice_ctx_create(&device, type, nullptr, nullptr, 0));
+		if (error || !device) {
+			LogError(qstr("av_hwdevice_ctx_create"), error);
+			continue;
+		}
+		if (context->hw_device_ctx) {
+			av_buffer_unref(&context->hw_device_ctx);
+		}
+		context->hw_device_ctx = device;
+		LOG(("Video Info: Using \"%1\" hardware decoding for \"%2\"."
+			).arg(av_hwdevice_get_type_name(type)
+			).arg(context->codec->name));
+		return *format;
+	}
+	LOG(("Video Info: Using software decoding for \"%1\"."
+		).arg(context->codec->name));
+	return software;
+}
+
 void UnPremultiplyLine(uchar *dst, const uchar *src, int intsCount) {
 	[[maybe_unused]] const auto udst = reinterpret_cast<uint*>(dst);
 	const auto usrc = reinterpret_cast<const uint*>(src);
@@ -160,9 +218,10 @@ void FormatDeleter::operator()(AVFormatContext *value) {
 	}
 }
 
-CodecPointer MakeCodecPointer(not_null<AVStream*> stream) {
+CodecPointer MakeCodecPointer(CodecDescriptor descriptor) {
 	auto error = AvErrorWrap();
 
+	const auto stream = descriptor.stream;
 	auto result = CodecPointer(avcodec_alloc_context3(nullptr));
 	const auto context = result.get();
 	if (!context) {
@@ -177,6 +236,9 @@ CodecPointer MakeCodecPointer(not_null<AVStream*> stream) {
 	context->pkt_timebase = stream->time_base;
 	av_opt_set(context, "threads", "auto", 0);
 	av_opt_set_int(context, "refcounted_frames", 1, 0);
+	if (descriptor.hwAllowed) {
+		context->get_format = GetHwFormat;
+	}
 
 	const auto codec = avcodec_find_decoder(context->codec_id);
 	if (!codec) {
@@ -209,6 +271,27 @@ void ClearFrameMemory(AVFrame *frame) {
 	}
 }
 
+AVFrame *SoftwareFrame(not_null<AVFrame*> frame, FramePointer &buffer) {
+	if (!frame->hw_frames_ctx) {
+		return frame;
+	} else if (!buffer) {
+		buffer = MakeFramePointer();
+		if (!buffer) {
+			return nullptr;
+		}
+	}
+	ClearFrameMemory(buffer.get());
+	const auto error = AvErrorWrap(
+		av_hwframe_transfer_data(buffer.get(), frame, 0));
+	if (error) {
+		LogError(qstr("av_hwframe_transfer_data"), error);
+		return nullptr;
+	}
+	av_frame_copy_props(buffer.get(), frame);
+	av_frame_unref(frame);
+	return buffer.get();
+}
+
 void FrameDeleter::operator()(AVFrame *value) {
 	av_frame_free(&value);
 }
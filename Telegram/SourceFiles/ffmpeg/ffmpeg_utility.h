@@ -137,7 +137,12 @@ struct CodecDeleter {
 	void operator()(AVCodecContext *value);
 };
 using CodecPointer = std::unique_ptr<AVCodecContext, CodecDeleter>;
-[[nodiscard]] CodecPointer MakeCodecPointer(not_null<AVStream*> stream);
+
+struct CodecDescriptor {
+	not_null<AVStream*> stream;
+	bool hwAllowed = false;
+};
+[[nodiscard]] CodecPointer MakeCodecPointer(CodecDescriptor descriptor);
 
 struct FrameDeleter {
 	void operator()(AVFrame *value);
@@ -147,6 +152,13 @@ using FramePointer = std::unique_ptr<AVFrame, FrameDeleter>;
 [[nodiscard]] bool FrameHasData(AVFrame *frame);
 void ClearFrameMemory(AVFrame *frame);
 
+// Returns the frame itself if it was decoded in software. Otherwise
+// downloads the data from the GPU to the buffer and returns it.
+// Returns nullptr if the download failed.
+[[nodiscard]] AVFrame *SoftwareFrame(
+	not_null<AVFrame*> frame,
+	FramePointer &buffer);
+
 struct SwscaleDeleter {
 	QSize srcSize;
 	int srcFormat = int(AV_PIX_FMT_NONE);
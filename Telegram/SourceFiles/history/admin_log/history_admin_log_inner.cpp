@@ -321,6 +321,11 @@ void InnerWidget::visibleTopBottomUpdated(
 		_userpicsCache = std::move(_userpics);
 	}
 
+	session().data().unloadHeavyViewPartsAround(
+		this,
+		visibleTop,
+		visibleBottom);
+
 	updateVisibleTopItem();
 	checkPreloadMore();
 	if (scrolledUp) {
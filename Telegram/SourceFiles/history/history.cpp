@@ -51,6 +51,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace {
 
 constexpr auto kNewBlockEachMessage = 50;
+constexpr auto kSlowCreateItemsDuration = crl::time(16);
 constexpr auto kSkipCloudDraftsFor = TimeId(3);
 
 using UpdateFlag = Data::HistoryUpdate::Flag;
@@ -379,6 +380,7 @@ std::vector<not_null<HistoryItem*>> History::createItems(
 		const QVector<MTPMessage> &data) {
 	auto result = std::vector<not_null<HistoryItem*>>();
 	result.reserve(data.size());
+	const auto started = crl::now();
 	const auto clientFlags = MTPDmessage_ClientFlags();
 	for (auto i = data.cend(), e = data.cbegin(); i != e;) {
 		const auto detachExistingItem = true;
@@ -387,6 +389,13 @@ std::vector<not_null<HistoryItem*>> History::createItems(
 			result.emplace_back(item);
 		}
 	}
+	const auto duration = crl::now() - started;
+	if (duration > kSlowCreateItemsDuration) {
+		DEBUG_LOG(("History Performance: %1 messages in %2 created in %3 ms."
+			).arg(data.size()
+			).arg(peer->id
+			).arg(duration));
+	}
 	return result;
 }
 
@@ -2720,6 +2729,10 @@ HistoryItem *History::lastSentMessage() const {
 }
 
 void History::resizeToWidth(int newWidth) {
+	resizeToWidth(newWidth, 0, std::numeric_limits<int>::max());
+}
+
+void History::resizeToWidth(int newWidth, int layoutFrom, int layoutTill) {
 	const auto resizeAllItems = (_width != newWidth);
 
 	if (!resizeAllItems && !hasPendingResizedItems()) {
@@ -2730,8 +2743,13 @@ void History::resizeToWidth(int newWidth) {
 	_width = newWidth;
 	int y = 0;
 	for (const auto &block : blocks) {
+		const auto wasTop = block->y();
+		const auto layout = (wasTop < layoutTill)
+			&& (wasTop + block->height() > layoutFrom);
 		block->setY(y);
-		y += block->resizeGetHeight(newWidth, resizeAllItems);
+		y += layout
+			? block->resizeGetHeight(newWidth, resizeAllItems)
+			: block->postponeResize(resizeAllItems);
 	}
 	_height = y;
 }
@@ -3156,6 +3174,17 @@ int HistoryBlock::resizeGetHeight(int newWidth, bool resizeAllItems) {
 	return _height;
 }
 
+int HistoryBlock::postponeResize(bool resizeAllItems) {
+	for (const auto &message : messages) {
+		if (resizeAllItems) {
+			message->setPendingResize();
+		} else if (message->pendingResize()) {
+			_history->setHasPendingResizedItems();
+		}
+	}
+	return _height;
+}
+
 void HistoryBlock::remove(not_null<Element*> view) {
 	Expects(view->block() == this);
 
@@ -262,6 +262,10 @@ public:
 	HistoryItem *lastSentMessage() const;
 
 	void resizeToWidth(int newWidth);
+
+	// Blocks outside of [layoutFrom, layoutTill) in the current layout
+	// keep their heights and are marked for a later resize.
+	void resizeToWidth(int newWidth, int layoutFrom, int layoutTill);
 	void forceFullResize();
 	int height() const;
 
@@ -607,6 +611,7 @@ public:
 	void refreshView(not_null<Element*> view);
 
 	int resizeGetHeight(int newWidth, bool resizeAllItems);
+	int postponeResize(bool resizeAllItems);
 	int y() const {
 		return _y;
 	}
@@ -11,6 +11,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/file_utilities.h"
 #include "core/crash_reports.h"
 #include "core/click_handler_types.h"
+#include "core/paint_stats.h"
 #include "history/history.h"
 #include "history/history_message.h"
 #include "history/view/media/history_view_media.h"
@@ -45,6 +46,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "layout.h"
 #include "main/main_session.h"
 #include "main/main_session_settings.h"
+#include "storage/download_manager_mtproto.h"
 #include "core/application.h"
 #include "apiwrap.h"
 #include "api/api_attached_stickers.h"
@@ -76,6 +78,16 @@ namespace {
 constexpr auto kScrollDateHideTimeout = 1000;
 constexpr auto kUnloadHeavyPartsPages = 2;
 constexpr auto kClearUserpicsAfter = 50;
+constexpr auto kPrefetchLookAhead = crl::time(1000);
+constexpr auto kPrefetchVelocityTimeout = crl::time(300);
+constexpr auto kMaxPrefetchedTracked = 100;
+
+// When the width changes only that many screens around the visible area
+// are laid out at once, the rest is resized later.
+constexpr auto kResizeLayoutPages = 2;
+
+// Heavy parts are unloaded beyond that, don't prefetch further.
+constexpr auto kMaxPrefetchPages = kUnloadHeavyPartsPages;
 
 // Helper binary search for an item in a list that is not completely
 // above the given top of the visible area or below the given bottom of the visible area
@@ -535,9 +547,7 @@ void HistoryInner::paintEvent(QPaintEvent *e) {
 	if (Ui::skipPaintEvent(this, e)) {
 		return;
 	}
-	if (hasPendingResizedItems()) {
-		return;
-	}
+	const auto stats = Core::PaintStats::Span("HistoryInner");
 
 	const auto guard = gsl::finally([&] {
 		_userpicsCache.clear();
@@ -602,18 +612,21 @@ void HistoryInner::paintEvent(QPaintEvent *e) {
 			p.save();
 			p.translate(0, y);
 			if (clip.y() < y + view->height()) while (y < drawToY) {
-				const auto selection = itemRenderSelection(
-					view,
-					selfromy - mtop,
-					seltoy - mtop);
-				view->draw(p, clip.translated(0, -y), selection, ms);
-
-				if (item->hasViews()) {
-					_controller->content()->scheduleViewIncrement(item);
-				}
-				if (item->isUnreadMention() && !item->isUnreadMedia()) {
-					readMentions.insert(item);
-					_widget->enqueueMessageHighlight(view);
+				// Items that are not laid out yet are painted once they are.
+				if (!view->pendingResize()) {
+					const auto selection = itemRenderSelection(
+						view,
+						selfromy - mtop,
+						seltoy - mtop);
+					view->draw(p, clip.translated(0, -y), selection, ms);
+
+					if (item->hasViews()) {
+						_controller->content()->scheduleViewIncrement(item);
+					}
+					if (item->isUnreadMention() && !item->isUnreadMedia()) {
+						readMentions.insert(item);
+						_widget->enqueueMessageHighlight(view);
+					}
 				}
 
 				int32 h = view->height();
@@ -647,7 +660,9 @@ void HistoryInner::paintEvent(QPaintEvent *e) {
 			p.translate(0, y);
 			while (y < drawToY) {
 				const auto h = view->height();
-				if (hclip.y() < y + h && hdrawtop < y + h) {
+				if (hclip.y() < y + h
+					&& hdrawtop < y + h
+					&& !view->pendingResize()) {
 					const auto selection = itemRenderSelection(
 						view,
 						selfromy - htop,
@@ -2097,8 +2112,10 @@ void HistoryInner::checkHistoryActivation() {
 	session().data().histories().readInboxTill(view->data());
 }
 
-void HistoryInner::recountHistoryGeometry() {
-	_contentWidth = _scroll->width();
+void HistoryInner::recountHistoryGeometry(bool full) {
+	const auto wasContentWidth = std::exchange(
+		_contentWidth,
+		_scroll->width());
 
 	const auto visibleHeight = _scroll->height();
 	int oldHistoryPaddingTop = qMax(visibleHeight - historyHeight() - st::historyPaddingBottom, 0);
@@ -2106,9 +2123,34 @@ void HistoryInner::recountHistoryGeometry() {
 		accumulate_max(oldHistoryPaddingTop, st::msgMargin.top() + st::msgMargin.bottom() + st::msgPadding.top() + st::msgPadding.bottom() + st::msgNameFont->height + st::botDescSkip + _botAbout->height);
 	}
 
-	_history->resizeToWidth(_contentWidth);
+	if (full) {
+		_resizeLayoutPages = 0;
+	} else if (wasContentWidth > 0 && wasContentWidth != _contentWidth) {
+		_resizeLayoutPages = kResizeLayoutPages;
+	} else if (_resizeLayoutPages > 0) {
+		_resizeLayoutPages += kResizeLayoutPages;
+	}
+	const auto partial = (_resizeLayoutPages > 0)
+		&& (_visibleAreaBottom > _visibleAreaTop);
+	const auto resize = [&](not_null<History*> history, int top) {
+		if (!partial || top < 0) {
+			history->resizeToWidth(_contentWidth);
+			return;
+		}
+		const auto margin = _resizeLayoutPages * visibleHeight;
+		history->resizeToWidth(
+			_contentWidth,
+			_visibleAreaTop - margin - top,
+			_visibleAreaBottom + margin - top);
+	};
+	const auto historyTopWas = historyTop();
+	const auto migratedTopWas = migratedTop();
+	resize(_history, historyTopWas);
 	if (_migrated) {
-		_migrated->resizeToWidth(_contentWidth);
+		resize(_migrated, migratedTopWas);
+	}
+	if (!hasPendingResizedItems()) {
+		_resizeLayoutPages = 0;
 	}
 
 	// With migrated history we perhaps do not need to display
@@ -2232,12 +2274,14 @@ void HistoryInner::setFirstLoading(bool loading) {
 
 void HistoryInner::visibleAreaUpdated(int top, int bottom) {
 	auto scrolledUp = (top < _visibleAreaTop);
+	const auto scrolledBy = top - _visibleAreaTop;
 	_visibleAreaTop = top;
 	_visibleAreaBottom = bottom;
 	const auto visibleAreaHeight = bottom - top;
 
 	// if history has pending resize events we should not update scrollTopItem
-	if (hasPendingResizedItems()) {
+	// unless they are left by a partial layout, that keeps the item tops
+	if (hasPendingResizedItems() && !_resizeLayoutPages) {
 		return;
 	}
 
@@ -2279,9 +2323,114 @@ void HistoryInner::visibleAreaUpdated(int top, int bottom) {
 	const auto from = _visibleAreaTop - pages * visibleAreaHeight;
 	const auto till = _visibleAreaBottom + pages * visibleAreaHeight;
 	session().data().unloadHeavyViewParts(ElementDelegate(), from, till);
+	prefetchMedia(scrolledBy);
 	checkHistoryActivation();
 }
 
+template <typename Method>
+void HistoryInner::enumerateItemsInRange(int from, int till, Method method) {
+	const auto enumerate = [&](History *history, int historytop) {
+		if (!history || historytop < 0 || history->isEmpty()) {
+			return;
+		}
+		const auto &blocks = history->blocks;
+		auto blockIndex = BinarySearchBlocksOrItems<true>(
+			blocks,
+			from - historytop);
+		for (; blockIndex != int(blocks.size()); ++blockIndex) {
+			const auto block = blocks[blockIndex].get();
+			const auto blocktop = historytop + block->y();
+			if (blocktop >= till) {
+				return;
+			}
+			for (const auto &view : block->messages) {
+				const auto itemtop = blocktop + view->y();
+				if (itemtop >= till) {
+					return;
+				} else if (itemtop + view->height() > from) {
+					method(view.get());
+				}
+			}
+		}
+	};
+	enumerate(_migrated, migratedTop());
+	enumerate(_history, historyTop());
+}
+
+void HistoryInner::prefetchMedia(int scrolledBy) {
+	if (!scrolledBy || hasPendingResizedItems()) {
+		return;
+	}
+	const auto now = crl::now();
+	const auto direction = (scrolledBy > 0) ? 1 : -1;
+	const auto passed = now - _prefetchScrollTime;
+	const auto velocity = std::abs(scrolledBy)
+		/ float64(std::max(passed, crl::time(1)));
+	if (direction != _prefetchDirection) {
+		cancelPrefetchedMedia();
+		_prefetchDirection = direction;
+		_prefetchVelocity = velocity;
+	} else if (passed > kPrefetchVelocityTimeout) {
+		_prefetchVelocity = velocity;
+	} else {
+		// Wheel events come in bursts, smooth the velocity a bit.
+		_prefetchVelocity = (_prefetchVelocity + velocity) / 2.;
+	}
+	_prefetchScrollTime = now;
+
+	const auto visibleAreaHeight = _visibleAreaBottom - _visibleAreaTop;
+	if (visibleAreaHeight <= 0) {
+		return;
+	}
+	const auto ahead = std::clamp(
+		int(_prefetchVelocity * kPrefetchLookAhead),
+		visibleAreaHeight,
+		kMaxPrefetchPages * visibleAreaHeight);
+	const auto from = (direction > 0)
+		? _visibleAreaBottom
+		: (_visibleAreaTop - ahead);
+	const auto till = (direction > 0)
+		? (_visibleAreaBottom + ahead)
+		: _visibleAreaTop;
+
+	auto &downloader = session().downloader();
+	downloader.setPrefetching(true);
+	enumerateItemsInRange(from, till, [&](not_null<Element*> view) {
+		if (const auto media = view->media()) {
+			if (media->prefetch()) {
+				_prefetchedIds.push_back(view->data()->fullId());
+			}
+		}
+	});
+	downloader.setPrefetching(false);
+
+	if (int(_prefetchedIds.size()) > kMaxPrefetchedTracked) {
+		// The oldest ones were most likely scrolled to and shown already.
+		_prefetchedIds.erase(
+			begin(_prefetchedIds),
+			end(_prefetchedIds) - kMaxPrefetchedTracked);
+	}
+}
+
+void HistoryInner::cancelPrefetchedMedia() {
+	const auto &owner = session().data();
+	for (const auto &itemId : base::take(_prefetchedIds)) {
+		const auto item = owner.message(itemId);
+		const auto view = item ? item->mainView() : nullptr;
+		const auto media = view ? view->media() : nullptr;
+		if (!media) {
+			continue;
+		}
+		const auto top = itemTop(view);
+		const auto visible = (top >= 0)
+			&& (top < _visibleAreaBottom)
+			&& (top + view->height() > _visibleAreaTop);
+		if (!visible) {
+			media->cancelPrefetch();
+		}
+	}
+}
+
 bool HistoryInner::displayScrollDate() const {
 	return (_visibleAreaTop <= height() - 2 * (_visibleAreaBottom - _visibleAreaTop));
 }
@@ -64,7 +64,11 @@ public:
 	void touchScrollUpdated(const QPoint &screenPos);
 
 	void checkHistoryActivation();
-	void recountHistoryGeometry();
+
+	// After a width change only a few pages around the visible area are
+	// laid out, each next call lays out that many pages more, until
+	// nothing is left pending or a full layout is requested.
+	void recountHistoryGeometry(bool full = false);
 	void updateSize();
 
 	void repaintItem(const HistoryItem *item);
@@ -218,6 +222,10 @@ private:
 
 	void scrollDateCheck();
 	void scrollDateHideByTimer();
+	void prefetchMedia(int scrolledBy);
+	void cancelPrefetchedMedia();
+	template <typename Method>
+	void enumerateItemsInRange(int from, int till, Method method);
 	bool canHaveFromUserpics() const;
 	void mouseActionStart(const QPoint &screenPos, Qt::MouseButton button);
 	void mouseActionUpdate();
@@ -332,6 +340,7 @@ private:
 	History *_migrated = nullptr;
 	int _contentWidth = 0;
 	int _historyPaddingTop = 0;
+	int _resizeLayoutPages = 0;
 
 	// Save visible area coords for painting / pressing userpics.
 	int _visibleAreaTop = 0;
@@ -402,4 +411,10 @@ private:
 	int _scrollDateLastItemTop = 0;
 	ClickHandlerPtr _scrollDateLink;
 
+	// Media loads started ahead of the scroll in _prefetchDirection.
+	std::vector<FullMsgId> _prefetchedIds;
+	crl::time _prefetchScrollTime = 0;
+	float64 _prefetchVelocity = 0.; // Pixels per millisecond.
+	int _prefetchDirection = 0;
+
 };
@@ -189,6 +189,7 @@ void HistoryMessageForwarded::create(const HistoryMessageVia *via) const {
 		Qt::LayoutDirectionAuto
 	};
 	text.setText(st::fwdTextStyle, phrase, opts);
+	textHeightWidth = -1;
 	static const auto hidden = std::make_shared<LambdaClickHandler>([] {
 		Ui::Toast::Show(tr::lng_forwarded_hidden(tr::now));
 	});
@@ -203,6 +204,14 @@ void HistoryMessageForwarded::create(const HistoryMessageVia *via) const {
 	}
 }
 
+int HistoryMessageForwarded::textHeight(int width) const {
+	if (textHeightWidth != width) {
+		textHeightWidth = width;
+		textHeightCached = text.countHeight(width);
+	}
+	return textHeightCached;
+}
+
 bool HistoryMessageReply::updateData(
 		not_null<HistoryMessage*> holder,
 		bool force) {
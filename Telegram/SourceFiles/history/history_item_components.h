@@ -91,6 +91,9 @@ struct HiddenSenderInfo {
 struct HistoryMessageForwarded : public RuntimeComponent<HistoryMessageForwarded, HistoryItem> {
 	void create(const HistoryMessageVia *via) const;
 
+	// The header is measured on each paint and each mouse move.
+	[[nodiscard]] int textHeight(int width) const;
+
 	TimeId originalDate = 0;
 	PeerData *originalSender = nullptr;
 	std::unique_ptr<HiddenSenderInfo> hiddenSenderInfo;
@@ -98,6 +101,8 @@ struct HistoryMessageForwarded : public RuntimeComponent<HistoryMessageForwarded
 	QString psaType;
 	MsgId originalId = 0;
 	mutable Ui::Text::String text = { 1 };
+	mutable int textHeightWidth = -1;
+	mutable int textHeightCached = 0;
 
 	PeerData *savedFromPeer = nullptr;
 	MsgId savedFromMsgId = 0;
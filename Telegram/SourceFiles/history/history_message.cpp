@@ -44,6 +44,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_channel.h"
 #include "data/data_user.h"
 #include "data/data_histories.h"
+#include "data/data_messages_index.h"
 #include "app.h"
 #include "styles/style_dialogs.h"
 #include "styles/style_widgets.h"
@@ -1516,6 +1517,10 @@ void HistoryMessage::setText(const TextWithEntities &textWithEntities) {
 
 	_textWidth = -1;
 	_textHeight = 0;
+
+	if (const auto index = history()->owner().messagesIndex()) {
+		index->refresh(this);
+	}
 }
 
 void HistoryMessage::reapplyText() {
@@ -1532,6 +1537,10 @@ void HistoryMessage::setEmptyText() {
 
 	_textWidth = -1;
 	_textHeight = 0;
+
+	if (const auto index = history()->owner().messagesIndex()) {
+		index->refresh(this);
+	}
 }
 
 void HistoryMessage::clearIsolatedEmoji() {
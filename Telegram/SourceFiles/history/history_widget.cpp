@@ -150,6 +150,7 @@ constexpr auto kDisplayEditTimeWarningMs = 300 * 1000;
 constexpr auto kFullDayInMs = 86400 * 1000;
 constexpr auto kSaveDraftTimeout = 1000;
 constexpr auto kSaveDraftAnywayTimeout = 5000;
+constexpr auto kPendingResizeTimeout = crl::time(300);
 constexpr auto kSaveCloudDraftIdleTimeout = 14000;
 constexpr auto kRecordingUpdateDelta = crl::time(100);
 constexpr auto kRefreshSlowmodeLabelTimeout = crl::time(200);
@@ -274,6 +275,7 @@ HistoryWidget::HistoryWidget(
 , _topBar(this, controller)
 , _scroll(this, st::historyScroll, false)
 , _updateHistoryItems([=] { updateHistoryItemsByTimer(); })
+, _pendingResizeTimer([=] { handlePendingHistoryUpdate(); })
 , _historyDown(_scroll, st::historyToDown)
 , _unreadMentions(_scroll, st::historyUnreadMentions)
 , _fieldAutocomplete(this, controller)
@@ -1130,7 +1132,7 @@ void HistoryWidget::animatedScrollToItem(MsgId msgId) {
 	Expects(_history != nullptr);
 
 	if (hasPendingResizedItems()) {
-		updateListSize();
+		updateListSize(true);
 	}
 
 	auto to = session().data().message(_channel, msgId);
@@ -1149,7 +1151,7 @@ void HistoryWidget::animatedScrollToY(int scrollTo, HistoryItem *attachTo) {
 	Expects(_history != nullptr);
 
 	if (hasPendingResizedItems()) {
-		updateListSize();
+		updateListSize(true);
 	}
 
 	// Attach our scroll animation to some item.
@@ -2001,6 +2003,11 @@ void HistoryWidget::showHistory(
 		_scrollToAnimation.stop();
 
 		clearAllLoadRequests();
+		auto &histories = session().data().histories();
+		histories.scheduleUnload(_history);
+		if (_migrated) {
+			histories.scheduleUnload(_migrated);
+		}
 		_history = _migrated = nullptr;
 		_list = nullptr;
 		_peer = nullptr;
@@ -2019,7 +2026,6 @@ void HistoryWidget::showHistory(
 	_replyEditMsg = nullptr;
 	_editMsgId = _replyToId = 0;
 	_previewData = nullptr;
-	_previewCache.clear();
 	_fieldBarCancel->hide();
 
 	_membersDropdownShowTimer.cancel();
@@ -2070,6 +2076,11 @@ void HistoryWidget::showHistory(
 	if (_peer) {
 		_history = _peer->owner().history(_peer);
 		_migrated = _history->migrateFrom();
+		auto &histories = session().data().histories();
+		histories.cancelUnload(_history);
+		if (_migrated) {
+			histories.cancelUnload(_migrated);
+		}
 		if (_migrated
 			&& !_migrated->isEmpty()
 			&& (!_history->loadedAtTop() || !_migrated->loadedAtBottom())) {
@@ -4854,7 +4865,7 @@ void HistoryWidget::createUnreadBarAndResize() {
 	const auto was = base::take(_historyInited);
 	_history->addUnreadBar();
 	if (hasPendingResizedItems()) {
-		updateListSize();
+		updateListSize(true);
 	}
 	_historyInited = was;
 }
@@ -4972,10 +4983,15 @@ void HistoryWidget::updateHistoryGeometry(
 	}
 	const auto toY = std::clamp(newScrollTop, 0, _scroll->scrollTopMax());
 	synteticScrollToY(toY);
+
+	if (hasPendingResizedItems()) {
+		// Resize the rest when the width stops changing.
+		_pendingResizeTimer.callOnce(kPendingResizeTimeout);
+	}
 }
 
-void HistoryWidget::updateListSize() {
-	_list->recountHistoryGeometry();
+void HistoryWidget::updateListSize(bool full) {
+	_list->recountHistoryGeometry(full);
 	auto washidden = _scroll->isHidden();
 	if (washidden) {
 		_scroll->show();
@@ -6315,8 +6331,8 @@ void HistoryWidget::checkPreview() {
 				previewCancel();
 			}
 		} else {
-			const auto i = _previewCache.constFind(links);
-			if (i == _previewCache.cend()) {
+			const auto cached = session().data().webpagePreviewCached(links);
+			if (!cached) {
 				_previewRequest = _api.request(MTPmessages_GetWebPagePreview(
 					MTP_flags(0),
 					MTP_string(links),
@@ -6324,8 +6340,8 @@ void HistoryWidget::checkPreview() {
 				)).done([=](const MTPMessageMedia &result, mtpRequestId requestId) {
 					gotPreview(links, result, requestId);
 				}).send();
-			} else if (i.value()) {
-				_previewData = session().data().webpage(i.value());
+			} else if (*cached) {
+				_previewData = session().data().webpage(*cached);
 				updatePreview();
 			} else if (_previewData && _previewData->pendingTill >= 0) {
 				previewCancel();
@@ -6357,7 +6373,7 @@ void HistoryWidget::gotPreview(QString links, const MTPMessageMedia &result, mtp
 	if (result.type() == mtpc_messageMediaWebPage) {
 		const auto &data = result.c_messageMediaWebPage().vwebpage();
 		const auto page = session().data().processWebpage(data);
-		_previewCache.insert(links, page->id);
+		session().data().webpagePreviewRemember(links, page->id);
 		if (page->pendingTill > 0 && page->pendingTill <= base::unixtime::now()) {
 			page->pendingTill = -1;
 		}
@@ -6369,7 +6385,7 @@ void HistoryWidget::gotPreview(QString links, const MTPMessageMedia &result, mtp
 		}
 		session().data().sendWebPageGamePollNotifications();
 	} else if (result.type() == mtpc_messageMediaEmpty) {
-		_previewCache.insert(links, 0);
+		session().data().webpagePreviewRemember(links, 0);
 		if (links == _previewLinks && !_previewCancelled) {
 			_previewData = nullptr;
 			updatePreview();
@@ -6989,8 +7005,9 @@ void HistoryWidget::paintEvent(QPaintEvent *e) {
 	if (Ui::skipPaintEvent(this, e)) {
 		return;
 	}
-	if (hasPendingResizedItems()) {
-		updateListSize();
+	if (hasPendingResizedItems() && !_pendingResizeTimer.isActive()) {
+		// Pending items are laid out by parts, not right in the paint.
+		_pendingResizeTimer.callOnce(0);
 	}
 
 	Window::SectionWidget::PaintBackground(controller(), this, e->rect());
@@ -7096,6 +7113,13 @@ void HistoryWidget::synteticScrollToY(int y) {
 HistoryWidget::~HistoryWidget() {
 	if (_history) {
 		clearAllLoadRequests();
+
+		// Account switch destroys the widget with the chat still shown.
+		auto &histories = _history->owner().histories();
+		histories.scheduleUnload(_history);
+		if (_migrated) {
+			histories.scheduleUnload(_migrated);
+		}
 	}
 	setTabbedPanel(nullptr);
 }
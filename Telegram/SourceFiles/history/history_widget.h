@@ -522,7 +522,7 @@ private:
 	void addMessagesToBack(PeerData *peer, const QVector<MTPMessage> &messages);
 
 	void updateHistoryGeometry(bool initial = false, bool loadedDown = false, const ScrollChange &change = { ScrollChangeNone, 0 });
-	void updateListSize();
+	void updateListSize(bool full = false);
 
 	// Does any of the shown histories has this flag set.
 	bool hasPendingResizedItems() const;
@@ -621,8 +621,6 @@ private:
 	QStringList _parsedLinks;
 	QString _previewLinks;
 	WebPageData *_previewData = nullptr;
-	typedef QMap<QString, WebPageId> PreviewCache;
-	PreviewCache _previewCache;
 	mtpRequestId _previewRequest = 0;
 	Ui::Text::String _previewTitle;
 	Ui::Text::String _previewDescription;
@@ -661,6 +659,7 @@ private:
 	int _lastScrollTop = 0; // gifs optimization
 	crl::time _lastScrolled = 0;
 	base::Timer _updateHistoryItems;
+	base::Timer _pendingResizeTimer;
 
 	crl::time _lastUserScrolled = 0;
 	bool _synteticScrollEvent = false;
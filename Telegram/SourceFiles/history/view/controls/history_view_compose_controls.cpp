@@ -1955,8 +1955,6 @@ void ComposeControls::initWebpageProcess() {
 	const auto parsedLinks = lifetime.make_state<QStringList>();
 	const auto previewLinks = lifetime.make_state<QString>();
 	const auto previewData = lifetime.make_state<WebPageData*>(nullptr);
-	using PreviewCache = std::map<QString, WebPageId>;
-	const auto previewCache = lifetime.make_state<PreviewCache>();
 	const auto previewRequest = lifetime.make_state<mtpRequestId>(0);
 	const auto mtpSender =
 		lifetime.make_state<MTP::Sender>(&_window->session().mtp());
@@ -1999,7 +1997,7 @@ void ComposeControls::initWebpageProcess() {
 		}
 		result.match([=](const MTPDmessageMediaWebPage &d) {
 			const auto page = _history->owner().processWebpage(d.vwebpage());
-			previewCache->insert({ links, page->id });
+			_history->owner().webpagePreviewRemember(links, page->id);
 			auto &till = page->pendingTill;
 			if (till > 0 && till <= base::unixtime::now()) {
 				till = -1;
@@ -2011,7 +2009,7 @@ void ComposeControls::initWebpageProcess() {
 				updatePreview();
 			}
 		}, [=](const MTPDmessageMediaEmpty &d) {
-			previewCache->insert({ links, 0 });
+			_history->owner().webpagePreviewRemember(links, 0);
 			if (links == *previewLinks && !_previewCancelled) {
 				*previewData = nullptr;
 				updatePreview();
@@ -2056,11 +2054,12 @@ void ComposeControls::initWebpageProcess() {
 				_previewCancel();
 			}
 		} else {
-			const auto i = previewCache->find(*previewLinks);
-			if (i == previewCache->end()) {
+			const auto cached = _history->owner().webpagePreviewCached(
+				*previewLinks);
+			if (!cached) {
 				getWebPagePreview();
-			} else if (i->second) {
-				*previewData = _history->owner().webpage(i->second);
+			} else if (*cached) {
+				*previewData = _history->owner().webpage(*cached);
 				updatePreview();
 			} else if (ShowWebPagePreview(*previewData)) {
 				_previewCancel();
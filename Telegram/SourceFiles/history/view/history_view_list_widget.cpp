@@ -677,6 +677,11 @@ void ListWidget::visibleTopBottomUpdated(
 		_userpicsCache = std::move(_userpics);
 	}
 
+	session().data().unloadHeavyViewPartsAround(
+		this,
+		visibleTop,
+		visibleBottom);
+
 	if (initializing) {
 		checkUnreadBarCreation();
 	}
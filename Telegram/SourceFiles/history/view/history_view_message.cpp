@@ -976,7 +976,7 @@ void Message::paintForwardedInfo(Painter &p, QRect &trect, bool selected) const
 		const auto fits = (forwarded->text.maxWidth() + skip1 <= trect.width());
 		const auto skip = fits ? skip1 : skip2;
 		const auto useWidth = trect.width() - skip;
-		const auto countedHeight = forwarded->text.countHeight(useWidth);
+		const auto countedHeight = forwarded->textHeight(useWidth);
 		const auto breakEverywhere = (countedHeight > 2 * serviceFont->height);
 		p.setPen(!forwarded->psaType.isEmpty()
 			? st::boxTextFgGood
@@ -1504,7 +1504,7 @@ bool Message::getStateForwardedInfo(
 				}
 			}
 			const auto useWidth = trect.width() - (fits ? skip1 : skip2);
-			const auto breakEverywhere = (forwarded->text.countHeight(useWidth) > 2 * st::semiboldFont->height);
+			const auto breakEverywhere = (forwarded->textHeight(useWidth) > 2 * st::semiboldFont->height);
 			auto textRequest = request.forText();
 			if (breakEverywhere) {
 				textRequest.flags |= Ui::Text::StateRequest::Flag::BreakEverywhere;
@@ -1452,7 +1452,7 @@ void RepliesWidget::restoreState(not_null<RepliesMemento*> memento) {
 	if (auto replies = memento->getReplies()) {
 		setReplies(std::move(replies));
 	} else if (!_replies) {
-		setReplies(std::make_shared<Data::RepliesList>(_history, _rootId));
+		setReplies(_history->owner().repliesList(_history, _rootId));
 	}
 	restoreReplyReturns(memento->replyReturns());
 	_inner->restoreState(memento->list());
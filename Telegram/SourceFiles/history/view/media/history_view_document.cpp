@@ -580,6 +580,19 @@ void Document::unloadHeavyPart() {
 	_dataMedia = nullptr;
 }
 
+bool Document::prefetch() const {
+	ensureDataMediaCreated();
+	if (_dataMedia->canBePlayed() || _data->loading()) {
+		return false;
+	}
+	_dataMedia->automaticLoad(_realParent->fullId(), _realParent);
+	return _data->loading();
+}
+
+void Document::cancelPrefetch() const {
+	_data->stopAutomaticLoad();
+}
+
 void Document::ensureDataMediaCreated() const {
 	if (_dataMedia) {
 		return;
@@ -591,7 +591,7 @@ void Gif::draw(Painter &p, const QRect &r, TextSelection selection, crl::time ms
 			auto rectw = width() - usew - st::msgReplyPadding.left();
 			auto innerw = rectw - (st::msgReplyPadding.left() + st::msgReplyPadding.right());
 			auto recth = st::msgReplyPadding.top() + st::msgReplyPadding.bottom();
-			auto forwardedHeightReal = forwarded ? forwarded->text.countHeight(innerw) : 0;
+			auto forwardedHeightReal = forwarded ? forwarded->textHeight(innerw) : 0;
 			auto forwardedHeight = qMin(forwardedHeightReal, kMaxGifForwardedBarLines * st::msgServiceNameFont->height);
 			if (forwarded) {
 				recth += forwardedHeight;
@@ -788,7 +788,7 @@ TextState Gif::textState(QPoint point, StateRequest request) const {
 		auto rectw = paintw - usew - st::msgReplyPadding.left();
 		auto innerw = rectw - (st::msgReplyPadding.left() + st::msgReplyPadding.right());
 		auto recth = st::msgReplyPadding.top() + st::msgReplyPadding.bottom();
-		auto forwardedHeightReal = forwarded ? forwarded->text.countHeight(innerw) : 0;
+		auto forwardedHeightReal = forwarded ? forwarded->textHeight(innerw) : 0;
 		auto forwardedHeight = qMin(forwardedHeightReal, kMaxGifForwardedBarLines * st::msgServiceNameFont->height);
 		if (forwarded) {
 			recth += forwardedHeight;
@@ -1361,6 +1361,12 @@ void Gif::unloadHeavyPart() {
 	_videoThumbnailFrame = nullptr;
 }
 
+bool Gif::prefetch() const {
+	// Only the thumbnails, the video itself is loaded by streaming.
+	ensureDataMediaCreated();
+	return false;
+}
+
 void Gif::refreshParentId(not_null<HistoryItem*> realParent) {
 	File::refreshParentId(realParent);
 	if (_parent->media() == this) {
@@ -108,6 +108,7 @@ public:
 
 	bool hasHeavyPart() const override;
 	void unloadHeavyPart() override;
+	bool prefetch() const override;
 
 	void refreshParentId(not_null<HistoryItem*> realParent) override;
 
@@ -157,7 +157,7 @@ public:
 	}
 	virtual void stickerClearLoopPlayed() {
 	}
-	virtual std::unique_ptr<Lottie::SinglePlayer> stickerTakeLottie(
+	virtual std::shared_ptr<Lottie::SinglePlayer> stickerTakeLottie(
 		not_null<DocumentData*> data,
 		const Lottie::ColorReplacements *replacements);
 	virtual void checkAnimation() {
@@ -281,11 +281,23 @@ public:
 	virtual void unloadHeavyPart() {
 	}
 
+	// Starts the loads that painting would start, before it is painted.
+	// Returns true if an automatic download was started by that.
+	virtual bool prefetch() const {
+		return false;
+	}
+	virtual void cancelPrefetch() const {
+	}
+
 	// Should be called only by Data::Session.
 	virtual void updateSharedContactUserId(UserId userId) {
 	}
 	virtual void parentTextUpdated() {
 	}
+	// Returns false if the data change requires a relayout.
+	[[nodiscard]] virtual bool updateInPlace() {
+		return false;
+	}
 
 	virtual ~Media() = default;
 
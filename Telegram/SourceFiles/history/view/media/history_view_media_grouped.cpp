@@ -669,6 +669,22 @@ void GroupedMedia::unloadHeavyPart() {
 	}
 }
 
+bool GroupedMedia::prefetch() const {
+	auto result = false;
+	for (const auto &part : _parts) {
+		if (part.content->prefetch()) {
+			result = true;
+		}
+	}
+	return result;
+}
+
+void GroupedMedia::cancelPrefetch() const {
+	for (const auto &part : _parts) {
+		part.content->cancelPrefetch();
+	}
+}
+
 void GroupedMedia::parentTextUpdated() {
 	history()->owner().requestViewResize(_parent);
 }
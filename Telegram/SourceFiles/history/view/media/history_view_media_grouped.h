@@ -92,6 +92,8 @@ public:
 	void checkAnimation() override;
 	bool hasHeavyPart() const override;
 	void unloadHeavyPart() override;
+	bool prefetch() const override;
+	void cancelPrefetch() const override;
 
 	void parentTextUpdated() override;
 
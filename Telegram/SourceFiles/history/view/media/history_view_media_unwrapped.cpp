@@ -31,7 +31,7 @@ constexpr auto kMaxForwardedBarLines = 4;
 auto UnwrappedMedia::Content::stickerTakeLottie(
 	not_null<DocumentData*> data,
 	const Lottie::ColorReplacements *replacements)
--> std::unique_ptr<Lottie::SinglePlayer> {
+-> std::shared_ptr<Lottie::SinglePlayer> {
 	return nullptr;
 }
 
@@ -171,7 +171,7 @@ UnwrappedMedia::SurroundingInfo UnwrappedMedia::surroundingInfo(
 	auto height = st::msgReplyPadding.top() + st::msgReplyPadding.bottom();
 	const auto innerw = outerw - st::msgReplyPadding.left() - st::msgReplyPadding.right();
 	auto forwardedHeightReal = forwarded
-		? forwarded->text.countHeight(innerw)
+		? forwarded->textHeight(innerw)
 		: 0;
 	auto forwardedHeight = std::min(
 		forwardedHeightReal,
@@ -402,7 +402,7 @@ TextState UnwrappedMedia::textState(QPoint point, StateRequest request) const {
 	return result;
 }
 
-std::unique_ptr<Lottie::SinglePlayer> UnwrappedMedia::stickerTakeLottie(
+std::shared_ptr<Lottie::SinglePlayer> UnwrappedMedia::stickerTakeLottie(
 		not_null<DocumentData*> data,
 		const Lottie::ColorReplacements *replacements) {
 	return _content->stickerTakeLottie(data, replacements);
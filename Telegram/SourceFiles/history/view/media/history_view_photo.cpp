@@ -126,6 +126,19 @@ void Photo::unloadHeavyPart() {
 	_dataMedia = nullptr;
 }
 
+bool Photo::prefetch() const {
+	ensureDataMediaCreated();
+	if (_dataMedia->loaded() || _data->loading()) {
+		return false;
+	}
+	_dataMedia->automaticLoad(_realParent->fullId(), _parent->data());
+	return _data->loading();
+}
+
+void Photo::cancelPrefetch() const {
+	_data->stopAutomaticLoad();
+}
+
 QSize Photo::countOptimalSize() {
 	if (_parent->media() != this) {
 		_caption = Ui::Text::String();
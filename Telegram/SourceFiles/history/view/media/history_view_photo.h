@@ -92,6 +92,8 @@ public:
 
 	bool hasHeavyPart() const override;
 	void unloadHeavyPart() override;
+	bool prefetch() const override;
+	void cancelPrefetch() const override;
 
 protected:
 	float64 dataProgress() const override;
@@ -419,6 +419,31 @@ void Poll::updateTexts() {
 		first ? anim::type::instant : anim::type::normal);
 }
 
+bool Poll::updateInPlace() {
+	if (_pollVersion == _poll->version) {
+		return true;
+	} else if (!_pollVersion
+		|| _flags != _poll->flags()
+		|| _question.toString() != _poll->question) {
+		return false;
+	}
+	const auto sameAnswers = ranges::equal(
+		_answers,
+		_poll->answers,
+		[](const Answer &answer, const PollAnswer &original) {
+			return (answer.option == original.option)
+				&& (answer.text.toString() == original.text);
+		});
+	if (!sameAnswers) {
+		return false;
+	}
+
+	// Only votes, recent voters or the solution have changed,
+	// none of them affects the poll size.
+	updateTexts();
+	return true;
+}
+
 void Poll::checkQuizAnswered() {
 	if (!_voted || !_votedFromHere || !_poll->quiz() || anim::Disabled()) {
 		return;
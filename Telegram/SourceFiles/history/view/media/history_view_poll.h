@@ -61,6 +61,8 @@ public:
 	void unloadHeavyPart() override;
 	bool hasHeavyPart() const override;
 
+	bool updateInPlace() override;
+
 private:
 	struct AnswerAnimation;
 	struct AnswersAnimation;
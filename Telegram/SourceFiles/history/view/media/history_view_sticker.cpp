@@ -30,6 +30,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_file_origin.h"
 #include "lottie/lottie_single_player.h"
 #include "chat_helpers/stickers_lottie.h"
+#include "base/call_delayed.h"
 #include "styles/style_chat.h"
 
 namespace HistoryView {
@@ -209,6 +210,7 @@ void Sticker::paintLottie(Painter &p, const QRect &r, bool selected) {
 		|| (!lastDiceFrame && (frame.index != 0 || !_lottieOncePlayed));
 	if (!paused
 		&& switchToNext
+		&& readyToShowNextFrame(request.box)
 		&& _lottie->markFrameShown()
 		&& playOnce
 		&& !_lottieOncePlayed) {
@@ -217,6 +219,20 @@ void Sticker::paintLottie(Painter &p, const QRect &r, bool selected) {
 	}
 }
 
+bool Sticker::readyToShowNextFrame(QSize box) {
+	const auto delay = ChatHelpers::LottieFrameShowDelay(_lottie.get(), box);
+	if (!delay) {
+		return true;
+	} else if (!_nextFrameRepaintScheduled) {
+		_nextFrameRepaintScheduled = true;
+		base::call_delayed(delay, this, [=] {
+			_nextFrameRepaintScheduled = false;
+			_parent->history()->owner().requestViewRepaint(_parent);
+		});
+	}
+	return false;
+}
+
 void Sticker::paintPixmap(Painter &p, const QRect &r, bool selected) {
 	const auto pixmap = paintedPixmap(selected);
 	if (!pixmap.isNull()) {
@@ -303,12 +319,25 @@ void Sticker::setDiceIndex(const QString &emoji, int index) {
 void Sticker::setupLottie() {
 	Expects(_dataMedia != nullptr);
 
-	_lottie = ChatHelpers::LottiePlayerFromDocument(
-		_dataMedia.get(),
-		_replacements,
-		ChatHelpers::StickerLottieSize::MessageHistory,
-		size() * cIntRetinaFactor(),
-		Lottie::Quality::High);
+	// Looping stickers show the same frames in all the views,
+	// while dice and play-once stickers track their own progress.
+	const auto shared = (_diceIndex < 0)
+		&& !isEmojiSticker()
+		&& Core::App().settings().loopAnimatedStickers();
+	_lottie = shared
+		? ChatHelpers::SharedLottiePlayerFromDocument(
+			_dataMedia.get(),
+			_replacements,
+			ChatHelpers::StickerLottieSize::MessageHistory,
+			size() * cIntRetinaFactor(),
+			Lottie::Quality::High)
+		: std::shared_ptr<Lottie::SinglePlayer>(
+			ChatHelpers::LottiePlayerFromDocument(
+				_dataMedia.get(),
+				_replacements,
+				ChatHelpers::StickerLottieSize::MessageHistory,
+				size() * cIntRetinaFactor(),
+				Lottie::Quality::High));
 	lottieCreated();
 }
 
@@ -348,7 +377,7 @@ void Sticker::unloadLottie() {
 	_parent->checkHeavyPart();
 }
 
-std::unique_ptr<Lottie::SinglePlayer> Sticker::stickerTakeLottie(
+std::shared_ptr<Lottie::SinglePlayer> Sticker::stickerTakeLottie(
 		not_null<DocumentData*> data,
 		const Lottie::ColorReplacements *replacements) {
 	return (data == _data && replacements == _replacements)
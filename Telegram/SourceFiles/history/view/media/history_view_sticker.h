@@ -50,7 +50,7 @@ public:
 	void stickerClearLoopPlayed() override {
 		_lottieOncePlayed = false;
 	}
-	std::unique_ptr<Lottie::SinglePlayer> stickerTakeLottie(
+	std::shared_ptr<Lottie::SinglePlayer> stickerTakeLottie(
 		not_null<DocumentData*> data,
 		const Lottie::ColorReplacements *replacements) override;
 
@@ -84,6 +84,7 @@ public:
 private:
 	[[nodiscard]] bool isEmojiSticker() const;
 	void paintLottie(Painter &p, const QRect &r, bool selected);
+	[[nodiscard]] bool readyToShowNextFrame(QSize box);
 	void paintPixmap(Painter &p, const QRect &r, bool selected);
 	[[nodiscard]] QPixmap paintedPixmap(bool selected) const;
 
@@ -97,7 +98,7 @@ private:
 	const not_null<Element*> _parent;
 	const not_null<DocumentData*> _data;
 	const Lottie::ColorReplacements *_replacements = nullptr;
-	std::unique_ptr<Lottie::SinglePlayer> _lottie;
+	std::shared_ptr<Lottie::SinglePlayer> _lottie;
 	mutable std::shared_ptr<Data::DocumentMedia> _dataMedia;
 	ClickHandlerPtr _link;
 	QSize _size;
@@ -108,6 +109,7 @@ private:
 	mutable int _framesCount = -1;
 	mutable bool _lottieOncePlayed = false;
 	mutable bool _nextLastDiceFrame = false;
+	bool _nextFrameRepaintScheduled = false;
 
 	rpl::lifetime _lifetime;
 
@@ -454,6 +454,16 @@ void WebPage::unloadHeavyPart() {
 	_photoMedia = nullptr;
 }
 
+bool WebPage::prefetch() const {
+	return _attach ? _attach->prefetch() : false;
+}
+
+void WebPage::cancelPrefetch() const {
+	if (_attach) {
+		_attach->cancelPrefetch();
+	}
+}
+
 void WebPage::draw(Painter &p, const QRect &r, TextSelection selection, crl::time ms) const {
 	if (width() < st::msgPadding.left() + st::msgPadding.right() + 1) return;
 	auto paintx = 0, painty = 0, paintw = width(), painth = height();
@@ -88,6 +88,8 @@ public:
 
 	bool hasHeavyPart() const override;
 	void unloadHeavyPart() override;
+	bool prefetch() const override;
+	void cancelPrefetch() const override;
 
 	~WebPage();
 
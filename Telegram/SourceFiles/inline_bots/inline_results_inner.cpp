@@ -456,6 +456,30 @@ void Inner::preloadImages() {
 	}
 }
 
+void Inner::preloadFirstRow() {
+	if (_rows.empty()) {
+		return;
+	}
+	for (const auto &item : _rows.front().items) {
+		item->preload();
+	}
+}
+
+void Inner::inlineResultsExpired(const Results &results) {
+	clearSelection();
+	for (const auto &result : results) {
+		const auto i = _inlineLayouts.find(result.get());
+		if (i == _inlineLayouts.cend()) {
+			continue;
+		} else if (i->second->position() >= 0) {
+			// The rows were not refreshed, they still show these results.
+			clearInlineRows(true);
+		}
+		_inlineLayouts.erase(i);
+	}
+	update();
+}
+
 void Inner::hideInlineRowsPanel() {
 	clearInlineRows(false);
 }
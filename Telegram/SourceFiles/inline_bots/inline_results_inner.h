@@ -56,6 +56,10 @@ struct CacheEntry {
 	QString nextOffset;
 	QString switchPmText, switchPmStartToken;
 	Results results;
+	crl::time cacheTill = 0;
+
+	// Shown until the results of the new first page request replace them.
+	bool expired = false;
 };
 
 class Inner
@@ -77,6 +81,8 @@ public:
 	void clearInlineRowsPanel();
 
 	void preloadImages();
+	void preloadFirstRow();
+	void inlineResultsExpired(const Results &results);
 
 	void inlineItemLayoutChanged(const ItemBase *layout) override;
 	void inlineItemRepaint(const ItemBase *layout) override;
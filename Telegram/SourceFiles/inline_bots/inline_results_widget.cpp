@@ -25,6 +25,12 @@ namespace {
 
 constexpr auto kInlineBotRequestDelay = 400;
 
+// Checked only on a new lookup, so zero cache_time results are not
+// reused for the next lookup, but can still be paged through.
+[[nodiscard]] bool CacheEntryExpired(not_null<const CacheEntry*> entry) {
+	return entry->expired || (entry->cacheTill <= crl::now());
+}
+
 } // namespace
 
 Widget::Widget(
@@ -348,6 +354,7 @@ void Widget::inlineResultsDone(const MTPmessages_BotResults &result) {
 
 	auto it = _inlineCache.find(_inlineQuery);
 	auto adding = (it != _inlineCache.cend());
+	auto expired = std::unique_ptr<CacheEntry>();
 	if (result.type() == mtpc_messages_botResults) {
 		auto &d = result.c_messages_botResults();
 		_controller->session().data().processUsers(d.vusers());
@@ -355,10 +362,19 @@ void Widget::inlineResultsDone(const MTPmessages_BotResults &result) {
 		auto &v = d.vresults().v;
 		auto queryId = d.vquery_id().v;
 
+		if (adding && it->second->expired) {
+			// Keep the old results alive until the rows move off them.
+			expired = base::take(it->second);
+			_inlineCache.erase(it);
+			it = _inlineCache.end();
+			adding = false;
+		}
 		if (it == _inlineCache.cend()) {
 			it = _inlineCache.emplace(
 				_inlineQuery,
 				std::make_unique<CacheEntry>()).first;
+			it->second->cacheTill = crl::now()
+				+ d.vcache_time().v * crl::time(1000);
 		}
 		auto entry = it->second.get();
 		entry->nextOffset = qs(d.vnext_offset().value_or_empty());
@@ -393,6 +409,11 @@ void Widget::inlineResultsDone(const MTPmessages_BotResults &result) {
 
 	if (!showInlineRows(!adding)) {
 		it->second->nextOffset = QString();
+	} else if (!adding) {
+		_inner->preloadFirstRow();
+	}
+	if (expired) {
+		_inner->inlineResultsExpired(expired->results);
 	}
 	onScroll();
 }
@@ -412,11 +433,17 @@ void Widget::queryInlineBot(UserData *bot, PeerData *peer, QString query) {
 			_inlineRequestId = 0;
 			_requesting.fire(false);
 		}
-		if (_inlineCache.find(query) != _inlineCache.cend()) {
+		// The bot asked not to keep expired results for so long,
+		// request them again and replace the entry when they arrive.
+		const auto i = _inlineCache.find(query);
+		if (i != _inlineCache.cend() && !CacheEntryExpired(i->second.get())) {
 			_inlineRequestTimer.cancel();
 			_inlineQuery = _inlineNextQuery = query;
 			showInlineRows(true);
 		} else {
+			if (i != _inlineCache.cend()) {
+				i->second->expired = true;
+			}
 			_inlineNextQuery = query;
 			_inlineRequestTimer.callOnce(kInlineBotRequestDelay);
 		}
@@ -429,7 +456,7 @@ void Widget::onInlineRequest() {
 
 	QString nextOffset;
 	auto it = _inlineCache.find(_inlineQuery);
-	if (it != _inlineCache.cend()) {
+	if (it != _inlineCache.cend() && !it->second->expired) {
 		nextOffset = it->second->nextOffset;
 		if (nextOffset.isEmpty()) {
 			return;
@@ -21,6 +21,8 @@ https://github.com/kotatogram/kotatogram-desktop/blob/dev/LEGAL
 #include <QtCore/QJsonArray>
 #include <QtCore/QJsonValue>
 #include <QtCore/QTimer>
+#include <QtCore/QSaveFile>
+#include <QtCore/QMutex>
 
 namespace Kotato {
 namespace JsonSettings {
@@ -61,6 +63,27 @@ bool DefaultFileIsValid() {
 	return true;
 }
 
+void WriteFileAtomic(
+		const QString &path,
+		const QByteArray &content,
+		uint64 generation) {
+	static QMutex Mutex;
+	static auto WrittenGeneration = uint64(0);
+
+	// Writes may finish out of order, never replace a newer content.
+	QMutexLocker lock(&Mutex);
+	if (generation <= WrittenGeneration) {
+		return;
+	}
+	WrittenGeneration = generation;
+
+	auto file = QSaveFile(path);
+	if (file.open(QIODevice::WriteOnly)) {
+		file.write(content);
+		file.commit();
+	}
+}
+
 void WriteDefaultCustomFile() {
 	const auto path = CustomFilePath();
 	auto input = QFile(":/misc/default_kotato-settings-custom.json");
@@ -371,6 +394,19 @@ QByteArray GenerateSettingsJson(bool areDefault = false) {
 	settings.insert(qsl("always_show_scheduled"), cAlwaysShowScheduled());
 	settings.insert(qsl("show_chat_id"), cShowChatId());
 	settings.insert(qsl("show_phone_in_drawer"), cShowPhoneInDrawer());
+	settings.insert(qsl("net_adaptive_download"), cNetAdaptiveDownload());
+	settings.insert(qsl("net_warm_up_connections"), cNetWarmUpConnections());
+	settings.insert(qsl("hw_video_decoding"), cHardwareVideoDecoding());
+	settings.insert(qsl("fast_cache_path"), cFastCachePath());
+	settings.insert(qsl("local_messages_index"), cLocalMessagesIndex());
+	settings.insert(qsl("image_pixmap_cache_limit"), cImagePixmapCacheLimit());
+	settings.insert(qsl("export_from_local_cache"), cExportFromLocalCache());
+	settings.insert(qsl("video_compress_bitrate"), cVideoCompressBitrate());
+	settings.insert(qsl("small_video_low_power"), cSmallVideoLowPower());
+	settings.insert(qsl("small_video_skip_frames"), cSmallVideoSkipFrames());
+	settings.insert(
+		qsl("mtp_log_filter"),
+		QJsonArray::fromStringList(cMtpLogFilter()));
 	settings.insert(qsl("chat_list_lines"), DialogListLines());
 	settings.insert(qsl("disable_up_edit"), cDisableUpEdit());
 	settings.insert(qsl("confirm_before_calls"), cConfirmBeforeCall());
@@ -426,9 +462,11 @@ void Manager::fill() {
 }
 
 void Manager::write(bool force) {
-	if (force && _jsonWriteTimer.isActive()) {
+	if (force && (_jsonWriteTimer.isActive() || _writeGeneration > 0)) {
+		// Make sure the last content is on disk before we quit,
+		// even if a background write is still in progress.
 		_jsonWriteTimer.stop();
-		writeTimeout();
+		writeCurrentSettings(true);
 	} else if (!force && !_jsonWriteTimer.isActive()) {
 		_jsonWriteTimer.start(kWriteJsonTimeout);
 	}
@@ -556,6 +594,60 @@ bool Manager::readCustomFile() {
 		cSetShowPhoneInDrawer(v);
 	});
 
+	ReadBoolOption(settings, "net_adaptive_download", [&](auto v) {
+		cSetNetAdaptiveDownload(v);
+	});
+
+	ReadBoolOption(settings, "net_warm_up_connections", [&](auto v) {
+		cSetNetWarmUpConnections(v);
+	});
+
+	ReadBoolOption(settings, "hw_video_decoding", [&](auto v) {
+		cSetHardwareVideoDecoding(v);
+	});
+
+	ReadStringOption(settings, "fast_cache_path", [&](auto v) {
+		cSetFastCachePath(v);
+	});
+
+	ReadBoolOption(settings, "local_messages_index", [&](auto v) {
+		cSetLocalMessagesIndex(v);
+	});
+
+	ReadIntOption(settings, "image_pixmap_cache_limit", [&](auto v) {
+		if (v >= 0) {
+			cSetImagePixmapCacheLimit(v);
+		}
+	});
+
+	ReadBoolOption(settings, "export_from_local_cache", [&](auto v) {
+		cSetExportFromLocalCache(v);
+	});
+
+	ReadIntOption(settings, "video_compress_bitrate", [&](auto v) {
+		if (v >= 0) {
+			cSetVideoCompressBitrate(v);
+		}
+	});
+
+	ReadBoolOption(settings, "small_video_low_power", [&](auto v) {
+		cSetSmallVideoLowPower(v);
+	});
+
+	ReadBoolOption(settings, "small_video_skip_frames", [&](auto v) {
+		cSetSmallVideoSkipFrames(v);
+	});
+
+	ReadArrayOption(settings, "mtp_log_filter", [&](auto v) {
+		auto filter = QStringList();
+		for (auto i = v.constBegin(), e = v.constEnd(); i != e; ++i) {
+			if ((*i).isString() && !(*i).toString().isEmpty()) {
+				filter.push_back((*i).toString());
+			}
+		}
+		cSetMtpLogFilter(filter);
+	});
+
 	ReadArrayOption(settings, "scales", [&](auto v) {
 		ClearCustomScales();
 		for (auto i = v.constBegin(), e = v.constEnd(); i != e; ++i) {
@@ -943,11 +1035,7 @@ void Manager::writeDefaultFile() {
 	file.write(GenerateSettingsJson(true));
 }
 
-void Manager::writeCurrentSettings() {
-	auto file = QFile(CustomFilePath());
-	if (!file.open(QIODevice::WriteOnly)) {
-		return;
-	}
+void Manager::writeCurrentSettings(bool sync) {
 	if (_jsonWriteTimer.isActive()) {
 		writing();
 	}
@@ -957,8 +1045,24 @@ void Manager::writeCurrentSettings() {
 // You should restart app to see changes
 
 )HEADER";
-	file.write(customHeader);
-	file.write(GenerateSettingsJson());
+
+	// Settings are read on the main thread, the file is written in the
+	// background and only if something has changed since the last write.
+	auto content = QByteArray(customHeader) + GenerateSettingsJson();
+	if (!sync && content == _writtenContent) {
+		return;
+	}
+	_writtenContent = content;
+
+	const auto path = CustomFilePath();
+	const auto generation = ++_writeGeneration;
+	if (sync) {
+		WriteFileAtomic(path, content, generation);
+	} else {
+		crl::async([=] {
+			WriteFileAtomic(path, content, generation);
+		});
+	}
 }
 
 void Manager::writeTimeout() {
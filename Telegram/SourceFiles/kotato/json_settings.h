@@ -25,11 +25,13 @@ public slots:
 
 private:
 	void writeDefaultFile();
-	void writeCurrentSettings();
+	void writeCurrentSettings(bool sync = false);
 	bool readCustomFile();
 	void writing();
 
 	QTimer _jsonWriteTimer;
+	QByteArray _writtenContent;
+	uint64 _writeGeneration = 0;
 
 };
 
@@ -82,6 +82,17 @@ int gNetSpeedBoost = 0;
 int gNetRequestsCount = 2;
 int gNetUploadSessionsCount = 2;
 int gNetUploadRequestInterval = 500;
+bool gNetAdaptiveDownload = false;
+bool gNetWarmUpConnections = false;
+bool gHardwareVideoDecoding = false;
+QString gFastCachePath;
+bool gLocalMessagesIndex = false;
+int gImagePixmapCacheLimit = 256;
+bool gExportFromLocalCache = true;
+int gVideoCompressBitrate = 0;
+bool gSmallVideoLowPower = true;
+bool gSmallVideoSkipFrames = false;
+QStringList gMtpLogFilter;
 
 bool gShowPhoneInDrawer = true;
 
@@ -58,6 +58,17 @@ DeclareSetting(int, NetSpeedBoost);
 DeclareSetting(int, NetRequestsCount);
 DeclareSetting(int, NetUploadSessionsCount);
 DeclareSetting(int, NetUploadRequestInterval);
+DeclareSetting(bool, NetAdaptiveDownload);
+DeclareSetting(bool, NetWarmUpConnections);
+DeclareSetting(bool, HardwareVideoDecoding);
+DeclareSetting(QString, FastCachePath);
+DeclareSetting(bool, LocalMessagesIndex);
+DeclareSetting(int, ImagePixmapCacheLimit);
+DeclareSetting(bool, ExportFromLocalCache);
+DeclareSetting(int, VideoCompressBitrate);
+DeclareSetting(bool, SmallVideoLowPower);
+DeclareSetting(bool, SmallVideoSkipFrames);
+DeclareSetting(QStringList, MtpLogFilter);
 
 inline void SetNetworkBoost(int boost) {
 	if (boost < 0) {
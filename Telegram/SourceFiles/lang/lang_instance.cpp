@@ -260,6 +260,7 @@ Instance::Instance(not_null<Instance*> derived, const PrivateTag &)
 void Instance::switchToId(const Language &data) {
 	reset(data);
 	if (_id == qstr("#TEST_X") || _id == qstr("#TEST_0")) {
+		parsePendingValues();
 		for (auto &value : _values) {
 			value = PrepareTestValue(value, _id[5]);
 		}
@@ -305,6 +306,7 @@ void Instance::reset(const Language &data) {
 	_customFileContent = QByteArray();
 	_version = 0;
 	_nonDefaultValues.clear();
+	_pendingValues.clear();
 	for (auto i = 0, count = int(_values.size()); i != count; ++i) {
 		_values[i] = GetOriginalValue(ushort(i));
 	}
@@ -551,7 +553,7 @@ void Instance::fillFromSerialized(
 	_customFileContent = customFileContent;
 	LOG(("Lang Info: Loaded cached, keys: %1").arg(nonDefaultValuesCount));
 	for (auto i = 0, count = nonDefaultValuesCount * 2; i != count; i += 2) {
-		applyValue(nonDefaultStrings[i], nonDefaultStrings[i + 1]);
+		applyValueDelayed(nonDefaultStrings[i], nonDefaultStrings[i + 1]);
 	}
 	updatePluralRules();
 
@@ -798,7 +800,7 @@ void Instance::applyDifferenceToMe(
 	_version = difference.vversion().v;
 	for (const auto &string : difference.vstrings().v) {
 		HandleString(string, [&](auto &&key, auto &&value) {
-			applyValue(key, value);
+			applyValueDelayed(key, value);
 		}, [&](auto &&key) {
 			resetValue(key);
 		});
@@ -842,13 +844,77 @@ void Instance::applyValue(const QByteArray &key, const QByteArray &value) {
 	ParseKeyValue(key, value, [&](ushort key, QString &&value) {
 		_nonDefaultSet[key] = 1;
 		if (!_derived) {
+			clearPendingValue(key);
 			_values[key] = std::move(value);
 		} else if (!_derived->_nonDefaultSet[key]) {
+			_derived->clearPendingValue(key);
 			_derived->_values[key] = std::move(value);
 		}
 	});
 }
 
+void Instance::applyValueDelayed(
+		const QByteArray &key,
+		const QByteArray &value) {
+	_nonDefaultValues[key] = value;
+	const auto index = GetKeyIndex(QLatin1String(key));
+	if (index == kKeysCount) {
+		if (!key.startsWith("cloud_")) {
+			DEBUG_LOG(("Lang Warning: Unknown key '%1'"
+				).arg(QString::fromLatin1(key)));
+		}
+		return;
+	}
+	_nonDefaultSet[index] = 1;
+	if (!_derived) {
+		setPendingValue(index, key, value);
+	} else if (!_derived->_nonDefaultSet[index]) {
+		_derived->setPendingValue(index, key, value);
+	}
+}
+
+void Instance::setPendingValue(
+		ushort key,
+		const QByteArray &name,
+		const QByteArray &value) {
+	if (value.isEmpty()) {
+		clearPendingValue(key);
+		_values[key] = QString();
+		return;
+	} else if (_pendingValues.empty()) {
+		_pendingValues.resize(kKeysCount);
+	}
+	_pendingValues[key] = PendingValue{ name, value };
+}
+
+void Instance::clearPendingValue(ushort key) {
+	if (!_pendingValues.empty()) {
+		_pendingValues[key] = PendingValue();
+	}
+}
+
+void Instance::parsePendingValue(ushort key) const {
+	const auto pending = base::take(_pendingValues[key]);
+	ValueParser parser(pending.key, key, pending.value);
+	if (parser.parse()) {
+		_values[key] = parser.takeResult();
+	} else {
+		_values[key] = GetOriginalValue(key);
+	}
+}
+
+void Instance::parsePendingValues() {
+	if (_pendingValues.empty()) {
+		return;
+	}
+	for (auto i = 0; i != kKeysCount; ++i) {
+		if (!_pendingValues[i].value.isEmpty()) {
+			parsePendingValue(ushort(i));
+		}
+	}
+	_pendingValues.clear();
+}
+
 void Instance::updatePluralRules() {
 	if (_pluralId.isEmpty()) {
 		_pluralId = isCustom()
@@ -867,6 +933,7 @@ void Instance::resetValue(const QByteArray &key) {
 	if (keyIndex != kKeysCount) {
 		_nonDefaultSet[keyIndex] = 0;
 		if (!_derived) {
+			clearPendingValue(keyIndex);
 			const auto base = _base
 				? _base->getNonDefaultValue(key)
 				: QString();
@@ -874,6 +941,7 @@ void Instance::resetValue(const QByteArray &key) {
 				? base
 				: GetOriginalValue(keyIndex);
 		} else if (!_derived->_nonDefaultSet[keyIndex]) {
+			_derived->clearPendingValue(keyIndex);
 			_derived->_values[keyIndex] = GetOriginalValue(keyIndex);
 		}
 	}
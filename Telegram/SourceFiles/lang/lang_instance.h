@@ -90,6 +90,9 @@ public:
 	QString getValue(ushort key) const {
 		Expects(key < _values.size());
 
+		if (!_pendingValues.empty() && !_pendingValues[key].value.isEmpty()) {
+			parsePendingValue(key);
+		}
 		return _values[key];
 	}
 	QString getNonDefaultValue(const QByteArray &key) const;
@@ -106,10 +109,23 @@ public:
 	}
 
 private:
+	struct PendingValue {
+		QByteArray key;
+		QByteArray value;
+	};
+
 	void setBaseId(const QString &baseId, const QString &pluralId);
 
 	void applyDifferenceToMe(const MTPDlangPackDifference &difference);
 	void applyValue(const QByteArray &key, const QByteArray &value);
+	void applyValueDelayed(const QByteArray &key, const QByteArray &value);
+	void setPendingValue(
+		ushort key,
+		const QByteArray &name,
+		const QByteArray &value);
+	void clearPendingValue(ushort key);
+	void parsePendingValue(ushort key) const;
+	void parsePendingValues();
 	void resetValue(const QByteArray &key);
 	void reset(const Language &language);
 	void fillFromCustomContent(
@@ -138,7 +154,11 @@ private:
 
 	mutable QString _systemLanguage;
 
-	std::vector<QString> _values;
+	mutable std::vector<QString> _values;
+
+	// Values applied from the cached or cloud langpack are kept as raw
+	// bytes and parsed on the first access. Empty when nothing is pending.
+	mutable std::vector<PendingValue> _pendingValues;
 	std::vector<uchar> _nonDefaultSet;
 	std::map<QByteArray, QByteArray> _nonDefaultValues;
 
@@ -11,6 +11,9 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/crash_reports.h"
 #include "core/launcher.h"
 
+#include <thread>
+#include <condition_variable>
+
 namespace {
 
 std::atomic<int> ThreadCounter/* = 0*/;
@@ -65,6 +68,16 @@ public:
 		for (int32 i = 0; i < LogDataCount; ++i) {
 			files[i].reset(new QFile());
 		}
+		_writer = std::thread([=] { writerLoop(); });
+	}
+
+	~LogsDataFields() {
+		{
+			std::unique_lock<std::mutex> lock(_pendingMutex);
+			_writerStopping = true;
+		}
+		_pendingCondition.notify_one();
+		_writer.join();
 	}
 
 	bool openMain() {
@@ -97,10 +110,11 @@ public:
 	}
 
 	void write(LogDataType type, const QString &msg) {
-		QMutexLocker lock(_logsMutex(type));
 		if (type != LogDataMain) {
-			reopenDebug();
+			writeDelayed(type, msg.toUtf8());
+			return;
 		}
+		QMutexLocker lock(_logsMutex(type));
 		const auto file = files[type].get();
 		if (!file || !file->isOpen()) {
 			return;
@@ -110,8 +124,88 @@ public:
 	}
 
 private:
+	struct PendingEntry {
+		LogDataType type = LogDataMain;
+		QByteArray data;
+		FnMut<QString()> render;
+	};
+
+	// The main log is written right away, so that it is complete in
+	// crash reports. Debug logs are written in batches by a separate
+	// thread, so that the network threads don't wait for the disk.
+	void writeDelayed(LogDataType type, QByteArray &&data) {
+		push({ type, std::move(data) });
+	}
+
+	void writeDeferred(LogDataType type, FnMut<QString()> render) {
+		push({ type, QByteArray(), std::move(render) });
+	}
+
+	void push(PendingEntry &&entry) {
+		auto wake = false;
+		{
+			std::unique_lock<std::mutex> lock(_pendingMutex);
+			wake = _pending.empty();
+			_pending.push_back(std::move(entry));
+		}
+		if (wake) {
+			_pendingCondition.notify_one();
+		}
+	}
+
+	void writerLoop() {
+		auto batch = std::vector<PendingEntry>();
+		auto lock = std::unique_lock<std::mutex>(_pendingMutex);
+		while (true) {
+			_pendingCondition.wait(lock, [&] {
+				return _writerStopping || !_pending.empty();
+			});
+			if (_pending.empty()) {
+				return;
+			}
+			std::swap(batch, _pending);
+			lock.unlock();
+
+			writeBatch(batch);
+			batch.clear();
+
+			lock.lock();
+		}
+	}
+
+	void writeBatch(std::vector<PendingEntry> &batch) {
+		// Only the writer thread touches the debug log files.
+		reopenDebug();
+
+		bool written[LogDataCount] = { false };
+		for (auto &entry : batch) {
+			const auto file = files[entry.type].get();
+			if (!file || !file->isOpen()) {
+				continue;
+			} else if (entry.render) {
+				entry.data = entry.render().toUtf8();
+				if (entry.data.isEmpty()) {
+					continue;
+				}
+			}
+			file->write(entry.data);
+			written[entry.type] = true;
+		}
+		for (int32 i = 0; i < LogDataCount; ++i) {
+			if (written[i]) {
+				files[i]->flush();
+			}
+		}
+	}
+
 	std::unique_ptr<QFile> files[LogDataCount];
 
+	std::thread _writer;
+	std::mutex _pendingMutex;
+	std::condition_variable _pendingCondition;
+	std::vector<PendingEntry> _pending;
+	bool _writerStopping = false;
+
 	int32 part = -1;
 
 	bool reopen(LogDataType type, int32 dayIndex, const QString &postfix) {
@@ -258,6 +352,14 @@ void _logsWrite(LogDataType type, const QString &msg) {
 	}
 }
 
+void _logsWriteDeferred(LogDataType type, FnMut<QString()> render) {
+	if (LogsData && LogsStartIndexChosen < 0 && Logs::DebugEnabled()) {
+		LogsData->writeDeferred(type, std::move(render));
+	} else if (auto text = render(); !text.isEmpty()) {
+		_logsWrite(type, text);
+	}
+}
+
 namespace Logs {
 namespace {
 
@@ -571,6 +673,16 @@ void writeMtp(int32 dc, const QString &v) {
 	_logsWrite(LogDataMtp, msg);
 }
 
+void writeMtpDeferred(int32 dc, FnMut<QString()> render) {
+	auto prefix = QString("%1 (dc:%2) ").arg(_logsEntryStart()).arg(dc);
+	_logsWriteDeferred(LogDataMtp, [
+			prefix = std::move(prefix),
+			render = std::move(render)]() mutable {
+		const auto text = render();
+		return text.isEmpty() ? QString() : (prefix + text + '\n');
+	});
+}
+
 QString full() {
 	if (LogsData) {
 		return LogsData->full();
@@ -36,6 +36,10 @@ void writeDebug(const char *file, int32 line, const QString &v);
 void writeTcp(const QString &v);
 void writeMtp(int32 dc, const QString &v);
 
+// The text is rendered only when the entry is written by the log writer.
+// If render() returns an empty string the entry is skipped.
+void writeMtpDeferred(int32 dc, FnMut<QString()> render);
+
 QString full();
 
 inline const char *b(bool v) {
@@ -45,7 +45,9 @@ void AppConfig::refresh() {
 			_data.clear();
 			for (const auto &element : result.c_jsonObject().vvalue().v) {
 				element.match([&](const MTPDjsonObjectValue &data) {
-					_data.emplace_or_assign(qs(data.vkey()), data.vvalue());
+					_data.emplace_or_assign(
+						qs(data.vkey()),
+						ParseValue(data.vvalue()));
 				});
 			}
 			DEBUG_LOG(("getAppConfig result handled."));
@@ -71,103 +73,104 @@ rpl::producer<> AppConfig::value() const {
 	return _refreshed.events_starting_with({});
 }
 
-template <typename Extractor>
-auto AppConfig::getValue(const QString &key, Extractor &&extractor) const {
+auto AppConfig::ParseValue(const MTPJSONValue &value) -> Value {
+	const auto parseStringArray = [](const MTPDjsonArray &data) -> Value {
+		auto result = std::vector<QString>();
+		result.reserve(data.vvalue().v.size());
+		for (const auto &entry : data.vvalue().v) {
+			if (entry.type() != mtpc_jsonString) {
+				return v::null;
+			}
+			result.push_back(qs(entry.c_jsonString().vvalue()));
+		}
+		return result;
+	};
+	const auto parseStringMapArray = [](const MTPDjsonArray &data) -> Value {
+		auto result = std::vector<StringMap>();
+		result.reserve(data.vvalue().v.size());
+		for (const auto &entry : data.vvalue().v) {
+			if (entry.type() != mtpc_jsonObject) {
+				return v::null;
+			}
+			auto element = StringMap();
+			for (const auto &field : entry.c_jsonObject().vvalue().v) {
+				const auto &data = field.c_jsonObjectValue();
+				if (data.vvalue().type() != mtpc_jsonString) {
+					return v::null;
+				}
+				element.emplace(
+					qs(data.vkey()),
+					qs(data.vvalue().c_jsonString().vvalue()));
+			}
+			result.push_back(std::move(element));
+		}
+		return result;
+	};
+	return value.match([&](const MTPDjsonBool &data) -> Value {
+		return mtpIsTrue(data.vvalue());
+	}, [&](const MTPDjsonNumber &data) -> Value {
+		return data.vvalue().v;
+	}, [&](const MTPDjsonString &data) -> Value {
+		return qs(data.vvalue());
+	}, [&](const MTPDjsonArray &data) -> Value {
+		const auto &list = data.vvalue().v;
+		return (list.isEmpty() || list.front().type() != mtpc_jsonObject)
+			? parseStringArray(data)
+			: parseStringMapArray(data);
+	}, [&](const auto &data) -> Value {
+		return v::null;
+	});
+}
+
+template <typename Type>
+const Type *AppConfig::find(const QString &key) const {
 	const auto i = _data.find(key);
-	return extractor((i != end(_data))
-		? i->second
-		: MTPJSONValue(MTP_jsonNull()));
+	return (i != end(_data)) ? std::get_if<Type>(&i->second) : nullptr;
 }
 
 bool AppConfig::getBool(const QString &key, bool fallback) const {
-	return getValue(key, [&](const MTPJSONValue &value) {
-		return value.match([&](const MTPDjsonBool &data) {
-			return mtpIsTrue(data.vvalue());
-		}, [&](const auto &data) {
-			return fallback;
-		});
-	});
+	const auto value = find<bool>(key);
+	return value ? *value : fallback;
 }
 
 double AppConfig::getDouble(const QString &key, double fallback) const {
-	return getValue(key, [&](const MTPJSONValue &value) {
-		return value.match([&](const MTPDjsonNumber &data) {
-			return data.vvalue().v;
-		}, [&](const auto &data) {
-			return fallback;
-		});
-	});
+	const auto value = find<double>(key);
+	return value ? *value : fallback;
 }
 
 QString AppConfig::getString(
 		const QString &key,
 		const QString &fallback) const {
-	return getValue(key, [&](const MTPJSONValue &value) {
-		return value.match([&](const MTPDjsonString &data) {
-			return qs(data.vvalue());
-		}, [&](const auto &data) {
-			return fallback;
-		});
-	});
+	const auto value = find<QString>(key);
+	return value ? *value : fallback;
 }
 
 std::vector<QString> AppConfig::getStringArray(
 		const QString &key,
 		std::vector<QString> &&fallback) const {
-	return getValue(key, [&](const MTPJSONValue &value) {
-		return value.match([&](const MTPDjsonArray &data) {
-			auto result = std::vector<QString>();
-			result.reserve(data.vvalue().v.size());
-			for (const auto &entry : data.vvalue().v) {
-				if (entry.type() != mtpc_jsonString) {
-					return std::move(fallback);
-				}
-				result.push_back(qs(entry.c_jsonString().vvalue()));
-			}
-			return result;
-		}, [&](const auto &data) {
-			return std::move(fallback);
-		});
-	});
+	const auto value = find<std::vector<QString>>(key);
+	return value ? *value : std::move(fallback);
 }
 
 std::vector<std::map<QString, QString>> AppConfig::getStringMapArray(
 		const QString &key,
 		std::vector<std::map<QString, QString>> &&fallback) const {
-	return getValue(key, [&](const MTPJSONValue &value) {
-		return value.match([&](const MTPDjsonArray &data) {
-			auto result = std::vector<std::map<QString, QString>>();
-			result.reserve(data.vvalue().v.size());
-			for (const auto &entry : data.vvalue().v) {
-				if (entry.type() != mtpc_jsonObject) {
-					return std::move(fallback);
-				}
-				auto element = std::map<QString, QString>();
-				for (const auto &field : entry.c_jsonObject().vvalue().v) {
-					const auto &data = field.c_jsonObjectValue();
-					if (data.vvalue().type() != mtpc_jsonString) {
-						return std::move(fallback);
-					}
-					element.emplace(
-						qs(data.vkey()),
-						qs(data.vvalue().c_jsonString().vvalue()));
-				}
-				result.push_back(std::move(element));
-			}
-			return result;
-		}, [&](const auto &data) {
-			return std::move(fallback);
-		});
-	});
+	if (const auto value = find<std::vector<StringMap>>(key)) {
+		return *value;
+	} else if (const auto list = find<std::vector<QString>>(key)) {
+		if (list->empty()) {
+			return {};
+		}
+	}
+	return std::move(fallback);
 }
 
 bool AppConfig::suggestionCurrent(const QString &key) const {
-	return !_dismissedSuggestions.contains(key)
-		&& ranges::contains(
-			get<std::vector<QString>>(
-				u"pending_suggestions"_q,
-				std::vector<QString>()),
-			key);
+	if (_dismissedSuggestions.contains(key)) {
+		return false;
+	}
+	const auto list = find<std::vector<QString>>(u"pending_suggestions"_q);
+	return list && ranges::contains(*list, key);
 }
 
 rpl::producer<> AppConfig::suggestionRequested(const QString &key) const {
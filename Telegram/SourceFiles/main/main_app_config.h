@@ -43,12 +43,24 @@ public:
 	void refresh();
 
 private:
+	using StringMap = std::map<QString, QString>;
+
+	// Values are converted once when the config arrives.
+	// An empty array is stored as an empty std::vector<QString>.
+	using Value = std::variant<
+		v::null_t,
+		bool,
+		double,
+		QString,
+		std::vector<QString>,
+		std::vector<StringMap>>;
+
 	void refreshDelayed();
 
-	template <typename Extractor>
-	[[nodiscard]] auto getValue(
-		const QString &key,
-		Extractor &&extractor) const;
+	[[nodiscard]] static Value ParseValue(const MTPJSONValue &value);
+
+	template <typename Type>
+	[[nodiscard]] const Type *find(const QString &key) const;
 
 	[[nodiscard]] bool getBool(
 		const QString &key,
@@ -69,7 +81,7 @@ private:
 	const not_null<Account*> _account;
 	std::optional<MTP::Sender> _api;
 	mtpRequestId _requestId = 0;
-	base::flat_map<QString, MTPJSONValue> _data;
+	base::flat_map<QString, Value> _data;
 	rpl::event_stream<> _refreshed;
 	base::flat_set<QString> _dismissedSuggestions;
 	rpl::lifetime _lifetime;
@@ -137,13 +137,10 @@ Session::Session(
 
 		// Storage::Account uses Main::Account::session() in those methods.
 		// So they can't be called during Main::Session construction.
-		local().readInstalledStickers();
-		local().readFeaturedStickers();
-		local().readRecentStickers();
-		local().readFavedStickers();
-		local().readSavedGifs();
-		data().stickers().notifyUpdated();
-		data().stickers().notifySavedGifsUpdated();
+		local().readStickersAndSavedGifsAsync(crl::guard(this, [=] {
+			data().stickers().notifyUpdated();
+			data().stickers().notifySavedGifsUpdated();
+		}));
 	});
 
 #ifndef TDESKTOP_DISABLE_SPELLCHECK
@@ -597,8 +597,9 @@ Mixer::Mixer(not_null<Audio::Instance*> instance)
 	connect(this, SIGNAL(stoppedOnError(const AudioMsgId&)), this, SIGNAL(updated(const AudioMsgId&)), Qt::QueuedConnection);
 	connect(this, SIGNAL(updated(const AudioMsgId&)), this, SLOT(onUpdated(const AudioMsgId&)));
 
-	_loaderThread.start();
-	_faderThread.start();
+	// Fader feeds the playback device, loaders decode the next buffers.
+	_loaderThread.start(QThread::HighPriority);
+	_faderThread.start(QThread::TimeCriticalPriority);
 }
 
 // Thread: Main. Locks: AudioMutex.
@@ -1338,12 +1339,13 @@ void Fader::onTimer() {
 	}
 	auto hasFading = (_suppressAll || _suppressSongAnim);
 	auto hasPlaying = false;
+	auto nextCheck = kCheckPlaybackPositionTimeout;
 
-	auto updatePlayback = [this, &hasPlaying, &hasFading](AudioMsgId::Type type, int index, float64 volumeMultiplier, bool suppressGainChanged) {
+	auto updatePlayback = [&](AudioMsgId::Type type, int index, float64 volumeMultiplier, bool suppressGainChanged) {
 		auto track = mixer()->trackForType(type, index);
 		if (IsStopped(track->state.state) || track->state.state == State::Paused || !track->isStreamCreated()) return;
 
-		auto emitSignals = updateOnePlayback(track, hasPlaying, hasFading, volumeMultiplier, suppressGainChanged);
+		auto emitSignals = updateOnePlayback(track, hasPlaying, hasFading, nextCheck, volumeMultiplier, suppressGainChanged);
 		if (emitSignals & EmitError) emit error(track->state.id);
 		if (emitSignals & EmitStopped) emit audioStopped(track->state.id);
 		if (emitSignals & EmitPositionUpdated) emit playPositionUpdated(track->state.id);
@@ -1365,14 +1367,17 @@ void Fader::onTimer() {
 		_timer.start(kCheckFadingTimeout);
 		Audio::StopDetachIfNotUsedSafe();
 	} else if (hasPlaying) {
-		_timer.start(kCheckPlaybackPositionTimeout);
+		_timer.start(std::clamp(
+			nextCheck,
+			kCheckFadingTimeout,
+			kCheckPlaybackPositionTimeout));
 		Audio::StopDetachIfNotUsedSafe();
 	} else {
 		Audio::ScheduleDetachIfNotUsedSafe();
 	}
 }
 
-int32 Fader::updateOnePlayback(Mixer::Track *track, bool &hasPlaying, bool &hasFading, float64 volumeMultiplier, bool volumeChanged) {
+int32 Fader::updateOnePlayback(Mixer::Track *track, bool &hasPlaying, bool &hasFading, crl::time &nextCheck, float64 volumeMultiplier, bool volumeChanged) {
 	const auto errorHappened = [&] {
 		if (Audio::PlaybackErrorHappened()) {
 			setStoppedState(track, State::StoppedAtError);
@@ -1483,6 +1488,22 @@ int32 Fader::updateOnePlayback(Mixer::Track *track, bool &hasPlaying, bool &hasF
 	if (playing) hasPlaying = true;
 	if (fading) hasFading = true;
 
+	if (alState == AL_PLAYING && track->state.frequency > 0) {
+		// Wake up right when the next position update is due, when the
+		// preload should start or when the buffered data runs out.
+		const auto buffered = track->bufferedPosition
+			+ track->bufferedLength;
+		auto samples = std::min(
+			track->state.position + kCheckPlaybackPositionDelta,
+			buffered) - fullPosition;
+		if (!track->loaded && !track->loading) {
+			accumulate_min(samples, buffered - kPreloadSamples - fullPosition);
+		}
+		accumulate_min(
+			nextCheck,
+			std::max(samples, int64(0)) * 1000 / track->state.frequency);
+	}
+
 	return emitSignals;
 }
 
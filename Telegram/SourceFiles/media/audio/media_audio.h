@@ -348,7 +348,7 @@ private:
 		EmitPositionUpdated = 0x04,
 		EmitNeedToPreload = 0x08,
 	};
-	int32 updateOnePlayback(Mixer::Track *track, bool &hasPlaying, bool &hasFading, float64 volumeMultiplier, bool volumeChanged);
+	int32 updateOnePlayback(Mixer::Track *track, bool &hasPlaying, bool &hasFading, crl::time &nextCheck, float64 volumeMultiplier, bool volumeChanged);
 	void setStoppedState(Mixer::Track *track, State state = State::Stopped);
 
 	QTimer _timer;
@@ -11,6 +11,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ffmpeg/ffmpeg_utility.h"
 #include "base/timer.h"
 
+#include <QtCore/QTemporaryFile>
+
 #include <al.h>
 #include <alc.h>
 
@@ -163,55 +165,66 @@ struct Instance::Inner::Private {
 	int32 lastUpdate = 0;
 	uint16 levelMax = 0;
 
-	QByteArray data;
-	int32 dataPos = 0;
+	// Encoded pages are streamed to a temporary file while recording,
+	// so that long recordings don't grow the memory usage.
+	std::unique_ptr<QTemporaryFile> file;
 
 	int64 waveformMod = 0;
 	int64 waveformEach = (kCaptureFrequency / 100);
 	uint16 waveformPeak = 0;
 	QVector<uchar> waveform;
 
-	static int _read_data(void *opaque, uint8_t *buf, int buf_size) {
-		auto l = reinterpret_cast<Private*>(opaque);
+	void clearData() {
+		if (file) {
+			file->resize(0);
+			file->seek(0);
+		}
+	}
 
-		int32 nbytes = qMin(l->data.size() - l->dataPos, int32(buf_size));
-		if (nbytes <= 0) {
-			return 0;
+	[[nodiscard]] QByteArray readData() {
+		if (!file || !file->flush() || !file->seek(0)) {
+			return QByteArray();
 		}
+		return file->readAll();
+	}
 
-		memcpy(buf, l->data.constData() + l->dataPos, nbytes);
-		l->dataPos += nbytes;
-		return nbytes;
+	static int _read_data(void *opaque, uint8_t *buf, int buf_size) {
+		auto l = reinterpret_cast<Private*>(opaque);
+
+		const auto nbytes = l->file->read((char*)buf, buf_size);
+		return (nbytes > 0) ? int(nbytes) : 0;
 	}
 
 	static int _write_data(void *opaque, uint8_t *buf, int buf_size) {
 		auto l = reinterpret_cast<Private*>(opaque);
 
 		if (buf_size <= 0) return 0;
-		if (l->dataPos + buf_size > l->data.size()) l->data.resize(l->dataPos + buf_size);
-		memcpy(l->data.data() + l->dataPos, buf, buf_size);
-		l->dataPos += buf_size;
+		const auto written = l->file->write((const char*)buf, buf_size);
+		if (written != buf_size) {
+			LOG(("Audio Error: Unable to write captured data, error %1"
+				).arg(l->file->errorString()));
+			return -1;
+		}
 		return buf_size;
 	}
 
 	static int64_t _seek_data(void *opaque, int64_t offset, int whence) {
 		auto l = reinterpret_cast<Private*>(opaque);
 
-		int32 newPos = -1;
+		int64 newPos = -1;
 		switch (whence) {
 		case SEEK_SET: newPos = offset; break;
-		case SEEK_CUR: newPos = l->dataPos + offset; break;
-		case SEEK_END: newPos = l->data.size() + offset; break;
+		case SEEK_CUR: newPos = l->file->pos() + offset; break;
+		case SEEK_END: newPos = l->file->size() + offset; break;
 		case AVSEEK_SIZE: {
 			// Special whence for determining filesize without any seek.
-			return l->data.size();
+			return l->file->size();
 		} break;
 		}
-		if (newPos < 0) {
+		if (newPos < 0 || !l->file->seek(newPos)) {
 			return -1;
 		}
-		l->dataPos = newPos;
-		return l->dataPos;
+		return newPos;
 	}
 };
 
@@ -253,6 +266,15 @@ void Instance::Inner::start(Fn<void(Update)> updated, Fn<void()> error) {
 
 	// Create encoding context
 
+	d->file = std::make_unique<QTemporaryFile>();
+	if (!d->file->open()) {
+		LOG(("Audio Error: Unable to open temporary file for capture, %1"
+			).arg(d->file->errorString()));
+		d->file = nullptr;
+		fail();
+		return;
+	}
+
 	d->ioBuffer = (uchar*)av_malloc(FFmpeg::kAVBlockSize);
 
 	d->ioContext = avio_alloc_context(d->ioBuffer, FFmpeg::kAVBlockSize, 1, static_cast<void*>(d.get()), &Private::_read_data, &Private::_write_data, &Private::_seek_data);
@@ -395,8 +417,7 @@ void Instance::Inner::stop(Fn<void(Result&&)> callback) {
 		auto capturedSamples = static_cast<int>(_captured.size() / sizeof(short));
 		if ((_captured.size() % sizeof(short)) || (d->fullSamples + capturedSamples < kCaptureFrequency) || (capturedSamples < fadeSamples)) {
 			d->fullSamples = 0;
-			d->dataPos = 0;
-			d->data.clear();
+			d->clearData();
 			d->waveformMod = 0;
 			d->waveformPeak = 0;
 			d->waveform.clear();
@@ -420,8 +441,7 @@ void Instance::Inner::stop(Fn<void(Result&&)> callback) {
 			writeFrame(nullptr); // drain the codec
 			if (encoded != _captured.size()) {
 				d->fullSamples = 0;
-				d->dataPos = 0;
-				d->data.clear();
+				d->clearData();
 				d->waveformMod = 0;
 				d->waveformPeak = 0;
 				d->waveform.clear();
@@ -431,7 +451,7 @@ void Instance::Inner::stop(Fn<void(Result&&)> callback) {
 	DEBUG_LOG(("Audio Capture: "
 		"stopping (need result: %1), size: %2, samples: %3"
 		).arg(Logs::b(callback != nullptr)
-		).arg(d->data.size()
+		).arg(d->file ? d->file->size() : 0
 		).arg(d->fullSamples));
 	_captured = QByteArray();
 
@@ -440,7 +460,9 @@ void Instance::Inner::stop(Fn<void(Result&&)> callback) {
 		av_write_trailer(d->fmtContext);
 	}
 
-	QByteArray result = d->fullSamples ? d->data : QByteArray();
+	QByteArray result = (callback && d->fullSamples)
+		? d->readData()
+		: QByteArray();
 	VoiceWaveform waveform;
 	qint32 samples = d->fullSamples;
 	if (samples && !d->waveform.isEmpty()) {
@@ -520,8 +542,7 @@ void Instance::Inner::stop(Fn<void(Result&&)> callback) {
 		d->lastUpdate = 0;
 		d->levelMax = 0;
 
-		d->dataPos = 0;
-		d->data.clear();
+		d->file = nullptr;
 
 		d->waveformMod = 0;
 		d->waveformPeak = 0;
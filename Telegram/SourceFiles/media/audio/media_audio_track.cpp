@@ -21,6 +21,8 @@ namespace {
 
 constexpr auto kMaxFileSize = 10 * 1024 * 1024;
 constexpr auto kDetachDeviceTimeout = crl::time(500); // destroy the audio device after 500ms of silence
+constexpr auto kDetachDeviceBurstTimeout = 5 * crl::time(1000);
+constexpr auto kBurstTracksInterval = 10 * crl::time(1000);
 constexpr auto kTrackUpdateTimeout = crl::time(100);
 
 ALuint CreateSource() {
@@ -281,6 +283,12 @@ void Instance::unregisterTrack(Track *track) {
 }
 
 void Instance::trackStarted(Track *track) {
+	// Don't reopen the device for each sound in a burst of notifications.
+	const auto now = crl::now();
+	_tracksBurst = _lastTrackStarted
+		&& (now - _lastTrackStarted < kBurstTracksInterval);
+	_lastTrackStarted = now;
+
 	stopDetachIfNotUsed();
 	if (!_updateTimer.isActive()) {
 		_updateTimer.callEach(kTrackUpdateTimeout);
@@ -322,13 +330,19 @@ bool Instance::hasActiveTracks() const {
 }
 
 void Instance::scheduleDetachFromDevice() {
-	_detachFromDeviceForce = true;
+	if (!_detachFromDeviceForce) {
+		_detachFromDeviceForce = true;
+		_detachFromDeviceTimer.cancel();
+	}
 	scheduleDetachIfNotUsed();
 }
 
 void Instance::scheduleDetachIfNotUsed() {
 	if (!_detachFromDeviceTimer.isActive()) {
-		_detachFromDeviceTimer.callOnce(kDetachDeviceTimeout);
+		const auto burst = _tracksBurst && !_detachFromDeviceForce;
+		_detachFromDeviceTimer.callOnce(burst
+			? kDetachDeviceBurstTimeout
+			: kDetachDeviceTimeout);
 	}
 }
 
@@ -0,0 +1,634 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "media/clip/media_clip_compress.h"
+
+#include "ffmpeg/ffmpeg_utility.h"
+#include "logs.h"
+
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QThread>
+
+extern "C" {
+#include <libavutil/opt.h>
+} // extern "C"
+
+namespace Media {
+namespace Clip {
+namespace {
+
+constexpr auto kMaxSide = 1280;
+constexpr auto kKeyframeInterval = 250;
+
+// Videos that are already close to the target bitrate are sent as is.
+constexpr auto kSkipBitrateFactor = 1.2;
+
+struct InputDeleter {
+	void operator()(AVFormatContext *value) {
+		if (value) {
+			avformat_close_input(&value);
+		}
+	}
+};
+using InputPointer = std::unique_ptr<AVFormatContext, InputDeleter>;
+
+struct OutputDeleter {
+	void operator()(AVFormatContext *value) {
+		if (value) {
+			if (value->pb) {
+				avio_closep(&value->pb);
+			}
+			avformat_free_context(value);
+		}
+	}
+};
+using OutputPointer = std::unique_ptr<AVFormatContext, OutputDeleter>;
+
+// The task queue requests interruption of its threads when it is stopped,
+// so quitting or logging out doesn't wait for a long video to finish.
+[[nodiscard]] bool Interrupted() {
+	if (!QThread::currentThread()->isInterruptionRequested()) {
+		return false;
+	}
+	DEBUG_LOG(("Compress Info: Interrupted."));
+	return true;
+}
+
+[[nodiscard]] QSize CompressedSize(QSize size) {
+	if (std::max(size.width(), size.height()) > kMaxSide) {
+		size = size.scaled(kMaxSide, kMaxSide, Qt::KeepAspectRatio);
+	}
+
+	// yuv420p requires even dimensions.
+	return QSize(size.width() & ~1, size.height() & ~1);
+}
+
+class Compressor final {
+public:
+	Compressor(const QString &from, const QString &to, int bitrate);
+
+	[[nodiscard]] bool run();
+
+private:
+	[[nodiscard]] bool openInput();
+	[[nodiscard]] bool openOutput();
+	[[nodiscard]] bool openEncoder();
+	[[nodiscard]] bool decode(AVPacket *packet);
+	[[nodiscard]] bool encodeDecoded();
+	[[nodiscard]] bool encode(AVFrame *frame);
+	[[nodiscard]] bool copyAudio(AVPacket &packet);
+	[[nodiscard]] bool write(AVPacket &packet);
+
+	const QString _from;
+	const QString _to;
+	const int _bitrate = 0;
+
+	InputPointer _input;
+	OutputPointer _output;
+	FFmpeg::CodecPointer _decoder;
+	FFmpeg::CodecPointer _encoder;
+	FFmpeg::FramePointer _frame;
+	FFmpeg::FramePointer _scaled;
+	FFmpeg::SwscalePointer _scale;
+	AVStream *_videoStream = nullptr;
+	AVStream *_audioStream = nullptr;
+	int _videoIndex = -1;
+	int _audioIndex = -1;
+	int64_t _lastPts = AV_NOPTS_VALUE;
+
+};
+
+Compressor::Compressor(const QString &from, const QString &to, int bitrate)
+: _from(from)
+, _to(to)
+, _bitrate(bitrate)
+, _frame(FFmpeg::MakeFramePointer())
+, _scaled(FFmpeg::MakeFramePointer()) {
+}
+
+bool Compressor::run() {
+	if (!_frame || !_scaled || !openInput() || !openOutput()) {
+		return false;
+	}
+	auto options = (AVDictionary*)nullptr;
+	av_dict_set(&options, "movflags", "+faststart", 0);
+	auto error = FFmpeg::AvErrorWrap(
+		avformat_write_header(_output.get(), &options));
+	av_dict_free(&options);
+	if (error) {
+		FFmpeg::LogError(qstr("avformat_write_header"), error);
+		return false;
+	}
+
+	auto packet = FFmpeg::Packet();
+	while (true) {
+		if (Interrupted()) {
+			return false;
+		}
+		error = av_read_frame(_input.get(), &packet.fields());
+		if (error.code() == AVERROR_EOF) {
+			break;
+		} else if (error) {
+			FFmpeg::LogError(qstr("av_read_frame"), error);
+			return false;
+		}
+		const auto index = packet.fields().stream_index;
+		const auto ok = (index == _videoIndex)
+			? decode(&packet.fields())
+			: (index == _audioIndex)
+			? copyAudio(packet.fields())
+			: true;
+		av_packet_unref(&packet.fields());
+		if (!ok) {
+			return false;
+		}
+	}
+	if (!decode(nullptr) || !encode(nullptr)) {
+		return false;
+	} else if ((error = av_write_trailer(_output.get()))) {
+		FFmpeg::LogError(qstr("av_write_trailer"), error);
+		return false;
+	}
+	return true;
+}
+
+bool Compressor::openInput() {
+	auto raw = (AVFormatContext*)nullptr;
+	auto error = FFmpeg::AvErrorWrap(avformat_open_input(
+		&raw,
+		_from.toUtf8().constData(),
+		nullptr,
+		nullptr));
+	if (error) {
+		FFmpeg::LogError(qstr("avformat_open_input"), error);
+		return false;
+	}
+	_input = InputPointer(raw);
+	if ((error = avformat_find_stream_info(_input.get(), nullptr))) {
+		FFmpeg::LogError(qstr("avformat_find_stream_info"), error);
+		return false;
+	}
+	_videoIndex = av_find_best_stream(
+		_input.get(),
+		AVMEDIA_TYPE_VIDEO,
+		-1,
+		-1,
+		nullptr,
+		0);
+	if (_videoIndex < 0) {
+		return false;
+	}
+	const auto bitrate = _input->bit_rate;
+	if (bitrate > 0 && bitrate <= _bitrate * 1000. * kSkipBitrateFactor) {
+		DEBUG_LOG(("Compress Info: Skipping video with bitrate %1."
+			).arg(bitrate));
+		return false;
+	}
+	_audioIndex = av_find_best_stream(
+		_input.get(),
+		AVMEDIA_TYPE_AUDIO,
+		-1,
+		_videoIndex,
+		nullptr,
+		0);
+	_decoder = FFmpeg::MakeCodecPointer({
+		.stream = _input->streams[_videoIndex],
+	});
+	return (_decoder != nullptr);
+}
+
+bool Compressor::openOutput() {
+	auto raw = (AVFormatContext*)nullptr;
+	auto error = FFmpeg::AvErrorWrap(avformat_alloc_output_context2(
+		&raw,
+		nullptr,
+		"mp4",
+		nullptr));
+	if (error) {
+		FFmpeg::LogError(qstr("avformat_alloc_output_context2"), error);
+		return false;
+	}
+	_output = OutputPointer(raw);
+	if (!openEncoder()) {
+		return false;
+	}
+
+	const auto input = _input->streams[_videoIndex];
+	_videoStream = avformat_new_stream(_output.get(), nullptr);
+	if (!_videoStream) {
+		FFmpeg::LogError(qstr("avformat_new_stream"));
+		return false;
+	}
+	error = avcodec_parameters_from_context(
+		_videoStream->codecpar,
+		_encoder.get());
+	if (error) {
+		FFmpeg::LogError(qstr("avcodec_parameters_from_context"), error);
+		return false;
+	}
+	_videoStream->time_base = _encoder->time_base;
+
+	// Keeps the rotation tag of the original.
+	av_dict_copy(&_videoStream->metadata, input->metadata, 0);
+
+	if (_audioIndex >= 0) {
+		const auto audio = _input->streams[_audioIndex];
+		const auto supported = avformat_query_codec(
+			_output->oformat,
+			audio->codecpar->codec_id,
+			FF_COMPLIANCE_NORMAL);
+		if (supported != 1) {
+			LOG(("Compress Error: Audio codec %1 can't be copied to mp4."
+				).arg(audio->codecpar->codec_id));
+			return false;
+		}
+		_audioStream = avformat_new_stream(_output.get(), nullptr);
+		if (!_audioStream) {
+			FFmpeg::LogError(qstr("avformat_new_stream"));
+			return false;
+		}
+		error = avcodec_parameters_copy(
+			_audioStream->codecpar,
+			audio->codecpar);
+		if (error) {
+			FFmpeg::LogError(qstr("avcodec_parameters_copy"), error);
+			return false;
+		}
+		_audioStream->codecpar->codec_tag = 0;
+		_audioStream->time_base = audio->time_base;
+	}
+
+	error = avio_open(
+		&_output->pb,
+		_to.toUtf8().constData(),
+		AVIO_FLAG_WRITE);
+	if (error) {
+		FFmpeg::LogError(qstr("avio_open"), error);
+		return false;
+	}
+	return true;
+}
+
+bool Compressor::openEncoder() {
+	const auto codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+	if (!codec) {
+		LOG(("Compress Error: H.264 encoder is not available."));
+		return false;
+	}
+	const auto size = CompressedSize(
+		QSize(_decoder->width, _decoder->height));
+	if (size.isEmpty()) {
+		return false;
+	}
+	_encoder = FFmpeg::CodecPointer(avcodec_alloc_context3(codec));
+	if (!_encoder) {
+		FFmpeg::LogError(qstr("avcodec_alloc_context3"));
+		return false;
+	}
+	const auto stream = _input->streams[_videoIndex];
+	_encoder->width = size.width();
+	_encoder->height = size.height();
+	_encoder->pix_fmt = AV_PIX_FMT_YUV420P;
+	_encoder->sample_aspect_ratio = _decoder->sample_aspect_ratio;
+	_encoder->time_base = stream->time_base;
+	_encoder->framerate = av_guess_frame_rate(_input.get(), stream, nullptr);
+	_encoder->bit_rate = int64_t(_bitrate) * 1000;
+	_encoder->gop_size = kKeyframeInterval;
+	if (_output->oformat->flags & AVFMT_GLOBALHEADER) {
+		_encoder->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+	}
+	if (_encoder->priv_data) {
+		av_opt_set(_encoder->priv_data, "preset", "veryfast", 0);
+	}
+	av_opt_set(_encoder.get(), "threads", "auto", 0);
+
+	auto error = FFmpeg::AvErrorWrap(
+		avcodec_open2(_encoder.get(), codec, nullptr));
+	if (error) {
+		FFmpeg::LogError(qstr("avcodec_open2"), error);
+		return false;
+	}
+
+	_scaled->width = size.width();
+	_scaled->height = size.height();
+	_scaled->format = AV_PIX_FMT_YUV420P;
+	if ((error = av_frame_get_buffer(_scaled.get(), 0))) {
+		FFmpeg::LogError(qstr("av_frame_get_buffer"), error);
+		return false;
+	}
+	return true;
+}
+
+bool Compressor::decode(AVPacket *packet) {
+	auto error = FFmpeg::AvErrorWrap(
+		avcodec_send_packet(_decoder.get(), packet));
+	if (error.code() == AVERROR_INVALIDDATA) {
+		return true; // Skip a broken packet.
+	} else if (error) {
+		FFmpeg::LogError(qstr("avcodec_send_packet"), error);
+		return false;
+	}
+	while (true) {
+		if (Interrupted()) {
+			return false;
+		}
+		error = avcodec_receive_frame(_decoder.get(), _frame.get());
+		if (error.code() == AVERROR(EAGAIN) || error.code() == AVERROR_EOF) {
+			return true;
+		} else if (error) {
+			FFmpeg::LogError(qstr("avcodec_receive_frame"), error);
+			return false;
+		}
+		const auto ok = encodeDecoded();
+		av_frame_unref(_frame.get());
+		if (!ok) {
+			return false;
+		}
+	}
+}
+
+bool Compressor::encodeDecoded() {
+	_scale = FFmpeg::MakeSwscalePointer(
+		QSize(_frame->width, _frame->height),
+		_frame->format,
+		QSize(_scaled->width, _scaled->height),
+		AV_PIX_FMT_YUV420P,
+		&_scale);
+	if (!_scale) {
+		return false;
+	}
+	const auto error = FFmpeg::AvErrorWrap(
+		av_frame_make_writable(_scaled.get()));
+	if (error) {
+		FFmpeg::LogError(qstr("av_frame_make_writable"), error);
+		return false;
+	}
+	sws_scale(
+		_scale.get(),
+		_frame->data,
+		_frame->linesize,
+		0,
+		_frame->height,
+		_scaled->data,
+		_scaled->linesize);
+
+	// The encoder works in the time base of the original stream,
+	// it only requires the timestamps to grow.
+	auto pts = _frame->best_effort_timestamp;
+	if (pts == AV_NOPTS_VALUE
+		|| (_lastPts != AV_NOPTS_VALUE && pts <= _lastPts)) {
+		pts = (_lastPts != AV_NOPTS_VALUE) ? (_lastPts + 1) : 0;
+	}
+	_scaled->pts = _lastPts = pts;
+	return encode(_scaled.get());
+}
+
+bool Compressor::encode(AVFrame *frame) {
+	auto error = FFmpeg::AvErrorWrap(
+		avcodec_send_frame(_encoder.get(), frame));
+	if (error) {
+		FFmpeg::LogError(qstr("avcodec_send_frame"), error);
+		return false;
+	}
+	auto packet = FFmpeg::Packet();
+	while (true) {
+		error = avcodec_receive_packet(_encoder.get(), &packet.fields());
+		if (error.code() == AVERROR(EAGAIN) || error.code() == AVERROR_EOF) {
+			return true;
+		} else if (error) {
+			FFmpeg::LogError(qstr("avcodec_receive_packet"), error);
+			return false;
+		}
+		av_packet_rescale_ts(
+			&packet.fields(),
+			_encoder->time_base,
+			_videoStream->time_base);
+		packet.fields().stream_index = _videoStream->index;
+		if (!write(packet.fields())) {
+			return false;
+		}
+	}
+}
+
+bool Compressor::copyAudio(AVPacket &packet) {
+	av_packet_rescale_ts(
+		&packet,
+		_input->streams[_audioIndex]->time_base,
+		_audioStream->time_base);
+	packet.stream_index = _audioStream->index;
+	packet.pos = -1;
+	return write(packet);
+}
+
+bool Compressor::write(AVPacket &packet) {
+	const auto error = FFmpeg::AvErrorWrap(
+		av_interleaved_write_frame(_output.get(), &packet));
+	if (error) {
+		FFmpeg::LogError(qstr("av_interleaved_write_frame"), error);
+		return false;
+	}
+	return true;
+}
+
+class Remuxer final {
+public:
+	Remuxer(const QString &from, const QString &to);
+
+	[[nodiscard]] bool run();
+
+private:
+	[[nodiscard]] bool openInput();
+	[[nodiscard]] bool openOutput();
+
+	const QString _from;
+	const QString _to;
+
+	InputPointer _input;
+	OutputPointer _output;
+
+	// Output stream for each input stream, nullptr for skipped ones.
+	std::vector<AVStream*> _streams;
+
+};
+
+Remuxer::Remuxer(const QString &from, const QString &to)
+: _from(from)
+, _to(to) {
+}
+
+bool Remuxer::run() {
+	if (!openInput() || !openOutput()) {
+		return false;
+	}
+	auto options = (AVDictionary*)nullptr;
+	av_dict_set(&options, "movflags", "+faststart", 0);
+	auto error = FFmpeg::AvErrorWrap(
+		avformat_write_header(_output.get(), &options));
+	av_dict_free(&options);
+	if (error) {
+		FFmpeg::LogError(qstr("avformat_write_header"), error);
+		return false;
+	}
+
+	auto packet = FFmpeg::Packet();
+	while (true) {
+		if (Interrupted()) {
+			return false;
+		}
+		error = av_read_frame(_input.get(), &packet.fields());
+		if (error.code() == AVERROR_EOF) {
+			break;
+		} else if (error) {
+			FFmpeg::LogError(qstr("av_read_frame"), error);
+			return false;
+		}
+		auto &fields = packet.fields();
+		const auto index = fields.stream_index;
+		const auto stream = (index >= 0 && index < int(_streams.size()))
+			? _streams[index]
+			: nullptr;
+		if (stream) {
+			av_packet_rescale_ts(
+				&fields,
+				_input->streams[index]->time_base,
+				stream->time_base);
+			fields.stream_index = stream->index;
+			fields.pos = -1;
+			error = av_interleaved_write_frame(_output.get(), &fields);
+		}
+		av_packet_unref(&fields);
+		if (error) {
+			FFmpeg::LogError(qstr("av_interleaved_write_frame"), error);
+			return false;
+		}
+	}
+	if ((error = av_write_trailer(_output.get()))) {
+		FFmpeg::LogError(qstr("av_write_trailer"), error);
+		return false;
+	}
+	return true;
+}
+
+bool Remuxer::openInput() {
+	auto raw = (AVFormatContext*)nullptr;
+	auto error = FFmpeg::AvErrorWrap(avformat_open_input(
+		&raw,
+		_from.toUtf8().constData(),
+		nullptr,
+		nullptr));
+	if (error) {
+		FFmpeg::LogError(qstr("avformat_open_input"), error);
+		return false;
+	}
+	_input = InputPointer(raw);
+	if ((error = avformat_find_stream_info(_input.get(), nullptr))) {
+		FFmpeg::LogError(qstr("avformat_find_stream_info"), error);
+		return false;
+	}
+	return true;
+}
+
+bool Remuxer::openOutput() {
+	auto raw = (AVFormatContext*)nullptr;
+	auto error = FFmpeg::AvErrorWrap(avformat_alloc_output_context2(
+		&raw,
+		nullptr,
+		"mp4",
+		nullptr));
+	if (error) {
+		FFmpeg::LogError(qstr("avformat_alloc_output_context2"), error);
+		return false;
+	}
+	_output = OutputPointer(raw);
+
+	auto hasVideo = false;
+	_streams.resize(_input->nb_streams, nullptr);
+	for (auto i = 0; i != int(_input->nb_streams); ++i) {
+		const auto input = _input->streams[i];
+		const auto type = input->codecpar->codec_type;
+		if (type != AVMEDIA_TYPE_VIDEO && type != AVMEDIA_TYPE_AUDIO) {
+			continue; // Timecode and other data tracks are not needed.
+		} else if (input->disposition & AV_DISPOSITION_ATTACHED_PIC) {
+			continue;
+		}
+		const auto supported = avformat_query_codec(
+			_output->oformat,
+			input->codecpar->codec_id,
+			FF_COMPLIANCE_NORMAL);
+		if (supported != 1) {
+			// Better send the original than lose a track.
+			LOG(("Compress Error: Codec %1 can't be copied to mp4."
+				).arg(input->codecpar->codec_id));
+			return false;
+		}
+		const auto stream = avformat_new_stream(_output.get(), nullptr);
+		if (!stream) {
+			FFmpeg::LogError(qstr("avformat_new_stream"));
+			return false;
+		}
+		error = avcodec_parameters_copy(stream->codecpar, input->codecpar);
+		if (error) {
+			FFmpeg::LogError(qstr("avcodec_parameters_copy"), error);
+			return false;
+		}
+		stream->codecpar->codec_tag = 0;
+		stream->time_base = input->time_base;
+		av_dict_copy(&stream->metadata, input->metadata, 0);
+		_streams[i] = stream;
+		hasVideo = hasVideo || (type == AVMEDIA_TYPE_VIDEO);
+	}
+	if (!hasVideo) {
+		return false;
+	}
+
+	error = avio_open(
+		&_output->pb,
+		_to.toUtf8().constData(),
+		AVIO_FLAG_WRITE);
+	if (error) {
+		FFmpeg::LogError(qstr("avio_open"), error);
+		return false;
+	}
+	return true;
+}
+
+} // namespace
+
+bool CompressVideo(const QString &from, const QString &to, int bitrate) {
+	Expects(bitrate > 0);
+
+	auto done = false;
+	{
+		Compressor compressor(from, to, bitrate);
+		done = compressor.run();
+	}
+	if (done && QFileInfo(to).size() >= QFileInfo(from).size()) {
+		DEBUG_LOG(("Compress Info: Result is not smaller than '%1'."
+			).arg(from));
+		done = false;
+	}
+	if (!done) {
+		QFile::remove(to);
+	}
+	return done;
+}
+
+bool FastStartVideo(const QString &from, const QString &to) {
+	auto done = false;
+	{
+		Remuxer remuxer(from, to);
+		done = remuxer.run();
+	}
+	if (!done) {
+		QFile::remove(to);
+	}
+	return done;
+}
+
+} // namespace Clip
+} // namespace Media
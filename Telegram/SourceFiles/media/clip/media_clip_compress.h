@@ -0,0 +1,28 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+namespace Media {
+namespace Clip {
+
+// Re-encodes the video track to H.264 at the given bitrate (kbit/s),
+// copying the audio track, and writes a streamable mp4 to 'to'.
+// Returns false (and leaves nothing at 'to') if the video can't be
+// compressed or the result wouldn't be smaller than the original.
+[[nodiscard]] bool CompressVideo(
+	const QString &from,
+	const QString &to,
+	int bitrate);
+
+// Copies the tracks without re-encoding into an mp4 at 'to' that has
+// the index in front, so a video with 'moov' at the end can be streamed.
+// Returns false (and leaves nothing at 'to') if it can't be remuxed.
+[[nodiscard]] bool FastStartVideo(const QString &from, const QString &to);
+
+} // namespace Clip
+} // namespace Media
@@ -162,6 +162,7 @@ void FFMpegReaderImplementation::processReadFrame() {
 
 	_hadFrame = _frameRead = true;
 	_frameTime += _currentFrameDelay;
+	++_framesRead;
 }
 
 ReaderImplementation::ReadResult FFMpegReaderImplementation::readFramesTill(crl::time frameMs, crl::time systemMs) {
@@ -187,6 +188,10 @@ crl::time FFMpegReaderImplementation::framePresentationTime() const {
 	return qMax(_frameTime + _frameTimeCorrection, crl::time(0));
 }
 
+int FFMpegReaderImplementation::framesRead() const {
+	return _framesRead;
+}
+
 crl::time FFMpegReaderImplementation::durationMs() const {
 	if (_fmtContext->streams[_streamId]->duration == AV_NOPTS_VALUE) return 0;
 	return (_fmtContext->streams[_streamId]->duration * 1000LL * _fmtContext->streams[_streamId]->time_base.num) / _fmtContext->streams[_streamId]->time_base.den;
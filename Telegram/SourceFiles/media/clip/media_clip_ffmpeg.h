@@ -32,6 +32,7 @@ public:
 
 	crl::time frameRealTime() const override;
 	crl::time framePresentationTime() const override;
+	int framesRead() const override;
 
 	bool renderFrame(QImage &to, bool &hasAlpha, const QSize &size) override;
 
@@ -87,6 +88,7 @@ private:
 	bool _opened = false;
 	bool _hadFrame = false;
 	bool _frameRead = false;
+	int _framesRead = 0;
 	int _skippedInvalidDataPackets = 0;
 
 	bool _hasAudioStream = false;
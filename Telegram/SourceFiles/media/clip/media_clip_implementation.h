@@ -40,6 +40,9 @@ public:
 	virtual crl::time frameRealTime() const = 0;
 	virtual crl::time framePresentationTime() const = 0;
 
+	// Count of frames read, to know if some were skipped to keep up.
+	virtual int framesRead() const = 0;
+
 	// Render current frame to an image with specific size.
 	virtual bool renderFrame(QImage &to, bool &hasAlpha, const QSize &size) = 0;
 
@@ -31,13 +31,24 @@ namespace Media {
 namespace Clip {
 namespace {
 
-constexpr auto kClipThreadsCount = 8;
+constexpr auto kClipThreadsMin = 2;
+constexpr auto kClipThreadsMax = 8;
 constexpr auto kAverageGifSize = 320 * 240;
 constexpr auto kWaitBeforeGifPause = crl::time(200);
+constexpr auto kMaxLoopCacheSize = int64(16 * 1024 * 1024);
+constexpr auto kMaxLoopCachesSize = int64(96 * 1024 * 1024);
 
 QVector<QThread*> threads;
 QVector<Manager*> managers;
 
+[[nodiscard]] int ClipThreadsCount() {
+	static const auto result = std::clamp(
+		QThread::idealThreadCount(),
+		kClipThreadsMin,
+		kClipThreadsMax);
+	return result;
+}
+
 QImage PrepareFrameImage(const FrameRequest &request, const QImage &original, bool hasAlpha, QImage &cache) {
 	auto needResize = (original.width() != request.framew) || (original.height() != request.frameh);
 	auto needOuterFill = (request.outerw != request.framew) || (request.outerh != request.frameh);
@@ -88,6 +99,150 @@ QPixmap PrepareFrame(const FrameRequest &request, const QImage &original, bool h
 	return QPixmap::fromImage(PrepareFrameImage(request, original, hasAlpha, cache), Qt::ColorOnly);
 }
 
+// Bytes held by all the loop caches of all the managers.
+std::atomic<int64> LoopCachesSize = 0;
+
+// Decoded frames of a short looping clip, collected during one loop,
+// so that the following loops don't decode anything.
+class LoopCache final {
+public:
+	struct Frame {
+		QImage image;
+		crl::time position = 0;
+		crl::time delay = 0;
+		bool alpha = false;
+	};
+
+	LoopCache() = default;
+	LoopCache(const LoopCache &other) = delete;
+	LoopCache &operator=(const LoopCache &other) = delete;
+	~LoopCache() {
+		clear();
+	}
+
+	[[nodiscard]] bool ready() const {
+		return (_state == State::Ready);
+	}
+	[[nodiscard]] QSize size() const {
+		return _size;
+	}
+
+	// Frames are collected starting from the next loop.
+	void clear(QSize size = QSize()) {
+		LoopCachesSize -= base::take(_bytes);
+		_frames.clear();
+		_state = State::Waiting;
+		_size = size;
+		_hasFirstFrame = false;
+		_lastPosition = -1;
+	}
+
+	// Frames are collected starting from the current one,
+	// which is the first frame after the loop start.
+	void startFromFirstFrame(
+			QSize size,
+			crl::time position,
+			crl::time presentation) {
+		clear(size);
+		_state = State::Filling;
+		_lastPosition = position;
+		_lastPresentation = presentation;
+	}
+
+	void add(
+			const QImage &image,
+			bool alpha,
+			crl::time position,
+			crl::time presentation,
+			bool contiguous) {
+		if (_state == State::Disabled || _state == State::Ready) {
+			return;
+		}
+		const auto wrapped = (_lastPosition >= 0)
+			&& (position < _lastPosition);
+		const auto delay = presentation - _lastPresentation;
+		_lastPosition = position;
+		_lastPresentation = presentation;
+		if (_state == State::Waiting) {
+			if (!wrapped) {
+				return;
+			}
+			_state = State::Filling;
+			_hasFirstFrame = true;
+		} else if (!contiguous) {
+			disable();
+			return;
+		} else if (wrapped && _hasFirstFrame) {
+			_frames.front().delay = delay;
+			finishFilling(presentation);
+			return;
+		}
+		const auto bytes = int64(image.bytesPerLine()) * image.height();
+		if (_bytes + bytes > kMaxLoopCacheSize
+			|| (LoopCachesSize += bytes) > kMaxLoopCachesSize) {
+			LoopCachesSize -= bytes;
+			disable();
+			return;
+		}
+		_bytes += bytes;
+		auto frame = Frame{ image, position, delay, alpha };
+		if (wrapped && !_hasFirstFrame) {
+			// Started from the frame after the first one, so the loop
+			// is complete once the first frame is shown again.
+			_frames.insert(begin(_frames), std::move(frame));
+			finishFilling(presentation);
+		} else {
+			// Including the first frame when the loop just wrapped from
+			// Waiting: the loop is complete only on the next wrap.
+			_frames.push_back(std::move(frame));
+		}
+	}
+
+	// Returns the next frame and updates the presentation time.
+	[[nodiscard]] const Frame &next() {
+		Expects(ready());
+
+		_index = (_index + 1) % int(_frames.size());
+		_presentation += _frames[_index].delay;
+		return _frames[_index];
+	}
+	[[nodiscard]] crl::time presentationTime() const {
+		return _presentation;
+	}
+	void keepUp(crl::time frameMs) {
+		_presentation = frameMs + 5;
+	}
+
+private:
+	enum class State {
+		Waiting,
+		Filling,
+		Ready,
+		Disabled,
+	};
+
+	void disable() {
+		clear(_size);
+		_state = State::Disabled;
+	}
+	void finishFilling(crl::time presentation) {
+		_state = State::Ready;
+		_index = 0;
+		_presentation = presentation;
+	}
+
+	std::vector<Frame> _frames;
+	State _state = State::Waiting;
+	QSize _size;
+	int64 _bytes = 0;
+	int _index = 0;
+	crl::time _presentation = 0;
+	crl::time _lastPosition = -1;
+	crl::time _lastPresentation = 0;
+	bool _hasFirstFrame = false;
+
+};
+
 } // namespace
 
 Reader::Reader(
@@ -109,7 +264,7 @@ Reader::Reader(const QByteArray &data, Callback &&callback)
 }
 
 void Reader::init(const Core::FileLocation &location, const QByteArray &data) {
-	if (threads.size() < kClipThreadsCount) {
+	if (threads.size() < ClipThreadsCount()) {
 		_threadIndex = threads.size();
 		threads.push_back(new QThread());
 		managers.push_back(new Manager(threads.back()));
@@ -428,6 +583,11 @@ public:
 
 	ProcessResult finishProcess(crl::time ms) {
 		auto frameMs = _seekPositionMs + ms - _animationStarted;
+		prepareLoopCache();
+		if (_loopCache.ready()) {
+			return showCachedFrame(frameMs);
+		}
+		const auto framesRead = _implementation->framesRead();
 		auto readResult = _implementation->readFramesTill(frameMs, ms);
 		if (readResult == internal::ReaderImplementation::ReadResult::EndOfFile) {
 			stop();
@@ -447,6 +607,51 @@ public:
 		if (!renderFrame()) {
 			return error();
 		}
+		_loopCache.add(
+			frame()->original,
+			frame()->alpha,
+			_nextFramePositionMs,
+			_implementation->framePresentationTime(),
+			(_implementation->framesRead() == framesRead + 1));
+		return ProcessResult::CopyFrame;
+	}
+
+	void prepareLoopCache() {
+		const auto size = QSize(_request.framew, _request.frameh);
+		if (_loopCache.size() == size) {
+			return;
+		} else if (_loopCache.size().isEmpty()
+			&& !_seekPositionMs
+			&& _implementation->framesRead() == 1) {
+			// Only the first frame was read yet, start from the next one.
+			_loopCache.startFromFirstFrame(
+				size,
+				_implementation->frameRealTime(),
+				_implementation->framePresentationTime());
+		} else {
+			_loopCache.clear(size);
+		}
+	}
+
+	ProcessResult showCachedFrame(crl::time frameMs) {
+		// Same keep up logic as in readFramesTill() of the implementation.
+		auto cached = &_loopCache.next();
+		if (_loopCache.presentationTime() <= frameMs) {
+			cached = &_loopCache.next();
+			if (_loopCache.presentationTime() <= frameMs) {
+				_loopCache.keepUp(frameMs);
+			}
+		}
+		_nextFramePositionMs = cached->position;
+		_nextFrameWhen = _animationStarted + _loopCache.presentationTime();
+		if (_nextFrameWhen > _seekPositionMs) {
+			_nextFrameWhen -= _seekPositionMs;
+		} else {
+			_nextFrameWhen = 1;
+		}
+		frame()->original = cached->image;
+		frame()->alpha = cached->alpha;
+		prepareFrame();
 		return ProcessResult::CopyFrame;
 	}
 
@@ -456,12 +661,16 @@ public:
 		if (!_implementation->renderFrame(frame()->original, frame()->alpha, QSize(_request.framew, _request.frameh))) {
 			return false;
 		}
+		prepareFrame();
+		return true;
+	}
+
+	void prepareFrame() {
 		frame()->original.setDevicePixelRatio(_request.factor);
 		frame()->pix = QPixmap();
 		frame()->pix = PrepareFrame(_request, frame()->original, frame()->alpha, frame()->cache);
 		frame()->when = _nextFrameWhen;
 		frame()->positionMs = _nextFramePositionMs;
-		return true;
 	}
 
 	bool init() {
@@ -502,6 +711,7 @@ public:
 
 	ProcessResult error() {
 		stop();
+		_loopCache.clear();
 		_state = State::Error;
 		return ProcessResult::Error;
 	}
@@ -562,6 +772,11 @@ private:
 	bool _started = false;
 	crl::time _videoPausedAtMs = 0;
 
+	// Part of the Manager::_loadLevel counted for this reader.
+	int _loadLevel = 0;
+
+	LoopCache _loopCache;
+
 	friend class Manager;
 
 };
@@ -578,10 +793,30 @@ Manager::Manager(QThread *thread) {
 
 void Manager::append(Reader *reader, const Core::FileLocation &location, const QByteArray &data) {
 	reader->_private = new ReaderPrivate(reader, location, data);
-	_loadLevel.fetchAndAddRelaxed(kAverageGifSize);
+	updateLoadLevel(reader->_private);
 	update(reader);
 }
 
+void Manager::updateLoadLevel(not_null<ReaderPrivate*> reader) {
+	// Paused readers don't decode anything, so they don't count.
+	const auto active = (reader->_state == State::Reading)
+		&& !reader->_autoPausedGif
+		&& !reader->_videoPausedAtMs;
+	const auto level = !active
+		? 0
+		: (reader->_width > 0)
+		? (reader->_width * reader->_height)
+		: kAverageGifSize;
+	if (const auto delta = level - reader->_loadLevel) {
+		reader->_loadLevel = level;
+		_loadLevel.fetchAndAddRelaxed(delta);
+	}
+}
+
+void Manager::removeLoadLevel(not_null<ReaderPrivate*> reader) {
+	_loadLevel.fetchAndAddRelaxed(-base::take(reader->_loadLevel));
+}
+
 void Manager::start(Reader *reader) {
 	update(reader);
 }
@@ -652,7 +887,7 @@ bool Manager::handleProcessResult(ReaderPrivate *reader, ProcessResult result, c
 	}
 
 	if (result == ProcessResult::Started) {
-		_loadLevel.fetchAndAddRelaxed(reader->_width * reader->_height - kAverageGifSize);
+		updateLoadLevel(reader);
 		it.key()->_durationMs = reader->_durationMs;
 	}
 	// See if we need to pause GIF because it is not displayed right now.
@@ -664,6 +899,8 @@ bool Manager::handleProcessResult(ReaderPrivate *reader, ProcessResult result, c
 			if (reader->_frames[ishowing].when + kWaitBeforeGifPause < ms || (reader->_frames[iprevious].when && previous->displayed.loadAcquire() <= 0)) {
 				reader->_autoPausedGif = true;
 				it.key()->_autoPausedGif.storeRelease(1);
+				reader->_loopCache.clear();
+				updateLoadLevel(reader);
 				result = ProcessResult::Paused;
 			}
 		}
@@ -693,7 +930,7 @@ bool Manager::handleProcessResult(ReaderPrivate *reader, ProcessResult result, c
 
 Manager::ResultHandleState Manager::handleResult(ReaderPrivate *reader, ProcessResult result, crl::time ms) {
 	if (!handleProcessResult(reader, result, ms)) {
-		_loadLevel.fetchAndAddRelaxed(-1 * (reader->_width > 0 ? reader->_width * reader->_height : kAverageGifSize));
+		removeLoadLevel(reader);
 		delete reader;
 		return ResultHandleRemove;
 	}
@@ -753,6 +990,7 @@ void Manager::process() {
 					} else {
 						i.key()->resumeVideo(ms);
 					}
+					updateLoadLevel(i.key());
 				}
 				auto frame = it.key()->frameToWrite();
 				if (frame) it.key()->_private->_request = frame->request;
@@ -785,7 +1023,7 @@ void Manager::process() {
 			QMutexLocker lock(&_readerPointersMutex);
 			auto it = constUnsafeFindReaderPointer(reader);
 			if (it == _readerPointers.cend()) {
-				_loadLevel.fetchAndAddRelaxed(-1 * (reader->_width > 0 ? reader->_width * reader->_height : kAverageGifSize));
+				removeLoadLevel(reader);
 				delete reader;
 				i = _readers.erase(i);
 				continue;
@@ -239,6 +239,8 @@ private:
 	void finish();
 	void callback(Reader *reader, Notification notification);
 	void clear();
+	void updateLoadLevel(not_null<ReaderPrivate*> reader);
+	void removeLoadLevel(not_null<ReaderPrivate*> reader);
 
 	QAtomicInt _loadLevel;
 	using ReaderPointers = QMap<Reader*, QAtomicInt>;
@@ -45,6 +45,9 @@ constexpr auto kIdsPreloadAfter = 28;
 
 constexpr auto kMinLengthForSavePosition = 20 * TimeId(60); // 20 minutes.
 
+// Prepare the next track of the playlist that much before the current ends.
+constexpr auto kPreloadNextBefore = 15 * crl::time(1000);
+
 } // namespace
 
 struct Instance::Streamed {
@@ -373,6 +376,42 @@ bool Instance::moveInPlaylist(
 	return false;
 }
 
+void Instance::preloadNext(not_null<Data*> data, const TrackState &state) {
+	if (!data->playlistIndex
+		|| data->repeatEnabled
+		|| !state.length
+		|| !state.frequency
+		|| IsStopped(state.state)) {
+		return;
+	}
+	const auto left = (state.length - state.position)
+		* crl::time(1000)
+		/ state.frequency;
+	if (state.receivedTill < state.length && left > kPreloadNextBefore) {
+		return;
+	}
+	const auto item = itemByIndex(data, *data->playlistIndex + 1);
+	if (!item || item->fullId() == data->preloadedContextId) {
+		return;
+	}
+	const auto media = item->media();
+	const auto document = media ? media->document() : nullptr;
+	if (!document
+		|| (!document->isAudioFile()
+			&& !document->isVoiceMessage()
+			&& !document->isVideoMessage())) {
+		return;
+	}
+
+	// The shared document opens its reader right away, so the header is
+	// requested from the cache while the current track is still playing.
+	// When we switch to the next track play() gets this same document.
+	data->preloadedContextId = item->fullId();
+	data->preloaded = document->owner().streaming().sharedDocument(
+		document,
+		item->fullId());
+}
+
 bool Instance::previousAvailable(AudioMsgId::Type type) const {
 	const auto data = getData(type);
 	Assert(data != nullptr);
@@ -484,6 +523,8 @@ void Instance::playStreamed(
 	}, data->streamed->lifetime);
 
 	data->streamed->instance.play(streamingOptions(audioId));
+	data->preloaded = nullptr;
+	data->preloadedContextId = FullMsgId();
 
 	emitUpdate(audioId.type());
 }
@@ -530,6 +571,8 @@ void Instance::stop(AudioMsgId::Type type) {
 		if (data->streamed) {
 			clearStreamed(data);
 		}
+		data->preloaded = nullptr;
+		data->preloadedContextId = FullMsgId();
 		data->resumeOnCallEnd = false;
 		_playerStopped.fire_copy({type});
 	}
@@ -721,6 +764,7 @@ void Instance::emitUpdate(AudioMsgId::Type type, CheckCallback check) {
 			}
 		}
 		_updatedNotifier.fire_copy({state});
+		preloadNext(data, state);
 		if (data->isPlaying && state.state == State::StoppedAtEnd) {
 			if (data->repeatEnabled) {
 				play(data->current);
@@ -187,6 +187,8 @@ private:
 		bool isPlaying = false;
 		bool resumeOnCallEnd = false;
 		std::unique_ptr<Streamed> streamed;
+		std::shared_ptr<Streaming::Document> preloaded;
+		FullMsgId preloadedContextId;
 	};
 
 	Instance();
@@ -216,6 +218,7 @@ private:
 	void validatePlaylist(not_null<Data*> data);
 	void playlistUpdated(not_null<Data*> data);
 	bool moveInPlaylist(not_null<Data*> data, int delta, bool autonext);
+	void preloadNext(not_null<Data*> data, const TrackState &state);
 	HistoryItem *itemByIndex(not_null<Data*> data, int index);
 	void stopAndClear(not_null<Data*> data);
 
@@ -10,6 +10,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "media/streaming/media_streaming_loader.h"
 #include "media/streaming/media_streaming_file_delegate.h"
 #include "ffmpeg/ffmpeg_utility.h"
+#include "kotato/settings.h"
 
 namespace Media {
 namespace Streaming {
@@ -157,7 +158,10 @@ Stream File::Context::initStream(
 		}
 	}
 
-	result.codec = FFmpeg::MakeCodecPointer(info);
+	result.codec = FFmpeg::MakeCodecPointer({
+		.stream = info,
+		.hwAllowed = (type == AVMEDIA_TYPE_VIDEO) && cHardwareVideoDecoding(),
+	});
 	if (!result.codec) {
 		if (info->codecpar->codec_id == AV_CODEC_ID_MJPEG) {
 			// mp3 files contain such "video stream", just ignore it.
@@ -498,6 +498,11 @@ void Player::provideStartInformation() {
 	} else {
 		_stage = Stage::Ready;
 
+		DEBUG_LOG(("Streaming Info: Ready at %1 in %2 ms, remote: %3."
+			).arg(_options.position
+			).arg(crl::now() - _playRequestedAt
+			).arg(Logs::b(_remoteLoader)));
+
 		if (_audio && _audioFinished) {
 			// Audio was stopped before it was ready.
 			_audio->stop();
@@ -541,6 +546,7 @@ void Player::play(const PlaybackOptions &options) {
 		_options.speed = 1.;
 	}
 	_stage = Stage::Initializing;
+	_playRequestedAt = crl::now();
 	_file->start(delegate(), _options.position);
 }
 
@@ -691,6 +697,8 @@ bool Player::receivedTillEnd() const {
 
 void Player::checkResumeFromWaitingForData() {
 	if (_pausedByWaitingForData && bothReceivedEnough(kBufferFor)) {
+		DEBUG_LOG(("Streaming Info: Waited for data %1 ms."
+			).arg(crl::now() - base::take(_waitingForDataSince)));
 		_pausedByWaitingForData = false;
 		updatePausedState();
 		_updates.fire({ WaitingForData{ false } });
@@ -709,6 +717,9 @@ void Player::start() {
 	) | rpl::filter([=] {
 		return !bothReceivedEnough(kBufferFor);
 	}) | rpl::start_with_next([=] {
+		if (!_pausedByWaitingForData) {
+			_waitingForDataSince = crl::now();
+		}
 		_pausedByWaitingForData = true;
 		updatePausedState();
 		_updates.fire({ WaitingForData{ true } });
@@ -198,6 +198,10 @@ private:
 	crl::time _totalDuration = kTimeUnknown;
 	crl::time _loopingShift = 0;
 	crl::time _previousReceivedTill = kTimeUnknown;
+
+	// For the startup and stall timings in the debug log.
+	crl::time _playRequestedAt = 0;
+	crl::time _waitingForDataSince = 0;
 	std::atomic<int> _durationByPackets = 0;
 	int _durationByLastAudioPacket = 0;
 	int _durationByLastVideoPacket = 0;
@@ -10,6 +10,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "media/streaming/media_streaming_common.h"
 #include "media/streaming/media_streaming_loader.h"
 #include "storage/cache/storage_cache_database.h"
+#include "platform/platform_specific.h"
 
 namespace Media {
 namespace Streaming {
@@ -22,13 +23,138 @@ constexpr auto kMaxPartsInHeader = 64;
 constexpr auto kMaxOnlyInHeader = 80 * kPartSize;
 constexpr auto kPartsOutsideFirstSliceGood = 8;
 constexpr auto kSlicesInMemory = 2;
+constexpr auto kSlicesMemoryMin = int64(64 * 1024 * 1024);
+constexpr auto kSlicesMemoryMax = int64(512 * 1024 * 1024);
+constexpr auto kSlicesMemoryPhysicalPart = 32;
 
 // 1 MB of parts are requested from cloud ahead of reading demand.
 constexpr auto kPreloadPartsAhead = 8;
 constexpr auto kDownloaderRequestsLimit = 4;
 
+// When the read position jumps farther than that the parts requested
+// for the old position are cancelled to free the download sessions.
+constexpr auto kKeepLoadsAroundSeek = kInSlice;
+
 using PartsMap = base::flat_map<int, QByteArray>;
 
+// Slices used by all the readers are kept in memory while they fit in the
+// budget. Above it the reader holding the least recently used slice (or
+// more than its fair share of slices) unloads its oldest one.
+class SlicesBudget final {
+public:
+	SlicesBudget();
+
+	void add(not_null<const void*> owner);
+	void remove(not_null<const void*> owner);
+	void update(not_null<const void*> owner, int count, crl::time oldest);
+	[[nodiscard]] bool shouldUnload(not_null<const void*> owner);
+
+	void hit();
+	void cacheRead();
+	void evicted();
+
+	[[nodiscard]] Reader::SlicesCacheStats stats();
+
+private:
+	struct Usage {
+		int count = 0;
+		crl::time oldest = 0;
+	};
+
+	QMutex _mutex;
+	base::flat_map<not_null<const void*>, Usage> _owners;
+	const int _limit = 0;
+	int _used = 0;
+	std::atomic<int64> _hits = 0;
+	std::atomic<int64> _cacheReads = 0;
+	std::atomic<int64> _evictions = 0;
+
+};
+
+[[nodiscard]] int ComputeSlicesLimit() {
+	const auto physical = Platform::PhysicalMemorySize();
+	const auto bytes = physical
+		? std::clamp(
+			physical / kSlicesMemoryPhysicalPart,
+			kSlicesMemoryMin,
+			kSlicesMemoryMax)
+		: kSlicesMemoryMin;
+	return int(bytes / kInSlice);
+}
+
+SlicesBudget::SlicesBudget() : _limit(ComputeSlicesLimit()) {
+}
+
+void SlicesBudget::add(not_null<const void*> owner) {
+	QMutexLocker lock(&_mutex);
+	_owners.emplace(owner, Usage());
+}
+
+void SlicesBudget::remove(not_null<const void*> owner) {
+	QMutexLocker lock(&_mutex);
+	if (const auto usage = _owners.take(owner)) {
+		_used -= usage->count;
+	}
+}
+
+void SlicesBudget::update(
+		not_null<const void*> owner,
+		int count,
+		crl::time oldest) {
+	QMutexLocker lock(&_mutex);
+	const auto i = _owners.find(owner);
+	Assert(i != end(_owners));
+	_used += count - i->second.count;
+	i->second = Usage{ count, oldest };
+}
+
+bool SlicesBudget::shouldUnload(not_null<const void*> owner) {
+	QMutexLocker lock(&_mutex);
+	if (_used <= _limit) {
+		return false;
+	}
+	const auto i = _owners.find(owner);
+	Assert(i != end(_owners));
+	const auto fair = std::max(_limit / int(_owners.size()), kSlicesInMemory);
+	if (i->second.count > fair) {
+		return true;
+	}
+	return ranges::none_of(_owners, [&](const auto &pair) {
+		const auto &usage = pair.second;
+		return (usage.count > kSlicesInMemory)
+			&& (usage.oldest < i->second.oldest);
+	});
+}
+
+void SlicesBudget::hit() {
+	++_hits;
+}
+
+void SlicesBudget::cacheRead() {
+	++_cacheReads;
+}
+
+void SlicesBudget::evicted() {
+	++_evictions;
+}
+
+Reader::SlicesCacheStats SlicesBudget::stats() {
+	auto result = Reader::SlicesCacheStats();
+	result.hits = _hits;
+	result.cacheReads = _cacheReads;
+	result.evictions = _evictions;
+	result.slicesLimit = _limit;
+
+	QMutexLocker lock(&_mutex);
+	result.slicesUsed = _used;
+	return result;
+}
+
+[[nodiscard]] SlicesBudget &Budget() {
+	static auto result = SlicesBudget();
+	return result;
+}
+
 struct ParsedCacheEntry {
 	PartsMap parts;
 	std::optional<PartsMap> included;
@@ -344,6 +470,11 @@ Reader::Slices::Slices(int size, bool useCache)
 	if (!isFullInHeader()) {
 		_data.resize(SlicesCount(_size));
 	}
+	Budget().add(this);
+}
+
+Reader::Slices::~Slices() {
+	Budget().remove(this);
 }
 
 bool Reader::Slices::headerModeUnknown() const {
@@ -588,6 +719,7 @@ auto Reader::Slices::fill(int offset, bytes::span buffer) -> FillResult {
 			if (!(_data[sliceIndex].flags & Flag::LoadingFromCache)) {
 				_data[sliceIndex].flags |= Flag::LoadingFromCache;
 				result.sliceNumbersFromCache.add(sliceIndex + 1);
+				Budget().cacheRead();
 			}
 			result.state = FillState::WaitingCache;
 		}
@@ -605,6 +737,7 @@ auto Reader::Slices::fill(int offset, bytes::span buffer) -> FillResult {
 		handlePrepareResult(fromSlice + 1, second);
 	}
 	if (first.ready && second.ready) {
+		Budget().hit();
 		markSliceUsed(fromSlice);
 		CopyLoaded(
 			buffer,
@@ -684,6 +817,7 @@ bool Reader::Slices::readCacheForDownloaderRequired(int offset) {
 }
 
 void Reader::Slices::markSliceUsed(int sliceIndex) {
+	_data[sliceIndex].lastUsed = crl::now();
 	const auto i = ranges::find(_usedSlices, sliceIndex);
 	const auto end = _usedSlices.end();
 	if (i == end) {
@@ -694,6 +828,14 @@ void Reader::Slices::markSliceUsed(int sliceIndex) {
 			std::rotate(i, next, end);
 		}
 	}
+	updateBudgetUsage();
+}
+
+void Reader::Slices::updateBudgetUsage() {
+	const auto oldest = _usedSlices.empty()
+		? crl::time(0)
+		: _data[_usedSlices.front()].lastUsed;
+	Budget().update(this, int(_usedSlices.size()), oldest);
 }
 
 int Reader::Slices::maxSliceSize(int sliceNumber) const {
@@ -704,11 +846,14 @@ Reader::SerializedSlice Reader::Slices::serializeAndUnloadUnused() {
 	using Flag = Slice::Flag;
 
 	if (_headerMode == HeaderMode::Unknown
-		|| _usedSlices.size() <= kSlicesInMemory) {
+		|| _usedSlices.size() <= kSlicesInMemory
+		|| !Budget().shouldUnload(this)) {
 		return {};
 	}
 	const auto purgeSlice = _usedSlices.front();
 	_usedSlices.pop_front();
+	updateBudgetUsage();
+	Budget().evicted();
 	if (!(_data[purgeSlice].flags & Flag::LoadedFromCache)) {
 		// If the only data in this slice was from _header, just leave it.
 		return {};
@@ -1299,8 +1444,20 @@ void Reader::cancelLoadInRange(int from, int till) {
 	}
 }
 
+void Reader::cancelStaleLoads(int offset) {
+	const auto from = std::max(offset - kKeepLoadsAroundSeek, 0);
+	const auto till = std::min(offset + kKeepLoadsAroundSeek, size());
+	if (from > 0) {
+		cancelLoadInRange(0, from);
+	}
+	if (till < size()) {
+		cancelLoadInRange(till, size());
+	}
+}
+
 void Reader::checkLoadWillBeFirst(int offset) {
 	if (_loadingOffsets.front().value_or(offset) != offset) {
+		cancelStaleLoads(offset);
 		_loadingOffsets.resetPriorities();
 		_loader->resetPriorities();
 	}
@@ -1392,8 +1549,21 @@ void Reader::finalizeCache() {
 	_cache->sync();
 }
 
+Reader::SlicesCacheStats Reader::CacheStats() {
+	return Budget().stats();
+}
+
 Reader::~Reader() {
 	finalizeCache();
+
+	const auto stats = CacheStats();
+	DEBUG_LOG(("Streaming Info: Slices cache hits %1, cache reads %2, "
+		"evictions %3, slices used %4 of %5."
+		).arg(stats.hits
+		).arg(stats.cacheReads
+		).arg(stats.evictions
+		).arg(stats.slicesUsed
+		).arg(stats.slicesLimit));
 }
 
 } // namespace Streaming
@@ -78,6 +78,16 @@ public:
 	void cancelForDownloader(
 		not_null<Storage::StreamedFileDownloader*> downloader);
 
+	struct SlicesCacheStats {
+		int64 hits = 0;
+		int64 cacheReads = 0;
+		int64 evictions = 0;
+		int slicesUsed = 0;
+		int slicesLimit = 0;
+	};
+	// Thread safe, shared by all the readers.
+	[[nodiscard]] static SlicesCacheStats CacheStats();
+
 	~Reader();
 
 private:
@@ -137,6 +147,7 @@ private:
 			int till) const;
 
 		PartsMap parts;
+		crl::time lastUsed = 0;
 		Flags flags;
 
 	};
@@ -144,6 +155,9 @@ private:
 	class Slices {
 	public:
 		Slices(int size, bool useCache);
+		Slices(const Slices &other) = delete;
+		Slices &operator=(const Slices &other) = delete;
+		~Slices();
 
 		void headerDone(bool fromCache);
 		[[nodiscard]] int headerSize() const;
@@ -184,6 +198,7 @@ private:
 			const Slice &slice) const;
 		[[nodiscard]] QByteArray serializeAndUnloadFirstSliceNoHeader();
 		void markSliceUsed(int sliceIndex);
+		void updateBudgetUsage();
 		[[nodiscard]] bool computeIsGoodHeader() const;
 		[[nodiscard]] FillResult fillFromHeader(
 			int offset,
@@ -209,6 +224,7 @@ private:
 	void putToCache(SerializedSlice &&data);
 
 	void cancelLoadInRange(int from, int till);
+	void cancelStaleLoads(int offset);
 	void loadAtOffset(int offset);
 	void checkLoadWillBeFirst(int offset);
 	bool processLoadedParts();
@@ -110,6 +110,10 @@ QImage ConvertFrame(
 		QImage storage) {
 	Expects(frame != nullptr);
 
+	frame = FFmpeg::SoftwareFrame(frame, stream.transferred);
+	if (!frame) {
+		return QImage();
+	}
 	const auto frameSize = QSize(frame->width, frame->height);
 	if (frameSize.isEmpty()) {
 		LOG(("Streaming Error: Bad frame size %1,%2"
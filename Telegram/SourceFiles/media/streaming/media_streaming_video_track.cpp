@@ -9,6 +9,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 
 #include "media/audio/media_audio.h"
 #include "base/concurrent_timer.h"
+#include "core/crash_reports.h"
+#include "kotato/settings.h"
 
 namespace Media {
 namespace Streaming {
@@ -17,6 +19,7 @@ namespace {
 constexpr auto kMaxFrameArea = 3840 * 2160; // usual 4K
 constexpr auto kDisplaySkipped = crl::time(-1);
 constexpr auto kFinishedPosition = std::numeric_limits<crl::time>::max();
+constexpr auto kSmallFrameDivider = 2;
 static_assert(kDisplaySkipped != kTimeUnknown);
 
 } // namespace
@@ -77,7 +80,9 @@ private:
 	[[nodiscard]] ReadEnoughState readEnoughFrames(crl::time trackTime);
 	[[nodiscard]] FrameResult readFrame(not_null<Frame*> frame);
 	void fillRequests(not_null<Frame*> frame) const;
-	[[nodiscard]] QSize chooseOriginalResize() const;
+	[[nodiscard]] QSize chooseOriginalResize(QSize encoded) const;
+	[[nodiscard]] bool allRequestsSmall() const;
+	void updateDecodeQuality();
 	void presentFrameIfNeeded();
 	void callReady();
 	[[nodiscard]] bool loopAround();
@@ -109,6 +114,7 @@ private:
 	rpl::event_stream<> _checkNextFrame;
 	rpl::event_stream<> _waitingForData;
 	base::flat_map<const Instance*, FrameRequest> _requests;
+	bool _decodeReduced = false;
 
 	bool _queued = false;
 	base::ConcurrentTimer _readFramesTimer;
@@ -321,6 +327,9 @@ auto VideoTrackObject::readFrame(not_null<Frame*> frame) -> FrameResult {
 	std::swap(frame->decoded, _stream.frame);
 	frame->position = position;
 	frame->displayed = kTimeUnknown;
+	CrashReports::SetAnnotationSlot(
+		CrashReports::AnnotationSlot::StreamingPosition,
+		uint64(position));
 	return FrameResult::Done;
 }
 
@@ -340,21 +349,33 @@ void VideoTrackObject::fillRequests(not_null<Frame*> frame) const {
 	}
 }
 
-QSize VideoTrackObject::chooseOriginalResize() const {
+QSize VideoTrackObject::chooseOriginalResize(QSize encoded) const {
 	auto chosen = QSize();
+	auto different = false;
 	for (const auto &[_, request] : _requests) {
 		if (request.resize.isEmpty()) {
 			return QSize();
 		}
 		const auto byWidth = (request.resize.width() >= chosen.width());
 		const auto byHeight = (request.resize.height() >= chosen.height());
-		if (byWidth && byHeight) {
-			chosen = request.resize;
-		} else if (byWidth || byHeight) {
-			return QSize();
+		if (byWidth != byHeight) {
+			different = true;
 		}
+		chosen = chosen.expandedTo(request.resize);
+	}
+	if (!different) {
+		return chosen;
+	}
+
+	// Rasterize to the bounding size of all requests and downscale
+	// from it, that is still much cheaper than the original size.
+	if (FFmpeg::RotationSwapWidthHeight(_stream.rotation)) {
+		encoded.transpose();
 	}
-	return chosen;
+	return (chosen.width() <= encoded.width()
+		&& chosen.height() <= encoded.height())
+		? chosen
+		: QSize();
 }
 
 void VideoTrackObject::rasterizeFrame(not_null<Frame*> frame) {
@@ -365,7 +386,8 @@ void VideoTrackObject::rasterizeFrame(not_null<Frame*> frame) {
 	frame->original = ConvertFrame(
 		_stream,
 		frame->decoded.get(),
-		chooseOriginalResize(),
+		chooseOriginalResize(
+			QSize(frame->decoded->width, frame->decoded->height)),
 		std::move(frame->original));
 	if (frame->original.isNull()) {
 		frame->prepared.clear();
@@ -475,10 +497,47 @@ void VideoTrackObject::updateFrameRequest(
 		const Instance *instance,
 		const FrameRequest &request) {
 	_requests.emplace(instance, request);
+	updateDecodeQuality();
 }
 
 void VideoTrackObject::removeFrameRequest(const Instance *instance) {
 	_requests.remove(instance);
+	updateDecodeQuality();
+}
+
+bool VideoTrackObject::allRequestsSmall() const {
+	if (_requests.empty()) {
+		return false;
+	}
+	auto encoded = QSize(_stream.codec->width, _stream.codec->height);
+	if (FFmpeg::RotationSwapWidthHeight(_stream.rotation)) {
+		encoded.transpose();
+	}
+	for (const auto &[_, request] : _requests) {
+		if (request.resize.isEmpty()
+			|| request.resize.width() * kSmallFrameDivider > encoded.width()
+			|| request.resize.height() * kSmallFrameDivider
+				> encoded.height()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void VideoTrackObject::updateDecodeQuality() {
+	const auto reduced = cSmallVideoLowPower() && allRequestsSmall();
+	if (_decodeReduced == reduced) {
+		return;
+	}
+	_decodeReduced = reduced;
+
+	// When the frames are heavily downscaled anyway the deblocking
+	// artifacts are not visible, so we can save quite some CPU time.
+	const auto codec = _stream.codec.get();
+	codec->skip_loop_filter = reduced ? AVDISCARD_ALL : AVDISCARD_DEFAULT;
+	codec->skip_frame = (reduced && cSmallVideoSkipFrames())
+		? AVDISCARD_NONREF
+		: AVDISCARD_DEFAULT;
 }
 
 bool VideoTrackObject::tryReadFirstFrame(FFmpeg::Packet &&packet) {
@@ -16,6 +16,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/file_utilities.h"
 #include "core/mime_type.h"
 #include "core/ui_integration.h"
+#include "core/paint_stats.h"
 #include "ui/widgets/popup_menu.h"
 #include "ui/widgets/buttons.h"
 #include "ui/image/image.h"
@@ -46,6 +47,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "data/data_media_rotation.h"
 #include "data/data_photo_media.h"
 #include "data/data_document_media.h"
+#include "data/data_streaming.h"
 #include "window/themes/window_theme_preview.h"
 #include "window/window_peer_menu.h"
 #include "window/window_session_controller.h"
@@ -198,7 +200,8 @@ void PaintImageProfile(QPainter &p, const QImage &image, QRect rect, QRect fill)
 
 QPixmap PrepareStaticImage(const QString &path) {
 	auto image = App::readImage(path, nullptr, false);
-#if defined Q_OS_MAC && !defined OS_MAC_OLD
+#ifdef USE_OPENGL_OVERLAY_WIDGET
+	// Textures larger than that may be not supported.
 	if (image.width() > kMaxDisplayImageSize
 		|| image.height() > kMaxDisplayImageSize) {
 		image = image.scaled(
@@ -207,7 +210,7 @@ QPixmap PrepareStaticImage(const QString &path) {
 			Qt::KeepAspectRatio,
 			Qt::SmoothTransformation);
 	}
-#endif // Q_OS_MAC && !OS_MAC_OLD
+#endif // USE_OPENGL_OVERLAY_WIDGET
 	return App::pixmapFromImageInPlace(std::move(image));
 }
 
@@ -524,7 +527,8 @@ QImage OverlayWidget::videoFrameForDirectPaint() const {
 		return result;
 	}
 
-	// On macOS 10.8+ we use QOpenGLWidget as OverlayWidget base class.
+	// On macOS 10.8+ (or with KTGDESKTOP_ENABLE_OPENGL_OVERLAY)
+	// we use QOpenGLWidget as OverlayWidget base class.
 	// The OpenGL painter can't paint textures where byte data is with strides.
 	// So in that case we prepare a compact copy of the frame to render.
 	//
@@ -570,6 +574,14 @@ void OverlayWidget::clearStreaming(bool savePosition) {
 			_document,
 			_streamed->instance.player().prepareLegacyState());
 	}
+	if (_streamed && !_streamed->instance.player().failed()) {
+		// Showing the same video again soon reuses the opened demuxer.
+		if (_document) {
+			_document->owner().streaming().keepAlive(_document);
+		} else if (_photo) {
+			_photo->owner().streaming().keepAlive(_photo);
+		}
+	}
 	_fullScreenVideo = false;
 	_streamed = nullptr;
 }
@@ -3045,6 +3057,7 @@ void OverlayWidget::validatePhotoCurrentImage() {
 }
 
 void OverlayWidget::paintEvent(QPaintEvent *e) {
+	const auto stats = Core::PaintStats::Span("OverlayWidget");
 	const auto r = e->rect();
 	const auto region = e->region();
 	const auto contentShown = _photo || documentContentShown();
@@ -3830,13 +3843,17 @@ void OverlayWidget::preloadData(int delta) {
 	if (!_index) {
 		return;
 	}
-	auto from = *_index + (delta ? delta : -1);
-	auto till = *_index + (delta ? delta * kPreloadCount : 1);
-	if (from > till) std::swap(from, till);
+	// Preload a few items in the direction we're moving and keep the one
+	// we came from, so that going back doesn't load and decode it again.
+	const auto from = *_index - ((delta < 0) ? kPreloadCount : 1);
+	const auto till = *_index + ((delta > 0) ? kPreloadCount : 1);
 
 	auto photos = base::flat_set<std::shared_ptr<Data::PhotoMedia>>();
 	auto documents = base::flat_set<std::shared_ptr<Data::DocumentMedia>>();
 	for (auto index = from; index != till + 1; ++index) {
+		if (index == *_index) {
+			continue;
+		}
 		auto entity = entityByIndex(index);
 		if (auto photo = std::get_if<not_null<PhotoData*>>(&entity.data)) {
 			const auto [i, ok] = photos.emplace((*photo)->createMediaView());
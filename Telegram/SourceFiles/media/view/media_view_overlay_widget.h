@@ -51,9 +51,10 @@ namespace View {
 class GroupThumbs;
 class Pip;
 
-#if defined Q_OS_MAC && !defined OS_MAC_OLD
+#if (defined Q_OS_MAC && !defined OS_MAC_OLD) \
+	|| defined KTGDESKTOP_ENABLE_OPENGL_OVERLAY
 #define USE_OPENGL_OVERLAY_WIDGET
-#endif // Q_OS_MAC && !OS_MAC_OLD
+#endif // (Q_OS_MAC && !OS_MAC_OLD) || KTGDESKTOP_ENABLE_OPENGL_OVERLAY
 
 #ifdef USE_OPENGL_OVERLAY_WIDGET
 using OverlayParent = Ui::RpWidgetWrap<QOpenGLWidget>;
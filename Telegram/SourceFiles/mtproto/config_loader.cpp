@@ -40,6 +40,12 @@ void ConfigLoader::load() {
 	if (!_instance->isKeysDestroyer()) {
 		sendRequest(_instance->mainDcId());
 		_enumDCTimer.callOnce(kEnumerateDcTimeout);
+
+		// If the last config said we're blocked, race the special
+		// endpoints right away instead of after the enumerate timeout.
+		if (_instance->configValues().blockedMode) {
+			refreshSpecialLoader();
+		}
 	} else {
 		auto ids = _instance->dcOptions().configEnumDcIds();
 		Assert(!ids.empty());
@@ -24,6 +24,11 @@ constexpr auto kPacketSizeMax = int(0x01000000 * sizeof(mtpPrime));
 constexpr auto kFullConnectionTimeout = 8 * crl::time(1000);
 constexpr auto kSmallBufferSize = 256 * 1024;
 constexpr auto kMinPacketBuffer = 256;
+
+// Packets of that size or larger that are not received at once are read
+// straight to their own mtpBuffer and then moved to the received queue.
+constexpr auto kMinLargePacketSize = 16 * 1024;
+static_assert(kMinLargePacketSize <= kSmallBufferSize);
 constexpr auto kConnectionStartPrefixSize = 64;
 
 } // namespace
@@ -42,6 +47,7 @@ public:
 	static constexpr auto kUnknownSize = -1;
 	static constexpr auto kInvalidSize = -2;
 	virtual int readPacketLength(bytes::const_span bytes) const = 0;
+	virtual int readPacketHeaderSize(bytes::const_span bytes) const = 0;
 	virtual bytes::const_span readPacket(bytes::const_span bytes) const = 0;
 
 	virtual ~Protocol() = default;
@@ -63,6 +69,7 @@ public:
 	bytes::span finalizePacket(mtpBuffer &buffer) override;
 
 	int readPacketLength(bytes::const_span bytes) const override;
+	int readPacketHeaderSize(bytes::const_span bytes) const override;
 	bytes::const_span readPacket(bytes::const_span bytes) const override;
 
 };
@@ -128,13 +135,20 @@ int TcpConnection::Protocol::Version0::readPacketLength(
 	return kInvalidSize;
 }
 
+int TcpConnection::Protocol::Version0::readPacketHeaderSize(
+		bytes::const_span bytes) const {
+	Expects(!bytes.empty());
+
+	return (static_cast<char>(bytes[0]) == 0x7F) ? 4 : 1;
+}
+
 bytes::const_span TcpConnection::Protocol::Version0::readPacket(
 		bytes::const_span bytes) const {
 	const auto size = readPacketLength(bytes);
 	Assert(size != kUnknownSize
 		&& size != kInvalidSize
 		&& size <= bytes.size());
-	const auto sizeLength = (static_cast<char>(bytes[0]) == 0x7F) ? 4 : 1;
+	const auto sizeLength = readPacketHeaderSize(bytes);
 	return bytes.subspan(sizeLength, size - sizeLength);
 }
 
@@ -175,6 +189,7 @@ public:
 	bytes::span finalizePacket(mtpBuffer &buffer) override;
 
 	int readPacketLength(bytes::const_span bytes) const override;
+	int readPacketHeaderSize(bytes::const_span bytes) const override;
 	bytes::const_span readPacket(bytes::const_span bytes) const override;
 
 };
@@ -213,13 +228,18 @@ int TcpConnection::Protocol::VersionD::readPacketLength(
 		: kInvalidSize;
 }
 
+int TcpConnection::Protocol::VersionD::readPacketHeaderSize(
+		bytes::const_span bytes) const {
+	return 4;
+}
+
 bytes::const_span TcpConnection::Protocol::VersionD::readPacket(
 		bytes::const_span bytes) const {
 	const auto size = readPacketLength(bytes);
 	Assert(size != kUnknownSize
 		&& size != kInvalidSize
 		&& size <= bytes.size());
-	const auto sizeLength = 4;
+	const auto sizeLength = readPacketHeaderSize(bytes);
 	return bytes.subspan(sizeLength, size - sizeLength);
 }
 
@@ -252,35 +272,48 @@ ConnectionPointer TcpConnection::clone(const ProxyData &proxy) {
 }
 
 void TcpConnection::ensureAvailableInBuffer(int amount) {
-	auto &buffer = _usingLargeBuffer ? _largeBuffer : _smallBuffer;
-	const auto full = bytes::make_span(buffer).subspan(
-		_offsetBytes);
+	Expects(amount <= _smallBuffer.size());
+
+	const auto full = bytes::make_span(_smallBuffer).subspan(_offsetBytes);
 	if (full.size() >= amount) {
 		return;
 	}
-	const auto read = full.subspan(0, _readBytes);
-	if (amount <= _smallBuffer.size()) {
-		if (_usingLargeBuffer) {
-			bytes::copy(_smallBuffer, read);
-			_usingLargeBuffer = false;
-			_largeBuffer.clear();
-		} else {
-			bytes::move(_smallBuffer, read);
-		}
-	} else if (amount <= _largeBuffer.size()) {
-		Assert(_usingLargeBuffer);
-		bytes::move(_largeBuffer, read);
-	} else {
-		auto enough = bytes::vector(amount);
-		bytes::copy(enough, read);
-		_largeBuffer = std::move(enough);
-		_usingLargeBuffer = true;
-	}
+	bytes::move(_smallBuffer, full.subspan(0, _readBytes));
 	_offsetBytes = 0;
 }
 
+void TcpConnection::startLargePacket(
+		bytes::const_span available,
+		int packetSize) {
+	Expects(_largePacket.isEmpty());
+	Expects(available.size() < packetSize);
+
+	const auto header = _protocol->readPacketHeaderSize(available);
+	const auto payload = packetSize - header;
+	_largePacket = mtpBuffer((payload + sizeof(mtpPrime) - 1)
+		/ sizeof(mtpPrime));
+	_largePacketSize = payload;
+	_largePacketRead = available.size() - header;
+	bytes::copy(
+		bytes::make_span(_largePacket),
+		available.subspan(header));
+	_leftBytes = packetSize - available.size();
+	_offsetBytes = _readBytes = 0;
+}
+
+void TcpConnection::finishLargePacket() {
+	Expects(_largePacketRead == _largePacketSize);
+
+	auto packet = base::take(_largePacket);
+	packet.resize(_largePacketSize / sizeof(mtpPrime));
+	_largePacketSize = _largePacketRead = 0;
+	TCP_LOG(("TCP Info: large packet received, size = %1"
+		).arg(packet.size() * sizeof(mtpPrime)));
+	processPacket(std::move(packet));
+}
+
 void TcpConnection::socketRead() {
-	Expects(_leftBytes > 0 || !_usingLargeBuffer);
+	Expects(_leftBytes > 0 || _largePacket.isEmpty());
 
 	if (!_socket || !_socket->isConnected()) {
 		LOG(("MTP Error: Socket not connected in socketRead()"));
@@ -292,20 +325,36 @@ void TcpConnection::socketRead() {
 		_smallBuffer.resize(kSmallBufferSize);
 	}
 	do {
+		const auto large = !_largePacket.isEmpty();
 		const auto readLimit = (_leftBytes > 0)
 			? _leftBytes
 			: (kSmallBufferSize - _offsetBytes - _readBytes);
 		Assert(readLimit > 0);
 
-		auto &buffer = _usingLargeBuffer ? _largeBuffer : _smallBuffer;
-		const auto full = bytes::make_span(buffer).subspan(_offsetBytes);
-		const auto free = full.subspan(_readBytes);
+		const auto full = large
+			? bytes::make_span(_largePacket)
+			: bytes::make_span(_smallBuffer).subspan(_offsetBytes);
+		const auto free = full.subspan(large ? _largePacketRead : _readBytes);
 		const auto readCount = _socket->read(free.subspan(0, readLimit));
 		if (readCount > 0) {
 			const auto read = free.subspan(0, readCount);
 			aesCtrEncrypt(read, _receiveKey, &_receiveState);
 			TCP_LOG(("TCP Info: read %1 bytes").arg(readCount));
 
+			if (large) {
+				Assert(readCount <= _leftBytes);
+				_largePacketRead += readCount;
+				_leftBytes -= readCount;
+				if (!_leftBytes) {
+					finishLargePacket();
+					if (!_socket || !_socket->isConnected()) {
+						return;
+					}
+				} else {
+					emit receivedSome();
+				}
+				continue;
+			}
 			_readBytes += readCount;
 			if (_leftBytes > 0) {
 				Assert(readCount <= _leftBytes);
@@ -316,8 +365,6 @@ void TcpConnection::socketRead() {
 						return;
 					}
 
-					_usingLargeBuffer = false;
-					_largeBuffer.clear();
 					_offsetBytes = _readBytes = 0;
 				} else {
 					TCP_LOG(("TCP Info: not enough %1 for packet! read %2"
@@ -350,6 +397,17 @@ void TcpConnection::socketRead() {
 
 						// If we have too little space left in the buffer.
 						ensureAvailableInBuffer(kMinPacketBuffer);
+					} else if (packetSize >= kMinLargePacketSize) {
+						// Read the rest right to the packet buffer.
+						startLargePacket(available, packetSize);
+
+						TCP_LOG(("TCP Info: not enough %1 for large packet! "
+							"full size %2 read %3"
+							).arg(_leftBytes
+							).arg(packetSize
+							).arg(_largePacketRead));
+						emit receivedSome();
+						break;
 					} else {
 						_leftBytes = packetSize - available.size();
 
@@ -583,10 +641,13 @@ crl::time TcpConnection::fullConnectTimeout() const {
 }
 
 void TcpConnection::socketPacket(bytes::const_span bytes) {
+	processPacket(parsePacket(bytes));
+}
+
+void TcpConnection::processPacket(mtpBuffer &&data) {
 	Expects(_socket != nullptr);
 
 	// old quickack?..
-	const auto data = parsePacket(bytes);
 	if (data.size() == 1) {
 		if (data[0] != 0) {
 			emit error(data[0]);
@@ -596,7 +657,7 @@ void TcpConnection::socketPacket(bytes::const_span bytes) {
 	//} else if (data.size() == 2) {
 		// new quickack?..
 	} else if (_status == Status::Ready) {
-		_receivedQueue.push_back(data);
+		_receivedQueue.push_back(std::move(data));
 		emit receivedData();
 	} else if (_status == Status::Waiting) {
 		if (const auto res_pq = readPQFakeReply(data)) {
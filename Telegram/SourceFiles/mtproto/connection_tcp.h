@@ -55,6 +55,7 @@ private:
 	bytes::const_span prepareConnectionStartPrefix(bytes::span buffer);
 
 	void socketPacket(bytes::const_span bytes);
+	void processPacket(mtpBuffer &&data);
 
 	void socketConnected();
 	void socketDisconnected();
@@ -62,6 +63,8 @@ private:
 
 	mtpBuffer parsePacket(bytes::const_span bytes);
 	void ensureAvailableInBuffer(int amount);
+	void startLargePacket(bytes::const_span available, int packetSize);
+	void finishLargePacket();
 	static uint32 fourCharsToUInt(char ch1, char ch2, char ch3, char ch4) {
 		char ch[4] = { ch1, ch2, ch3, ch4 };
 		return *reinterpret_cast<uint32*>(ch);
@@ -75,8 +78,9 @@ private:
 	int _readBytes = 0;
 	int _leftBytes = 0;
 	bytes::vector _smallBuffer;
-	bytes::vector _largeBuffer;
-	bool _usingLargeBuffer = false;
+	mtpBuffer _largePacket;
+	int _largePacketSize = 0;
+	int _largePacketRead = 0;
 
 	uchar _sendKey[CTRState::KeySize];
 	CTRState _sendState;
@@ -159,7 +159,7 @@ AbstractDedicatedLoader::AbstractDedicatedLoader(
 
 void AbstractDedicatedLoader::start() {
 	if (!validateOutput()
-		|| (!_output.isOpen() && !_output.open(QIODevice::Append))) {
+		|| (!_output.isOpen() && !_output.open(QIODevice::ReadWrite))) {
 		QFile(_filepath).remove();
 		threadSafeFailed();
 		return;
@@ -195,15 +195,44 @@ rpl::producer<> AbstractDedicatedLoader::failed() const {
 
 void AbstractDedicatedLoader::wipeFolder() {
 	QFileInfo info(_filepath);
+	QFileInfo state(statePath());
 	const auto dir = info.dir();
 	const auto all = dir.entryInfoList(QDir::Files);
 	for (auto i = all.begin(), e = all.end(); i != e; ++i) {
-		if (i->absoluteFilePath() != info.absoluteFilePath()) {
+		if (i->absoluteFilePath() != info.absoluteFilePath()
+			&& i->absoluteFilePath() != state.absoluteFilePath()) {
 			QFile::remove(i->absoluteFilePath());
 		}
 	}
 }
 
+QString AbstractDedicatedLoader::statePath() const {
+	return _filepath + qstr(".part");
+}
+
+bool AbstractDedicatedLoader::writeState(bool holes) {
+	// The state keeps the size of the fully written prefix while
+	// the output has parts written after a hole, so that resuming
+	// never trusts the zero-filled gaps.
+	if (!holes) {
+		if (_stateWritten) {
+			QFile(statePath()).remove();
+			_stateWritten = false;
+		}
+		return true;
+	}
+	QFile state(statePath());
+	if (!state.open(QIODevice::WriteOnly)) {
+		return false;
+	}
+	const auto size = qint32(_alreadySize);
+	const auto written = state.write(
+		reinterpret_cast<const char*>(&size),
+		sizeof(size));
+	_stateWritten = true;
+	return (written == sizeof(size));
+}
+
 bool AbstractDedicatedLoader::validateOutput() {
 	if (_filepath.isEmpty()) {
 		return false;
@@ -216,10 +245,22 @@ bool AbstractDedicatedLoader::validateOutput() {
 	}
 	_output.setFileName(_filepath);
 
+	QFile state(statePath());
+	auto writtenSize = info.exists() ? info.size() : qint64(0);
+	if (state.exists()) {
+		auto size = qint32(0);
+		const auto good = state.open(QIODevice::ReadOnly)
+			&& (state.read(reinterpret_cast<char*>(&size), sizeof(size))
+				== sizeof(size))
+			&& (size >= 0);
+		state.close();
+		state.remove();
+		writtenSize = good ? std::min(writtenSize, qint64(size)) : 0;
+	}
 	if (!info.exists()) {
 		return true;
 	}
-	const auto fullSize = info.size();
+	const auto fullSize = writtenSize;
 	if (fullSize < _chunkSize || fullSize > kMaxFileSize) {
 		return _output.remove();
 	}
@@ -252,8 +293,23 @@ void AbstractDedicatedLoader::threadSafeFailed() {
 }
 
 void AbstractDedicatedLoader::writeChunk(bytes::const_span data, int totalSize) {
-	const auto size = data.size();
+	writePart(_alreadySize, data, totalSize);
+}
+
+void AbstractDedicatedLoader::writePart(
+		int offset,
+		bytes::const_span data,
+		int totalSize) {
+	Expects(offset >= _alreadySize);
+
+	const auto size = int(data.size());
+	const auto hole = (offset > _alreadySize);
 	if (size > 0) {
+		if ((hole && !_stateWritten && !writeState(true))
+			|| !_output.seek(offset)) {
+			threadSafeFailed();
+			return;
+		}
 		const auto written = _output.write(QByteArray::fromRawData(
 			reinterpret_cast<const char*>(data.data()),
 			size));
@@ -268,9 +324,25 @@ void AbstractDedicatedLoader::writeChunk(bytes::const_span data, int totalSize)
 		if (!_totalSize) {
 			_totalSize = totalSize;
 		}
-		_alreadySize += size;
-		return Progress { _alreadySize, _totalSize };
+		if (hole) {
+			_parts.emplace(offset, size);
+			_partsSize += size;
+		} else {
+			_alreadySize += size;
+			while (!_parts.empty()
+				&& _parts.begin()->first == _alreadySize) {
+				const auto part = _parts.begin()->second;
+				_parts.erase(_parts.begin());
+				_partsSize -= part;
+				_alreadySize += part;
+			}
+		}
+		return Progress { _alreadySize + _partsSize, _totalSize };
 	}();
+	if (!hole && _stateWritten && !writeState(!_parts.empty())) {
+		threadSafeFailed();
+		return;
+	}
 
 	if (progress.size > 0 && progress.already >= progress.size) {
 		_output.close();
@@ -314,7 +386,7 @@ void DedicatedLoader::sendRequest() {
 		return;
 	}
 	const auto offset = _offset;
-	_requests.push_back({ offset });
+	_requests.emplace(offset);
 	_mtp.send(
 		MTPupload_GetFile(
 			MTP_flags(0),
@@ -346,17 +418,21 @@ void DedicatedLoader::gotPart(int offset, const MTPupload_File &result) {
 		return;
 	}
 
-	const auto i = ranges::find(
-		_requests,
-		offset,
-		[](const Request &request) { return request.offset; });
-	Assert(i != end(_requests));
-
-	i->bytes = data.vbytes().v;
-	while (!_requests.empty() && !_requests.front().bytes.isEmpty()) {
-		writeChunk(bytes::make_span(_requests.front().bytes), _size);
-		_requests.pop_front();
+	const auto &bytes = data.vbytes().v;
+	if (bytes.size() != std::min(kChunkSize, _size - offset)) {
+		LOG(("Update Error: MTP bad part size %1 for offset %2."
+			).arg(bytes.size()
+			).arg(offset));
+		threadSafeFailed();
+		return;
 	}
+
+	// Parts are written in place as soon as they arrive, so the
+	// requests window does not hold any downloaded bytes in memory.
+	const auto removed = _requests.remove(offset);
+	Assert(removed);
+
+	writePart(offset, bytes::make_span(bytes), _size);
 	sendRequest();
 }
 
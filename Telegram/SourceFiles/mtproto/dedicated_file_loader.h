@@ -84,11 +84,14 @@ protected:
 
 	// Single threaded.
 	void writeChunk(bytes::const_span data, int totalSize);
+	void writePart(int offset, bytes::const_span data, int totalSize);
 
 private:
 	virtual void startLoading() = 0;
 
 	bool validateOutput();
+	[[nodiscard]] QString statePath() const;
+	[[nodiscard]] bool writeState(bool holes);
 	void threadSafeProgress(Progress progress);
 	void threadSafeReady();
 
@@ -96,7 +99,10 @@ private:
 	int _chunkSize = 0;
 
 	QFile _output;
+	base::flat_map<int, int> _parts; // Written after a hole, offset -> size.
+	bool _stateWritten = false;
 	int _alreadySize = 0;
+	int _partsSize = 0;
 	int _totalSize = 0;
 	mutable QMutex _sizesMutex;
 	rpl::event_stream<Progress> _progress;
@@ -126,10 +132,6 @@ public:
 		const File &file);
 
 private:
-	struct Request {
-		int offset = 0;
-		QByteArray bytes;
-	};
 	void startLoading() override;
 	void sendRequest();
 	void gotPart(int offset, const MTPupload_File &result);
@@ -138,7 +140,7 @@ private:
 	static constexpr auto kRequestsCount = 2;
 	static constexpr auto kNextRequestDelay = crl::time(20);
 
-	std::deque<Request> _requests;
+	base::flat_set<int> _requests;
 	int32 _size = 0;
 	int _offset = 0;
 	DcId _dcId = 0;
@@ -255,11 +255,16 @@ void DomainResolver::sendNextRequest(const AttemptKey &key) {
 	}
 	auto &attempts = i->second;
 	auto &list = attempts.list;
+	if (list.empty()) {
+		return;
+	}
 	const auto attempt = list.back();
 	list.pop_back();
 
-	if (!list.empty()) {
-		base::call_delayed(kSendNextTimeout, &attempts.guard, [=] {
+	if (list.empty()) {
+		attempts.guard.reset();
+	} else {
+		base::call_delayed(kSendNextTimeout, &attempts.guard.emplace(), [=] {
 			sendNextRequest(key);
 		});
 	}
@@ -315,6 +320,15 @@ void DomainResolver::requestFinished(
 	const auto result = finalizeRequest(key, reply);
 	const auto response = ParseDnsResponse(result);
 	if (response.empty()) {
+		if (_requests.find(key) == end(_requests)) {
+			// Nothing else is in flight, don't wait for the next timeout.
+			const auto i = _attempts.find(key);
+			if (i != end(_attempts) && !i->second.list.empty()) {
+				sendNextRequest(key);
+			} else {
+				_attempts.erase(key);
+			}
+		}
 		return;
 	}
 	_requests.erase(key);
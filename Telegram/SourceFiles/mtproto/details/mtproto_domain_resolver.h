@@ -76,7 +76,7 @@ private:
 	};
 	struct Attempts {
 		std::vector<Attempt> list;
-		base::has_weak_ptr guard;
+		std::optional<base::has_weak_ptr> guard; // Of the delayed next.
 	};
 
 	void resolve(const AttemptKey &key);
@@ -10,45 +10,96 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace MTP::details {
 
 bool ReceivedIdsManager::registerMsgId(mtpMsgId msgId, bool needAck) {
-	const auto i = _idsNeedAck.find(msgId);
-	if (i == _idsNeedAck.end()) {
-		if (_idsNeedAck.size() < kIdsBufferSize || msgId > min()) {
-			_idsNeedAck.emplace(msgId, needAck);
-			return true;
-		}
-		MTP_LOG(-1, ("No need to handle - %1 < min = %2").arg(msgId).arg(min()));
-	} else {
+	if (!_count || msgId > max()) {
+		insert(_count, msgId, needAck);
+		return true;
+	}
+	const auto position = lowerBound(msgId);
+	if (position < _count && at(position) == msgId) {
 		MTP_LOG(-1, ("No need to handle - %1 already is in map").arg(msgId));
+	} else if (_count < kIdsBufferSize || msgId > min()) {
+		insert(position, msgId, needAck);
+		return true;
+	} else {
+		MTP_LOG(-1, ("No need to handle - %1 < min = %2").arg(msgId).arg(min()));
 	}
 	return false;
 }
 
 mtpMsgId ReceivedIdsManager::min() const {
-	return _idsNeedAck.empty() ? 0 : _idsNeedAck.begin()->first;
+	return _count ? at(0) : 0;
 }
 
 mtpMsgId ReceivedIdsManager::max() const {
-	auto end = _idsNeedAck.end();
-	return _idsNeedAck.empty() ? 0 : (--end)->first;
+	return _count ? at(_count - 1) : 0;
 }
 
 ReceivedIdsManager::State ReceivedIdsManager::lookup(mtpMsgId msgId) const {
-	auto i = _idsNeedAck.find(msgId);
-	if (i == _idsNeedAck.end()) {
+	const auto position = lowerBound(msgId);
+	if (position == _count || at(position) != msgId) {
 		return State::NotFound;
 	}
-	return i->second ? State::NeedsAck : State::NoAckNeeded;
+	return _needAck[ringIndex(position)]
+		? State::NeedsAck
+		: State::NoAckNeeded;
 }
 
 void ReceivedIdsManager::shrink() {
-	auto size = _idsNeedAck.size();
-	while (size-- > kIdsBufferSize) {
-		_idsNeedAck.erase(_idsNeedAck.begin());
+	if (_count > kIdsBufferSize) {
+		removeOldest(_count - kIdsBufferSize);
 	}
 }
 
 void ReceivedIdsManager::clear() {
-	_idsNeedAck.clear();
+	_first = _count = 0;
+}
+
+int ReceivedIdsManager::ringIndex(int position) const {
+	return (_first + position) % kCapacity;
+}
+
+mtpMsgId ReceivedIdsManager::at(int position) const {
+	return _ids[ringIndex(position)];
+}
+
+int ReceivedIdsManager::lowerBound(mtpMsgId msgId) const {
+	auto from = 0;
+	auto till = _count;
+	while (from < till) {
+		const auto middle = from + (till - from) / 2;
+		if (at(middle) < msgId) {
+			from = middle + 1;
+		} else {
+			till = middle;
+		}
+	}
+	return from;
+}
+
+void ReceivedIdsManager::insert(int position, mtpMsgId msgId, bool needAck) {
+	if (_count == kCapacity) {
+		// Full without shrink(), forget the oldest one.
+		Assert(position > 0);
+		removeOldest(1);
+		--position;
+	}
+	for (auto i = _count; i != position; --i) {
+		const auto to = ringIndex(i);
+		const auto from = ringIndex(i - 1);
+		_ids[to] = _ids[from];
+		_needAck[to] = _needAck[from];
+	}
+	const auto index = ringIndex(position);
+	_ids[index] = msgId;
+	_needAck[index] = needAck;
+	++_count;
+}
+
+void ReceivedIdsManager::removeOldest(int count) {
+	Expects(count <= _count);
+
+	_first = ringIndex(count);
+	_count -= count;
 }
 
 } // namespace MTP::details
@@ -7,7 +7,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #pragma once
 
-#include "base/flat_map.h"
+#include <bitset>
 
 namespace MTP::details {
 
@@ -31,7 +31,21 @@ public:
 	void clear();
 
 private:
-	base::flat_map<mtpMsgId, bool> _idsNeedAck;
+	// Room for a whole container of ids between shrink() calls.
+	static constexpr auto kCapacity = 2 * kIdsBufferSize;
+
+	[[nodiscard]] int ringIndex(int position) const;
+	[[nodiscard]] mtpMsgId at(int position) const;
+	[[nodiscard]] int lowerBound(mtpMsgId msgId) const;
+	void insert(int position, mtpMsgId msgId, bool needAck);
+	void removeOldest(int count);
+
+	// Sorted msgIds in a ring buffer, server msgIds are almost monotonic,
+	// so usually they're added to the end and removed from the beginning.
+	std::array<mtpMsgId, kCapacity> _ids = { { 0 } };
+	std::bitset<kCapacity> _needAck;
+	int _first = 0;
+	int _count = 0;
 
 };
 
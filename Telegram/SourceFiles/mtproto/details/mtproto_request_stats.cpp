@@ -0,0 +1,178 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "mtproto/details/mtproto_request_stats.h"
+
+#include "mtproto/core_types.h"
+
+namespace MTP::details {
+namespace {
+
+// Upper bounds of the histogram buckets, the last one has no bound.
+constexpr auto kBucketBounds = std::array<crl::time, 9>{ {
+	10,
+	25,
+	50,
+	100,
+	250,
+	500,
+	1000,
+	2500,
+	5000,
+} };
+
+} // namespace
+
+void RequestStats::Histogram::add(crl::time duration) {
+	const auto i = ranges::upper_bound(kBucketBounds, duration);
+	++buckets[i - begin(kBucketBounds)];
+	++count;
+	total += duration;
+	accumulate_max(max, duration);
+}
+
+QString RequestStats::Histogram::text() const {
+	auto result = QString("n:%1 avg:%2 max:%3"
+		).arg(count
+		).arg(count ? (total / count) : 0
+		).arg(max);
+	for (auto i = 0; i != kBucketsCount; ++i) {
+		if (!buckets[i]) {
+			continue;
+		}
+		result += (i < int(kBucketBounds.size()))
+			? QString(" <%1:%2").arg(kBucketBounds[i]).arg(buckets[i])
+			: QString(" >=%1:%2").arg(kBucketBounds.back()).arg(buckets[i]);
+	}
+	return result;
+}
+
+auto RequestStats::CategoryByDcId(ShiftedDcId shiftedDcId) -> Category {
+	const auto shift = GetDcIdShift(shiftedDcId);
+	if (!shift || shift == kLogoutDcShift) {
+		return Category::Api;
+	} else if (shift == kExportDcShift || shift == kExportMediaDcShift) {
+		return Category::Export;
+	} else if (shift == kUpdaterDcShift) {
+		return Category::Updater;
+	} else if (shift >= kBaseDownloadDcShift
+		&& shift < kBaseDownloadDcShift + kMaxMediaDcCount) {
+		return Category::Download;
+	} else if (shift >= kBaseUploadDcShift
+		&& shift < kBaseUploadDcShift + kMaxMediaDcCount) {
+		return Category::Upload;
+	}
+	return Category::Service;
+}
+
+const char *RequestStats::CategoryName(Category category) {
+	switch (category) {
+	case Category::Api: return "api";
+	case Category::Download: return "download";
+	case Category::Upload: return "upload";
+	case Category::Export: return "export";
+	case Category::Updater: return "updater";
+	case Category::Service: return "service";
+	case Category::kCount: break;
+	}
+	Unexpected("Category in RequestStats::CategoryName.");
+}
+
+void RequestStats::packetSent(
+		ShiftedDcId shiftedDcId,
+		int bytes,
+		int messages,
+		bool container) {
+	const auto category = int(CategoryByDcId(shiftedDcId));
+
+	QMutexLocker lock(&_mutex);
+	_categories[category].sent += bytes;
+	_categoriesTotal[category].sent += bytes;
+	auto &dc = _dcs[shiftedDcId];
+	dc.bytesSent += bytes;
+	++dc.packetsSent;
+	if (container) {
+		++dc.containers;
+		dc.containerMessages += messages;
+	}
+}
+
+void RequestStats::packetReceived(ShiftedDcId shiftedDcId, int bytes) {
+	const auto category = int(CategoryByDcId(shiftedDcId));
+
+	QMutexLocker lock(&_mutex);
+	_categories[category].received += bytes;
+	_categoriesTotal[category].received += bytes;
+	auto &dc = _dcs[shiftedDcId];
+	dc.bytesReceived += bytes;
+	++dc.packetsReceived;
+}
+
+void RequestStats::responseReceived(
+		ShiftedDcId shiftedDcId,
+		mtpTypeId method,
+		crl::time queued,
+		crl::time network) {
+	QMutexLocker lock(&_mutex);
+	auto &stats = _methods[std::make_pair(shiftedDcId, method)];
+	stats.queued.add(std::max(queued, crl::time(0)));
+	stats.network.add(std::max(network, crl::time(0)));
+}
+
+QString RequestStats::takeDump(crl::time now) {
+	QMutexLocker lock(&_mutex);
+	const auto methods = base::take(_methods);
+	const auto dcs = base::take(_dcs);
+	const auto categories = base::take(_categories);
+	const auto categoriesTotal = _categoriesTotal;
+	const auto duration = _periodStart ? (now - _periodStart) : 0;
+	_periodStart = now;
+	lock.unlock();
+
+	auto result = QStringList();
+	result.push_back(QString("Period: %1 ms").arg(duration));
+	for (auto i = 0; i != int(Category::kCount); ++i) {
+		const auto &period = categories[i];
+		const auto &total = categoriesTotal[i];
+		if (!total.sent && !total.received) {
+			continue;
+		}
+		result.push_back(QString("traffic:%1 sent:%2 received:%3 "
+			"total_sent:%4 total_received:%5"
+			).arg(CategoryName(Category(i))
+			).arg(period.sent
+			).arg(period.received
+			).arg(total.sent
+			).arg(total.received));
+	}
+	for (const auto &[shiftedDcId, dc] : dcs) {
+		result.push_back(QString("dc:%1 sent:%2/%3 received:%4/%5 "
+			"containers:%6 packing:%7"
+			).arg(shiftedDcId
+			).arg(dc.bytesSent
+			).arg(dc.packetsSent
+			).arg(dc.bytesReceived
+			).arg(dc.packetsReceived
+			).arg(dc.containers
+			).arg(dc.containers
+				? (dc.containerMessages / double(dc.containers))
+				: 1.,
+				0,
+				'f',
+				2));
+	}
+	for (const auto &[key, stats] : methods) {
+		result.push_back(QString("dc:%1 method:0x%2 queued:{%3} network:{%4}"
+			).arg(key.first
+			).arg(key.second, 8, 16, QChar('0')
+			).arg(stats.queued.text()
+			).arg(stats.network.text()));
+	}
+	return result.join('\n');
+}
+
+} // namespace MTP::details
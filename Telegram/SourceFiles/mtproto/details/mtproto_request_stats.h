@@ -0,0 +1,90 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/flat_map.h"
+
+#include <QtCore/QMutex>
+
+namespace MTP::details {
+
+// Thread safe, collected from all the session threads.
+class RequestStats final {
+public:
+	void packetSent(
+		ShiftedDcId shiftedDcId,
+		int bytes,
+		int messages,
+		bool container);
+	void packetReceived(ShiftedDcId shiftedDcId, int bytes);
+	void responseReceived(
+		ShiftedDcId shiftedDcId,
+		mtpTypeId method,
+		crl::time queued,
+		crl::time network);
+
+	// Returns the collected statistics text and starts a new period.
+	[[nodiscard]] QString takeDump(crl::time now);
+
+private:
+	static constexpr auto kBucketsCount = 10;
+
+	// Traffic kind, derived from the dc shift of the session.
+	enum class Category {
+		Api,
+		Download,
+		Upload,
+		Export,
+		Updater,
+		Service,
+
+		kCount,
+	};
+	struct Traffic {
+		int64 sent = 0;
+		int64 received = 0;
+	};
+	using Categories = std::array<
+		Traffic,
+		static_cast<size_t>(Category::kCount)>;
+
+	[[nodiscard]] static Category CategoryByDcId(ShiftedDcId shiftedDcId);
+	[[nodiscard]] static const char *CategoryName(Category category);
+
+	struct Histogram {
+		void add(crl::time duration);
+		[[nodiscard]] QString text() const;
+
+		std::array<int, kBucketsCount> buckets = { { 0 } };
+		int count = 0;
+		crl::time total = 0;
+		crl::time max = 0;
+	};
+	struct MethodStats {
+		Histogram queued;
+		Histogram network;
+	};
+	struct DcStats {
+		int64 bytesSent = 0;
+		int64 bytesReceived = 0;
+		int packetsSent = 0;
+		int packetsReceived = 0;
+		int containers = 0;
+		int containerMessages = 0;
+	};
+
+	QMutex _mutex;
+	base::flat_map<std::pair<ShiftedDcId, mtpTypeId>, MethodStats> _methods;
+	base::flat_map<ShiftedDcId, DcStats> _dcs;
+	Categories _categories;
+	Categories _categoriesTotal;
+	crl::time _periodStart = 0;
+
+};
+
+} // namespace MTP::details
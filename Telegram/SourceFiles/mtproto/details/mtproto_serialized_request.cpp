@@ -12,6 +12,9 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 namespace MTP::details {
 namespace {
 
+// Alignment, 12 bytes of minimal padding and up to 60 extended primes.
+constexpr auto kMaxPaddingPrimes = uint32(3 + 4 + (0x0F << 2));
+
 uint32 CountPaddingPrimesCount(uint32 requestSize, bool extended, bool old) {
 	if (old) {
 		return ((8 + requestSize) & 0x03)
@@ -32,6 +35,7 @@ uint32 CountPaddingPrimesCount(uint32 requestSize, bool extended, bool old) {
 		result += ((openssl::RandomValue<uchar>() & 0x0F) << 2);
 	}
 
+	Ensures(result <= kMaxPaddingPrimes);
 	return result;
 }
 
@@ -48,8 +52,10 @@ SerializedRequest SerializedRequest::Prepare(
 
 	const auto finalSize = std::max(size, reserveSize);
 
+	// Reserve for addPadding() as well, so that sending the request
+	// doesn't reallocate and copy the whole buffer.
 	auto result = SerializedRequest(RequestConstructHider::Tag{});
-	result->reserve(kMessageBodyPosition + finalSize);
+	result->reserve(kMessageBodyPosition + finalSize + kMaxPaddingPrimes);
 	result->resize(kMessageBodyPosition);
 	result->back() = (size << 2);
 	result->lastSentTime = crl::now();
@@ -143,6 +149,25 @@ bool SerializedRequest::needAck() const {
 	return true;
 }
 
+RequestPriority SerializedRequest::computePriority(
+		crl::time msCanWait) const {
+	Expects(_data != nullptr);
+	Expects(_data->size() > kMessageBodyPosition);
+
+	const auto type = mtpTypeId((*_data)[kMessageBodyPosition]);
+	switch (type) {
+	case mtpc_upload_getFile:
+	case mtpc_upload_getCdnFile:
+	case mtpc_upload_getWebFile:
+	case mtpc_upload_saveFilePart:
+	case mtpc_upload_saveBigFilePart:
+		return RequestPriority::Bulk;
+	}
+	return (msCanWait > 0)
+		? RequestPriority::Background
+		: RequestPriority::Interactive;
+}
+
 size_t SerializedRequest::sizeInBytes() const {
 	Expects(!_data || _data->size() > kMessageBodyPosition);
 	return _data ? (*_data)[kMessageLengthPosition] : 0;
@@ -17,6 +17,12 @@ namespace details {
 class RequestData;
 class SerializedRequest;
 
+enum class RequestPriority : uchar {
+	Interactive,
+	Background,
+	Bulk,
+};
+
 class RequestConstructHider {
 	struct Tag {};
 	friend class RequestData;
@@ -70,6 +76,9 @@ public:
 
 	[[nodiscard]] bool needAck() const;
 
+	// Bulk for file parts transfer, background for the delayed requests.
+	[[nodiscard]] RequestPriority computePriority(crl::time msCanWait) const;
+
 	using ResponseType = void; // don't know real response type =(
 
 private:
@@ -88,10 +97,12 @@ public:
 	}
 
 	SerializedRequest after;
+	crl::time queuedTime = 0;
 	crl::time lastSentTime = 0;
 	mtpRequestId requestId = 0;
 	bool needsLayer = false;
 	bool forceSendInContainer = false;
+	RequestPriority priority = RequestPriority::Interactive;
 
 };
 
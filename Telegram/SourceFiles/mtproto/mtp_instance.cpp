@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/mtp_instance.h"
 
 #include "mtproto/details/mtproto_dcenter.h"
+#include "mtproto/details/mtproto_request_stats.h"
 #include "mtproto/details/mtproto_rsa_public_key.h"
 #include "mtproto/special_config_request.h"
 #include "mtproto/session.h"
@@ -34,6 +35,15 @@ constexpr auto kConfigBecomesOldIn = 2 * 60 * crl::time(1000);
 constexpr auto kConfigBecomesOldForBlockedIn = 8 * crl::time(1000);
 constexpr auto kCheckKeyEach = 60 * crl::time(1000);
 
+// How many recently used dcs to connect to at startup.
+constexpr auto kWarmUpDcsCount = 2;
+
+// Warmed up sessions without any requests are killed after that.
+constexpr auto kWarmUpSessionTimeout = 60 * crl::time(1000);
+
+// Request statistics are written to the debug log that often.
+constexpr auto kRequestStatsDumpPeriod = 5 * 60 * crl::time(1000);
+
 using namespace details;
 
 std::atomic<int> GlobalAtomicRequestId = 0;
@@ -66,6 +76,7 @@ public:
 	[[nodiscard]] DcOptions &dcOptions() const;
 	[[nodiscard]] Environment environment() const;
 	[[nodiscard]] bool isTestMode() const;
+	[[nodiscard]] details::RequestStats &requestStats() const;
 
 	void resolveProxyDomain(const QString &host);
 	void setGoodProxyDomain(const QString &host, const QString &ip);
@@ -178,6 +189,10 @@ private:
 
 	void unpaused();
 
+	void warmUpSessions();
+	void killWarmUpSessions();
+	void dumpRequestStats();
+
 	Session *findSession(ShiftedDcId shiftedDcId);
 	not_null<Session*> startSession(ShiftedDcId shiftedDcId);
 	Session *removeSession(ShiftedDcId shiftedDcId);
@@ -265,6 +280,12 @@ private:
 
 	base::Timer _checkDelayedTimer;
 
+	base::flat_set<ShiftedDcId> _warmUpSessions;
+	base::Timer _warmUpTimer;
+
+	mutable details::RequestStats _requestStats;
+	base::Timer _requestStatsTimer;
+
 	rpl::lifetime _lifetime;
 
 };
@@ -327,14 +348,58 @@ void Instance::Private::start() {
 		}
 	} else if (_mainDcId != Fields::kNoneMainDc) {
 		_mainSession = startSession(_mainDcId);
+		if (cNetWarmUpConnections()) {
+			warmUpSessions();
+		}
 	}
 
 	_checkDelayedTimer.setCallback([this] { checkDelayedRequests(); });
 
+	_requestStatsTimer.setCallback([=] { dumpRequestStats(); });
+	_requestStatsTimer.callEach(kRequestStatsDumpPeriod);
+
 	Assert((_mainDcId == Fields::kNoneMainDc) == isKeysDestroyer());
 	requestConfig();
 }
 
+void Instance::Private::warmUpSessions() {
+	// Connect to the recently used media dcs in parallel with the main one,
+	// only where we have an auth key already, so no handshake is needed.
+	const auto mainDcId = BareDcId(_mainDcId);
+	for (const auto dcId : dcOptions().recentDcIds(kWarmUpDcsCount + 1)) {
+		if (dcId == mainDcId
+			|| !_keysForWrite.contains(dcId)
+			|| dcOptions().dcType(dcId) != DcType::Regular) {
+			continue;
+		} else if (int(_warmUpSessions.size()) >= kWarmUpDcsCount) {
+			break;
+		}
+		const auto shiftedDcId = MTP::downloadDcId(dcId, 0);
+		if (!findSession(shiftedDcId)) {
+			DEBUG_LOG(("MTP Info: warming up session %1.").arg(shiftedDcId));
+			startSession(shiftedDcId);
+			_warmUpSessions.emplace(shiftedDcId);
+		}
+	}
+	if (!_warmUpSessions.empty()) {
+		_warmUpTimer.setCallback([=] { killWarmUpSessions(); });
+		_warmUpTimer.callOnce(kWarmUpSessionTimeout);
+	}
+}
+
+void Instance::Private::killWarmUpSessions() {
+	for (const auto shiftedDcId : base::take(_warmUpSessions)) {
+		DEBUG_LOG(("MTP Info: killing unused warm up session %1."
+			).arg(shiftedDcId));
+		killSession(shiftedDcId);
+	}
+}
+
+void Instance::Private::dumpRequestStats() {
+	const auto dump = _requestStats.takeDump(crl::now());
+	DEBUG_LOG(("MTP Stats:\n%1").arg(dump));
+}
+
 void Instance::Private::resolveProxyDomain(const QString &host) {
 	if (!_domainResolver) {
 		_domainResolver = std::make_unique<DomainResolver>([=](
@@ -817,6 +882,10 @@ DcOptions &Instance::Private::dcOptions() const {
 	return _config->dcOptions();
 }
 
+details::RequestStats &Instance::Private::requestStats() const {
+	return _requestStats;
+}
+
 Environment Instance::Private::environment() const {
 	return _config->environment();
 }
@@ -950,8 +1019,12 @@ void Instance::Private::sendRequest(
 	if (afterRequestId) {
 		request->after = getRequest(afterRequestId);
 	}
-	request->lastSentTime = crl::now();
+	request->queuedTime = request->lastSentTime = crl::now();
 	request->needsLayer = needsLayer;
+	request->priority = request.computePriority(msCanWait);
+	if (!_warmUpSessions.empty()) {
+		_warmUpSessions.remove(session->getDcWithShift());
+	}
 
 	session->sendPrepared(request, msCanWait);
 }
@@ -1790,6 +1863,10 @@ DcOptions &Instance::dcOptions() const {
 	return _private->dcOptions();
 }
 
+details::RequestStats &Instance::requestStats() const {
+	return _private->requestStats();
+}
+
 Environment Instance::environment() const {
 	return _private->environment();
 }
@@ -15,6 +15,7 @@ namespace details {
 
 class Dcenter;
 class Session;
+class RequestStats;
 
 [[nodiscard]] int GetNextRequestId();
 
@@ -78,6 +79,7 @@ public:
 	[[nodiscard]] DcOptions &dcOptions() const;
 	[[nodiscard]] Environment environment() const;
 	[[nodiscard]] bool isTestMode() const;
+	[[nodiscard]] details::RequestStats &requestStats() const;
 	[[nodiscard]] QString deviceModel() const;
 	[[nodiscard]] QString systemVersion() const;
 
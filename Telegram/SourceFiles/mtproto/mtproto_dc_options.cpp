@@ -21,6 +21,8 @@ namespace {
 
 using namespace details;
 
+constexpr auto kMaxPreferredEndpoints = 8;
+
 struct BuiltInDc {
 	int id;
 	const char *ip;
@@ -151,6 +153,7 @@ DcOptions::DcOptions(const DcOptions &other)
 , _cdnDcIds(other._cdnDcIds)
 , _publicKeys(other._publicKeys)
 , _cdnPublicKeys(other._cdnPublicKeys)
+, _preferred(other._preferred)
 , _immutable(other._immutable) {
 }
 
@@ -460,7 +463,16 @@ QByteArray DcOptions::serialize() const {
 		}
 	}
 
-	constexpr auto kVersion = 1;
+	// Preferred endpoints.
+	size += sizeof(qint32);
+	for (const auto &preferred : _preferred) {
+		// id + type + protocol + port
+		size += sizeof(qint32) * 4;
+		size += sizeof(qint32) + preferred.ip.size();
+		size += sizeof(qint64);
+	}
+
+	constexpr auto kVersion = 2;
 
 	auto result = QByteArray();
 	result.reserve(size);
@@ -495,6 +507,18 @@ QByteArray DcOptions::serialize() const {
 				<< Serialize::bytes(key.n)
 				<< Serialize::bytes(key.e);
 		}
+
+		// Preferred endpoints.
+		stream << qint32(_preferred.size());
+		for (const auto &preferred : _preferred) {
+			stream << qint32(preferred.id)
+				<< qint32(preferred.type)
+				<< qint32(preferred.protocol)
+				<< qint32(preferred.port)
+				<< qint32(preferred.ip.size());
+			stream.writeRawData(preferred.ip.data(), preferred.ip.size());
+			stream << qint64(preferred.rtt);
+		}
 	}
 	return result;
 }
@@ -590,6 +614,52 @@ bool DcOptions::constructFromSerialized(const QByteArray &serialized) {
 			}
 		}
 	}
+
+	// Read preferred endpoints
+	_preferred.clear();
+	if (version > 1 && !stream.atEnd()) {
+		auto count = qint32(0);
+		stream >> count;
+		if (stream.status() != QDataStream::Ok
+			|| count < 0
+			|| count > kMaxPreferredEndpoints) {
+			LOG(("MTP Error: Bad data for preferred endpoints in DcOptions::constructFromSerialized()"));
+			return false;
+		}
+		for (auto i = 0; i != count; ++i) {
+			qint32 id = 0, type = 0, protocol = 0, port = 0, ipSize = 0;
+			stream >> id >> type >> protocol >> port >> ipSize;
+
+			constexpr auto kMaxIpSize = 45;
+			if (ipSize <= 0 || ipSize > kMaxIpSize) {
+				LOG(("MTP Error: Bad data for preferred endpoints inside DcOptions::constructFromSerialized()"));
+				return false;
+			}
+			auto ip = std::string(ipSize, ' ');
+			stream.readRawData(ip.data(), ipSize);
+
+			auto rtt = qint64(0);
+			stream >> rtt;
+			if (stream.status() != QDataStream::Ok) {
+				LOG(("MTP Error: Bad data for preferred endpoints inside DcOptions::constructFromSerialized()"));
+				return false;
+			}
+			const auto known = (DcType(type) == DcType::Regular)
+				|| (DcType(type) == DcType::MediaCluster);
+			const auto valid = (protocol == Variants::Tcp)
+				|| (protocol == Variants::Http);
+			if (known && valid) {
+				_preferred.push_back({
+					DcId(id),
+					DcType(type),
+					Variants::Protocol(protocol),
+					std::move(ip),
+					port,
+					crl::time(rtt),
+				});
+			}
+		}
+	}
 	return true;
 }
 
@@ -601,6 +671,66 @@ rpl::producer<> DcOptions::cdnConfigChanged() const {
 	return _cdnConfigChanged.events();
 }
 
+rpl::producer<> DcOptions::preferredChanged() const {
+	return _preferredChanged.events();
+}
+
+void DcOptions::setPreferredEndpoint(const PreferredEndpoint &endpoint) {
+	if (_immutable) {
+		return;
+	}
+	WriteLocker lock(this);
+	const auto i = ranges::find_if(_preferred, [&](
+			const PreferredEndpoint &preferred) {
+		return (preferred.id == endpoint.id)
+			&& (preferred.type == endpoint.type);
+	});
+	const auto changed = (i == end(_preferred))
+		|| (i != begin(_preferred))
+		|| (i->protocol != endpoint.protocol)
+		|| (i->ip != endpoint.ip)
+		|| (i->port != endpoint.port);
+	if (i != end(_preferred)) {
+		_preferred.erase(i);
+	}
+	_preferred.insert(begin(_preferred), endpoint);
+	if (_preferred.size() > kMaxPreferredEndpoints) {
+		_preferred.resize(kMaxPreferredEndpoints);
+	}
+	lock.unlock();
+
+	// Don't rewrite the settings if only the measured rtt has changed.
+	if (changed) {
+		_preferredChanged.fire({});
+	}
+}
+
+auto DcOptions::preferredEndpoint(DcId dcId, DcType type) const
+-> std::optional<PreferredEndpoint> {
+	ReadLocker lock(this);
+	const auto i = ranges::find_if(_preferred, [&](
+			const PreferredEndpoint &preferred) {
+		return (preferred.id == dcId) && (preferred.type == type);
+	});
+	if (i == end(_preferred)) {
+		return std::nullopt;
+	}
+	return *i;
+}
+
+std::vector<DcId> DcOptions::recentDcIds(int limit) const {
+	auto result = std::vector<DcId>();
+	ReadLocker lock(this);
+	for (const auto &preferred : _preferred) {
+		if (int(result.size()) >= limit) {
+			break;
+		} else if (!ranges::contains(result, preferred.id)) {
+			result.push_back(preferred.id);
+		}
+	}
+	return result;
+}
+
 std::vector<DcId> DcOptions::configEnumDcIds() const {
 	auto result = std::vector<DcId>();
 	{
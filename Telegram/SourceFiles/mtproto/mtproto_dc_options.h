@@ -106,6 +106,22 @@ public:
 		bool throughProxy) const;
 	[[nodiscard]] DcType dcType(ShiftedDcId shiftedDcId) const;
 
+	// Endpoints that won the connection race, most recently used first.
+	struct PreferredEndpoint {
+		DcId id = 0;
+		DcType type = DcType::Regular;
+		Variants::Protocol protocol = Variants::Tcp;
+		std::string ip;
+		int port = 0;
+		crl::time rtt = 0;
+	};
+	void setPreferredEndpoint(const PreferredEndpoint &endpoint);
+	[[nodiscard]] std::optional<PreferredEndpoint> preferredEndpoint(
+		DcId dcId,
+		DcType type) const;
+	[[nodiscard]] std::vector<DcId> recentDcIds(int limit) const;
+	[[nodiscard]] rpl::producer<> preferredChanged() const;
+
 	void setCDNConfig(const MTPDcdnConfig &config);
 	[[nodiscard]] bool hasCDNKeysForDc(DcId dcId) const;
 	[[nodiscard]] details::RSAPublicKey getDcRSAKey(
@@ -155,10 +171,12 @@ private:
 	base::flat_map<
 		DcId,
 		base::flat_map<uint64, details::RSAPublicKey>> _cdnPublicKeys;
+	std::vector<PreferredEndpoint> _preferred;
 	mutable QReadWriteLock _useThroughLockers;
 
 	rpl::event_stream<DcId> _changed;
 	rpl::event_stream<> _cdnConfigChanged;
+	rpl::event_stream<> _preferredChanged;
 
 	// True when we have overriden options from a .tdesktop-endpoints file.
 	bool _immutable = false;
@@ -10,15 +10,18 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/details/mtproto_bound_key_creator.h"
 #include "mtproto/details/mtproto_dcenter.h"
 #include "mtproto/details/mtproto_dump_to_text.h"
+#include "mtproto/details/mtproto_request_stats.h"
 #include "mtproto/details/mtproto_rsa_public_key.h"
 #include "mtproto/session.h"
 #include "mtproto/mtproto_rpc_sender.h"
 #include "mtproto/mtproto_dc_options.h"
 #include "mtproto/connection_abstract.h"
 #include "platform/platform_specific.h"
+#include "core/crash_reports.h"
 #include "base/openssl_help.h"
 #include "base/qthelp_url.h"
 #include "base/unixtime.h"
+#include "kotato/settings.h"
 #include "zlib.h"
 
 namespace MTP {
@@ -27,6 +30,7 @@ namespace {
 
 constexpr auto kIntSize = static_cast<int>(sizeof(mtpPrime));
 constexpr auto kWaitForBetterTimeout = crl::time(2000);
+constexpr auto kPreferredConnectionPriority = 4;
 constexpr auto kMinConnectedTimeout = crl::time(1000);
 constexpr auto kMaxConnectedTimeout = crl::time(8000);
 constexpr auto kMinReceiveTimeout = crl::time(4000);
@@ -37,6 +41,7 @@ constexpr auto kPingSendAfter = 30 * crl::time(1000);
 constexpr auto kPingSendAfterForce = 45 * crl::time(1000);
 constexpr auto kTemporaryExpiresIn = TimeId(86400);
 constexpr auto kBindKeyAdditionalExpiresTimeout = TimeId(30);
+constexpr auto kRenewTemporaryKeyBefore = TimeId(900);
 constexpr auto kTestModeDcIdShift = 10000;
 constexpr auto kCheckSentRequestsEach = 1 * crl::time(1000);
 constexpr auto kKeyOldEnoughForDestroy = 60 * crl::time(1000);
@@ -59,6 +64,17 @@ constexpr auto kSendStateRequestWaiting = crl::time(1000);
 // How much time to wait for some more requests, when sending msg acks.
 constexpr auto kAckSendWaiting = 10 * crl::time(1000);
 
+// Received packets of that size are decrypted in the worker threads.
+constexpr auto kDecryptInWorkerSize = 64 * 1024;
+
+constexpr auto kExternalHeaderIntsCount = 6U; // 2 auth_key_id, 4 msg_key
+constexpr auto kEncryptedHeaderIntsCount = 8U; // 2 salt, 2 session, 2 msg_id, 1 seq_no, 1 length
+constexpr auto kMinimalEncryptedIntsCount = kEncryptedHeaderIntsCount + 4U; // + 1 data + 3 padding
+constexpr auto kMinimalIntsCount = kExternalHeaderIntsCount + kMinimalEncryptedIntsCount;
+
+// Bulk requests are added to a container only while it is smaller than that.
+constexpr auto kMaxContainerBulkIntsCount = 1024 * 1024 / kIntSize;
+
 auto SyncTimeRequestDuration = kFastRequestDuration;
 
 using namespace details;
@@ -108,6 +124,48 @@ void WrapInvokeAfter(
 	}
 }
 
+[[nodiscard]] std::vector<SerializedRequest> TakeRequestsToSend(
+		base::flat_map<mtpRequestId, SerializedRequest> &toSend) {
+	// A request sent with invokeAfter can't go before the request it waits.
+	auto priorities = base::flat_map<mtpRequestId, RequestPriority>();
+	auto ordered = std::vector<std::pair<RequestPriority, SerializedRequest>>();
+	ordered.reserve(toSend.size());
+	for (const auto &[requestId, request] : toSend) {
+		auto priority = request->priority;
+		if (request->after) {
+			const auto i = priorities.find(request->after->requestId);
+			if (i != end(priorities)) {
+				priority = std::max(priority, i->second);
+			}
+		}
+		if (requestId) {
+			priorities.emplace(requestId, priority);
+		}
+		ordered.emplace_back(priority, request);
+	}
+	std::stable_sort(begin(ordered), end(ordered), [](
+			const auto &a,
+			const auto &b) {
+		return (a.first < b.first);
+	});
+
+	auto result = std::vector<SerializedRequest>();
+	result.reserve(ordered.size());
+	auto size = uint32(0);
+	for (auto &[priority, request] : ordered) {
+		const auto add = request.messageSize();
+		if (priority == RequestPriority::Bulk
+			&& size > 0
+			&& size + add > kMaxContainerBulkIntsCount) {
+			break;
+		}
+		size += add;
+		toSend.remove(request->requestId);
+		result.push_back(std::move(request));
+	}
+	return result;
+}
+
 [[nodiscard]] bool ConstTimeIsDifferent(
 		const void *a,
 		const void *b,
@@ -121,8 +179,123 @@ void WrapInvokeAfter(
 	return different;
 }
 
+void LogDumpDeferred(
+		ShiftedDcId shiftedDcId,
+		const char *prefix,
+		const mtpPrime *from,
+		const mtpPrime *end,
+		QString suffix) {
+	if (!Logs::DebugEnabled() && Logs::started()) {
+		return;
+	}
+
+	// Copy the raw data, the text is rendered by the log writer thread.
+	Logs::writeMtpDeferred(shiftedDcId, [
+			prefix,
+			data = std::vector<mtpPrime>(from, end),
+			suffix = std::move(suffix),
+			filter = cMtpLogFilter()] {
+		auto from = data.data();
+		const auto text = DumpToText(from, from + data.size());
+		const auto matches = filter.isEmpty() || ranges::any_of(
+			filter,
+			[&](const QString &part) { return text.contains(part); });
+		return matches ? (prefix + text + suffix) : QString();
+	});
+}
+
 } // namespace
 
+struct SessionPrivate::ReceivedPacket {
+	enum class Result {
+		Good,
+		BadMessageLength,
+		BadMsgKey,
+		BadPadding,
+	};
+
+	void decrypt(const AuthKeyPtr &key);
+
+	mtpBuffer encrypted;
+	QByteArray decrypted;
+	uint32 messageLength = 0;
+	Result result = Result::Good;
+	std::atomic<bool> ready = { false };
+};
+
+struct SessionPrivate::ReceivedNotifier {
+	QMutex mutex;
+	SessionPrivate *session = nullptr;
+};
+
+void SessionPrivate::ReceivedPacket::decrypt(const AuthKeyPtr &key) {
+	const auto guard = gsl::finally([&] { ready = true; });
+
+	auto ints = encrypted.constData();
+	auto intsCount = uint32(encrypted.size());
+	auto encryptedInts = ints + kExternalHeaderIntsCount;
+	auto encryptedIntsCount = (intsCount - kExternalHeaderIntsCount) & ~0x03U;
+	auto encryptedBytesCount = encryptedIntsCount * kIntSize;
+	decrypted = QByteArray(encryptedBytesCount, Qt::Uninitialized);
+	auto msgKey = *(MTPint128*)(ints + 2);
+
+#ifdef TDESKTOP_MTPROTO_OLD
+	aesIgeDecrypt_oldmtp(encryptedInts, decrypted.data(), encryptedBytesCount, key, msgKey);
+#else // TDESKTOP_MTPROTO_OLD
+	aesIgeDecrypt(encryptedInts, decrypted.data(), encryptedBytesCount, key, msgKey);
+#endif // TDESKTOP_MTPROTO_OLD
+
+	auto decryptedInts = reinterpret_cast<const mtpPrime*>(decrypted.constData());
+	messageLength = *(uint32*)&decryptedInts[7];
+	if (messageLength > kMaxMessageLength) {
+		result = Result::BadMessageLength;
+		return;
+	}
+	auto fullDataLength = kEncryptedHeaderIntsCount * kIntSize + messageLength; // Without padding.
+
+	// Can underflow, but it is an unsigned type, so we just check the range later.
+	auto paddingSize = static_cast<uint32>(encryptedBytesCount) - static_cast<uint32>(fullDataLength);
+
+#ifdef TDESKTOP_MTPROTO_OLD
+	constexpr auto kMinPaddingSize_oldmtp = 0U;
+	constexpr auto kMaxPaddingSize_oldmtp = 15U;
+	auto badMessageLength = (/*paddingSize < kMinPaddingSize_oldmtp || */paddingSize > kMaxPaddingSize_oldmtp);
+
+	auto hashedDataLength = badMessageLength ? encryptedBytesCount : fullDataLength;
+	auto sha1ForMsgKeyCheck = hashSha1(decryptedInts, hashedDataLength);
+
+	constexpr auto kMsgKeyShift_oldmtp = 4U;
+	if (ConstTimeIsDifferent(&msgKey, sha1ForMsgKeyCheck.data() + kMsgKeyShift_oldmtp, sizeof(msgKey))) {
+		result = Result::BadMsgKey;
+		return;
+	}
+#else // TDESKTOP_MTPROTO_OLD
+	constexpr auto kMinPaddingSize = 12U;
+	constexpr auto kMaxPaddingSize = 1024U;
+	auto badMessageLength = (paddingSize < kMinPaddingSize || paddingSize > kMaxPaddingSize);
+
+	std::array<uchar, 32> sha256Buffer = { { 0 } };
+
+	SHA256_CTX msgKeyLargeContext;
+	SHA256_Init(&msgKeyLargeContext);
+	SHA256_Update(&msgKeyLargeContext, key->partForMsgKey(false), 32);
+	SHA256_Update(&msgKeyLargeContext, decryptedInts, encryptedBytesCount);
+	SHA256_Final(sha256Buffer.data(), &msgKeyLargeContext);
+
+	constexpr auto kMsgKeyShift = 8U;
+	if (ConstTimeIsDifferent(&msgKey, sha256Buffer.data() + kMsgKeyShift, sizeof(msgKey))) {
+		result = Result::BadMsgKey;
+		return;
+	}
+#endif // TDESKTOP_MTPROTO_OLD
+
+	if (badMessageLength || (messageLength & 0x03)) {
+		result = Result::BadPadding;
+		return;
+	}
+	result = Result::Good;
+}
+
 SessionPrivate::SessionPrivate(
 	not_null<Instance*> instance,
 	not_null<QThread*> thread,
@@ -155,6 +328,10 @@ SessionPrivate::SessionPrivate(
 }
 
 SessionPrivate::~SessionPrivate() {
+	if (_receivedNotifier) {
+		QMutexLocker lock(&_receivedNotifier->mutex);
+		_receivedNotifier->session = nullptr;
+	}
 	releaseKeyCreationOnFail();
 	doDisconnect();
 
@@ -179,7 +356,10 @@ void SessionPrivate::appendTestConnection(
 			thread(),
 			protocolSecret,
 			_options->proxy),
-		priority
+		priority,
+		protocol,
+		ip,
+		port,
 	});
 	const auto weak = _testConnections.back().data.get();
 	connect(weak, &AbstractConnection::error, [=](int errorCode) {
@@ -682,12 +862,15 @@ void SessionPrivate::tryToSend() {
 	{
 		QWriteLocker locker1(_sessionData->toSendMutex());
 
-		auto toSendDummy = base::flat_map<mtpRequestId, SerializedRequest>();
-		auto &toSend = sendAll
-			? _sessionData->toSendMap()
-			: toSendDummy;
+		// Fill the container highest priority first, so that file parts
+		// transfer doesn't delay the interactive requests on the same dc.
+		auto toSend = sendAll
+			? TakeRequestsToSend(_sessionData->toSendMap())
+			: std::vector<SerializedRequest>();
 		if (!sendAll) {
 			locker1.unlock();
+		} else if (!_sessionData->toSendMap().empty()) {
+			_sessionData->queueSendAnything();
 		}
 
 		uint32 toSendCount = toSend.size();
@@ -714,11 +897,10 @@ void SessionPrivate::tryToSend() {
 			? httpWaitRequest
 			: bindDcKeyRequest
 			? bindDcKeyRequest
-			: toSend.begin()->second;
+			: toSend.front();
 		if (toSendCount == 1 && !first->forceSendInContainer) {
 			toSendRequest = first;
 			if (sendAll) {
-				toSend.clear();
 				locker1.unlock();
 			}
 
@@ -786,7 +968,7 @@ void SessionPrivate::tryToSend() {
 			if (stateRequest) containerSize += stateRequest.messageSize();
 			if (httpWaitRequest) containerSize += httpWaitRequest.messageSize();
 			if (bindDcKeyRequest) containerSize += bindDcKeyRequest.messageSize();
-			for (const auto &[requestId, request] : toSend) {
+			for (const auto &request : toSend) {
 				containerSize += request.messageSize();
 				if (needsLayer && request->needsLayer) {
 					containerSize += initSizeInInts;
@@ -837,7 +1019,7 @@ void SessionPrivate::tryToSend() {
 				needAnyResponse = true;
 			}
 
-			for (auto &[requestId, request] : toSend) {
+			for (auto &request : toSend) {
 				const auto msgId = prepareToSend(
 					request,
 					bigMsgId,
@@ -881,8 +1063,6 @@ void SessionPrivate::tryToSend() {
 					memcpy(toSendRequest->data() + from, request->constData() + 4, len * sizeof(mtpPrime));
 				}
 			}
-			toSend.clear();
-
 			if (stateRequest) {
 				const auto msgId = placeToContainer(
 					toSendRequest,
@@ -1026,6 +1206,7 @@ void SessionPrivate::connectToServer(bool afterConfig) {
 	DEBUG_LOG(("Connection Info: Connecting to %1 with %2 test connections."
 		).arg(_shiftedDcId
 		).arg(_testConnections.size()));
+	applyPreferredConnection();
 
 	if (!_startedConnectingAt) {
 		_startedConnectingAt = crl::now();
@@ -1193,6 +1374,7 @@ void SessionPrivate::connectingTimedOut() {
 }
 
 void SessionPrivate::doDisconnect() {
+	_receivedPackets.clear();
 	destroyAllConnections();
 	setState(DisconnectedState);
 }
@@ -1212,10 +1394,6 @@ void SessionPrivate::handleReceived() {
 		auto intsBuffer = std::move(_connection->received().front());
 		_connection->received().pop_front();
 
-		constexpr auto kExternalHeaderIntsCount = 6U; // 2 auth_key_id, 4 msg_key
-		constexpr auto kEncryptedHeaderIntsCount = 8U; // 2 salt, 2 session, 2 msg_id, 1 seq_no, 1 length
-		constexpr auto kMinimalEncryptedIntsCount = kEncryptedHeaderIntsCount + 4U; // + 1 data + 3 padding
-		constexpr auto kMinimalIntsCount = kExternalHeaderIntsCount + kMinimalEncryptedIntsCount;
 		auto intsCount = uint32(intsBuffer.size());
 		auto ints = intsBuffer.constData();
 		if ((intsCount < kMinimalIntsCount) || (intsCount > kMaxMessageLength / kIntSize)) {
@@ -1231,176 +1409,205 @@ void SessionPrivate::handleReceived() {
 			return restart();
 		}
 
-		auto encryptedInts = ints + kExternalHeaderIntsCount;
-		auto encryptedIntsCount = (intsCount - kExternalHeaderIntsCount) & ~0x03U;
-		auto encryptedBytesCount = encryptedIntsCount * kIntSize;
-		auto decryptedBuffer = QByteArray(encryptedBytesCount, Qt::Uninitialized);
-		auto msgKey = *(MTPint128*)(ints + 2);
-
-#ifdef TDESKTOP_MTPROTO_OLD
-		aesIgeDecrypt_oldmtp(encryptedInts, decryptedBuffer.data(), encryptedBytesCount, _encryptionKey, msgKey);
-#else // TDESKTOP_MTPROTO_OLD
-		aesIgeDecrypt(encryptedInts, decryptedBuffer.data(), encryptedBytesCount, _encryptionKey, msgKey);
-#endif // TDESKTOP_MTPROTO_OLD
+		_instance->requestStats().packetReceived(
+			_shiftedDcId,
+			intsCount * kIntSize);
 
-		auto decryptedInts = reinterpret_cast<const mtpPrime*>(decryptedBuffer.constData());
-		auto serverSalt = *(uint64*)&decryptedInts[0];
-		auto session = *(uint64*)&decryptedInts[2];
-		auto msgId = *(uint64*)&decryptedInts[4];
-		auto seqNo = *(uint32*)&decryptedInts[6];
-		auto needAck = ((seqNo & 0x01) != 0);
-
-		auto messageLength = *(uint32*)&decryptedInts[7];
-		if (messageLength > kMaxMessageLength) {
-			LOG(("TCP Error: bad messageLength %1").arg(messageLength));
-			TCP_LOG(("TCP Error: bad message %1").arg(Logs::mb(ints, intsCount * kIntSize).str()));
+		auto packet = std::make_shared<ReceivedPacket>();
+		packet->encrypted = std::move(intsBuffer);
+		_receivedPackets.push_back(packet);
+		if (intsCount * kIntSize < kDecryptInWorkerSize) {
+			packet->decrypt(_encryptionKey);
+			continue;
+		}
 
-			return restart();
+		// Large packets are decrypted and checked in the worker threads,
+		// the results are handled in the order the packets were received.
+		if (!_receivedNotifier) {
+			_receivedNotifier = std::make_shared<ReceivedNotifier>();
+			_receivedNotifier->session = this;
+		}
+		crl::async([
+			packet,
+			key = _encryptionKey,
+			notifier = _receivedNotifier
+		] {
+			packet->decrypt(key);
+
+			QMutexLocker lock(&notifier->mutex);
+			if (const auto session = notifier->session) {
+				InvokeQueued(session, [=] {
+					session->handleDecrypted();
+				});
+			}
+		});
+	}
+	handleDecrypted();
+}
 
+void SessionPrivate::handleDecrypted() {
+	if (!_encryptionKey) {
+		_receivedPackets.clear();
+		return;
+	}
+	while (!_receivedPackets.empty()
+		&& _receivedPackets.front()->ready.load()) {
+		const auto packet = std::move(_receivedPackets.front());
+		_receivedPackets.pop_front();
+		if (!handleDecryptedPacket(*packet)) {
+			return;
 		}
-		auto fullDataLength = kEncryptedHeaderIntsCount * kIntSize + messageLength; // Without padding.
-
-		// Can underflow, but it is an unsigned type, so we just check the range later.
-		auto paddingSize = static_cast<uint32>(encryptedBytesCount) - static_cast<uint32>(fullDataLength);
+	}
+	if (_receivedPackets.empty()
+		&& _connection
+		&& _connection->needHttpWait()) {
+		_sessionData->queueSendAnything();
+	}
+}
 
-#ifdef TDESKTOP_MTPROTO_OLD
-		constexpr auto kMinPaddingSize_oldmtp = 0U;
-		constexpr auto kMaxPaddingSize_oldmtp = 15U;
-		auto badMessageLength = (/*paddingSize < kMinPaddingSize_oldmtp || */paddingSize > kMaxPaddingSize_oldmtp);
+bool SessionPrivate::handleDecryptedPacket(const ReceivedPacket &packet) {
+	Expects(_encryptionKey != nullptr);
 
-		auto hashedDataLength = badMessageLength ? encryptedBytesCount : fullDataLength;
-		auto sha1ForMsgKeyCheck = hashSha1(decryptedInts, hashedDataLength);
+	const auto encryptedInts = packet.encrypted.constData()
+		+ kExternalHeaderIntsCount;
+	const auto encryptedBytesCount = packet.decrypted.size();
+	switch (packet.result) {
+	case ReceivedPacket::Result::BadMessageLength: {
+		LOG(("TCP Error: bad messageLength %1").arg(packet.messageLength));
+		TCP_LOG(("TCP Error: bad message %1").arg(Logs::mb(packet.encrypted.constData(), packet.encrypted.size() * kIntSize).str()));
 
-		constexpr auto kMsgKeyShift_oldmtp = 4U;
-		if (ConstTimeIsDifferent(&msgKey, sha1ForMsgKeyCheck.data() + kMsgKeyShift_oldmtp, sizeof(msgKey))) {
-			LOG(("TCP Error: bad SHA1 hash after aesDecrypt in message."));
-			TCP_LOG(("TCP Error: bad message %1").arg(Logs::mb(encryptedInts, encryptedBytesCount).str()));
+		restart();
+	} return false;
 
-			return restart();
-		}
+	case ReceivedPacket::Result::BadMsgKey: {
+#ifdef TDESKTOP_MTPROTO_OLD
+		LOG(("TCP Error: bad SHA1 hash after aesDecrypt in message."));
 #else // TDESKTOP_MTPROTO_OLD
-		constexpr auto kMinPaddingSize = 12U;
-		constexpr auto kMaxPaddingSize = 1024U;
-		auto badMessageLength = (paddingSize < kMinPaddingSize || paddingSize > kMaxPaddingSize);
+		LOG(("TCP Error: bad SHA256 hash after aesDecrypt in message"));
+#endif // TDESKTOP_MTPROTO_OLD
+		TCP_LOG(("TCP Error: bad message %1").arg(Logs::mb(encryptedInts, encryptedBytesCount).str()));
 
-		std::array<uchar, 32> sha256Buffer = { { 0 } };
+		restart();
+	} return false;
 
-		SHA256_CTX msgKeyLargeContext;
-		SHA256_Init(&msgKeyLargeContext);
-		SHA256_Update(&msgKeyLargeContext, _encryptionKey->partForMsgKey(false), 32);
-		SHA256_Update(&msgKeyLargeContext, decryptedInts, encryptedBytesCount);
-		SHA256_Final(sha256Buffer.data(), &msgKeyLargeContext);
+	case ReceivedPacket::Result::BadPadding: {
+		LOG(("TCP Error: bad msg_len received %1, data size: %2").arg(packet.messageLength).arg(encryptedBytesCount));
+		TCP_LOG(("TCP Error: bad message %1").arg(Logs::mb(encryptedInts, encryptedBytesCount).str()));
 
-		constexpr auto kMsgKeyShift = 8U;
-		if (ConstTimeIsDifferent(&msgKey, sha256Buffer.data() + kMsgKeyShift, sizeof(msgKey))) {
-			LOG(("TCP Error: bad SHA256 hash after aesDecrypt in message"));
-			TCP_LOG(("TCP Error: bad message %1").arg(Logs::mb(encryptedInts, encryptedBytesCount).str()));
+		restart();
+	} return false;
 
-			return restart();
-		}
-#endif // TDESKTOP_MTPROTO_OLD
+	case ReceivedPacket::Result::Good: break;
 
-		if (badMessageLength || (messageLength & 0x03)) {
-			LOG(("TCP Error: bad msg_len received %1, data size: %2").arg(messageLength).arg(encryptedBytesCount));
-			TCP_LOG(("TCP Error: bad message %1").arg(Logs::mb(encryptedInts, encryptedBytesCount).str()));
+	default: Unexpected("Result in SessionPrivate::handleDecryptedPacket.");
+	}
 
-			return restart();
-		}
+	auto decryptedInts = reinterpret_cast<const mtpPrime*>(packet.decrypted.constData());
+	auto serverSalt = *(uint64*)&decryptedInts[0];
+	auto session = *(uint64*)&decryptedInts[2];
+	auto msgId = *(uint64*)&decryptedInts[4];
+	auto seqNo = *(uint32*)&decryptedInts[6];
+	auto needAck = ((seqNo & 0x01) != 0);
+	auto messageLength = packet.messageLength;
+	auto fullDataLength = kEncryptedHeaderIntsCount * kIntSize + messageLength; // Without padding.
 
-		TCP_LOG(("TCP Info: decrypted message %1,%2,%3 is %4 len").arg(msgId).arg(seqNo).arg(Logs::b(needAck)).arg(fullDataLength));
+	TCP_LOG(("TCP Info: decrypted message %1,%2,%3 is %4 len").arg(msgId).arg(seqNo).arg(Logs::b(needAck)).arg(fullDataLength));
 
-		if (session != _sessionId) {
-			LOG(("MTP Error: bad server session received"));
-			TCP_LOG(("MTP Error: bad server session %1 instead of %2 in message received").arg(session).arg(_sessionId));
+	if (session != _sessionId) {
+		LOG(("MTP Error: bad server session received"));
+		TCP_LOG(("MTP Error: bad server session %1 instead of %2 in message received").arg(session).arg(_sessionId));
 
-			return restart();
-		}
+		restart();
+		return false;
+	}
 
-		const auto serverTime = int32(msgId >> 32);
-		const auto isReply = ((msgId & 0x03) == 1);
-		if (!isReply && ((msgId & 0x03) != 3)) {
-			LOG(("MTP Error: bad msg_id %1 in message received").arg(msgId));
+	const auto serverTime = int32(msgId >> 32);
+	const auto isReply = ((msgId & 0x03) == 1);
+	if (!isReply && ((msgId & 0x03) != 3)) {
+		LOG(("MTP Error: bad msg_id %1 in message received").arg(msgId));
 
-			return restart();
-		}
+		restart();
+		return false;
+	}
 
-		const auto clientTime = base::unixtime::now();
-		const auto badTime = (serverTime > clientTime + 60)
-			|| (serverTime + 300 < clientTime);
-		if (badTime) {
-			DEBUG_LOG(("MTP Info: bad server time from msg_id: %1, my time: %2").arg(serverTime).arg(clientTime));
-		}
+	const auto clientTime = base::unixtime::now();
+	const auto badTime = (serverTime > clientTime + 60)
+		|| (serverTime + 300 < clientTime);
+	if (badTime) {
+		DEBUG_LOG(("MTP Info: bad server time from msg_id: %1, my time: %2").arg(serverTime).arg(clientTime));
+	}
 
-		bool wasConnected = (getState() == ConnectedState);
-		if (serverSalt != _sessionSalt) {
-			if (!badTime) {
-				DEBUG_LOG(("MTP Info: other salt received... received: %1, my salt: %2, updating...").arg(serverSalt).arg(_sessionSalt));
-				_sessionSalt = serverSalt;
+	bool wasConnected = (getState() == ConnectedState);
+	if (serverSalt != _sessionSalt) {
+		if (!badTime) {
+			DEBUG_LOG(("MTP Info: other salt received... received: %1, my salt: %2, updating...").arg(serverSalt).arg(_sessionSalt));
+			_sessionSalt = serverSalt;
 
-				if (setState(ConnectedState, ConnectingState)) {
-					resendAll();
-				}
-			} else {
-				DEBUG_LOG(("MTP Info: other salt received... received: %1, my salt: %2").arg(serverSalt).arg(_sessionSalt));
+			if (setState(ConnectedState, ConnectingState)) {
+				resendAll();
 			}
 		} else {
-			serverSalt = 0; // dont pass to handle method, so not to lock in setSalt()
+			DEBUG_LOG(("MTP Info: other salt received... received: %1, my salt: %2").arg(serverSalt).arg(_sessionSalt));
 		}
+	} else {
+		serverSalt = 0; // dont pass to handle method, so not to lock in setSalt()
+	}
 
-		if (needAck) _ackRequestData.push_back(MTP_long(msgId));
+	if (needAck) _ackRequestData.push_back(MTP_long(msgId));
 
-		auto res = HandleResult::Success; // if no need to handle, then succeed
-		auto from = decryptedInts + kEncryptedHeaderIntsCount;
-		auto end = from + (messageLength / kIntSize);
-		auto sfrom = decryptedInts + 4U; // msg_id + seq_no + length + message
-		MTP_LOG(_shiftedDcId, ("Recv: ")
-			+ DumpToText(sfrom, end)
-			+ QString(" (protocolDcId:%1,key:%2)"
-			).arg(getProtocolDcId()
-			).arg(_encryptionKey->keyId()));
+	auto res = HandleResult::Success; // if no need to handle, then succeed
+	auto from = decryptedInts + kEncryptedHeaderIntsCount;
+	auto end = from + (messageLength / kIntSize);
+	auto sfrom = decryptedInts + 4U; // msg_id + seq_no + length + message
+	LogDumpDeferred(
+		_shiftedDcId,
+		"Recv: ",
+		sfrom,
+		end,
+		QString(" (protocolDcId:%1,key:%2)"
+		).arg(getProtocolDcId()
+		).arg(_encryptionKey->keyId()));
 
-		if (_receivedMessageIds.registerMsgId(msgId, needAck)) {
-			res = handleOneReceived(from, end, msgId, serverTime, serverSalt, badTime);
-		}
-		_receivedMessageIds.shrink();
+	if (_receivedMessageIds.registerMsgId(msgId, needAck)) {
+		res = handleOneReceived(from, end, msgId, serverTime, serverSalt, badTime);
+	}
+	_receivedMessageIds.shrink();
 
-		// send acks
-		if (const auto toAckSize = _ackRequestData.size()) {
-			DEBUG_LOG(("MTP Info: will send %1 acks, ids: %2").arg(toAckSize).arg(LogIdsVector(_ackRequestData)));
-			_sessionData->queueSendAnything(kAckSendWaiting);
-		}
+	// send acks
+	if (const auto toAckSize = _ackRequestData.size()) {
+		DEBUG_LOG(("MTP Info: will send %1 acks, ids: %2").arg(toAckSize).arg(LogIdsVector(_ackRequestData)));
+		_sessionData->queueSendAnything(kAckSendWaiting);
+	}
 
-		auto lock = QReadLocker(_sessionData->haveReceivedMutex());
-		const auto tryToReceive = !_sessionData->haveReceivedResponses().empty()
-			|| !_sessionData->haveReceivedUpdates().empty();
-		lock.unlock();
+	auto lock = QReadLocker(_sessionData->haveReceivedMutex());
+	const auto tryToReceive = !_sessionData->haveReceivedResponses().empty()
+		|| !_sessionData->haveReceivedUpdates().empty();
+	lock.unlock();
 
-		if (tryToReceive) {
-			DEBUG_LOG(("MTP Info: queueTryToReceive() - need to parse in another thread, %1 responses, %2 updates.").arg(_sessionData->haveReceivedResponses().size()).arg(_sessionData->haveReceivedUpdates().size()));
-			_sessionData->queueTryToReceive();
-		}
+	if (tryToReceive) {
+		DEBUG_LOG(("MTP Info: queueTryToReceive() - need to parse in another thread, %1 responses, %2 updates.").arg(_sessionData->haveReceivedResponses().size()).arg(_sessionData->haveReceivedUpdates().size()));
+		_sessionData->queueTryToReceive();
+	}
 
-		if (res != HandleResult::Success && res != HandleResult::Ignored) {
-			if (res == HandleResult::DestroyTemporaryKey) {
-				destroyTemporaryKey();
-			} else if (res == HandleResult::ResetSession) {
-				_needSessionReset = true;
-			}
-			return restart();
+	if (res != HandleResult::Success && res != HandleResult::Ignored) {
+		if (res == HandleResult::DestroyTemporaryKey) {
+			destroyTemporaryKey();
+		} else if (res == HandleResult::ResetSession) {
+			_needSessionReset = true;
 		}
-		_retryTimeout = 1; // reset restart() timer
+		restart();
+		return false;
+	}
+	_retryTimeout = 1; // reset restart() timer
 
-		_startedConnectingAt = crl::time(0);
+	_startedConnectingAt = crl::time(0);
 
-		if (!wasConnected) {
-			if (getState() == ConnectedState) {
-				_sessionData->queueNeedToResumeAndSend();
-			}
+	if (!wasConnected) {
+		if (getState() == ConnectedState) {
+			_sessionData->queueNeedToResumeAndSend();
 		}
 	}
-	if (_connection->needHttpWait()) {
-		_sessionData->queueSendAnything();
-	}
+	return true;
 }
 
 SessionPrivate::HandleResult SessionPrivate::handleOneReceived(
@@ -1781,6 +1988,16 @@ SessionPrivate::HandleResult SessionPrivate::handleOneReceived(
 			response.resize(end - from);
 			memcpy(response.data(), from, (end - from) * sizeof(mtpPrime));
 		}
+		if (const auto sent = findSentRequest(requestMsgId)) {
+			const auto now = crl::now();
+			_instance->requestStats().responseReceived(
+				_shiftedDcId,
+				mtpTypeId((*sent)[SerializedRequest::kMessageBodyPosition]),
+				(sent->queuedTime
+					? (sent->lastSentTime - sent->queuedTime)
+					: crl::time(0)),
+				now - sent->lastSentTime);
+		}
 		if (typeId == mtpc_rpc_error) {
 			if (IsDestroyedTemporaryKeyError(response)) {
 				return HandleResult::DestroyTemporaryKey;
@@ -2256,6 +2473,7 @@ void SessionPrivate::onConnected(
 	} else {
 		DEBUG_LOG(("MTP Info: connection through IPv4 succeed."));
 		_waitForBetterTimer.cancel();
+		rememberPreferredConnection(*i);
 		_connection = std::move(i->data);
 		_testConnections.clear();
 		checkAuthKey();
@@ -2292,12 +2510,62 @@ void SessionPrivate::confirmBestConnection() {
 	DEBUG_LOG(("MTP Info: can't connect through better, using %1."
 		).arg(i->data->tag()));
 
+	rememberPreferredConnection(*i);
 	_connection = std::move(i->data);
 	_testConnections.clear();
 
 	checkAuthKey();
 }
 
+void SessionPrivate::applyPreferredConnection() {
+	// Prefer the endpoint that won the race last time, so that if it is
+	// the first one to connect we don't wait for a better one.
+	if (_options->proxy.type != ProxyData::Type::None
+		|| _testConnections.size() < 2) {
+		return;
+	}
+	const auto preferred = _instance->dcOptions().preferredEndpoint(
+		BareDcId(_shiftedDcId),
+		_currentDcType);
+	if (!preferred) {
+		return;
+	}
+	const auto ip = QString::fromStdString(preferred->ip);
+	QWriteLocker lock(&_stateMutex);
+	for (auto &test : _testConnections) {
+		if (test.protocol == preferred->protocol
+			&& test.port == preferred->port
+			&& test.ip == ip) {
+			DEBUG_LOG(("MTP Info: preferring connection %1, last rtt %2."
+				).arg(test.data->tag()
+				).arg(preferred->rtt));
+			test.priority = kPreferredConnectionPriority;
+			break;
+		}
+	}
+}
+
+void SessionPrivate::rememberPreferredConnection(
+		const TestConnection &connection) {
+	if (_options->proxy.type != ProxyData::Type::None
+		|| connection.ip.isEmpty()
+		|| (_currentDcType != DcType::Regular
+			&& _currentDcType != DcType::MediaCluster)) {
+		return;
+	}
+	const auto endpoint = DcOptions::PreferredEndpoint{
+		BareDcId(_shiftedDcId),
+		_currentDcType,
+		connection.protocol,
+		connection.ip.toStdString(),
+		connection.port,
+		connection.data->pingTime(),
+	};
+	InvokeQueued(_instance, [instance = _instance, endpoint] {
+		instance->dcOptions().setPreferredEndpoint(endpoint);
+	});
+}
+
 void SessionPrivate::removeTestConnection(
 		not_null<AbstractConnection*> connection) {
 	_testConnections.erase(
@@ -2314,8 +2582,7 @@ void SessionPrivate::checkAuthKey() {
 	} else if (_instance->isKeysDestroyer()) {
 		applyAuthKey(_sessionData->getPersistentKey());
 	} else {
-		applyAuthKey(_sessionData->getTemporaryKey(
-			TemporaryKeyTypeByDcType(_currentDcType)));
+		applyAuthKey(temporaryKeyToApply());
 	}
 }
 
@@ -2326,8 +2593,32 @@ void SessionPrivate::updateAuthKey() {
 
 	DEBUG_LOG(("AuthKey Info: Connection updating key from Session, dc %1"
 		).arg(_shiftedDcId));
-	applyAuthKey(_sessionData->getTemporaryKey(
-		TemporaryKeyTypeByDcType(_currentDcType)));
+	applyAuthKey(temporaryKeyToApply());
+}
+
+AuthKeyPtr SessionPrivate::temporaryKeyToApply() {
+	auto key = _sessionData->getTemporaryKey(
+		TemporaryKeyTypeByDcType(_currentDcType));
+	if (key
+		&& key->expiresAt() > 0
+		&& key->expiresAt() - kRenewTemporaryKeyBefore
+			<= base::unixtime::now()) {
+		// Renew the key while connecting, before any request is sent,
+		// instead of waiting for the -404 from the server mid-traffic.
+		LOG(("MTP Info: temporary key in %1 expires soon, renewing."
+			).arg(_shiftedDcId));
+		_sessionData->destroyTemporaryKey(key->keyId());
+
+		// Create the new key on this connection, unless someone else does.
+		const auto dcType = tryAcquireKeyCreation();
+		if (_keyCreator && dcType != _currentDcType) {
+			DEBUG_LOG(("AuthKey Info: "
+				"Dc type changed for creation, restarting."));
+			restart();
+		}
+		return nullptr;
+	}
+	return key;
 }
 
 void SessionPrivate::setCurrentKeyId(uint64 newKeyId) {
@@ -2589,10 +2880,28 @@ bool SessionPrivate::sendSecureRequest(
 	memcpy(request->data() + 0, &_sessionSalt, 2 * sizeof(mtpPrime));
 	memcpy(request->data() + 2, &_sessionId, 2 * sizeof(mtpPrime));
 
+	const auto container = (mtpTypeId((*request)[SerializedRequest::kMessageBodyPosition]) == mtpc_msg_container);
+	CrashReports::SetAnnotationSlot(
+		CrashReports::AnnotationSlot::MtpDcId,
+		uint64(_shiftedDcId));
+	if (!container) {
+		CrashReports::SetAnnotationSlot(
+			CrashReports::AnnotationSlot::MtpRequest,
+			uint64(mtpTypeId((*request)[SerializedRequest::kMessageBodyPosition])));
+	}
+	_instance->requestStats().packetSent(
+		_shiftedDcId,
+		fullSize * sizeof(mtpPrime),
+		container ? (*request)[SerializedRequest::kMessageBodyPosition + 1] : 1,
+		container);
+
 	auto from = request->constData() + 4;
-	MTP_LOG(_shiftedDcId, ("Send: ")
-		+ DumpToText(from, from + messageSize)
-		+ QString(" (protocolDcId:%1,key:%2)"
+	LogDumpDeferred(
+		_shiftedDcId,
+		"Send: ",
+		from,
+		from + messageSize,
+		QString(" (protocolDcId:%1,key:%2)"
 		).arg(getProtocolDcId()
 		).arg(_encryptionKey->keyId()));
 
@@ -2650,6 +2959,13 @@ bool SessionPrivate::sendSecureRequest(
 	return true;
 }
 
+SerializedRequest SessionPrivate::findSentRequest(mtpMsgId msgId) const {
+	QReadLocker locker(_sessionData->haveSentMutex());
+	const auto &haveSent = _sessionData->haveSentMap();
+	const auto i = haveSent.find(msgId);
+	return (i != end(haveSent)) ? i->second : SerializedRequest();
+}
+
 mtpRequestId SessionPrivate::wasSent(mtpMsgId msgId) const {
 	if (msgId == _pingMsgId || msgId == _bindMsgId) {
 		return mtpRequestId(0xFFFFFFFF);
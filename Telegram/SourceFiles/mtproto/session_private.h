@@ -57,11 +57,16 @@ private:
 	struct TestConnection {
 		ConnectionPointer data;
 		int priority = 0;
+		DcOptions::Variants::Protocol protocol = {};
+		QString ip;
+		int port = 0;
 	};
 	struct SentContainer {
 		crl::time sent = 0;
 		std::vector<mtpMsgId> messages;
 	};
+	struct ReceivedPacket;
+	struct ReceivedNotifier;
 	enum class HandleResult {
 		Success,
 		Ignored,
@@ -86,6 +91,7 @@ private:
 	void onReceivedSome();
 
 	void handleReceived();
+	void handleDecrypted();
 
 	void retryByTimer();
 	void waitConnectedFailed();
@@ -97,6 +103,8 @@ private:
 
 	void confirmBestConnection();
 	void removeTestConnection(not_null<AbstractConnection*> connection);
+	void applyPreferredConnection();
+	void rememberPreferredConnection(const TestConnection &connection);
 	[[nodiscard]] int16 getProtocolDcId() const;
 
 	void checkSentRequests();
@@ -119,7 +127,9 @@ private:
 		SerializedRequest &&request,
 		bool needAnyResponse);
 	mtpRequestId wasSent(mtpMsgId msgId) const;
+	[[nodiscard]] SerializedRequest findSentRequest(mtpMsgId msgId) const;
 
+	[[nodiscard]] bool handleDecryptedPacket(const ReceivedPacket &packet);
 	[[nodiscard]] HandleResult handleOneReceived(const mtpPrime *from, const mtpPrime *end, uint64 msgId, int32 serverTime, uint64 serverSalt, bool badTime);
 	[[nodiscard]] HandleResult handleBindResponse(
 		mtpMsgId requestMsgId,
@@ -163,6 +173,7 @@ private:
 	void clearUnboundKeyCreator();
 	void releaseKeyCreationOnFail();
 	void applyAuthKey(AuthKeyPtr &&encryptionKey);
+	[[nodiscard]] AuthKeyPtr temporaryKeyToApply();
 	[[nodiscard]] bool noMediaKeyWithExistingRegularKey() const;
 	bool destroyOldEnoughPersistentKey();
 
@@ -222,6 +233,8 @@ private:
 	QVector<MTPlong> _resendRequestData;
 	base::flat_set<mtpMsgId> _stateRequestData;
 	ReceivedIdsManager _receivedMessageIds;
+	std::deque<std::shared_ptr<ReceivedPacket>> _receivedPackets;
+	std::shared_ptr<ReceivedNotifier> _receivedNotifier;
 	base::flat_map<mtpMsgId, mtpRequestId> _resendingIds;
 	base::flat_map<mtpMsgId, mtpRequestId> _ackedIds;
 	base::flat_map<mtpMsgId, SerializedRequest> _stateAndResendRequests;
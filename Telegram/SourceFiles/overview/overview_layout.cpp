@@ -55,6 +55,29 @@ TextParseOptions _documentNameOptions = {
 	Qt::LayoutDirectionAuto, // dir
 };
 
+// Crops the image to a square of the given size. Blurring is done
+// on the smaller of the original and the result, it costs per pixel.
+[[nodiscard]] QImage PrepareSquare(QImage img, int size, bool blurred) {
+	const auto shrinking = (std::min(img.width(), img.height()) > size);
+	if (blurred && !shrinking) {
+		img = Images::prepareBlur(std::move(img));
+	}
+	if (img.width() == img.height()) {
+		if (img.width() != size) {
+			img = img.scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+		}
+	} else if (img.width() > img.height()) {
+		img = img.copy((img.width() - img.height()) / 2, 0, img.height(), img.height()).scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+	} else {
+		img = img.copy(0, (img.height() - img.width()) / 2, img.width(), img.width()).scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
+	}
+	if (blurred && shrinking) {
+		img = Images::prepareBlur(std::move(img));
+	}
+	img.setDevicePixelRatio(cRetinaFactor());
+	return img;
+}
+
 TextWithEntities ComposeNameWithEntities(DocumentData *document) {
 	TextWithEntities result;
 	const auto song = document->song();
@@ -363,26 +386,14 @@ void Photo::paint(Painter &p, const QRect &clip, TextSelection selection, const
 
 void Photo::setPixFrom(not_null<Image*> image) {
 	const auto size = _width * cIntRetinaFactor();
-	auto img = image->original();
-	if (!_goodLoaded) {
-		img = Images::prepareBlur(std::move(img));
-	}
-	if (img.width() == img.height()) {
-		if (img.width() != size) {
-			img = img.scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-		}
-	} else if (img.width() > img.height()) {
-		img = img.copy((img.width() - img.height()) / 2, 0, img.height(), img.height()).scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-	} else {
-		img = img.copy(0, (img.height() - img.width()) / 2, img.width(), img.width()).scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-	}
-	img.setDevicePixelRatio(cRetinaFactor());
+	auto img = PrepareSquare(image->original(), size, !_goodLoaded);
 
 	// In case we have inline thumbnail we can unload all images and we still
 	// won't get a blank image in the media viewer when the photo is opened.
+	// The item stays registered as heavy, so that the prepared pixmap is
+	// freed as well when the item goes far from the visible area.
 	if (!_data->inlineThumbnailBytes().isEmpty()) {
 		_dataMedia = nullptr;
-		delegate()->unregisterHeavyItem(this);
 	}
 
 	_pix = App::pixmapFromImageInPlace(std::move(img));
@@ -402,6 +413,8 @@ void Photo::ensureDataMediaCreated() const {
 
 void Photo::clearHeavyPart() {
 	_dataMedia = nullptr;
+	_pix = QPixmap();
+	_goodLoaded = false;
 }
 
 TextState Photo::getState(
@@ -460,21 +473,14 @@ void Video::paint(Painter &p, const QRect &clip, TextSelection selection, const
 		&& ((_pix.width() != _width * cIntRetinaFactor())
 			|| (_pixBlurred && (thumbnail || good)))) {
 		auto size = _width * cIntRetinaFactor();
-		auto img = good
-			? good->original()
-			: thumbnail
-			? thumbnail->original()
-			: Images::prepareBlur(blurred->original());
-		if (img.width() == img.height()) {
-			if (img.width() != size) {
-				img = img.scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-			}
-		} else if (img.width() > img.height()) {
-			img = img.copy((img.width() - img.height()) / 2, 0, img.height(), img.height()).scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-		} else {
-			img = img.copy(0, (img.height() - img.width()) / 2, img.width(), img.width()).scaled(size, size, Qt::KeepAspectRatioByExpanding, Qt::SmoothTransformation);
-		}
-		img.setDevicePixelRatio(cRetinaFactor());
+		auto img = PrepareSquare(
+			(good
+				? good->original()
+				: thumbnail
+				? thumbnail->original()
+				: blurred->original()),
+			size,
+			!(thumbnail || good));
 
 		_pix = App::pixmapFromImageInPlace(std::move(img));
 		_pixBlurred = !(thumbnail || good);
@@ -557,6 +563,7 @@ void Video::ensureDataMediaCreated() const {
 
 void Video::clearHeavyPart() {
 	_dataMedia = nullptr;
+	_pix = QPixmap();
 }
 
 float64 Video::dataProgress() const {
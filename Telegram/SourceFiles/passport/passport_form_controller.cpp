@@ -1397,10 +1397,13 @@ void FormController::uploadScan(
 		return std::nullopt;
 	}();
 	auto &scan = nonconst->fileInEdit(type, fileIndex);
-	encryptFile(scan, std::move(content), [=](UploadScanData &&result) {
-		uploadEncryptedFile(
-			nonconst->fileInEdit(type, fileIndex),
-			std::move(result));
+	encryptFile(scan, std::move(content), [=](
+			UploadScanData &&result,
+			QImage &&image) {
+		auto &file = nonconst->fileInEdit(type, fileIndex);
+		file.fields.image = std::move(image);
+		uploadEncryptedFile(file, std::move(result));
+		_scanUpdated.fire(&file);
 	});
 }
 
@@ -1427,7 +1430,6 @@ void FormController::prepareFile(
 	file.fields.dcId = _controller->session().mainDcId();
 	file.fields.secret = GenerateSecretBytes();
 	file.fields.date = base::unixtime::now();
-	file.fields.image = ReadImage(bytes::make_span(content));
 	file.fields.downloadOffset = file.fields.size;
 
 	_scanUpdated.fire(&file);
@@ -1436,7 +1438,7 @@ void FormController::prepareFile(
 void FormController::encryptFile(
 		EditFile &file,
 		QByteArray &&content,
-		Fn<void(UploadScanData &&result)> callback) {
+		Fn<void(UploadScanData &&result, QImage &&image)> callback) {
 	prepareFile(file, content);
 
 	const auto weak = std::weak_ptr<bool>(file.guard);
@@ -1458,9 +1460,13 @@ void FormController::encryptFile(
 			result.bytes.data(),
 			result.bytes.size(),
 			result.md5checksum.data());
-		crl::on_main([=, encrypted = std::move(result)]() mutable {
+		crl::on_main([
+			=,
+			encrypted = std::move(result),
+			image = ReadImage(bytes::make_span(bytes))
+		]() mutable {
 			if (weak.lock()) {
-				callback(std::move(encrypted));
+				callback(std::move(encrypted), std::move(image));
 			}
 		});
 	});
@@ -1769,19 +1775,38 @@ void FormController::loadFile(File &file) {
 }
 
 void FormController::fileLoadDone(FileKey key, const QByteArray &bytes) {
-	if (const auto [value, file] = findFile(key); file != nullptr) {
+	const auto [value, file] = findFile(key);
+	if (!file) {
+		return;
+	}
+	crl::async([
+		=,
+		weak = base::make_weak(this),
+		hash = file->hash,
+		secret = file->secret
+	] {
 		const auto decrypted = DecryptData(
 			bytes::make_span(bytes),
-			file->hash,
-			file->secret);
-		if (decrypted.empty()) {
-			fileLoadFail(key);
-			return;
-		}
+			hash,
+			secret);
+		crl::on_main(weak, [
+			=,
+			failed = decrypted.empty(),
+			image = ReadImage(decrypted)
+		]() mutable {
+			if (failed) {
+				fileLoadFail(key);
+			} else {
+				fileLoadDecrypted(key, std::move(image));
+			}
+		});
+	});
+}
+
+void FormController::fileLoadDecrypted(FileKey key, QImage &&image) {
+	if (const auto [value, file] = findFile(key); file != nullptr) {
 		file->downloadOffset = file->size;
-		file->image = App::readImage(QByteArray::fromRawData(
-			reinterpret_cast<const char*>(decrypted.data()),
-			decrypted.size()));
+		file->image = std::move(image);
 		if (const auto fileInEdit = findEditFile(key)) {
 			fileInEdit->fields.image = file->image;
 			fileInEdit->fields.downloadOffset = file->downloadOffset;
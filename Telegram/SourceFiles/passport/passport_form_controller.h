@@ -463,6 +463,7 @@ private:
 
 	void loadFile(File &file);
 	void fileLoadDone(FileKey key, const QByteArray &bytes);
+	void fileLoadDecrypted(FileKey key, QImage &&image);
 	void fileLoadProgress(FileKey key, int offset);
 	void fileLoadFail(FileKey key);
 	void generateSecret(bytes::const_span password);
@@ -475,7 +476,7 @@ private:
 	void encryptFile(
 		EditFile &file,
 		QByteArray &&content,
-		Fn<void(UploadScanData &&result)> callback);
+		Fn<void(UploadScanData &&result, QImage &&image)> callback);
 	void prepareFile(
 		EditFile &file,
 		const QByteArray &content);
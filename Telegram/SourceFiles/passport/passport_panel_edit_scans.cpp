@@ -39,7 +39,12 @@ constexpr auto kJpegQuality = 89;
 static_assert(kMaxSize <= Storage::kUseBigFilesFrom);
 
 std::variant<ReadScanError, QByteArray> ProcessImage(QByteArray &&bytes) {
-	auto image = App::readImage(base::take(bytes));
+	auto image = App::readImage(
+		base::take(bytes),
+		nullptr,
+		true,
+		nullptr,
+		kMaxDimensions);
 	if (image.isNull()) {
 		return ReadScanError::CantReadImage;
 	} else if (!Ui::ValidateThumbDimensions(image.width(), image.height())) {
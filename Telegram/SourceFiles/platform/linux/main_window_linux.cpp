@@ -63,6 +63,7 @@ constexpr auto kTelegramMutePanelTrayIconName = "telegram-mute-panel"_cs;
 constexpr auto kTelegramAttentionPanelTrayIconName = "telegram-attention-panel"_cs;
 constexpr auto kPropertiesInterface = "org.freedesktop.DBus.Properties"_cs;
 constexpr auto kTrayIconFilename = "ktgdesktop-trayicon-XXXXXX.png"_cs;
+constexpr auto kTrayIconsCacheLimit = 16;
 
 constexpr auto kSNIWatcherService = "org.kde.StatusNotifierWatcher"_cs;
 constexpr auto kSNIWatcherObjectPath = "/StatusNotifierWatcher"_cs;
@@ -80,6 +81,11 @@ QString TrayIconThemeName, TrayIconName;
 int TrayIconCustomId = 0;
 bool TrayIconCounterDisabled = false;
 
+// Generated icons by (icon name, counter slice, muted), valid while
+// the icon theme, the custom icon, the counter setting and colors stay.
+base::flat_map<std::tuple<QString, int, bool>, QIcon> TrayIconsCache;
+std::array<QRgb, 3> TrayIconsCacheColors = { { 0 } };
+
 bool XCBSkipTaskbar(QWindow *window, bool set) {
 	const auto connection = base::Platform::XCB::GetConnectionFromQt();
 	if (!connection) {
@@ -184,6 +190,14 @@ bool UseIconFromTheme(const QString &iconName) {
 		&& !iconName.isEmpty();
 }
 
+std::array<QRgb, 3> TrayCounterColors() {
+	return { {
+		st::trayCounterBg->c.rgba(),
+		st::trayCounterBgMute->c.rgba(),
+		st::trayCounterFg->c.rgba(),
+	} };
+}
+
 bool IsIconRegenerationNeeded(
 		int counter,
 		bool muted,
@@ -225,6 +239,23 @@ QIcon TrayIconGen(int counter, bool muted) {
 	}
 
 	const auto iconName = GetTrayIconName(counter, muted);
+	const auto cacheKey = std::make_tuple(
+		iconName,
+		GetCounterSlice(counter),
+		muted);
+	const auto colors = TrayCounterColors();
+	if (iconThemeName != TrayIconThemeName
+		|| cCustomAppIcon() != TrayIconCustomId
+		|| cDisableTrayCounter() != TrayIconCounterDisabled
+		|| colors != TrayIconsCacheColors) {
+		TrayIconsCache.clear();
+		TrayIconsCacheColors = colors;
+	} else if (const auto i = TrayIconsCache.find(cacheKey)
+		; i != end(TrayIconsCache)) {
+		const auto result = i->second;
+		UpdateIconRegenerationNeeded(result, counter, muted, iconThemeName);
+		return result;
+	}
 
 	if (UseIconFromTheme(iconName)) {
 		const auto result = QIcon::fromTheme(iconName);
@@ -336,6 +367,10 @@ QIcon TrayIconGen(int counter, bool muted) {
 			std::move(iconImage)));
 	}
 
+	if (TrayIconsCache.size() >= kTrayIconsCacheLimit) {
+		TrayIconsCache.clear();
+	}
+	TrayIconsCache.emplace(cacheKey, result);
 	UpdateIconRegenerationNeeded(result, counter, muted, iconThemeName);
 
 	return result;
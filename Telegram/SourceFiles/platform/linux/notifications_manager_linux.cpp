@@ -21,7 +21,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include <QtCore/QVersionNumber>
 #include <QtDBus/QDBusConnection>
 #include <QtDBus/QDBusMessage>
-#include <QtDBus/QDBusReply>
+#include <QtDBus/QDBusPendingReply>
 #include <QtDBus/QDBusError>
 
 extern "C" {
@@ -47,13 +47,27 @@ constexpr auto kNotifyArgsType = "(susssasa{sv}i)"_cs;
 
 bool NotificationsSupported = false;
 bool InhibitedNotSupported = false;
+bool InhibitedRequested = false;
+bool CurrentInhibited = false;
+std::vector<QString> CurrentServerInformation;
+QStringList CurrentCapabilities;
 
-void ComputeSupported(bool wait = false) {
-	const auto message = QDBusMessage::createMethodCall(
+void RequestInhibited() {
+	if (InhibitedRequested || InhibitedNotSupported) {
+		return;
+	}
+	InhibitedRequested = true;
+
+	auto message = QDBusMessage::createMethodCall(
 		kService.utf16(),
 		kObjectPath.utf16(),
-		kInterface.utf16(),
-		qsl("GetServerInformation"));
+		kPropertiesInterface.utf16(),
+		qsl("Get"));
+
+	message.setArguments({
+		qsl("org.freedesktop.Notifications"),
+		qsl("Inhibited")
+	});
 
 	auto async = QDBusConnection::sessionBus().asyncCall(message);
 	auto watcher = new QDBusPendingCallWatcher(async);
@@ -62,127 +76,190 @@ void ComputeSupported(bool wait = false) {
 		watcher,
 		&QDBusPendingCallWatcher::finished,
 		[=](QDBusPendingCallWatcher *call) {
-			QDBusPendingReply<
-				QString,
-				QString,
-				QString,
-				QString> reply = *call;
+			const QDBusPendingReply<QVariant> reply = *call;
+
+			static const auto NotSupportedErrors = {
+				QDBusError::ServiceUnknown,
+				QDBusError::InvalidArgs,
+			};
 
+			InhibitedRequested = false;
 			if (reply.isValid()) {
-				NotificationsSupported = true;
+				CurrentInhibited = reply.value().toBool();
+			} else if (ranges::contains(
+					NotSupportedErrors,
+					reply.error().type())) {
+				InhibitedNotSupported = true;
+			} else {
+				if (reply.error().type() == QDBusError::AccessDenied) {
+					InhibitedNotSupported = true;
+				}
+
+				LOG(("Native notification error: %1")
+					.arg(reply.error().message()));
 			}
 
 			call->deleteLater();
 		});
-
-	if (wait) {
-		watcher->waitForFinished();
-	}
 }
 
-void GetSupported() {
-	static auto Checked = false;
-	if (Checked) {
-		return;
+void InhibitedChanged(
+		GDBusConnection *connection,
+		const gchar *sender_name,
+		const gchar *object_path,
+		const gchar *interface_name,
+		const gchar *signal_name,
+		GVariant *parameters,
+		gpointer user_data) {
+	const gchar *interface = nullptr;
+	GVariant *changed = nullptr;
+	GVariant *invalidated = nullptr;
+	g_variant_get(
+		parameters,
+		"(&s@a{sv}@as)",
+		&interface,
+		&changed,
+		&invalidated);
+
+	if (QString::fromUtf8(interface) == kInterface.utf16()) {
+		auto inhibited = gboolean(false);
+		if (g_variant_lookup(changed, "Inhibited", "b", &inhibited)) {
+			crl::on_main([=] {
+				CurrentInhibited = inhibited;
+			});
+		} else if (g_variant_n_children(invalidated) > 0) {
+			crl::on_main([] {
+				RequestInhibited();
+			});
+		}
 	}
-	Checked = true;
 
-	if (Core::App().settings().nativeNotifications() && !IsWayland()) {
-		ComputeSupported(true);
-	} else {
-		ComputeSupported();
-	}
+	g_variant_unref(changed);
+	g_variant_unref(invalidated);
 }
 
-std::vector<QString> ComputeServerInformation() {
-	std::vector<QString> serverInformation;
-
+not_null<QDBusPendingCallWatcher*> RequestServerInformation() {
 	const auto message = QDBusMessage::createMethodCall(
 		kService.utf16(),
 		kObjectPath.utf16(),
 		kInterface.utf16(),
 		qsl("GetServerInformation"));
 
-	const auto reply = QDBusConnection::sessionBus().call(message);
+	auto async = QDBusConnection::sessionBus().asyncCall(message);
+	auto watcher = new QDBusPendingCallWatcher(async);
+
+	QObject::connect(
+		watcher,
+		&QDBusPendingCallWatcher::finished,
+		[=](QDBusPendingCallWatcher *call) {
+			QDBusPendingReply<
+				QString,
+				QString,
+				QString,
+				QString> reply = *call;
 
-	if (reply.type() == QDBusMessage::ReplyMessage) {
-		ranges::transform(
-			reply.arguments(),
-			ranges::back_inserter(serverInformation),
-			&QVariant::toString
-		);
-	} else if (reply.type() == QDBusMessage::ErrorMessage) {
-		LOG(("Native notification error: %1").arg(reply.errorMessage()));
-	} else {
-		LOG(("Native notification error: "
-			"invalid reply from GetServerInformation"));
-	}
+			if (reply.isValid()) {
+				NotificationsSupported = true;
 
-	return serverInformation;
-}
+				CurrentServerInformation.clear();
+				ranges::transform(
+					reply.reply().arguments(),
+					ranges::back_inserter(CurrentServerInformation),
+					&QVariant::toString
+				);
+
+				LOG(("Notification daemon product name: %1")
+					.arg(reply.argumentAt<0>()));
 
-std::vector<QString> GetServerInformation() {
-	static const auto Result = ComputeServerInformation();
-	return Result;
+				LOG(("Notification daemon vendor name: %1")
+					.arg(reply.argumentAt<1>()));
+
+				LOG(("Notification daemon version: %1")
+					.arg(reply.argumentAt<2>()));
+
+				LOG(("Notification daemon specification version: %1")
+					.arg(reply.argumentAt<3>()));
+			}
+
+			call->deleteLater();
+		});
+
+	return watcher;
 }
 
-QStringList ComputeCapabilities() {
+not_null<QDBusPendingCallWatcher*> RequestCapabilities() {
 	const auto message = QDBusMessage::createMethodCall(
 		kService.utf16(),
 		kObjectPath.utf16(),
 		kInterface.utf16(),
 		qsl("GetCapabilities"));
 
-	const QDBusReply<QStringList> reply = QDBusConnection::sessionBus().call(
-		message);
+	auto async = QDBusConnection::sessionBus().asyncCall(message);
+	auto watcher = new QDBusPendingCallWatcher(async);
 
-	if (reply.isValid()) {
-		return reply.value();
-	} else {
-		LOG(("Native notification error: %1").arg(reply.error().message()));
-	}
+	QObject::connect(
+		watcher,
+		&QDBusPendingCallWatcher::finished,
+		[=](QDBusPendingCallWatcher *call) {
+			const QDBusPendingReply<QStringList> reply = *call;
 
-	return {};
-}
+			if (reply.isValid()) {
+				CurrentCapabilities = reply.value();
 
-QStringList GetCapabilities() {
-	static const auto Result = ComputeCapabilities();
-	return Result;
-}
+				LOG(("Notification daemon capabilities: %1")
+					.arg(CurrentCapabilities.join(", ")));
 
-bool Inhibited() {
-	auto message = QDBusMessage::createMethodCall(
-		kService.utf16(),
-		kObjectPath.utf16(),
-		kPropertiesInterface.utf16(),
-		qsl("Get"));
+				if (CurrentCapabilities.contains(qsl("inhibitions"))) {
+					RequestInhibited();
+				}
+			} else {
+				LOG(("Native notification error: %1")
+					.arg(reply.error().message()));
+			}
 
-	message.setArguments({
-		qsl("org.freedesktop.Notifications"),
-		qsl("Inhibited")
-	});
+			call->deleteLater();
+		});
 
-	const QDBusReply<QVariant> reply = QDBusConnection::sessionBus().call(
-		message);
+	return watcher;
+}
 
-	static const auto NotSupportedErrors = {
-		QDBusError::ServiceUnknown,
-		QDBusError::InvalidArgs,
-	};
+void ComputeSupported(bool wait = false) {
+	// Both requests are sent at once, so even when we have to wait
+	// for the answers at startup it takes a single round trip.
+	const auto serverInformation = RequestServerInformation();
+	const auto capabilities = RequestCapabilities();
+	if (wait) {
+		serverInformation->waitForFinished();
+		capabilities->waitForFinished();
+	}
+}
 
-	if (reply.isValid()) {
-		return reply.value().toBool();
-	} else if (ranges::contains(NotSupportedErrors, reply.error().type())) {
-		InhibitedNotSupported = true;
-	} else {
-		if (reply.error().type() == QDBusError::AccessDenied) {
-			InhibitedNotSupported = true;
-		}
+void GetSupported() {
+	static auto Checked = false;
+	if (Checked) {
+		return;
+	}
+	Checked = true;
 
-		LOG(("Native notification error: %1").arg(reply.error().message()));
+	if (Core::App().settings().nativeNotifications() && !IsWayland()) {
+		ComputeSupported(true);
+	} else {
+		ComputeSupported();
 	}
+}
 
-	return false;
+const std::vector<QString> &GetServerInformation() {
+	return CurrentServerInformation;
+}
+
+const QStringList &GetCapabilities() {
+	return CurrentCapabilities;
+}
+
+bool Inhibited() {
+	// The value is requested once the capabilities are known and is
+	// tracked through PropertiesChanged, see Manager::Private.
+	return CurrentInhibited;
 }
 
 QVersionNumber ParseSpecificationVersion(
@@ -215,7 +292,8 @@ QString GetImageKey(const QVersionNumber &specificationVersion) {
 	return QString();
 }
 
-class NotificationData {
+class NotificationData
+	: public std::enable_shared_from_this<NotificationData> {
 public:
 	using NotificationId = Window::Notifications::Manager::NotificationId;
 
@@ -234,7 +312,7 @@ public:
 
 	~NotificationData();
 
-	bool show();
+	void show();
 	void close();
 	void setImage(const QString &imagePath);
 
@@ -250,11 +328,13 @@ private:
 	QImage _image;
 
 	uint _notificationId = 0;
+	bool _closeRequested = false;
 	guint _actionInvokedSignalId = 0;
 	guint _notificationRepliedSignalId = 0;
 	guint _notificationClosedSignalId = 0;
 	NotificationId _id;
 
+	void notificationShown(GVariant *reply, GError *error);
 	void notificationClosed(uint id, uint reason);
 	void actionInvoked(uint id, const QString &actionName);
 	void notificationReplied(uint id, const QString &text);
@@ -268,6 +348,11 @@ private:
 		GVariant *parameters,
 		gpointer user_data);
 
+	static void notifyFinished(
+		GObject *source_object,
+		GAsyncResult *result,
+		gpointer user_data);
+
 };
 
 using Notification = std::shared_ptr<NotificationData>;
@@ -428,9 +513,8 @@ NotificationData::~NotificationData() {
 	}
 }
 
-bool NotificationData::show() {
+void NotificationData::show() {
 	GVariantBuilder actionsBuilder, hintsBuilder;
-	GError *error = nullptr;
 
 	g_variant_builder_init(&actionsBuilder, G_VARIANT_TYPE("as"));
 	for (const auto &value : _actions) {
@@ -455,7 +539,9 @@ bool NotificationData::show() {
 		? GetIconName()
 		: QString();
 
-	auto reply = g_dbus_connection_call_sync(
+	// The reply is handled in notifyFinished, the strong reference
+	// keeps the data alive until then even if it was closed already.
+	g_dbus_connection_call(
 		_dbusConnection,
 		kService.utf8(),
 		kObjectPath.utf8(),
@@ -471,26 +557,56 @@ bool NotificationData::show() {
 			&actionsBuilder,
 			&hintsBuilder,
 			-1),
-		nullptr,
+		G_VARIANT_TYPE("(u)"),
 		G_DBUS_CALL_FLAGS_NONE,
 		kDBusTimeout,
 		nullptr,
+		notifyFinished,
+		new Notification(shared_from_this()));
+}
+
+void NotificationData::notifyFinished(
+		GObject *source_object,
+		GAsyncResult *result,
+		gpointer user_data) {
+	const auto notification = std::unique_ptr<Notification>(
+		static_cast<Notification*>(user_data));
+
+	GError *error = nullptr;
+	const auto reply = g_dbus_connection_call_finish(
+		G_DBUS_CONNECTION(source_object),
+		result,
 		&error);
 
-	const auto replyValid = !error;
+	(*notification)->notificationShown(reply, error);
+}
 
-	if (replyValid) {
-		g_variant_get(reply, "(u)", &_notificationId);
-		g_variant_unref(reply);
-	} else {
+void NotificationData::notificationShown(GVariant *reply, GError *error) {
+	if (error) {
 		LOG(("Native notification error: %1").arg(error->message));
 		g_error_free(error);
+
+		const auto manager = _manager;
+		const auto my = _id;
+		crl::on_main(manager, [=] {
+			manager->clearNotification(my);
+		});
+		return;
 	}
 
-	return replyValid;
+	g_variant_get(reply, "(u)", &_notificationId);
+	g_variant_unref(reply);
+
+	if (_closeRequested) {
+		close();
+	}
 }
 
 void NotificationData::close() {
+	if (!_notificationId) {
+		_closeRequested = true;
+		return;
+	}
 	g_dbus_connection_call(
 		_dbusConnection,
 		kService.utf8(),
@@ -708,36 +824,38 @@ private:
 
 	Window::Notifications::CachedUserpics _cachedUserpics;
 	base::weak_ptr<Manager> _manager;
+
+	GDBusConnection *_dbusConnection = nullptr;
+	guint _inhibitedSignalId = 0;
 };
 
 Manager::Private::Private(not_null<Manager*> manager, Type type)
 : _cachedUserpics(type)
 , _manager(manager) {
-	if (!Supported()) {
-		return;
-	}
-
-	const auto serverInformation = GetServerInformation();
-	const auto capabilities = GetCapabilities();
-
-	if (!serverInformation.empty()) {
-		LOG(("Notification daemon product name: %1")
-			.arg(serverInformation[0]));
-
-		LOG(("Notification daemon vendor name: %1")
-			.arg(serverInformation[1]));
+	GError *error = nullptr;
 
-		LOG(("Notification daemon version: %1")
-			.arg(serverInformation[2]));
+	_dbusConnection = g_bus_get_sync(
+		G_BUS_TYPE_SESSION,
+		nullptr,
+		&error);
 
-		LOG(("Notification daemon specification version: %1")
-			.arg(serverInformation[3]));
+	if (error) {
+		LOG(("Native notification error: %1").arg(error->message));
+		g_error_free(error);
+		return;
 	}
 
-	if (!capabilities.isEmpty()) {
-		LOG(("Notification daemon capabilities: %1")
-			.arg(capabilities.join(", ")));
-	}
+	_inhibitedSignalId = g_dbus_connection_signal_subscribe(
+		_dbusConnection,
+		kService.utf8(),
+		kPropertiesInterface.utf8(),
+		"PropertiesChanged",
+		kObjectPath.utf8(),
+		kInterface.utf8(),
+		G_DBUS_SIGNAL_FLAGS_NONE,
+		InhibitedChanged,
+		nullptr,
+		nullptr);
 }
 
 void Manager::Private::showNotification(
@@ -787,15 +905,7 @@ void Manager::Private::showNotification(
 			base::flat_map<MsgId, Notification>()).first;
 	}
 	i->second.emplace(msgId, notification);
-	if (!notification->show()) {
-		i = _notifications.find(key);
-		if (i != _notifications.cend()) {
-			i->second.remove(msgId);
-			if (i->second.empty()) {
-				_notifications.erase(i);
-			}
-		}
-	}
+	notification->show();
 }
 
 void Manager::Private::clearAll() {
@@ -865,6 +975,16 @@ void Manager::Private::clearNotification(NotificationId id) {
 
 Manager::Private::~Private() {
 	clearAll();
+
+	if (_dbusConnection) {
+		if (_inhibitedSignalId != 0) {
+			g_dbus_connection_signal_unsubscribe(
+				_dbusConnection,
+				_inhibitedSignalId);
+		}
+
+		g_object_unref(_dbusConnection);
+	}
 }
 #endif // !DESKTOP_APP_DISABLE_DBUS_INTEGRATION
 
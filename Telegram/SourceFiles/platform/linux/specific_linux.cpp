@@ -790,6 +790,12 @@ std::optional<bool> IsDarkMode() {
 	return std::nullopt;
 }
 
+int64 PhysicalMemorySize() {
+	const auto pages = sysconf(_SC_PHYS_PAGES);
+	const auto pageSize = sysconf(_SC_PAGESIZE);
+	return (pages > 0 && pageSize > 0) ? (int64(pages) * pageSize) : 0;
+}
+
 bool AutostartSupported() {
 	// snap sandbox doesn't allow creating files
 	// in folders with names started with a dot
@@ -122,6 +122,10 @@ std::optional<bool> IsDarkMode() {
 		: std::nullopt;
 }
 
+int64 PhysicalMemorySize() {
+	return int64([[NSProcessInfo processInfo] physicalMemory]);
+}
+
 void RegisterCustomScheme(bool force) {
 	OSStatus result = LSSetDefaultHandlerForURLScheme(CFSTR("tg"), (CFStringRef)[[NSBundle mainBundle] bundleIdentifier]);
 	DEBUG_LOG(("App Info: set default handler for 'tg' scheme result: %1").arg(result));
@@ -50,6 +50,9 @@ bool SetWindowExtents(QWindow *window, const QMargins &extents);
 bool UnsetWindowExtents(QWindow *window);
 Window::ControlsLayout WindowControlsLayout();
 
+// Returns 0 if the installed memory size is unknown.
+[[nodiscard]] int64 PhysicalMemorySize();
+
 [[nodiscard]] std::optional<bool> IsDarkMode();
 [[nodiscard]] inline bool IsDarkModeSupported() {
 	return IsDarkMode().has_value();
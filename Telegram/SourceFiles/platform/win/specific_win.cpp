@@ -312,6 +312,12 @@ bool AutostartSupported() {
 	return !IsWindowsStoreBuild();
 }
 
+int64 PhysicalMemorySize() {
+	auto status = MEMORYSTATUSEX();
+	status.dwLength = sizeof(status);
+	return GlobalMemoryStatusEx(&status) ? int64(status.ullTotalPhys) : 0;
+}
+
 bool ShowWindowMenu(QWindow *window) {
 	const auto pos = QCursor::pos();
 
@@ -67,14 +67,18 @@ FileKey GenerateKey(const QString &basePath) {
 }
 
 void ClearKey(const FileKey &key, const QString &basePath) {
-	QString name;
-	name.reserve(basePath.size() + 0x11);
-	name.append(basePath).append(ToFilePart(key)).append('0');
-	QFile::remove(name);
-	name[name.size() - 1] = '1';
-	QFile::remove(name);
-	name[name.size() - 1] = 's';
-	QFile::remove(name);
+	ClearFile(ToFilePart(key), basePath);
+}
+
+void ClearFile(const QString &name, const QString &basePath) {
+	auto path = QString();
+	path.reserve(basePath.size() + name.size() + 1);
+	path.append(basePath).append(name).append('0');
+	QFile::remove(path);
+	path[path.size() - 1] = '1';
+	QFile::remove(path);
+	path[path.size() - 1] = 's';
+	QFile::remove(path);
 }
 
 bool CheckStreamStatus(QDataStream &stream) {
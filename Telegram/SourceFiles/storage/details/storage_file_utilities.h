@@ -18,6 +18,7 @@ namespace details {
 [[nodiscard]] bool KeyAlreadyUsed(QString &name);
 [[nodiscard]] FileKey GenerateKey(const QString &basePath);
 void ClearKey(const FileKey &key, const QString &basePath);
+void ClearFile(const QString &name, const QString &basePath);
 
 [[nodiscard]] bool CheckStreamStatus(QDataStream &stream);
 [[nodiscard]] MTP::AuthKeyPtr CreateLocalKey(
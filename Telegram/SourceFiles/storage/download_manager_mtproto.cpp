@@ -12,12 +12,14 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/mtproto_rpc_sender.h"
 #include "main/main_session.h"
 #include "apiwrap.h"
+#include "storage/cache/storage_cache_types.h"
 #include "base/openssl_help.h"
 
 namespace Storage {
 namespace {
 
 constexpr auto kKillSessionTimeout = 15 * crl::time(1000);
+constexpr auto kKillWarmSessionTimeout = 60 * crl::time(1000);
 constexpr auto kStartWaitedInSession = 4 * kDownloadPartSize;
 constexpr auto kMaxWaitedInSession = 16 * kDownloadPartSize;
 constexpr auto kStartSessionsCount = 1;
@@ -31,6 +33,14 @@ constexpr auto kRemoveSessionAfterTimeouts = 4;
 constexpr auto kResetDownloadPrioritiesTimeout = crl::time(200);
 constexpr auto kBadRequestDurationThreshold = 8 * crl::time(1000);
 
+// Adaptive mode keeps about two bandwidth-delay products in flight
+// and chooses part size so that each part takes ~kTargetPartDuration.
+constexpr auto kMaxWaitedInSessionAdaptive = 64 * kDownloadPartSize;
+constexpr auto kBandwidthMeasurePeriod = crl::time(1000);
+constexpr auto kRttLifetime = 10 * crl::time(1000);
+constexpr auto kWindowGain = 2;
+constexpr auto kTargetPartDuration = crl::time(250);
+
 // Each (session remove by timeouts) we wait for time:
 // kRetryAddSessionTimeout * max(removesCount, kMaxTrackedSessionRemoves)
 // and for successes in all remaining sessions:
@@ -150,6 +160,14 @@ void DownloadManagerMtproto::remove(not_null<Task*> task) {
 	checkSendNext(dcId, queue);
 }
 
+void DownloadManagerMtproto::setPrefetching(bool prefetching) {
+	_prefetching = prefetching;
+}
+
+bool DownloadManagerMtproto::prefetching() const {
+	return _prefetching;
+}
+
 void DownloadManagerMtproto::resetGeneration() {
 	_resetGenerationTimer.cancel();
 	for (auto &[dcId, queue] : _queues) {
@@ -178,7 +196,7 @@ bool DownloadManagerMtproto::trySendNextPart(MTP::DcId dcId, Queue &queue) {
 		const auto proj = [](const DcSessionBalanceData &data) {
 			return (data.requested < data.maxWaitedAmount)
 				? data.requested
-				: kMaxWaitedInSession;
+				: std::numeric_limits<int>::max();
 		};
 		const auto j = ranges::min_element(sessions, ranges::less(), proj);
 		return (j->requested + kDownloadPartSize <= j->maxWaitedAmount)
@@ -215,6 +233,9 @@ int DownloadManagerMtproto::changeRequestedAmount(
 	if (delta > 0) {
 		killSessionsCancel(dcId);
 	} else if (findNonEmptySession(i->second) == end(i->second.sessions)) {
+		// Don't count idle time in the throughput measurement.
+		i->second.measureStart = 0;
+		i->second.measuredBytes = 0;
 		killSessionsSchedule(dcId);
 	}
 	return result;
@@ -224,7 +245,8 @@ void DownloadManagerMtproto::requestSucceeded(
 		MTP::DcId dcId,
 		int index,
 		int amountAtRequestStart,
-		crl::time timeAtRequestStart) {
+		crl::time timeAtRequestStart,
+		int size) {
 	using namespace rpl::mappers;
 
 	const auto guard = gsl::finally([&] {
@@ -240,6 +262,7 @@ void DownloadManagerMtproto::requestSucceeded(
 		|| (amountAtRequestStart > data.maxWaitedAmount);
 	const auto parts = amountAtRequestStart / kDownloadPartSize;
 	const auto duration = (crl::now() - timeAtRequestStart);
+	updateBandwidth(dc, size, duration);
 	DEBUG_LOG(("Download (%1,%2) request done, duration: %3, parts: %4%5"
 		).arg(dcId
 		).arg(index
@@ -257,7 +280,9 @@ void DownloadManagerMtproto::requestSucceeded(
 		});
 		return;
 	}
-	if (amountAtRequestStart == data.maxWaitedAmount
+	if (adaptive()) {
+		applyBandwidth(dcId, dc);
+	} else if (amountAtRequestStart == data.maxWaitedAmount
 		&& data.maxWaitedAmount < kMaxWaitedInSession) {
 		data.maxWaitedAmount = std::min(
 			data.maxWaitedAmount + kDownloadPartSize,
@@ -307,6 +332,159 @@ int DownloadManagerMtproto::chooseSessionIndex(MTP::DcId dcId) const {
 	return (j - begin(sessions));
 }
 
+bool DownloadManagerMtproto::adaptive() const {
+	return cNetAdaptiveDownload();
+}
+
+DownloadBandwidth DownloadManagerMtproto::bandwidth(MTP::DcId dcId) const {
+	const auto i = _balanceData.find(dcId);
+	if (i == end(_balanceData)) {
+		return DownloadBandwidth();
+	}
+	auto result = i->second.bandwidth;
+	if (!adaptive()) {
+		result.partSize = kDownloadPartSize;
+	}
+	return result;
+}
+
+void DownloadManagerMtproto::updateBandwidth(
+		DcBalanceData &dc,
+		int size,
+		crl::time duration) {
+	const auto now = crl::now();
+	auto &bandwidth = dc.bandwidth;
+	if (!bandwidth.rtt
+		|| duration < bandwidth.rtt
+		|| now - dc.rttMeasured >= kRttLifetime) {
+		bandwidth.rtt = std::max(duration, crl::time(1));
+		dc.rttMeasured = now;
+	}
+	if (!dc.measureStart) {
+		dc.measureStart = now - duration;
+	}
+	dc.measuredBytes += size;
+	const auto elapsed = now - dc.measureStart;
+	if (elapsed < kBandwidthMeasurePeriod) {
+		return;
+	}
+	const auto current = dc.measuredBytes * 1000 / elapsed;
+	bandwidth.bytesPerSecond = bandwidth.bytesPerSecond
+		? (bandwidth.bytesPerSecond * 3 + current) / 4
+		: current;
+	dc.measureStart = now;
+	dc.measuredBytes = 0;
+
+	const auto product = bandwidth.bytesPerSecond * bandwidth.rtt / 1000;
+	bandwidth.window = int(std::clamp(
+		product * kWindowGain,
+		int64(kStartWaitedInSession),
+		int64(kMaxWaitedInSessionAdaptive) * kMaxSessionsCount));
+
+	const auto target = bandwidth.bytesPerSecond * kTargetPartDuration / 1000;
+	bandwidth.partSize = kDownloadPartSize;
+	while (bandwidth.partSize < kMaxDownloadPartSize
+		&& bandwidth.partSize * 2 <= target) {
+		bandwidth.partSize *= 2;
+	}
+}
+
+void DownloadManagerMtproto::applyBandwidth(
+		MTP::DcId dcId,
+		DcBalanceData &dc) {
+	if (!dc.bandwidth.window) {
+		return;
+	}
+	const auto count = int(dc.sessions.size());
+	const auto perSession = std::clamp(
+		(dc.bandwidth.window / count / kDownloadPartSize) * kDownloadPartSize,
+		kStartWaitedInSession,
+		kMaxWaitedInSessionAdaptive);
+	for (auto &session : dc.sessions) {
+		// Grow slowly, like in the legacy mode, but shrink at once.
+		session.maxWaitedAmount = (session.maxWaitedAmount < perSession)
+			? std::min(
+				session.maxWaitedAmount + dc.bandwidth.partSize,
+				perSession)
+			: perSession;
+	}
+	DEBUG_LOG(("Download (%1) bandwidth: %2 B/s, rtt: %3, window: %4, "
+		"part: %5"
+		).arg(dcId
+		).arg(dc.bandwidth.bytesPerSecond
+		).arg(dc.bandwidth.rtt
+		).arg(dc.bandwidth.window
+		).arg(dc.bandwidth.partSize));
+}
+
+bool DownloadManagerMtproto::subscribeToSharedPart(
+		not_null<Task*> task,
+		const SharedPartKey &key,
+		int size) {
+	const auto i = _sharedParts.find(key);
+	if (i == end(_sharedParts)
+		|| i->second.owner == task
+		|| i->second.size != size) {
+		return false;
+	}
+	i->second.waiters.push_back(base::make_weak(task.get()));
+	return true;
+}
+
+bool DownloadManagerMtproto::registerSharedPart(
+		not_null<Task*> task,
+		const SharedPartKey &key,
+		int size) {
+	return _sharedParts.emplace(key, SharedPart{ task, size }).second;
+}
+
+void DownloadManagerMtproto::unsubscribeFromSharedPart(
+		not_null<Task*> task,
+		const SharedPartKey &key) {
+	const auto i = _sharedParts.find(key);
+	if (i == end(_sharedParts)) {
+		return;
+	}
+	auto &waiters = i->second.waiters;
+	waiters.erase(ranges::remove_if(waiters, [&](const auto &weak) {
+		return (weak.get() == task);
+	}), end(waiters));
+}
+
+auto DownloadManagerMtproto::takeSharedPartWaiters(
+	not_null<Task*> owner,
+	const SharedPartKey &key)
+-> std::vector<base::weak_ptr<Task>> {
+	const auto i = _sharedParts.find(key);
+	if (i == end(_sharedParts) || i->second.owner != owner) {
+		return {};
+	}
+	auto result = std::move(i->second.waiters);
+	_sharedParts.erase(i);
+	return result;
+}
+
+void DownloadManagerMtproto::sharedPartLoaded(
+		not_null<Task*> owner,
+		const SharedPartKey &key,
+		const QByteArray &bytes) {
+	for (const auto &weak : takeSharedPartWaiters(owner, key)) {
+		if (const auto strong = weak.get()) {
+			strong->sharedPartLoaded(key.offset, bytes);
+		}
+	}
+}
+
+void DownloadManagerMtproto::sharedPartFailed(
+		not_null<Task*> owner,
+		const SharedPartKey &key) {
+	for (const auto &weak : takeSharedPartWaiters(owner, key)) {
+		if (const auto strong = weak.get()) {
+			strong->sharedPartFailed(key.offset);
+		}
+	}
+}
+
 void DownloadManagerMtproto::sessionTimedOut(MTP::DcId dcId, int index) {
 	const auto i = _balanceData.find(dcId);
 	if (i == end(_balanceData)) {
@@ -368,6 +546,9 @@ void DownloadManagerMtproto::killSessionsSchedule(MTP::DcId dcId) {
 }
 
 void DownloadManagerMtproto::killSessionsCancel(MTP::DcId dcId) {
+	if (const auto i = _balanceData.find(dcId); i != end(_balanceData)) {
+		i->second.warmAfterIdle = false;
+	}
 	_killSessionsWhen.erase(dcId);
 	if (_killSessionsWhen.empty()) {
 		_killSessionsTimer.cancel();
@@ -379,8 +560,12 @@ void DownloadManagerMtproto::killSessions() {
 	auto left = kKillSessionTimeout;
 	for (auto i = begin(_killSessionsWhen); i != end(_killSessionsWhen); ) {
 		if (i->second <= now) {
-			killSessions(i->first);
-			i = _killSessionsWhen.erase(i);
+			if (killSessions(i->first)) {
+				i->second = now + kKillWarmSessionTimeout;
+				++i;
+			} else {
+				i = _killSessionsWhen.erase(i);
+			}
 		} else {
 			if (i->second - now < left) {
 				left = i->second - now;
@@ -393,20 +578,30 @@ void DownloadManagerMtproto::killSessions() {
 	}
 }
 
-void DownloadManagerMtproto::killSessions(MTP::DcId dcId) {
+bool DownloadManagerMtproto::killSessions(MTP::DcId dcId) {
 	const auto i = _balanceData.find(dcId);
-	if (i != end(_balanceData)) {
-		auto &dc = i->second;
-		Assert(dc.totalRequested == 0);
-		auto sessions = base::take(dc.sessions);
-		dc = DcBalanceData();
-		for (auto j = 0; j != int(sessions.size()); ++j) {
-			Assert(sessions[j].requested == 0);
-			sessions[j] = DcSessionBalanceData();
+	if (i == end(_balanceData)) {
+		return false;
+	}
+	auto &dc = i->second;
+	Assert(dc.totalRequested == 0);
+
+	// Stop the extra connections first and keep the first one warm
+	// for a while, so that the next burst of loads doesn't have to
+	// wait for a new socket and transport handshake.
+	const auto keepWarm = !dc.warmAfterIdle;
+	auto sessions = base::take(dc.sessions);
+	dc = DcBalanceData();
+	for (auto j = 0; j != int(sessions.size()); ++j) {
+		Assert(sessions[j].requested == 0);
+		sessions[j] = DcSessionBalanceData();
+		if (!keepWarm || j > 0) {
 			api().instance().stopSession(MTP::downloadDcId(dcId, j));
 		}
-		dc.sessions = base::take(sessions);
 	}
+	dc.sessions = base::take(sessions);
+	dc.warmAfterIdle = keepWarm;
+	return keepWarm;
 }
 
 DownloadMtprotoTask::DownloadMtprotoTask(
@@ -416,7 +611,8 @@ DownloadMtprotoTask::DownloadMtprotoTask(
 : _owner(owner)
 , _dcId(location.dcId())
 , _location({ location })
-, _origin(origin) {
+, _origin(origin)
+, _prefetch(owner->prefetching()) {
 }
 
 DownloadMtprotoTask::DownloadMtprotoTask(
@@ -425,7 +621,8 @@ DownloadMtprotoTask::DownloadMtprotoTask(
 	const Location &location)
 : _owner(owner)
 , _dcId(dcId)
-, _location(location) {
+, _location(location)
+, _prefetch(owner->prefetching()) {
 }
 
 DownloadMtprotoTask::~DownloadMtprotoTask() {
@@ -474,19 +671,45 @@ void DownloadMtprotoTask::refreshFileReferenceFrom(
 }
 
 void DownloadMtprotoTask::loadPart(int sessionIndex) {
-	makeRequest({ takeNextRequestOffset(), sessionIndex });
+	// takeNextRequestOffset() advances by partSizeAt() of the same offset.
+	const auto offset = takeNextRequestOffset();
+	makeRequest({ offset, sessionIndex, partSizeAt(offset) });
+}
+
+void DownloadMtprotoTask::sharedPartLoaded(
+		int offset,
+		const QByteArray &bytes) {
+	if (_sharedWaits.remove(offset)) {
+		feedPart(offset, bytes);
+	}
+}
+
+void DownloadMtprotoTask::sharedPartFailed(int offset) {
+	const auto i = _sharedWaits.find(offset);
+	if (i == end(_sharedWaits)) {
+		return;
+	}
+	auto requestData = i->second;
+	_sharedWaits.erase(i);
+	requestData.sessionIndex = _owner->chooseSessionIndex(dcId());
+	makeRequest(requestData);
 }
 
 void DownloadMtprotoTask::removeSession(int sessionIndex) {
 	struct Redirect {
 		mtpRequestId requestId = 0;
 		int offset = 0;
+		int size = 0;
 	};
 	auto redirect = std::vector<Redirect>();
 	for (const auto &[requestId, requestData] : _sentRequests) {
 		if (requestData.sessionIndex == sessionIndex) {
 			redirect.reserve(_sentRequests.size());
-			redirect.push_back({ requestId, requestData.offset });
+			redirect.push_back({
+				requestId,
+				requestData.offset,
+				requestData.size,
+			});
 		}
 	}
 	for (auto &[requestData, bytes] : _cdnUncheckedParts) {
@@ -496,21 +719,31 @@ void DownloadMtprotoTask::removeSession(int sessionIndex) {
 			requestData.sessionIndex = newIndex;
 		}
 	}
-	for (const auto &[requestId, offset] : redirect) {
+	for (const auto &[requestId, offset, size] : redirect) {
 		const auto needMakeRequest = (requestId != _cdnHashesRequestId);
 		cancelRequest(requestId);
 		if (needMakeRequest) {
 			const auto newIndex = _owner->chooseSessionIndex(dcId());
 			Assert(newIndex < sessionIndex);
-			makeRequest({ offset, newIndex });
+			makeRequest({ offset, newIndex, size });
 		}
 	}
 }
 
+std::optional<SharedPartKey> DownloadMtprotoTask::sharedPartKey(
+		int offset) const {
+	const auto v = std::get_if<StorageFileLocation>(&_location.data);
+	if (!v || !v->objectId()) {
+		return std::nullopt;
+	}
+	const auto key = v->cacheKey();
+	return SharedPartKey{ key.high, key.low, offset };
+}
+
 mtpRequestId DownloadMtprotoTask::sendRequest(
 		const RequestData &requestData) {
 	const auto offset = requestData.offset;
-	const auto limit = Storage::kDownloadPartSize;
+	const auto limit = requestData.size;
 	const auto shiftedDcId = MTP::downloadDcId(
 		_cdnDcId ? _cdnDcId : dcId(),
 		requestData.sessionIndex);
@@ -577,7 +810,26 @@ bool DownloadMtprotoTask::setWebFileSizeHook(int size) {
 }
 
 void DownloadMtprotoTask::makeRequest(const RequestData &requestData) {
-	placeSentRequest(sendRequest(requestData), requestData);
+	if (_cdnDcId && requestData.size > Storage::kDownloadPartSize) {
+		// CDN file hashes are checked by kDownloadPartSize parts.
+		const auto till = requestData.offset + requestData.size;
+		auto part = requestData;
+		part.size = Storage::kDownloadPartSize;
+		for (; part.offset < till; part.offset += part.size) {
+			makeRequest(part);
+		}
+		return;
+	}
+	auto data = requestData;
+	const auto key = _cdnDcId ? std::nullopt : sharedPartKey(data.offset);
+	if (key) {
+		if (_owner->subscribeToSharedPart(this, *key, data.size)) {
+			_sharedWaits.emplace(data.offset, data);
+			return;
+		}
+		data.shared = _owner->registerSharedPart(this, *key, data.size);
+	}
+	placeSentRequest(sendRequest(data), data);
 }
 
 void DownloadMtprotoTask::requestMoreCdnFileHashes() {
@@ -606,9 +858,22 @@ void DownloadMtprotoTask::normalPartLoaded(
 	const auto requestData = finishSentRequest(
 		requestId,
 		FinishRequestReason::Success);
+	const auto key = requestData.shared
+		? sharedPartKey(requestData.offset)
+		: std::nullopt;
 	result.match([&](const MTPDupload_fileCdnRedirect &data) {
+		if (key) {
+			_owner->sharedPartFailed(this, *key);
+		}
 		switchToCDN(requestData, data);
 	}, [&](const MTPDupload_file &data) {
+		if (key) {
+			const auto weak = base::make_weak(this);
+			_owner->sharedPartLoaded(this, *key, data.vbytes().v);
+			if (!weak) {
+				return;
+			}
+		}
 		partLoaded(requestData.offset, data.vbytes().v);
 	});
 }
@@ -768,7 +1033,7 @@ void DownloadMtprotoTask::placeSentRequest(
 	const auto amount = _owner->changeRequestedAmount(
 		dcId(),
 		requestData.sessionIndex,
-		Storage::kDownloadPartSize);
+		requestData.size);
 	const auto [i, ok1] = _sentRequests.emplace(requestId, requestData);
 	const auto [j, ok2] = _requestByOffset.emplace(
 		requestData.offset,
@@ -794,7 +1059,7 @@ auto DownloadMtprotoTask::finishSentRequest(
 	_owner->changeRequestedAmount(
 		dcId(),
 		result.sessionIndex,
-		-Storage::kDownloadPartSize);
+		-result.size);
 	_sentRequests.erase(it);
 	const auto ok = _requestByOffset.remove(result.offset);
 
@@ -803,7 +1068,12 @@ auto DownloadMtprotoTask::finishSentRequest(
 			dcId(),
 			result.sessionIndex,
 			result.requestedInSession,
-			result.sent);
+			result.sent,
+			result.size);
+	} else if (result.shared) {
+		if (const auto key = sharedPartKey(result.offset)) {
+			_owner->sharedPartFailed(this, *key);
+		}
 	}
 
 	Ensures(ok);
@@ -811,12 +1081,15 @@ auto DownloadMtprotoTask::finishSentRequest(
 }
 
 bool DownloadMtprotoTask::haveSentRequests() const {
-	return !_sentRequests.empty() || !_cdnUncheckedParts.empty();
+	return !_sentRequests.empty()
+		|| !_cdnUncheckedParts.empty()
+		|| !_sharedWaits.empty();
 }
 
 bool DownloadMtprotoTask::haveSentRequestForOffset(int offset) const {
 	return _requestByOffset.contains(offset)
-		|| _cdnUncheckedParts.contains({ offset, 0 });
+		|| _cdnUncheckedParts.contains({ offset, 0 })
+		|| _sharedWaits.contains(offset);
 }
 
 void DownloadMtprotoTask::cancelAllRequests() {
@@ -824,6 +1097,11 @@ void DownloadMtprotoTask::cancelAllRequests() {
 		cancelRequest(_sentRequests.begin()->first);
 	}
 	_cdnUncheckedParts.clear();
+	for (const auto &[offset, requestData] : base::take(_sharedWaits)) {
+		if (const auto key = sharedPartKey(offset)) {
+			_owner->unsubscribeFromSharedPart(this, *key);
+		}
+	}
 }
 
 void DownloadMtprotoTask::cancelRequestForOffset(int offset) {
@@ -832,6 +1110,11 @@ void DownloadMtprotoTask::cancelRequestForOffset(int offset) {
 		cancelRequest(i->second);
 	}
 	_cdnUncheckedParts.remove({ offset, 0 });
+	if (_sharedWaits.remove(offset)) {
+		if (const auto key = sharedPartKey(offset)) {
+			_owner->unsubscribeFromSharedPart(this, *key);
+		}
+	}
 }
 
 void DownloadMtprotoTask::cancelRequest(mtpRequestId requestId) {
@@ -848,13 +1131,43 @@ void DownloadMtprotoTask::cancelRequest(mtpRequestId requestId) {
 }
 
 void DownloadMtprotoTask::addToQueue(int priority) {
-	_owner->enqueue(this, priority);
+	// Prefetched files go together with the previous generation,
+	// until they are queued again not by prefetching, f.e. when opened.
+	if (_prefetch && !_owner->prefetching()) {
+		_prefetch = false;
+	}
+	_owner->enqueue(this, _prefetch ? std::min(priority, -1) : priority);
+}
+
+bool DownloadMtprotoTask::takePrefetch() {
+	return base::take(_prefetch);
 }
 
 void DownloadMtprotoTask::removeFromQueue() {
 	_owner->remove(this);
 }
 
+void DownloadMtprotoTask::allowLargeParts() {
+	_largePartsAllowed = true;
+}
+
+int DownloadMtprotoTask::partSizeAt(int offset) const {
+	if (!_largePartsAllowed || _cdnDcId) {
+		return Storage::kDownloadPartSize;
+	}
+
+	// Server requires (offset % limit == 0) and (1MB % limit == 0).
+	auto result = bandwidth().partSize;
+	while (result > Storage::kDownloadPartSize && (offset % result)) {
+		result /= 2;
+	}
+	return result;
+}
+
+DownloadBandwidth DownloadMtprotoTask::bandwidth() const {
+	return _owner->bandwidth(dcId());
+}
+
 void DownloadMtprotoTask::partLoaded(
 		int offset,
 		const QByteArray &bytes) {
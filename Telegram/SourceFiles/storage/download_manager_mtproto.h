@@ -16,12 +16,38 @@ class RPCError;
 
 namespace Storage {
 
-// Different part sizes are not supported for now :(
+// Different part sizes are supported only for plain locations :(
 // Because we start downloading with some part size
 // and then we get a CDN-redirect where we support only
 // fixed part size download for hash checking.
 constexpr auto kDownloadPartSize = 128 * 1024;
 
+// In adaptive mode plain (non-CDN) locations may be requested by bigger
+// parts, each of them is a multiple of kDownloadPartSize aligned by size.
+// After a CDN-redirect all requests are split back to kDownloadPartSize.
+constexpr auto kMaxDownloadPartSize = 1024 * 1024;
+
+struct DownloadBandwidth {
+	crl::time rtt = 0; // Minimal request duration in the recent period.
+	int64 bytesPerSecond = 0;
+	int window = 0; // Bytes allowed to be requested in all dc sessions.
+	int partSize = kDownloadPartSize;
+};
+
+// objectId() is the same for all photo sizes, so we use the cache key.
+struct SharedPartKey {
+	uint64 high = 0;
+	uint64 low = 0;
+	int offset = 0;
+
+	friend inline bool operator<(
+			const SharedPartKey &a,
+			const SharedPartKey &b) {
+		return std::tie(a.high, a.low, a.offset)
+			< std::tie(b.high, b.low, b.offset);
+	}
+};
+
 class DownloadMtprotoTask;
 
 class DownloadManagerMtproto final : public base::has_weak_ptr {
@@ -38,6 +64,10 @@ public:
 	void enqueue(not_null<Task*> task, int priority);
 	void remove(not_null<Task*> task);
 
+	// Tasks created while prefetching are queued after the current ones.
+	void setPrefetching(bool prefetching);
+	[[nodiscard]] bool prefetching() const;
+
 	void notifyTaskFinished() {
 		_taskFinished.fire({});
 	}
@@ -50,9 +80,31 @@ public:
 		MTP::DcId dcId,
 		int index,
 		int amountAtRequestStart,
-		crl::time timeAtRequestStart);
+		crl::time timeAtRequestStart,
+		int size);
 	[[nodiscard]] int chooseSessionIndex(MTP::DcId dcId) const;
 
+	[[nodiscard]] bool adaptive() const;
+	[[nodiscard]] DownloadBandwidth bandwidth(MTP::DcId dcId) const;
+
+	// Identical parts wanted by several tasks are requested only once.
+	[[nodiscard]] bool subscribeToSharedPart(
+		not_null<Task*> task,
+		const SharedPartKey &key,
+		int size);
+	[[nodiscard]] bool registerSharedPart(
+		not_null<Task*> task,
+		const SharedPartKey &key,
+		int size);
+	void unsubscribeFromSharedPart(
+		not_null<Task*> task,
+		const SharedPartKey &key);
+	void sharedPartLoaded(
+		not_null<Task*> owner,
+		const SharedPartKey &key,
+		const QByteArray &bytes);
+	void sharedPartFailed(not_null<Task*> owner, const SharedPartKey &key);
+
 private:
 	class Queue final {
 	public:
@@ -87,6 +139,17 @@ private:
 		int sessionRemoveTimes = 0;
 		int timeouts = 0; // Since all sessions had successes >= required.
 		int totalRequested = 0;
+		bool warmAfterIdle = false;
+
+		DownloadBandwidth bandwidth;
+		crl::time rttMeasured = 0;
+		crl::time measureStart = 0;
+		int64 measuredBytes = 0;
+	};
+	struct SharedPart {
+		not_null<Task*> owner;
+		int size = 0;
+		std::vector<base::weak_ptr<Task>> waiters;
 	};
 
 	void checkSendNext();
@@ -96,12 +159,18 @@ private:
 	void killSessionsSchedule(MTP::DcId dcId);
 	void killSessionsCancel(MTP::DcId dcId);
 	void killSessions();
-	void killSessions(MTP::DcId dcId);
+	bool killSessions(MTP::DcId dcId);
 
 	void resetGeneration();
+	void updateBandwidth(DcBalanceData &dc, int size, crl::time duration);
+	void applyBandwidth(MTP::DcId dcId, DcBalanceData &dc);
 	void sessionTimedOut(MTP::DcId dcId, int index);
 	void removeSession(MTP::DcId dcId);
 
+	[[nodiscard]] std::vector<base::weak_ptr<Task>> takeSharedPartWaiters(
+		not_null<Task*> owner,
+		const SharedPartKey &key);
+
 	const not_null<ApiWrap*> _api;
 
 	rpl::event_stream<> _taskFinished;
@@ -113,6 +182,8 @@ private:
 	base::Timer _killSessionsTimer;
 
 	base::flat_map<MTP::DcId, Queue> _queues;
+	base::flat_map<SharedPartKey, SharedPart> _sharedParts;
+	bool _prefetching = false;
 	rpl::lifetime _lifetime;
 
 };
@@ -145,6 +216,9 @@ public:
 	void loadPart(int sessionIndex);
 	void removeSession(int sessionIndex);
 
+	void sharedPartLoaded(int offset, const QByteArray &bytes);
+	void sharedPartFailed(int offset);
+
 	void refreshFileReferenceFrom(
 		const Data::UpdatedFileReferences &updates,
 		int requestId,
@@ -159,6 +233,14 @@ protected:
 	void addToQueue(int priority = 0);
 	void removeFromQueue();
 
+	// Returns true if the task was queued as a prefetch, clearing that.
+	[[nodiscard]] bool takePrefetch();
+
+	// Parts bigger than kDownloadPartSize are requested only if allowed.
+	void allowLargeParts();
+	[[nodiscard]] int partSizeAt(int offset) const;
+	[[nodiscard]] DownloadBandwidth bandwidth() const;
+
 	[[nodiscard]] ApiWrap &api() const {
 		return _owner->api();
 	}
@@ -167,6 +249,8 @@ private:
 	struct RequestData {
 		int offset = 0;
 		mutable int sessionIndex = 0;
+		int size = kDownloadPartSize;
+		bool shared = false;
 		int requestedInSession = 0;
 		crl::time sent = 0;
 
@@ -225,6 +309,8 @@ private:
 		mtpRequestId requestId);
 	bool cdnPartFailed(const RPCError &error, mtpRequestId requestId);
 
+	[[nodiscard]] std::optional<SharedPartKey> sharedPartKey(
+		int offset) const;
 	[[nodiscard]] mtpRequestId sendRequest(const RequestData &requestData);
 	void placeSentRequest(
 		mtpRequestId requestId,
@@ -257,6 +343,9 @@ private:
 
 	base::flat_map<mtpRequestId, RequestData> _sentRequests;
 	base::flat_map<int, mtpRequestId> _requestByOffset;
+	base::flat_map<int, RequestData> _sharedWaits;
+	bool _largePartsAllowed = false;
+	bool _prefetch = false;
 
 	MTP::DcId _cdnDcId = 0;
 	QByteArray _cdnToken;
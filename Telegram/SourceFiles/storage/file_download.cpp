@@ -15,6 +15,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/application.h"
 #include "core/file_location.h"
 #include "storage/storage_account.h"
+#include "storage/storage_cache_hot_set.h"
 #include "storage/file_download_mtproto.h"
 #include "storage/file_download_web.h"
 #include "platform/platform_file_utilities.h"
@@ -201,7 +202,17 @@ void FileLoader::increaseLoadSize(int size, bool autoLoading) {
 	Expects(size <= _fullSize);
 
 	_loadSize = size;
-	_autoLoading = autoLoading;
+	if (!autoLoading) {
+		stopAutoLoading();
+	} else {
+		_autoLoading = true;
+	}
+}
+
+void FileLoader::stopAutoLoading() {
+	if (base::take(_autoLoading)) {
+		autoLoadingStoppedHook();
+	}
 }
 
 void FileLoader::notifyAboutProgress() {
@@ -277,13 +288,16 @@ void FileLoader::loadLocal(const Storage::Cache::Key &key) {
 			image = std::move(image),
 			format = std::move(format)
 		]() mutable {
+			if (!value.startsWith("partial:")) {
+				_session->data().cacheHotSet().put(key, value);
+			}
 			localLoaded(
 				StorageImageSaved(std::move(value)),
 				format,
 				std::move(image));
 		});
 	};
-	_session->data().cache().get(key, [=, callback = std::move(done)](
+	auto received = [=, callback = std::move(done)](
 			QByteArray &&value) mutable {
 		if (readImage && !value.startsWith("partial:")) {
 			crl::async([
@@ -304,7 +318,13 @@ void FileLoader::loadLocal(const Storage::Cache::Key &key) {
 		} else {
 			callback(std::move(value), {}, {});
 		}
-	});
+	};
+	auto hot = _session->data().cacheHotSet().get(key);
+	if (!hot.isEmpty()) {
+		received(std::move(hot));
+	} else {
+		_session->data().cache().get(key, std::move(received));
+	}
 }
 
 bool FileLoader::tryLoadLocal() {
@@ -340,6 +360,7 @@ void FileLoader::cancel(bool fail) {
 	const auto started = (currentOffset() > 0);
 
 	cancelHook();
+	_imageDecoding = nullptr;
 
 	_cancelled = true;
 	_finished = true;
@@ -462,6 +483,9 @@ bool FileLoader::finalizeResult() {
 		if ((_toCache == LoadToCacheAsWell)
 			&& (_data.size() <= Storage::kMaxFileInMemory)
 			&& (key.low || key.high)) {
+			if (!_fullSize || _data.size() == _fullSize) {
+				_session->data().cacheHotSet().put(key, _data);
+			}
 			_session->data().cache().put(
 				cacheKey(),
 				Storage::Cache::Database::TaggedValue(
@@ -471,12 +495,44 @@ bool FileLoader::finalizeResult() {
 					_cacheTag));
 		}
 	}
+	if (_locationType == UnknownFileLocation
+		&& _imageData.isNull()
+		&& _data.size() <= Storage::kMaxFileInMemory) {
+		decodeImageAndNotify();
+		return true;
+	}
 	const auto session = _session;
 	_updates.fire_done();
 	session->notifyDownloaderTaskFinished();
 	return true;
 }
 
+void FileLoader::decodeImageAndNotify() {
+	// Decode the loaded image in the background, so that imageData()
+	// requested from the finish handlers doesn't block the main thread.
+	crl::async([
+		=,
+		data = _data,
+		guard = _imageDecoding.make_guard()
+	]() mutable {
+		auto format = QByteArray();
+		auto image = App::readImage(data, &format, false);
+		crl::on_main(std::move(guard), [
+			=,
+			image = std::move(image),
+			format = std::move(format)
+		]() mutable {
+			if (!image.isNull()) {
+				_imageData = std::move(image);
+				_imageFormat = std::move(format);
+			}
+			const auto session = _session;
+			_updates.fire_done();
+			session->notifyDownloaderTaskFinished();
+		});
+	});
+}
+
 std::unique_ptr<FileLoader> CreateFileLoader(
 		not_null<Main::Session*> session,
 		const DownloadLocation &location,
@@ -99,6 +99,7 @@ public:
 	bool setFileName(const QString &filename); // set filename for loaders to cache
 	void permitLoadFromCloud();
 	void increaseLoadSize(int size, bool autoLoading);
+	void stopAutoLoading(); // The file was requested explicitly.
 
 	void start();
 	void cancel();
@@ -143,6 +144,8 @@ protected:
 	virtual void startLoadingWithPartial(const QByteArray &data) {
 		startLoading();
 	}
+	virtual void autoLoadingStoppedHook() {
+	}
 
 	void cancel(bool failed);
 
@@ -150,6 +153,7 @@ protected:
 
 	bool writeResultPart(int offset, bytes::const_span buffer);
 	bool finalizeResult();
+	void decodeImageAndNotify();
 	[[nodiscard]] QByteArray readLoadedPartBack(int offset, int size);
 
 	const not_null<Main::Session*> _session;
@@ -175,6 +179,7 @@ protected:
 	LocationType _locationType = LocationType();
 
 	base::binary_guard _localLoading;
+	base::binary_guard _imageDecoding;
 	mutable QByteArray _imageFormat;
 	mutable QImage _imageData;
 
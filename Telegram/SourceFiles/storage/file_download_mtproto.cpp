@@ -17,6 +17,14 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mtproto/mtproto_auth_key.h"
 #include "base/openssl_help.h"
 
+namespace {
+
+// Bigger automatic downloads are queued after the explicitly requested
+// ones, so they don't eat the bandwidth when the connection is busy.
+constexpr auto kDeferAutoLoadSize = 2 * 1024 * 1024;
+
+} // namespace
+
 mtpFileLoader::mtpFileLoader(
 	not_null<Main::Session*> session,
 	const StorageFileLocation &location,
@@ -40,6 +48,7 @@ mtpFileLoader::mtpFileLoader(
 	autoLoading,
 	cacheTag)
 , DownloadMtprotoTask(&session->downloader(), location, origin) {
+	allowLargeParts();
 }
 
 mtpFileLoader::mtpFileLoader(
@@ -115,7 +124,7 @@ int mtpFileLoader::takeNextRequestOffset() {
 	Expects(readyToRequest());
 
 	const auto result = _nextRequestOffset;
-	_nextRequestOffset += Storage::kDownloadPartSize;
+	_nextRequestOffset += partSizeAt(result);
 	return result;
 }
 
@@ -158,7 +167,16 @@ bool mtpFileLoader::setWebFileSizeHook(int size) {
 }
 
 void mtpFileLoader::startLoading() {
-	addToQueue();
+	_deferred = _autoLoading && (_loadSize > kDeferAutoLoadSize);
+	addToQueue(_deferred ? -1 : 0);
+}
+
+void mtpFileLoader::autoLoadingStoppedHook() {
+	const auto deferred = base::take(_deferred);
+	const auto prefetch = takePrefetch();
+	if ((deferred || prefetch) && !_finished) {
+		addToQueue();
+	}
 }
 
 void mtpFileLoader::startLoadingWithPartial(const QByteArray &data) {
@@ -52,6 +52,7 @@ private:
 	std::optional<MediaKey> fileLocationKey() const override;
 	void startLoading() override;
 	void startLoadingWithPartial(const QByteArray &data) override;
+	void autoLoadingStoppedHook() override;
 	void cancelHook() override;
 
 	bool readyToRequest() const override;
@@ -61,6 +62,7 @@ private:
 	bool setWebFileSizeHook(int size) override;
 
 	bool _lastComplete = false;
+	bool _deferred = false;
 	int32 _nextRequestOffset = 0;
 
 };
@@ -260,7 +260,15 @@ void WebLoadManager::removeSent(int id) {
 }
 
 not_null<QNetworkReply*> WebLoadManager::send(int id, const QString &url) {
-	const auto result = _network.get(QNetworkRequest(url));
+	auto request = QNetworkRequest(url);
+
+	// Previews and map tiles often come from the same few hosts.
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+	request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+#elif QT_VERSION >= QT_VERSION_CHECK(5, 8, 0)
+	request.setAttribute(QNetworkRequest::HTTP2AllowedAttribute, true);
+#endif // Qt >= 5.8.0
+	const auto result = _network.get(request);
 	const auto handleProgress = [=](qint64 ready, qint64 total) {
 		progress(id, result, ready, total);
 	};
@@ -21,13 +21,23 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "core/file_location.h"
 #include "core/mime_type.h"
 #include "main/main_session.h"
+#include "storage/storage_account.h"
 #include "apiwrap.h"
 
 namespace Storage {
 namespace {
 
 // max 512kb uploaded at the same time in each session
-constexpr auto kMaxUploadFileParallelSize = MTP::kUploadSessionsCount * 512 * 1024;
+constexpr auto kMaxUploadPerSessionSize = 512 * 1024;
+
+// Add an upload session after that many fast acknowledges
+// received while all the current sessions were busy.
+constexpr auto kAddSessionAfterFastAcknowledges = 8;
+constexpr auto kFastAcknowledgeLatency = crl::time(1000);
+constexpr auto kSlowAcknowledgeLatency = 4 * crl::time(1000);
+
+// How many bytes of document parts are read from disk ahead of sending.
+constexpr auto kReadAheadBytes = 4 * 1024 * 1024;
 
 constexpr auto kDocumentMaxPartsCount = 3000;
 
@@ -58,6 +68,16 @@ constexpr auto kKillSessionTimeout = 15 * crl::time(000);
 
 } // namespace
 
+struct Uploader::DocumentReader {
+	explicit DocumentReader(const QString &path) : path(path) {
+	}
+
+	// Used only from the background thread while reading.
+	const QString path;
+	std::unique_ptr<QFile> file;
+	HashMd5 md5Hash;
+};
+
 struct Uploader::File {
 	File(const SendMediaReady &media);
 	File(const std::shared_ptr<FileLoadResult> &file);
@@ -71,18 +91,28 @@ struct Uploader::File {
 	mutable int32 fileSentSize = 0;
 
 	uint64 id() const;
+	uint64 uploadId() const;
 	SendMediaType type() const;
 	uint64 thumbId() const;
 	const QString &filename() const;
 
 	HashMd5 md5Hash;
 
-	std::unique_ptr<QFile> docFile;
+	std::shared_ptr<DocumentReader> docReader;
+	base::flat_map<int32, QByteArray> docReadParts;
+	int32 docReadTill = 0;
+	bool docReading = false;
 	int32 docSentParts = 0;
 	int32 docSize = 0;
 	int32 docPartSize = 0;
 	int32 docPartsCount = 0;
 
+	// Big file uploads continued after a restart keep their old file id.
+	uint64 docUploadId = 0;
+	QString resumePath;
+	qint64 resumeModified = 0;
+	int32 docSavedParts = 0;
+
 };
 
 Uploader::File::File(const SendMediaReady &media) : media(media) {
@@ -140,6 +170,10 @@ uint64 Uploader::File::id() const {
 	return file ? file->id : media.id;
 }
 
+uint64 Uploader::File::uploadId() const {
+	return docUploadId ? docUploadId : id();
+}
+
 SendMediaType Uploader::File::type() const {
 	return file ? file->type : media.type;
 }
@@ -153,7 +187,8 @@ const QString &Uploader::File::filename() const {
 }
 
 Uploader::Uploader(not_null<ApiWrap*> api)
-: _api(api) {
+: _api(api)
+, _sessionsCount(cNetUploadSessionsCount()) {
 	nextTimer.setSingleShot(true);
 	connect(&nextTimer, SIGNAL(timeout()), this, SLOT(sendNext()));
 	stopSessionsTimer.setSingleShot(true);
@@ -375,10 +410,80 @@ void Uploader::upload(
 			document->checkWallPaperProperties();
 		}
 	}
-	queue.emplace(msgId, File(file));
+	auto &added = queue.emplace(msgId, File(file)).first->second;
+	restoreUploadState(added);
 	sendNext();
 }
 
+void Uploader::restoreUploadState(File &file) {
+	if (!file.file
+		|| file.file->filepath.isEmpty()
+		|| !file.file->content.isEmpty()
+		|| file.docSize <= kUseBigFilesFrom) {
+		return;
+	}
+	const auto &path = file.file->filepath;
+	for (const auto &[msgId, other] : queue) {
+		if (other.resumePath == path) {
+			// The same file is already uploading in this session.
+			return;
+		}
+	}
+	file.resumePath = path;
+	file.resumeModified = QFileInfo(path).lastModified().toMSecsSinceEpoch();
+	const auto state = session().local().uploadResumeState(path);
+	if (!state
+		|| state->size != file.docSize
+		|| state->modified != file.resumeModified
+		|| state->partSize != file.docPartSize
+		|| state->partsDone <= 0
+		|| state->partsDone >= file.docPartsCount) {
+		return;
+	}
+	file.docUploadId = state->fileId;
+	file.docSentParts = file.docReadTill = file.docSavedParts
+		= state->partsDone;
+	LOG(("Upload Info: Resuming '%1' from part %2 of %3."
+		).arg(path
+		).arg(state->partsDone
+		).arg(file.docPartsCount));
+}
+
+void Uploader::saveUploadState(File &file) {
+	if (file.resumePath.isEmpty()) {
+		return;
+	}
+
+	// Parts are acknowledged out of order, save only the complete prefix.
+	auto done = file.docSentParts;
+	for (const auto &[requestId, part] : docRequestsSent) {
+		done = std::min(done, part);
+	}
+	if (done <= file.docSavedParts) {
+		return;
+	}
+	file.docSavedParts = done;
+	session().local().saveUploadResumeState(file.resumePath, {
+		.fileId = file.uploadId(),
+		.size = file.docSize,
+		.modified = file.resumeModified,
+		.partSize = file.docPartSize,
+		.partsDone = done,
+	});
+}
+
+void Uploader::clearUploadState(const File &file) {
+	if (!file.resumePath.isEmpty()) {
+		session().local().clearUploadResumeState(file.resumePath);
+	}
+}
+
+void Uploader::removeTemporaryFile(const File &file) {
+	if (file.file && file.file->filepathTemporary) {
+		QFile::remove(file.file->filepath);
+	}
+}
+
 void Uploader::currentFailed() {
 	auto j = queue.find(uploadingId);
 	if (j != queue.end()) {
@@ -397,15 +502,18 @@ void Uploader::currentFailed() {
 		} else {
 			Unexpected("Type in Uploader::currentFailed.");
 		}
+		clearUploadState(j->second);
+		removeTemporaryFile(j->second);
 		queue.erase(j);
 	}
 
 	requestsSent.clear();
 	docRequestsSent.clear();
 	dcMap.clear();
+	_sentAt.clear();
 	uploadingId = FullMsgId();
 	sentSize = 0;
-	for (int i = 0; i < cNetUploadSessionsCount(); ++i) {
+	for (int i = 0; i < MTP::kUploadSessionsCountMax; ++i) {
 		sentSizes[i] = 0;
 	}
 
@@ -413,13 +521,126 @@ void Uploader::currentFailed() {
 }
 
 void Uploader::stopSessions() {
-	for (int i = 0; i < cNetUploadSessionsCount(); ++i) {
+	for (int i = 0; i < MTP::kUploadSessionsCountMax; ++i) {
 		_api->instance().stopSession(MTP::uploadDcId(i));
 	}
+	_sessionsCount = cNetUploadSessionsCount();
+	_fastAcknowledges = 0;
+}
+
+uint32 Uploader::maxSentSize() const {
+	return uint32(_sessionsCount * kMaxUploadPerSessionSize);
+}
+
+void Uploader::updateSessionsCount(crl::time latency, bool saturated) {
+	if (latency >= kSlowAcknowledgeLatency) {
+		_fastAcknowledges = 0;
+		if (_sessionsCount > cNetUploadSessionsCount()) {
+			--_sessionsCount;
+			DEBUG_LOG(("Upload sessions decreased to %1, latency: %2"
+				).arg(_sessionsCount
+				).arg(latency));
+		}
+		return;
+	} else if (!saturated || latency > kFastAcknowledgeLatency) {
+		return;
+	} else if (++_fastAcknowledges < kAddSessionAfterFastAcknowledges
+		|| _sessionsCount >= MTP::kUploadSessionsCountMax) {
+		return;
+	}
+	_fastAcknowledges = 0;
+	++_sessionsCount;
+	DEBUG_LOG(("Upload sessions increased to %1, latency: %2"
+		).arg(_sessionsCount
+		).arg(latency));
+}
+
+void Uploader::readDocumentParts(const FullMsgId &msgId, File &file) {
+	const auto readAheadParts = std::max(
+		kReadAheadBytes / std::max(file.docPartSize, 1),
+		1);
+	if (file.docReading
+		|| file.docReadTill >= file.docPartsCount
+		|| int(file.docReadParts.size()) >= readAheadParts) {
+		return;
+	}
+	if (!file.docReader) {
+		file.docReader = std::make_shared<DocumentReader>(file.file
+			? file.file->filepath
+			: file.media.file);
+	}
+	file.docReading = true;
+
+	const auto reader = file.docReader;
+	const auto fromPart = file.docReadTill;
+	const auto count = std::min(
+		readAheadParts - int(file.docReadParts.size()),
+		file.docPartsCount - fromPart);
+	const auto last = (fromPart + count >= file.docPartsCount);
+	const auto partSize = file.docPartSize;
+	const auto feedMd5 = (file.docSize <= kUseBigFilesFrom);
+	crl::async([=] {
+		auto parts = std::vector<QByteArray>();
+		auto failed = false;
+		if (!reader->file) {
+			reader->file = std::make_unique<QFile>(reader->path);
+			failed = !reader->file->open(QIODevice::ReadOnly)
+				|| !reader->file->seek(qint64(fromPart) * partSize);
+		}
+		if (!failed) {
+			parts.reserve(count);
+			for (auto i = 0; i != count; ++i) {
+				parts.push_back(reader->file->read(partSize));
+				const auto &bytes = parts.back();
+				if (feedMd5) {
+					reader->md5Hash.feed(bytes.constData(), bytes.size());
+				}
+			}
+			if (last) {
+				// Don't keep the file open while the tail is uploading.
+				reader->file = nullptr;
+			}
+		}
+		crl::on_main(this, [=, parts = std::move(parts)]() mutable {
+			documentPartsRead(
+				msgId,
+				reader,
+				fromPart,
+				std::move(parts),
+				failed);
+		});
+	});
+}
+
+void Uploader::documentPartsRead(
+		const FullMsgId &msgId,
+		const std::shared_ptr<DocumentReader> &reader,
+		int fromPart,
+		std::vector<QByteArray> &&parts,
+		bool failed) {
+	const auto i = queue.find(msgId);
+	if (i == end(queue) || i->second.docReader != reader) {
+		return;
+	}
+	auto &file = i->second;
+	file.docReading = false;
+	if (failed) {
+		if (uploadingId == msgId) {
+			currentFailed();
+		}
+		return;
+	}
+	for (auto &bytes : parts) {
+		file.docReadParts.emplace(fromPart++, std::move(bytes));
+	}
+	file.docReadTill = fromPart;
+	if (uploadingId == msgId) {
+		sendNext();
+	}
 }
 
 void Uploader::sendNext() {
-	if (sentSize >= (cNetUploadSessionsCount() * 512 * 1024) || _pausedId.msg) {
+	if (sentSize >= maxSentSize() || _pausedId.msg) {
 		return;
 	}
 
@@ -444,7 +665,7 @@ void Uploader::sendNext() {
 	auto &uploadingData = i->second;
 
 	auto todc = 0;
-	for (auto dc = 1; dc != cNetUploadSessionsCount(); ++dc) {
+	for (auto dc = 1; dc != _sessionsCount; ++dc) {
 		if (sentSizes[dc] < sentSizes[todc]) {
 			todc = dc;
 		}
@@ -470,6 +691,9 @@ void Uploader::sendNext() {
 					: Api::SendOptions();
 				const auto edit = uploadingData.file &&
 					uploadingData.file->edit;
+				if (uploadingData.docReader) {
+					uploadingData.md5Hash = uploadingData.docReader->md5Hash;
+				}
 				if (uploadingData.type() == SendMediaType::Photo) {
 					auto photoFilename = uploadingData.filename();
 					if (!photoFilename.endsWith(qstr(".jpg"), Qt::CaseInsensitive)) {
@@ -495,7 +719,7 @@ void Uploader::sendNext() {
 
 					const auto file = (uploadingData.docSize > kUseBigFilesFrom)
 						? MTP_inputFileBig(
-							MTP_long(uploadingData.id()),
+							MTP_long(uploadingData.uploadId()),
 							MTP_int(uploadingData.docPartsCount),
 							MTP_string(uploadingData.filename()))
 						: MTP_inputFile(
@@ -534,6 +758,8 @@ void Uploader::sendNext() {
 						uploadingData.id(),
 						uploadingData.partsCount });
 				}
+				clearUploadState(uploadingData);
+				removeTemporaryFile(uploadingData);
 				queue.erase(uploadingId);
 				uploadingId = FullMsgId();
 				sendNext();
@@ -546,20 +772,16 @@ void Uploader::sendNext() {
 			: uploadingData.media.data;
 		QByteArray toSend;
 		if (content.isEmpty()) {
-			if (!uploadingData.docFile) {
-				const auto filepath = uploadingData.file
-					? uploadingData.file->filepath
-					: uploadingData.media.file;
-				uploadingData.docFile = std::make_unique<QFile>(filepath);
-				if (!uploadingData.docFile->open(QIODevice::ReadOnly)) {
-					currentFailed();
-					return;
-				}
-			}
-			toSend = uploadingData.docFile->read(uploadingData.docPartSize);
-			if (uploadingData.docSize <= kUseBigFilesFrom) {
-				uploadingData.md5Hash.feed(toSend.constData(), toSend.size());
+			// Parts are read and hashed on a background thread.
+			auto &read = uploadingData.docReadParts;
+			const auto ready = read.find(uploadingData.docSentParts);
+			if (ready == end(read)) {
+				readDocumentParts(uploadingId, uploadingData);
+				return;
 			}
+			toSend = std::move(ready->second);
+			read.erase(ready);
+			readDocumentParts(uploadingId, uploadingData);
 		} else {
 			const auto offset = uploadingData.docSentParts
 				* uploadingData.docPartSize;
@@ -580,7 +802,7 @@ void Uploader::sendNext() {
 		mtpRequestId requestId;
 		if (uploadingData.docSize > kUseBigFilesFrom) {
 			requestId = _api->request(MTPupload_SaveBigFilePart(
-				MTP_long(uploadingData.id()),
+				MTP_long(uploadingData.uploadId()),
 				MTP_int(uploadingData.docSentParts),
 				MTP_int(uploadingData.docPartsCount),
 				MTP_bytes(toSend)
@@ -602,6 +824,7 @@ void Uploader::sendNext() {
 		}
 		docRequestsSent.emplace(requestId, uploadingData.docSentParts);
 		dcMap.emplace(requestId, todc);
+		_sentAt.emplace(requestId, crl::now());
 		sentSize += uploadingData.docPartSize;
 		sentSizes[todc] += uploadingData.docPartSize;
 
@@ -620,6 +843,7 @@ void Uploader::sendNext() {
 		}).toDC(MTP::uploadDcId(todc)).send();
 		requestsSent.emplace(requestId, part.value());
 		dcMap.emplace(requestId, todc);
+		_sentAt.emplace(requestId, crl::now());
 		sentSize += part.value().size();
 		sentSizes[todc] += part.value().size();
 
@@ -632,8 +856,10 @@ void Uploader::cancel(const FullMsgId &msgId) {
 	uploaded.erase(msgId);
 	if (uploadingId == msgId) {
 		currentFailed();
-	} else {
-		queue.erase(msgId);
+	} else if (const auto i = queue.find(msgId); i != end(queue)) {
+		clearUploadState(i->second);
+		removeTemporaryFile(i->second);
+		queue.erase(i);
 	}
 }
 
@@ -651,6 +877,9 @@ void Uploader::confirm(const FullMsgId &msgId) {
 
 void Uploader::clear() {
 	uploaded.clear();
+	for (const auto &[msgId, file] : queue) {
+		removeTemporaryFile(file);
+	}
 	queue.clear();
 	for (const auto &requestData : requestsSent) {
 		_api->request(requestData.first).cancel();
@@ -661,11 +890,14 @@ void Uploader::clear() {
 	}
 	docRequestsSent.clear();
 	dcMap.clear();
+	_sentAt.clear();
 	sentSize = 0;
-	for (int i = 0; i < cNetUploadSessionsCount(); ++i) {
+	for (int i = 0; i < MTP::kUploadSessionsCountMax; ++i) {
 		_api->instance().stopSession(MTP::uploadDcId(i));
 		sentSizes[i] = 0;
 	}
+	_sessionsCount = cNetUploadSessionsCount();
+	_fastAcknowledges = 0;
 	stopSessionsTimer.stop();
 }
 
@@ -688,6 +920,11 @@ void Uploader::partLoaded(const MTPBool &result, mtpRequestId requestId) {
 			auto dc = dcIt->second;
 			dcMap.erase(dcIt);
 
+			const auto saturated = (sentSize >= maxSentSize());
+			if (const auto sent = _sentAt.take(requestId)) {
+				updateSessionsCount(crl::now() - *sent, saturated);
+			}
+
 			int32 sentPartSize = 0;
 			auto k = queue.find(uploadingId);
 			Assert(k != queue.cend());
@@ -720,6 +957,7 @@ void Uploader::partLoaded(const MTPBool &result, mtpRequestId requestId) {
 						document->uploadingData->size,
 						doneParts * file.docPartSize);
 				}
+				saveUploadState(file);
 				_documentProgress.fire_copy(fullId);
 			} else if (file.type() == SendMediaType::Secure) {
 				file.fileSentSize += sentPartSize;
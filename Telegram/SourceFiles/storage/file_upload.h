@@ -121,10 +121,25 @@ public slots:
 
 private:
 	struct File;
+	struct DocumentReader;
 
 	void partLoaded(const MTPBool &result, mtpRequestId requestId);
 	void partFailed(const RPCError &error, mtpRequestId requestId);
 
+	void readDocumentParts(const FullMsgId &msgId, File &file);
+	void documentPartsRead(
+		const FullMsgId &msgId,
+		const std::shared_ptr<DocumentReader> &reader,
+		int fromPart,
+		std::vector<QByteArray> &&parts,
+		bool failed);
+	void updateSessionsCount(crl::time latency, bool saturated);
+	void restoreUploadState(File &file);
+	void saveUploadState(File &file);
+	void clearUploadState(const File &file);
+	void removeTemporaryFile(const File &file);
+	[[nodiscard]] uint32 maxSentSize() const;
+
 	void processPhotoProgress(const FullMsgId &msgId);
 	void processPhotoFailed(const FullMsgId &msgId);
 	void processDocumentProgress(const FullMsgId &msgId);
@@ -141,8 +156,11 @@ private:
 	base::flat_map<mtpRequestId, QByteArray> requestsSent;
 	base::flat_map<mtpRequestId, int32> docRequestsSent;
 	base::flat_map<mtpRequestId, int32> dcMap;
+	base::flat_map<mtpRequestId, crl::time> _sentAt;
 	uint32 sentSize = 0;
 	uint32 sentSizes[MTP::kUploadSessionsCountMax] = { 0 };
+	int _sessionsCount = 0;
+	int _fastAcknowledges = 0;
 
 	FullMsgId uploadingId;
 	FullMsgId _pausedId;
@@ -16,6 +16,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "base/unixtime.h"
 #include "base/qt_adapters.h"
 #include "media/audio/media_audio.h"
+#include "media/clip/media_clip_compress.h"
 #include "media/clip/media_clip_reader.h"
 #include "mtproto/facade.h"
 #include "lottie/lottie_animation.h"
@@ -30,9 +31,11 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "mainwidget.h"
 #include "mainwindow.h"
 #include "main/main_session.h"
+#include "storage/storage_account.h"
 #include "app.h"
 
 #include <QtCore/QBuffer>
+#include <QtCore/QDir>
 #include <QtGui/QImageWriter>
 
 namespace {
@@ -41,6 +44,9 @@ constexpr auto kThumbnailQuality = 87;
 constexpr auto kThumbnailSize = 320;
 constexpr auto kPhotoUploadPartSize = 32 * 1024;
 
+// Remuxing copies the whole file, don't do that for huge videos.
+constexpr auto kFastStartVideoMaxSize = 256 * 1024 * 1024;
+
 using Ui::ValidateThumbDimensions;
 
 struct PreparedFileThumbnail {
@@ -254,7 +260,8 @@ SendMediaReady PreparePeerPhoto(MTP::DcId dcId, PeerId peerId, QImage &&image) {
 		0);
 }
 
-TaskQueue::TaskQueue(crl::time stopTimeoutMs) {
+TaskQueue::TaskQueue(crl::time stopTimeoutMs, int threadsCount)
+: _threadsCount(std::max(threadsCount, 1)) {
 	if (stopTimeoutMs > 0) {
 		_stopTimer = new QTimer(this);
 		connect(_stopTimer, SIGNAL(timeout()), this, SLOT(stop()));
@@ -287,16 +294,20 @@ void TaskQueue::addTasks(std::vector<std::unique_ptr<Task>> &&tasks) {
 }
 
 void TaskQueue::wakeThread() {
-	if (!_thread) {
-		_thread = new QThread();
+	if (_workers.empty()) {
+		_workers.reserve(_threadsCount);
+		for (auto i = 0; i != _threadsCount; ++i) {
+			auto &worker = _workers.emplace_back();
+			worker.thread = new QThread();
 
-		_worker = new TaskQueueWorker(this);
-		_worker->moveToThread(_thread);
+			worker.worker = new TaskQueueWorker(this);
+			worker.worker->moveToThread(worker.thread);
 
-		connect(this, SIGNAL(taskAdded()), _worker, SLOT(onTaskAdded()));
-		connect(_worker, SIGNAL(taskProcessed()), this, SLOT(onTaskProcessed()));
+			connect(this, SIGNAL(taskAdded()), worker.worker, SLOT(onTaskAdded()));
+			connect(worker.worker, SIGNAL(taskProcessed()), this, SLOT(onTaskProcessed()));
 
-		_thread->start();
+			worker.thread->start();
+		}
 	}
 	if (_stopTimer) _stopTimer->stop();
 	emit taskAdded();
@@ -315,12 +326,19 @@ void TaskQueue::cancelTask(TaskId id) {
 	{
 		QMutexLocker lock(&_tasksToProcessMutex);
 		removeFrom(_tasksToProcess);
-		if (_taskInProcessId == id) {
-			_taskInProcessId = TaskId();
-		}
+		_tasksInProcess.remove(id);
 	}
 	QMutexLocker lock(&_tasksToFinishMutex);
 	removeFrom(_tasksToFinish);
+	const auto wasFirst = !_tasksFinishOrder.empty()
+		&& (_tasksFinishOrder.front() == id);
+	_tasksFinishOrder.erase(
+		ranges::remove(_tasksFinishOrder, id),
+		end(_tasksFinishOrder));
+	if (wasFirst && !_tasksFinishOrder.empty()) {
+		// The next tasks could be already processed and waiting for it.
+		crl::on_main(this, [=] { onTaskProcessed(); });
+	}
 }
 
 void TaskQueue::onTaskProcessed() {
@@ -328,33 +346,45 @@ void TaskQueue::onTaskProcessed() {
 		auto task = std::unique_ptr<Task>();
 		{
 			QMutexLocker lock(&_tasksToFinishMutex);
-			if (_tasksToFinish.empty()) break;
-			task = std::move(_tasksToFinish.front());
-			_tasksToFinish.pop_front();
+			if (_tasksFinishOrder.empty()) break;
+
+			// Wait for the earlier added tasks to keep the finish order.
+			const auto proj = [](const std::unique_ptr<Task> &task) {
+				return task->id();
+			};
+			const auto id = _tasksFinishOrder.front();
+			const auto i = ranges::find(_tasksToFinish, id, proj);
+			if (i == _tasksToFinish.end()) break;
+			task = std::move(*i);
+			_tasksToFinish.erase(i);
+			_tasksFinishOrder.pop_front();
 		}
 		task->finish();
 	} while (true);
 
 	if (_stopTimer) {
 		QMutexLocker lock(&_tasksToProcessMutex);
-		if (_tasksToProcess.empty() && !_taskInProcessId) {
+		if (_tasksToProcess.empty() && _tasksInProcess.empty()) {
 			_stopTimer->start();
 		}
 	}
 }
 
 void TaskQueue::stop() {
-	if (_thread) {
-		_thread->requestInterruption();
-		_thread->quit();
+	for (const auto &worker : _workers) {
+		worker.thread->requestInterruption();
+		worker.thread->quit();
+	}
+	for (auto &worker : base::take(_workers)) {
 		DEBUG_LOG(("Waiting for taskThread to finish"));
-		_thread->wait();
-		delete base::take(_worker);
-		delete base::take(_thread);
+		worker.thread->wait();
+		delete worker.worker;
+		delete worker.thread;
 	}
 	_tasksToProcess.clear();
 	_tasksToFinish.clear();
-	_taskInProcessId = TaskId();
+	_tasksFinishOrder.clear();
+	_tasksInProcess.clear();
 }
 
 TaskQueue::~TaskQueue() {
@@ -374,7 +404,10 @@ void TaskQueueWorker::onTaskAdded() {
 			if (!_queue->_tasksToProcess.empty()) {
 				task = std::move(_queue->_tasksToProcess.front());
 				_queue->_tasksToProcess.pop_front();
-				_queue->_taskInProcessId = task->id();
+				_queue->_tasksInProcess.emplace(task->id());
+
+				QMutexLocker lockToFinish(&_queue->_tasksToFinishMutex);
+				_queue->_tasksFinishOrder.push_back(task->id());
 			}
 		}
 
@@ -383,12 +416,12 @@ void TaskQueueWorker::onTaskAdded() {
 			bool emitTaskProcessed = false;
 			{
 				QMutexLocker lockToProcess(&_queue->_tasksToProcessMutex);
-				if (_queue->_taskInProcessId == task->id()) {
-					_queue->_taskInProcessId = TaskId();
+				if (_queue->_tasksInProcess.remove(task->id())) {
 					someTasksLeft = !_queue->_tasksToProcess.empty();
 
 					QMutexLocker lockToFinish(&_queue->_tasksToFinishMutex);
-					emitTaskProcessed = _queue->_tasksToFinish.empty();
+					emitTaskProcessed = !_queue->_tasksFinishOrder.empty()
+						&& (_queue->_tasksFinishOrder.front() == task->id());
 					_queue->_tasksToFinish.push_back(std::move(task));
 				}
 			}
@@ -506,7 +539,9 @@ FileLoadTask::FileLoadTask(
 , _information(std::move(information))
 , _type(type)
 , _caption(caption)
-, _msgIdToEdit(msgIdToEdit) {
+, _msgIdToEdit(msgIdToEdit)
+, _compressBitrate(cVideoCompressBitrate())
+, _tempFolder(session->local().uploadsTempDirectory()) {
 	Expects(to.options.scheduled
 		|| (_msgIdToEdit == 0 || IsServerMsgId(_msgIdToEdit)));
 }
@@ -728,6 +763,12 @@ void FileLoadTask::process(Args &&args) {
 				fullimage = Images::prepareOpaque(std::move(fullimage));
 			}
 			isAnimation = image->animated;
+		} else if (compressVideo()) {
+			filesize = QFileInfo(_filepath).size();
+			filename = info.completeBaseName() + qsl(".mp4");
+			filemime = _information->filemime;
+		} else if (fastStartVideo()) {
+			filesize = QFileInfo(_filepath).size();
 		}
 	} else if (!_content.isEmpty()) {
 		filesize = _content.size();
@@ -960,6 +1001,7 @@ void FileLoadTask::process(Args &&args) {
 
 	_result->type = _type;
 	_result->filepath = _filepath;
+	_result->filepathTemporary = _filepathTemporary;
 	_result->content = _content;
 
 	_result->filename = filename;
@@ -1006,6 +1048,58 @@ FileLoadResult *FileLoadTask::peekResult() const {
 	return _result.get();
 }
 
+bool FileLoadTask::compressVideo() {
+	const auto video = std::get_if<Ui::PreparedFileInformation::Video>(
+		&_information->media);
+	if (!video || video->isGifv || !_compressBitrate) {
+		return false;
+	}
+	const auto path = _tempFolder
+		+ QString::number(_id, 16)
+		+ qsl(".mp4");
+	if (!QDir().mkpath(_tempFolder)
+		|| !Media::Clip::CompressVideo(_filepath, path, _compressBitrate)) {
+		QFile::remove(path);
+		return false;
+	}
+	DEBUG_LOG(("Compress Info: '%1' compressed from %2 to %3 bytes."
+		).arg(_filepath
+		).arg(QFileInfo(_filepath).size()
+		).arg(QFileInfo(path).size()));
+	_filepath = path;
+	_filepathTemporary = true;
+	_information->filemime = qsl("video/mp4");
+	video->supportsStreaming = true;
+	return true;
+}
+
+bool FileLoadTask::fastStartVideo() {
+	const auto video = std::get_if<Ui::PreparedFileInformation::Video>(
+		&_information->media);
+	if (!video
+		|| video->isGifv
+		|| video->supportsStreaming
+		|| _information->filemime != qstr("video/mp4")
+		|| _tempFolder.isEmpty()
+		|| QFileInfo(_filepath).size() > kFastStartVideoMaxSize) {
+		return false;
+	}
+	const auto path = _tempFolder
+		+ QString::number(_id, 16)
+		+ qsl(".mp4");
+	if (!QDir().mkpath(_tempFolder)
+		|| !Media::Clip::FastStartVideo(_filepath, path)) {
+		QFile::remove(path);
+		return false;
+	}
+	DEBUG_LOG(("Compress Info: '%1' remuxed for streaming."
+		).arg(_filepath));
+	_filepath = path;
+	_filepathTemporary = true;
+	video->supportsStreaming = true;
+	return true;
+}
+
 std::unique_ptr<Ui::PreparedFileInformation> FileLoadTask::readMediaInformation(
 		const QString &filemime) const {
 	return ReadMediaInformation(_filepath, _content, filemime);
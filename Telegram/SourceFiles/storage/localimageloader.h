@@ -8,6 +8,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "base/variant.h"
+#include "base/flat_set.h"
 #include "api/api_common.h"
 #include "ui/chat/attach/attach_prepare.h"
 
@@ -101,7 +102,10 @@ class TaskQueue : public QObject {
 	Q_OBJECT
 
 public:
-	explicit TaskQueue(crl::time stopTimeoutMs = 0); // <= 0 - never stop worker
+	// stopTimeoutMs <= 0 - never stop workers.
+	// Tasks are processed by up to threadsCount workers in parallel,
+	// but finish() is always called in the order the tasks were added.
+	explicit TaskQueue(crl::time stopTimeoutMs = 0, int threadsCount = 1);
 
 	TaskId addTask(std::unique_ptr<Task> &&task);
 	void addTasks(std::vector<std::unique_ptr<Task>> &&tasks);
@@ -119,14 +123,20 @@ public slots:
 private:
 	friend class TaskQueueWorker;
 
+	struct Worker {
+		QThread *thread = nullptr;
+		TaskQueueWorker *worker = nullptr;
+	};
+
 	void wakeThread();
 
 	std::deque<std::unique_ptr<Task>> _tasksToProcess;
 	std::deque<std::unique_ptr<Task>> _tasksToFinish;
-	TaskId _taskInProcessId = TaskId();
+	std::deque<TaskId> _tasksFinishOrder;
+	base::flat_set<TaskId> _tasksInProcess;
 	QMutex _tasksToProcessMutex, _tasksToFinishMutex;
-	QThread *_thread = nullptr;
-	TaskQueueWorker *_worker = nullptr;
+	std::vector<Worker> _workers;
+	int _threadsCount = 1;
 	QTimer *_stopTimer = nullptr;
 
 };
@@ -202,6 +212,7 @@ struct FileLoadResult {
 	SendMediaType type = SendMediaType::File;
 	QString filepath;
 	QByteArray content;
+	bool filepathTemporary = false; // Removed when the upload ends.
 
 	QString filename;
 	QString filemime;
@@ -297,6 +308,8 @@ private:
 	static bool CheckMimeOrExtensions(const QString &filepath, const QString &filemime, Mimes &mimes, Extensions &extensions);
 
 	std::unique_ptr<Ui::PreparedFileInformation> readMediaInformation(const QString &filemime) const;
+	[[nodiscard]] bool compressVideo();
+	[[nodiscard]] bool fastStartVideo();
 	void removeFromAlbum();
 
 	uint64 _id = 0;
@@ -312,6 +325,9 @@ private:
 	SendMediaType _type;
 	TextWithTags _caption;
 	MsgId _msgIdToEdit = 0;
+	int _compressBitrate = 0;
+	QString _tempFolder;
+	bool _filepathTemporary = false;
 
 	std::shared_ptr<FileLoadResult> _result;
 
@@ -11,6 +11,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "storage/storage_account.h"
 #include "storage/details/storage_file_utilities.h"
 #include "storage/details/storage_settings_scheme.h"
+#include "storage/cache/storage_cache_database.h"
 #include "data/data_session.h"
 #include "data/data_document.h"
 #include "data/data_document_media.h"
@@ -18,6 +19,7 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "ui/effects/animation_value.h"
 #include "core/update_checker.h"
 #include "core/file_location.h"
+#include "core/startup_trace.h"
 #include "core/application.h"
 #include "media/audio/media_audio.h"
 #include "mtproto/mtproto_config.h"
@@ -835,12 +837,20 @@ int32 oldKotatoVersion() {
 	return _oldKotatoVersion;
 }
 
+[[nodiscard]] bool ValidCachedWaveform(const QByteArray &value) {
+	if (value.isEmpty()
+		|| value.size() > Media::Player::kWaveformSamplesCount) {
+		return false;
+	}
+	return ranges::all_of(value, [](char ch) { return ch >= 0 && ch < 32; });
+}
+
 class CountWaveformTask : public Task {
 public:
-	CountWaveformTask(not_null<Data::DocumentMedia*> media)
-	: _doc(media->owner())
+	CountWaveformTask(not_null<DocumentData*> document, QByteArray data)
+	: _doc(document)
 	, _loc(_doc->location(true))
-	, _data(media->bytes())
+	, _data(std::move(data))
 	, _wavemax(0) {
 		if (_data.isEmpty() && !_loc.accessEnable()) {
 			_doc = nullptr;
@@ -859,6 +869,15 @@ public:
 			if (!_waveform.isEmpty()) {
 				voice->waveform = _waveform;
 				voice->wavemax = _wavemax;
+				if (_doc->hasRemoteLocation()) {
+					_doc->owner().cache().put(
+						_doc->waveformCacheKey(),
+						Storage::Cache::Database::TaggedValue(
+							QByteArray(
+								_waveform.constData(),
+								_waveform.size()),
+							Data::kVoiceMessageCacheTag));
+				}
 			}
 			if (voice->waveform.isEmpty()) {
 				voice->waveform.resize(1);
@@ -886,19 +905,59 @@ protected:
 
 };
 
-void countVoiceWaveform(not_null<Data::DocumentMedia*> media) {
-	const auto document = media->owner();
+void startCountVoiceWaveform(
+		not_null<DocumentData*> document,
+		const QByteArray &data) {
 	if (const auto voice = document->voice()) {
 		if (_localLoader) {
 			voice->waveform.resize(1 + sizeof(TaskId));
 			voice->waveform[0] = -1; // counting
 			TaskId taskId = _localLoader->addTask(
-				std::make_unique<CountWaveformTask>(media));
+				std::make_unique<CountWaveformTask>(document, data));
 			memcpy(voice->waveform.data() + 1, &taskId, sizeof(taskId));
+		} else {
+			voice->waveform.clear();
 		}
 	}
 }
 
+void countVoiceWaveform(not_null<Data::DocumentMedia*> media) {
+	const auto document = media->owner();
+	const auto voice = document->voice();
+	if (!voice || !_localLoader) {
+		return;
+	} else if (!document->hasRemoteLocation()) {
+		startCountVoiceWaveform(document, media->bytes());
+		return;
+	}
+
+	// Counting, the task will be started if the cache has no waveform.
+	voice->waveform.resize(1);
+	voice->waveform[0] = -1;
+
+	const auto data = media->bytes();
+	const auto guard = base::make_weak(&document->session());
+	document->owner().cache().get(
+		document->waveformCacheKey(),
+		[=](QByteArray value) {
+			crl::on_main(guard, [=] {
+				const auto voice = document->voice();
+				if (!voice
+					|| voice->waveform.size() != 1
+					|| voice->waveform[0] != -1) {
+					return;
+				} else if (!ValidCachedWaveform(value)) {
+					startCountVoiceWaveform(document, data);
+					return;
+				}
+				voice->waveform = VoiceWaveform(value.size());
+				memcpy(voice->waveform.data(), value.constData(), value.size());
+				voice->wavemax = *ranges::max_element(voice->waveform);
+				document->owner().requestDocumentViewRepaint(document);
+			});
+		});
+}
+
 void cancelTask(TaskId id) {
 	if (_localLoader) {
 		_localLoader->cancelTask(id);
@@ -978,6 +1037,7 @@ Window::Theme::Saved readThemeUsingKey(FileKey key) {
 }
 
 std::optional<QString> InitialLoadThemeUsingKey(FileKey key) {
+	const auto span = Core::StartupTrace::Span("Window::Theme::Initialize");
 	auto read = readThemeUsingKey(key);
 	const auto result = read.object.pathAbsolute;
 	if (read.object.content.isEmpty()
@@ -1095,6 +1155,7 @@ Window::Theme::Saved readThemeAfterSwitch() {
 }
 
 void readLangPack() {
+	const auto span = Core::StartupTrace::Span("Lang::fillFromSerialized");
 	FileReadDescriptor langpack;
 	if (!_langPackKey || !ReadEncryptedFile(langpack, _langPackKey, _basePath, SettingsKey)) {
 		return;
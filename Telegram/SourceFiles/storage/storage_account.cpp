@@ -25,6 +25,8 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "history/history.h"
 #include "core/application.h"
 #include "core/file_location.h"
+#include "core/startup_trace.h"
+#include "base/unixtime.h"
 #include "data/stickers/data_stickers.h"
 #include "data/data_session.h"
 #include "data/data_document.h"
@@ -41,6 +43,24 @@ using Database = Cache::Database;
 
 constexpr auto kDelayedWriteTimeout = crl::time(1000);
 
+// Upload states are saved at most that often while a file is uploading.
+constexpr auto kUploadStatesWriteTimeout = 5 * crl::time(1000);
+
+// Server doesn't keep the uploaded parts forever.
+constexpr auto kUploadStateLifetime = TimeId(6 * 3600);
+constexpr auto kUploadStatesLimit = 16;
+
+// Not listed in the map, so that older versions can read the map.
+constexpr auto kUploadStatesFileName = "uploads"_cs;
+constexpr auto kContactsFileName = "contacts"_cs;
+
+constexpr auto kPrefetchFilesLimit = qint64(16 * 1024 * 1024);
+constexpr auto kPrefetchBufferSize = 64 * 1024;
+
+// Locations journal is merged into the full file when it grows that big
+// or bigger than the full file itself.
+constexpr auto kLocationsJournalMinCompactSize = qint64(64 * 1024);
+
 constexpr auto kStickersVersionTag = quint32(-1);
 constexpr auto kStickersSerializeVersion = 1;
 constexpr auto kMaxSavedStickerSetsCount = 1000;
@@ -118,10 +138,14 @@ Account::Account(not_null<Main::Account*> owner, const QString &dataName)
 , _cacheTotalTimeLimit(Database::Settings().totalTimeLimit)
 , _cacheBigFileTotalTimeLimit(Database::Settings().totalTimeLimit)
 , _writeMapTimer([=] { writeMap(); })
-, _writeLocationsTimer([=] { writeLocations(); }) {
+, _writeLocationsTimer([=] { writeLocations(); })
+, _writeUploadStatesTimer([=] { writeUploadStates(); }) {
 }
 
 Account::~Account() {
+	if (_localKey && _writeUploadStatesTimer.isActive()) {
+		writeUploadStates();
+	}
 	if (_localKey && _mapChanged) {
 		writeMap();
 	}
@@ -131,6 +155,10 @@ QString Account::tempDirectory() const {
 	return _tempPath;
 }
 
+QString Account::uploadsTempDirectory() const {
+	return _tempPath + qsl("uploads/");
+}
+
 StartResult Account::legacyStart(const QByteArray &passcode) {
 	const auto result = readMapWith(MTP::AuthKeyPtr(), passcode);
 	if (result == ReadMapResult::Failed) {
@@ -148,6 +176,9 @@ std::unique_ptr<MTP::Config> Account::start(MTP::AuthKeyPtr localKey) {
 	_localKey = std::move(localKey);
 	readMapWith(_localKey);
 	clearLegacyFiles();
+	crl::async([uploads = uploadsTempDirectory()] {
+		QDir(uploads).removeRecursively();
+	});
 	return readMtpConfig();
 }
 
@@ -158,6 +189,27 @@ void Account::startAdded(MTP::AuthKeyPtr localKey) {
 	clearLegacyFiles();
 }
 
+void Account::prefetchLocalFiles() const {
+	crl::async([base = _basePath] {
+		const auto span = Core::StartupTrace::Span("Account::prefetch");
+		auto left = kPrefetchFilesLimit;
+		auto buffer = std::vector<char>(kPrefetchBufferSize);
+		const auto files = QDir(base).entryInfoList(QDir::Files);
+		for (const auto &info : files) {
+			if (info.size() > left) {
+				continue;
+			}
+			auto file = QFile(info.absoluteFilePath());
+			if (!file.open(QIODevice::ReadOnly)) {
+				continue;
+			}
+			while (file.read(buffer.data(), buffer.size()) > 0) {
+			}
+			left -= info.size();
+		}
+	});
+}
+
 void Account::clearLegacyFiles() {
 	const auto weak = base::make_weak(_owner.get());
 	ClearLegacyFiles(_basePath, [weak, this](
@@ -190,6 +242,8 @@ base::flat_set<QString> Account::collectGoodNames() const {
 		"map1",
 		"maps",
 		"configs",
+		kUploadStatesFileName.utf16() + QChar('s'),
+		kContactsFileName.utf16() + QChar('s'),
 	};
 	const auto push = [&](FileKey key) {
 		if (!key) {
@@ -211,6 +265,9 @@ base::flat_set<QString> Account::collectGoodNames() const {
 	for (const auto &value : keys) {
 		push(value);
 	}
+	if (_locationsKey) {
+		result.emplace(ToFilePart(_locationsKey) + 'j');
+	}
 	return result;
 }
 
@@ -395,9 +452,9 @@ Account::ReadMapResult Account::readMapWith(
 		_mapChanged = false;
 	}
 
-	if (_locationsKey) {
-		readLocations();
-	}
+	// Locations are read on the first access, they are not needed to start.
+	_locationsRead = !_locationsKey;
+
 	if (_legacyBackgroundKeyDay || _legacyBackgroundKeyNight) {
 		Local::moveLegacyBackground(
 			_basePath,
@@ -541,6 +598,8 @@ void Account::reset() {
 	_draftsMap.clear();
 	_draftCursorsMap.clear();
 	_draftsNotReadMap.clear();
+	_draftsWritten.clear();
+	_draftCursorsWritten.clear();
 	_locationsKey = _trustedBotsKey = 0;
 	_recentStickersKeyOld = 0;
 	_installedStickersKey = 0;
@@ -549,12 +608,22 @@ void Account::reset() {
 	_favedStickersKey = 0;
 	_archivedStickersKey = 0;
 	_savedGifsKey = 0;
+	_stickersReadAsync = false;
+	_stickersWritesDelayed = StickersFiles();
 	_legacyBackgroundKeyDay = _legacyBackgroundKeyNight = 0;
 	_settingsKey = _recentHashtagsAndBotsKey = _exportSettingsKey = 0;
+	_uploadStates.clear();
+	_uploadStatesRead = false;
+	_writeUploadStatesTimer.cancel();
 	_oldMapVersion = 0;
 	_fileLocations.clear();
 	_fileLocationPairs.clear();
 	_fileLocationAliases.clear();
+	_locationsJournalKeys.clear();
+	_locationsJournalAliases.clear();
+	_locationsJournalSize = _locationsFullSize = 0;
+	_locationsCompactNeeded = false;
+	_locationsRead = true;
 	_cacheTotalSizeLimit = Database::Settings().totalSizeLimit;
 	_cacheTotalTimeLimit = Database::Settings().totalTimeLimit;
 	_cacheBigFileTotalSizeLimit = Database::Settings().totalSizeLimit;
@@ -579,71 +648,170 @@ void Account::reset() {
 
 void Account::writeLocations() {
 	_writeLocationsTimer.cancel();
-	if (!_locationsChanged) {
+	if (!_locationsChanged || !_locationsRead) {
 		return;
 	}
 	_locationsChanged = false;
 
 	if (_fileLocations.isEmpty()) {
 		if (_locationsKey) {
+			QFile::remove(locationsJournalPath());
 			ClearKey(_locationsKey, _basePath);
 			_locationsKey = 0;
 			writeMapDelayed();
 		}
-	} else {
-		if (!_locationsKey) {
-			_locationsKey = GenerateKey(_basePath);
-			writeMapQueued();
-		}
-		quint32 size = 0;
-		for (auto i = _fileLocations.cbegin(), e = _fileLocations.cend(); i != e; ++i) {
-			// location + type + namelen + name
-			size += sizeof(quint64) * 2 + sizeof(quint32) + Serialize::stringSize(i.value().name());
-			if (AppVersion > 9013) {
-				// bookmark
-				size += Serialize::bytearraySize(i.value().bookmark());
-			}
-			// date + size
-			size += Serialize::dateTimeSize() + sizeof(quint32);
-		}
+		_locationsJournalKeys.clear();
+		_locationsJournalAliases.clear();
+		_locationsJournalSize = _locationsFullSize = 0;
+		_locationsCompactNeeded = false;
+		return;
+	} else if (!_locationsKey) {
+		_locationsKey = GenerateKey(_basePath);
+		writeMapQueued();
+	} else if (appendLocationsJournal()
+		&& !_locationsCompactNeeded
+		&& (_locationsJournalSize < std::max(
+			kLocationsJournalMinCompactSize,
+			_locationsFullSize))) {
+		return;
+	}
+	writeLocationsFull();
+}
 
-		//end mark
-		size += sizeof(quint64) * 2 + sizeof(quint32) + Serialize::stringSize(QString());
+void Account::writeLocationsFull() {
+	Expects(_locationsKey != 0);
+
+	quint32 size = 0;
+	for (auto i = _fileLocations.cbegin(), e = _fileLocations.cend(); i != e; ++i) {
+		// location + type + namelen + name
+		size += sizeof(quint64) * 2 + sizeof(quint32) + Serialize::stringSize(i.value().name());
 		if (AppVersion > 9013) {
-			size += Serialize::bytearraySize(QByteArray());
+			// bookmark
+			size += Serialize::bytearraySize(i.value().bookmark());
 		}
+		// date + size
 		size += Serialize::dateTimeSize() + sizeof(quint32);
+	}
 
-		size += sizeof(quint32); // aliases count
-		for (auto i = _fileLocationAliases.cbegin(), e = _fileLocationAliases.cend(); i != e; ++i) {
-			// alias + location
-			size += sizeof(quint64) * 2 + sizeof(quint64) * 2;
-		}
+	//end mark
+	size += sizeof(quint64) * 2 + sizeof(quint32) + Serialize::stringSize(QString());
+	if (AppVersion > 9013) {
+		size += Serialize::bytearraySize(QByteArray());
+	}
+	size += Serialize::dateTimeSize() + sizeof(quint32);
 
-		EncryptedDescriptor data(size);
-		auto legacyTypeField = 0;
-		for (auto i = _fileLocations.cbegin(); i != _fileLocations.cend(); ++i) {
-			data.stream << quint64(i.key().first) << quint64(i.key().second) << quint32(legacyTypeField) << i.value().name();
-			if (AppVersion > 9013) {
-				data.stream << i.value().bookmark();
-			}
-			data.stream << i.value().modified << quint32(i.value().size);
-		}
+	size += sizeof(quint32); // aliases count
+	for (auto i = _fileLocationAliases.cbegin(), e = _fileLocationAliases.cend(); i != e; ++i) {
+		// alias + location
+		size += sizeof(quint64) * 2 + sizeof(quint64) * 2;
+	}
 
-		data.stream << quint64(0) << quint64(0) << quint32(0) << QString();
+	EncryptedDescriptor data(size);
+	auto legacyTypeField = 0;
+	for (auto i = _fileLocations.cbegin(); i != _fileLocations.cend(); ++i) {
+		data.stream << quint64(i.key().first) << quint64(i.key().second) << quint32(legacyTypeField) << i.value().name();
 		if (AppVersion > 9013) {
-			data.stream << QByteArray();
+			data.stream << i.value().bookmark();
 		}
-		data.stream << QDateTime::currentDateTime() << quint32(0);
+		data.stream << i.value().modified << quint32(i.value().size);
+	}
+
+	data.stream << quint64(0) << quint64(0) << quint32(0) << QString();
+	if (AppVersion > 9013) {
+		data.stream << QByteArray();
+	}
+	data.stream << QDateTime::currentDateTime() << quint32(0);
+
+	data.stream << quint32(_fileLocationAliases.size());
+	for (auto i = _fileLocationAliases.cbegin(), e = _fileLocationAliases.cend(); i != e; ++i) {
+		data.stream << quint64(i.key().first) << quint64(i.key().second) << quint64(i.value().first) << quint64(i.value().second);
+	}
+
+	FileWriteDescriptor file(_locationsKey, _basePath);
+	file.writeEncrypted(data, _localKey);
+	_locationsFullSize = data.data.size();
+
+	// All the journaled changes are in the full file already.
+	QFile::remove(locationsJournalPath());
+	_locationsJournalKeys.clear();
+	_locationsJournalAliases.clear();
+	_locationsJournalSize = 0;
+	_locationsCompactNeeded = false;
+}
 
-		data.stream << quint32(_fileLocationAliases.size());
-		for (auto i = _fileLocationAliases.cbegin(), e = _fileLocationAliases.cend(); i != e; ++i) {
-			data.stream << quint64(i.key().first) << quint64(i.key().second) << quint64(i.value().first) << quint64(i.value().second);
+QString Account::locationsJournalPath() const {
+	return _basePath + ToFilePart(_locationsKey) + 'j';
+}
+
+bool Account::appendLocationsJournal() {
+	if (_locationsJournalKeys.empty() && _locationsJournalAliases.empty()) {
+		return true;
+	}
+
+	// Each record holds the current state of the changed keys, so records
+	// are idempotent and the journal may be replayed over a newer full file.
+	quint32 size = sizeof(quint32) * 2;
+	for (const auto &key : _locationsJournalKeys) {
+		size += sizeof(quint64) * 2 + sizeof(quint32);
+		for (auto i = _fileLocations.find(key); (i != _fileLocations.end()) && (i.key() == key); ++i) {
+			size += Serialize::stringSize(i.value().name())
+				+ Serialize::bytearraySize(i.value().bookmark())
+				+ Serialize::dateTimeSize()
+				+ sizeof(quint32);
 		}
+	}
+	size += _locationsJournalAliases.size()
+		* (sizeof(quint64) * 4 + sizeof(quint32));
 
-		FileWriteDescriptor file(_locationsKey, _basePath);
-		file.writeEncrypted(data, _localKey);
+	EncryptedDescriptor data(size);
+	data.stream << quint32(_locationsJournalKeys.size());
+	for (const auto &key : _locationsJournalKeys) {
+		data.stream
+			<< quint64(key.first)
+			<< quint64(key.second)
+			<< quint32(_fileLocations.count(key));
+		for (auto i = _fileLocations.find(key); (i != _fileLocations.end()) && (i.key() == key); ++i) {
+			data.stream
+				<< i.value().name()
+				<< i.value().bookmark()
+				<< i.value().modified
+				<< quint32(i.value().size);
+		}
+	}
+	data.stream << quint32(_locationsJournalAliases.size());
+	for (const auto &key : _locationsJournalAliases) {
+		const auto i = _fileLocationAliases.constFind(key);
+		const auto exists = (i != _fileLocationAliases.cend());
+		const auto value = exists ? i.value() : MediaKey();
+		data.stream
+			<< quint64(key.first)
+			<< quint64(key.second)
+			<< quint32(exists ? 1 : 0)
+			<< quint64(value.first)
+			<< quint64(value.second);
+	}
+	const auto record = PrepareEncrypted(data, _localKey);
+
+	QFile file(locationsJournalPath());
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+		LOG(("Storage Error: Could not open locations journal, %1"
+			).arg(file.errorString()));
+		return false;
 	}
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_1);
+	stream << record;
+	file.close();
+	if (stream.status() != QDataStream::Ok
+		|| file.error() != QFileDevice::NoError) {
+		LOG(("Storage Error: Could not write locations journal, %1"
+			).arg(file.errorString()));
+		return false;
+	}
+	_locationsJournalSize = file.size();
+	_locationsJournalKeys.clear();
+	_locationsJournalAliases.clear();
+	return true;
 }
 
 void Account::writeLocationsQueued() {
@@ -658,9 +826,24 @@ void Account::writeLocationsDelayed() {
 	_writeLocationsTimer.callOnce(kDelayedWriteTimeout);
 }
 
+void Account::ensureLocationsRead() {
+	if (_locationsRead) {
+		return;
+	}
+	_locationsRead = true;
+	if (_locationsKey) {
+		const auto started = crl::now();
+		readLocations();
+		DEBUG_LOG(("Storage Info: Read %1 file locations in %2 ms."
+			).arg(_fileLocations.size()
+			).arg(crl::now() - started));
+	}
+}
+
 void Account::readLocations() {
 	FileReadDescriptor locations;
 	if (!ReadEncryptedFile(locations, _locationsKey, _basePath, _localKey)) {
+		QFile::remove(locationsJournalPath());
 		ClearKey(_locationsKey, _basePath);
 		_locationsKey = 0;
 		writeMapDelayed();
@@ -714,6 +897,92 @@ void Account::readLocations() {
 			}
 		}
 	}
+	_locationsFullSize = locations.data.size();
+
+	readLocationsJournal();
+}
+
+void Account::readLocationsJournal() {
+	QFile file(locationsJournalPath());
+	if (!file.open(QIODevice::ReadOnly)) {
+		return;
+	}
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_1);
+
+	auto applied = 0;
+	while (!stream.atEnd()) {
+		auto encrypted = QByteArray();
+		stream >> encrypted;
+		if (stream.status() != QDataStream::Ok) {
+			LOG(("Storage Error: Bad locations journal tail."));
+			break;
+		}
+		EncryptedDescriptor data;
+		if (!DecryptLocal(data, encrypted, _localKey)
+			|| !applyLocationsJournalRecord(data.stream)) {
+			LOG(("Storage Error: Bad locations journal record."));
+			break;
+		}
+		++applied;
+	}
+	_locationsJournalSize = file.size();
+	file.close();
+
+	if (applied) {
+		_fileLocationPairs.clear();
+		for (auto i = _fileLocations.cbegin(); i != _fileLocations.cend(); ++i) {
+			if (!i.value().inMediaCache()) {
+				_fileLocationPairs.insert(i.value().fname, { i.key(), i.value() });
+			}
+		}
+	}
+
+	// Merge the journal into the full file, it also drops a broken tail.
+	_locationsCompactNeeded = true;
+	writeLocationsDelayed();
+}
+
+bool Account::applyLocationsJournalRecord(QDataStream &stream) {
+	quint32 keysCount = 0;
+	stream >> keysCount;
+	for (quint32 i = 0; i != keysCount; ++i) {
+		quint64 first = 0, second = 0;
+		quint32 count = 0;
+		stream >> first >> second >> count;
+		if (!CheckStreamStatus(stream)) {
+			return false;
+		}
+		const auto key = MediaKey(first, second);
+		_fileLocations.remove(key);
+		for (quint32 j = 0; j != count; ++j) {
+			QByteArray bookmark;
+			Core::FileLocation loc;
+			stream >> loc.fname >> bookmark >> loc.modified >> loc.size;
+			if (!CheckStreamStatus(stream)) {
+				return false;
+			}
+			loc.setBookmark(bookmark);
+			_fileLocations.insert(key, loc);
+		}
+	}
+	quint32 aliasesCount = 0;
+	stream >> aliasesCount;
+	for (quint32 i = 0; i != aliasesCount; ++i) {
+		quint64 kfirst = 0, ksecond = 0, vfirst = 0, vsecond = 0;
+		quint32 exists = 0;
+		stream >> kfirst >> ksecond >> exists >> vfirst >> vsecond;
+		if (!CheckStreamStatus(stream)) {
+			return false;
+		}
+		const auto key = MediaKey(kfirst, ksecond);
+		if (exists) {
+			_fileLocationAliases.insert(key, MediaKey(vfirst, vsecond));
+		} else {
+			_fileLocationAliases.remove(key);
+		}
+	}
+	return CheckStreamStatus(stream);
 }
 
 void Account::writeSessionSettings() {
@@ -1061,8 +1330,10 @@ void Account::writeDrafts(
 		MessageCursor(),
 		writeCallback);
 
-	FileWriteDescriptor file(i->second, _basePath);
-	file.writeEncrypted(data, _localKey);
+	if (DraftContentChanged(_draftsWritten, peerId, i->second, data.data)) {
+		FileWriteDescriptor file(i->second, _basePath);
+		file.writeEncrypted(data, _localKey);
+	}
 
 	_draftsNotReadMap.remove(peerId);
 }
@@ -1125,8 +1396,32 @@ void Account::writeDraftCursors(
 		replaceCursor,
 		writeCallback);
 
-	FileWriteDescriptor file(i->second, _basePath);
-	file.writeEncrypted(data, _localKey);
+	if (DraftContentChanged(
+			_draftCursorsWritten,
+			peerId,
+			i->second,
+			data.data)) {
+		FileWriteDescriptor file(i->second, _basePath);
+		file.writeEncrypted(data, _localKey);
+	}
+}
+
+bool Account::DraftContentChanged(
+		base::flat_map<PeerId, WrittenDraft> &written,
+		PeerId peerId,
+		FileKey key,
+		const QByteArray &data) {
+	// The first bytes are reserved for the encrypted data length.
+	const auto hash = hashMd5(
+		data.constData() + sizeof(uint32),
+		data.size() - sizeof(uint32));
+	auto &was = written[peerId];
+	if (was.key == key && was.hash == hash) {
+		return false;
+	}
+	was.key = key;
+	was.hash = hash;
+	return true;
 }
 
 void Account::clearDraftCursors(PeerId peerId) {
@@ -1351,6 +1646,7 @@ void Account::writeFileLocation(MediaKey location, const Core::FileLocation &loc
 	if (local.fname.isEmpty()) {
 		return;
 	}
+	ensureLocationsRead();
 	if (!local.inMediaCache()) {
 		const auto aliasIt = _fileLocationAliases.constFind(location);
 		if (aliasIt != _fileLocationAliases.cend()) {
@@ -1362,6 +1658,7 @@ void Account::writeFileLocation(MediaKey location, const Core::FileLocation &loc
 			if (i.value().second == local) {
 				if (i.value().first != location) {
 					_fileLocationAliases.insert(location, i.value().first);
+					_locationsJournalAliases.emplace(location);
 					writeLocationsQueued();
 				}
 				return;
@@ -1370,6 +1667,7 @@ void Account::writeFileLocation(MediaKey location, const Core::FileLocation &loc
 				for (auto j = _fileLocations.find(i.value().first), e = _fileLocations.end(); (j != e) && (j.key() == i.value().first); ++j) {
 					if (j.value() == i.value().second) {
 						_fileLocations.erase(j);
+						_locationsJournalKeys.emplace(i.value().first);
 						break;
 					}
 				}
@@ -1383,13 +1681,16 @@ void Account::writeFileLocation(MediaKey location, const Core::FileLocation &loc
 				return;
 			}
 			i = _fileLocations.erase(i);
+			_locationsJournalKeys.emplace(location);
 		}
 	}
 	_fileLocations.insert(location, local);
+	_locationsJournalKeys.emplace(location);
 	writeLocationsQueued();
 }
 
 void Account::removeFileLocation(MediaKey location) {
+	ensureLocationsRead();
 	auto i = _fileLocations.find(location);
 	if (i == _fileLocations.end()) {
 		return;
@@ -1397,10 +1698,12 @@ void Account::removeFileLocation(MediaKey location) {
 	while (i != _fileLocations.end() && (i.key() == location)) {
 		i = _fileLocations.erase(i);
 	}
+	_locationsJournalKeys.emplace(location);
 	writeLocationsQueued();
 }
 
 Core::FileLocation Account::readFileLocation(MediaKey location) {
+	ensureLocationsRead();
 	const auto aliasIt = _fileLocationAliases.constFind(location);
 	if (aliasIt != _fileLocationAliases.cend()) {
 		location = aliasIt.value();
@@ -1410,6 +1713,7 @@ Core::FileLocation Account::readFileLocation(MediaKey location) {
 		if (!i.value().inMediaCache() && !i.value().check()) {
 			_fileLocationPairs.remove(i.value().fname);
 			i = _fileLocations.erase(i);
+			_locationsJournalKeys.emplace(location);
 			writeLocationsDelayed();
 			continue;
 		}
@@ -1431,7 +1735,12 @@ EncryptionKey Account::cacheBigFileKey() const {
 QString Account::cachePath() const {
 	Expects(!_databasePath.isEmpty());
 
-	return _databasePath + "cache";
+	// Userpics, stickers and thumbnails may be kept on a faster drive,
+	// separately from the big media cache.
+	const auto fast = cFastCachePath();
+	return fast.isEmpty()
+		? (_databasePath + "cache")
+		: (QDir(fast).absolutePath() + "/user_" + _dataName + "/cache");
 }
 
 Cache::Database::Settings Account::cacheSettings() const {
@@ -1622,14 +1931,17 @@ void Account::writeStickerSets(
 void Account::readStickerSets(
 		FileKey &stickersKey,
 		Data::StickersSetsOrder *outOrder,
-		MTPDstickerSet::Flags readingFlags) {
-	FileReadDescriptor stickers;
-	if (!ReadEncryptedFile(stickers, stickersKey, _basePath, _localKey)) {
+		MTPDstickerSet::Flags readingFlags,
+		FileReadDescriptor *preread) {
+	FileReadDescriptor read;
+	if (!preread
+		&& !ReadEncryptedFile(read, stickersKey, _basePath, _localKey)) {
 		ClearKey(stickersKey, _basePath);
 		stickersKey = 0;
 		writeMapDelayed();
 		return;
 	}
+	auto &stickers = preread ? *preread : read;
 
 	const auto failed = [&] {
 		ClearKey(stickersKey, _basePath);
@@ -1852,7 +2164,18 @@ void Account::readStickerSets(
 	}
 }
 
+bool Account::delayStickersWrite(StickersFile file) {
+	if (!_stickersReadAsync) {
+		return false;
+	}
+	_stickersWritesDelayed |= file;
+	return true;
+}
+
 void Account::writeInstalledStickers() {
+	if (delayStickersWrite(StickersFile::Installed)) {
+		return;
+	}
 	writeStickerSets(_installedStickersKey, [](const Data::StickersSet &set) {
 		if (set.id == Data::Stickers::CloudRecentSetId || set.id == Data::Stickers::FavedSetId) { // separate files for them
 			return StickerSetCheckResult::Skip;
@@ -1872,6 +2195,9 @@ void Account::writeInstalledStickers() {
 }
 
 void Account::writeFeaturedStickers() {
+	if (delayStickersWrite(StickersFile::Featured)) {
+		return;
+	}
 	writeStickerSets(_featuredStickersKey, [](const Data::StickersSet &set) {
 		if (set.id == Data::Stickers::CloudRecentSetId
 			|| set.id == Data::Stickers::FavedSetId) { // separate files for them
@@ -1890,6 +2216,9 @@ void Account::writeFeaturedStickers() {
 }
 
 void Account::writeRecentStickers() {
+	if (delayStickersWrite(StickersFile::Recent)) {
+		return;
+	}
 	writeStickerSets(_recentStickersKey, [](const Data::StickersSet &set) {
 		if (set.id != Data::Stickers::CloudRecentSetId || set.stickers.isEmpty()) {
 			return StickerSetCheckResult::Skip;
@@ -1899,6 +2228,9 @@ void Account::writeRecentStickers() {
 }
 
 void Account::writeFavedStickers() {
+	if (delayStickersWrite(StickersFile::Faved)) {
+		return;
+	}
 	writeStickerSets(_favedStickersKey, [](const Data::StickersSet &set) {
 		if (set.id != Data::Stickers::FavedSetId || set.stickers.isEmpty()) {
 			return StickerSetCheckResult::Skip;
@@ -2037,6 +2369,10 @@ void Account::importOldRecentStickers() {
 }
 
 void Account::readInstalledStickers() {
+	readInstalledStickers(nullptr);
+}
+
+void Account::readInstalledStickers(FileReadDescriptor *preread) {
 	if (!_installedStickersKey) {
 		return importOldRecentStickers();
 	}
@@ -2045,14 +2381,20 @@ void Account::readInstalledStickers() {
 	readStickerSets(
 		_installedStickersKey,
 		&_owner->session().data().stickers().setsOrderRef(),
-		MTPDstickerSet::Flag::f_installed_date);
+		MTPDstickerSet::Flag::f_installed_date,
+		preread);
 }
 
 void Account::readFeaturedStickers() {
+	readFeaturedStickers(nullptr);
+}
+
+void Account::readFeaturedStickers(FileReadDescriptor *preread) {
 	readStickerSets(
 		_featuredStickersKey,
 		&_owner->session().data().stickers().featuredSetsOrderRef(),
-		MTPDstickerSet::Flags() | MTPDstickerSet_ClientFlag::f_featured);
+		MTPDstickerSet::Flags() | MTPDstickerSet_ClientFlag::f_featured,
+		preread);
 
 	const auto &sets = _owner->session().data().stickers().sets();
 	const auto &order = _owner->session().data().stickers().featuredSetsOrder();
@@ -2084,6 +2426,9 @@ void Account::readArchivedStickers() {
 }
 
 void Account::writeSavedGifs() {
+	if (delayStickersWrite(StickersFile::SavedGifs)) {
+		return;
+	}
 	auto &saved = _owner->session().data().stickers().savedGifs();
 	if (saved.isEmpty()) {
 		if (_savedGifsKey) {
@@ -2112,15 +2457,21 @@ void Account::writeSavedGifs() {
 }
 
 void Account::readSavedGifs() {
+	readSavedGifs(nullptr);
+}
+
+void Account::readSavedGifs(FileReadDescriptor *preread) {
 	if (!_savedGifsKey) return;
 
-	FileReadDescriptor gifs;
-	if (!ReadEncryptedFile(gifs, _savedGifsKey, _basePath, _localKey)) {
+	FileReadDescriptor read;
+	if (!preread
+		&& !ReadEncryptedFile(read, _savedGifsKey, _basePath, _localKey)) {
 		ClearKey(_savedGifsKey, _basePath);
 		_savedGifsKey = 0;
 		writeMapDelayed();
 		return;
 	}
+	auto &gifs = preread ? *preread : read;
 
 	auto &saved = _owner->session().data().stickers().savedGifsRef();
 	const auto failed = [&] {
@@ -2152,6 +2503,97 @@ void Account::readSavedGifs() {
 	}
 }
 
+void Account::readStickersAndSavedGifsAsync(Fn<void()> done) {
+	enum {
+		kInstalled,
+		kFeatured,
+		kRecent,
+		kFaved,
+		kSavedGifs,
+		kFilesCount,
+	};
+	using Files = std::array<
+		std::unique_ptr<FileReadDescriptor>,
+		kFilesCount>;
+	const auto keys = std::array<FileKey, kFilesCount>{ {
+		_installedStickersKey,
+		_featuredStickersKey,
+		_recentStickersKey,
+		_favedStickersKey,
+		_savedGifsKey,
+	} };
+	const auto session = &_owner->session();
+	_stickersReadAsync = true;
+	crl::async([=, base = _basePath, localKey = _localKey] {
+		const auto files = std::make_shared<Files>();
+		for (auto i = 0; i != kFilesCount; ++i) {
+			if (!keys[i]) {
+				continue;
+			}
+			auto file = std::make_unique<FileReadDescriptor>();
+			if (ReadEncryptedFile(*file, keys[i], base, localKey)) {
+				(*files)[i] = std::move(file);
+			}
+		}
+		crl::on_main(session, [=] {
+			// Files that failed to read are read again, that clears them.
+			// The keys are the same, because the writes were delayed.
+			const auto preread = [&](int index, FileKey key) {
+				return (keys[index] == key) ? (*files)[index].get() : nullptr;
+			};
+
+			// Lists written meanwhile, f.e. received from the server, are
+			// newer than the files, so the files don't override them.
+			const auto delayed = base::take(_stickersWritesDelayed);
+			const auto apply = [&](StickersFile file) {
+				return !(delayed & file);
+			};
+			if (apply(StickersFile::Installed)) {
+				readInstalledStickers(
+					preread(kInstalled, _installedStickersKey));
+			}
+			if (apply(StickersFile::Featured)) {
+				readFeaturedStickers(preread(kFeatured, _featuredStickersKey));
+			}
+			if (apply(StickersFile::Recent)) {
+				readStickerSets(
+					_recentStickersKey,
+					nullptr,
+					0,
+					preread(kRecent, _recentStickersKey));
+			}
+			if (apply(StickersFile::Faved)) {
+				readStickerSets(
+					_favedStickersKey,
+					nullptr,
+					0,
+					preread(kFaved, _favedStickersKey));
+			}
+			if (apply(StickersFile::SavedGifs)) {
+				readSavedGifs(preread(kSavedGifs, _savedGifsKey));
+			}
+
+			_stickersReadAsync = false;
+			if (delayed & StickersFile::Installed) {
+				writeInstalledStickers();
+			}
+			if (delayed & StickersFile::Featured) {
+				writeFeaturedStickers();
+			}
+			if (delayed & StickersFile::Recent) {
+				writeRecentStickers();
+			}
+			if (delayed & StickersFile::Faved) {
+				writeFavedStickers();
+			}
+			if (delayed & StickersFile::SavedGifs) {
+				writeSavedGifs();
+			}
+			done();
+		});
+	});
+}
+
 void Account::writeRecentHashtagsAndBots() {
 	const auto &write = cRecentWriteHashtags();
 	const auto &search = cRecentSearchHashtags();
@@ -2329,6 +2771,7 @@ void Account::writeExportSettings(const Export::Settings &settings) {
 		&& settings.path == check.path
 		&& settings.format == check.format
 		&& settings.availableAt == check.availableAt
+		&& settings.onlyNewMessages == check.onlyNewMessages
 		&& !settings.onlySinglePeer()) {
 		if (_exportSettingsKey) {
 			ClearKey(_exportSettingsKey, _basePath);
@@ -2343,7 +2786,7 @@ void Account::writeExportSettings(const Export::Settings &settings) {
 	}
 	quint32 size = sizeof(quint32) * 6
 		+ Serialize::stringSize(settings.path)
-		+ sizeof(qint32) * 2 + sizeof(quint64);
+		+ sizeof(qint32) * 3 + sizeof(quint64);
 	EncryptedDescriptor data(size);
 	data.stream
 		<< quint32(settings.types)
@@ -2376,6 +2819,7 @@ void Account::writeExportSettings(const Export::Settings &settings) {
 	});
 	data.stream << qint32(settings.singlePeerFrom);
 	data.stream << qint32(settings.singlePeerTill);
+	data.stream << qint32(settings.onlyNewMessages ? 1 : 0);
 
 	FileWriteDescriptor file(_exportSettingsKey, _basePath);
 	file.writeEncrypted(data, _localKey);
@@ -2397,6 +2841,7 @@ Export::Settings Account::readExportSettings() {
 	qint32 singlePeerType = 0, singlePeerBareId = 0;
 	quint64 singlePeerAccessHash = 0;
 	qint32 singlePeerFrom = 0, singlePeerTill = 0;
+	qint32 onlyNewMessages = 0;
 	file.stream
 		>> types
 		>> fullChats
@@ -2421,6 +2866,9 @@ Export::Settings Account::readExportSettings() {
 	if (!file.stream.atEnd()) {
 		file.stream >> singlePeerFrom >> singlePeerTill;
 	}
+	if (!file.stream.atEnd()) {
+		file.stream >> onlyNewMessages;
+	}
 	auto result = Export::Settings();
 	result.types = Export::Settings::Types::from_raw(types);
 	result.fullChats = Export::Settings::Types::from_raw(fullChats);
@@ -2450,6 +2898,7 @@ Export::Settings Account::readExportSettings() {
 	}();
 	result.singlePeerFrom = singlePeerFrom;
 	result.singlePeerTill = singlePeerTill;
+	result.onlyNewMessages = (onlyNewMessages == 1);
 	return (file.stream.status() == QDataStream::Ok && result.validate())
 		? result
 		: Export::Settings();
@@ -2542,6 +2991,179 @@ bool Account::isBotTrusted(not_null<UserData*> bot) {
 	return _trustedBots.contains(bot->id);
 }
 
+std::optional<UploadResumeState> Account::uploadResumeState(
+		const QString &path) {
+	if (!_uploadStatesRead) {
+		readUploadStates();
+		_uploadStatesRead = true;
+	}
+	const auto i = _uploadStates.find(path);
+	if (i == end(_uploadStates)) {
+		return std::nullopt;
+	} else if (i->second.saved + kUploadStateLifetime
+		< base::unixtime::now()) {
+		_uploadStates.erase(i);
+		_writeUploadStatesTimer.callOnce(kDelayedWriteTimeout);
+		return std::nullopt;
+	}
+	return i->second;
+}
+
+void Account::saveUploadResumeState(
+		const QString &path,
+		const UploadResumeState &state) {
+	if (!_uploadStatesRead) {
+		readUploadStates();
+		_uploadStatesRead = true;
+	}
+	auto &saved = _uploadStates[path];
+	saved = state;
+	saved.saved = base::unixtime::now();
+	while (_uploadStates.size() > kUploadStatesLimit) {
+		_uploadStates.erase(ranges::min_element(
+			_uploadStates,
+			ranges::less(),
+			[](const auto &pair) { return pair.second.saved; }));
+	}
+	if (!_writeUploadStatesTimer.isActive()) {
+		_writeUploadStatesTimer.callOnce(kUploadStatesWriteTimeout);
+	}
+}
+
+void Account::clearUploadResumeState(const QString &path) {
+	if (!_uploadStatesRead) {
+		readUploadStates();
+		_uploadStatesRead = true;
+	}
+	if (_uploadStates.remove(path)) {
+		_writeUploadStatesTimer.callOnce(kDelayedWriteTimeout);
+	}
+}
+
+void Account::writeUploadStates() {
+	_writeUploadStatesTimer.cancel();
+	if (_uploadStates.empty()) {
+		ClearFile(kUploadStatesFileName.utf16(), _basePath);
+		return;
+	}
+	quint32 size = sizeof(qint32);
+	for (const auto &[path, state] : _uploadStates) {
+		size += Serialize::stringSize(path)
+			+ sizeof(quint64)
+			+ sizeof(qint64) * 2
+			+ sizeof(qint32) * 3;
+	}
+	EncryptedDescriptor data(size);
+	data.stream << qint32(_uploadStates.size());
+	for (const auto &[path, state] : _uploadStates) {
+		data.stream
+			<< path
+			<< quint64(state.fileId)
+			<< qint64(state.size)
+			<< qint64(state.modified)
+			<< qint32(state.partSize)
+			<< qint32(state.partsDone)
+			<< qint32(state.saved);
+	}
+
+	FileWriteDescriptor file(kUploadStatesFileName.utf16(), _basePath);
+	file.writeEncrypted(data, _localKey);
+}
+
+void Account::readUploadStates() {
+	FileReadDescriptor states;
+	if (!ReadEncryptedFile(
+			states,
+			kUploadStatesFileName.utf16(),
+			_basePath,
+			_localKey)) {
+		return;
+	}
+
+	qint32 count = 0;
+	states.stream >> count;
+	for (auto i = 0; i < count; ++i) {
+		auto path = QString();
+		quint64 fileId = 0;
+		qint64 size = 0, modified = 0;
+		qint32 partSize = 0, partsDone = 0, saved = 0;
+		states.stream
+			>> path
+			>> fileId
+			>> size
+			>> modified
+			>> partSize
+			>> partsDone
+			>> saved;
+		if (!CheckStreamStatus(states.stream)) {
+			_uploadStates.clear();
+			return;
+		}
+		_uploadStates.emplace(path, UploadResumeState{
+			.fileId = fileId,
+			.size = size,
+			.modified = modified,
+			.partSize = partSize,
+			.partsDone = partsDone,
+			.saved = TimeId(saved),
+		});
+	}
+}
+
+void Account::writeContacts(
+		int32 hash,
+		const std::vector<not_null<UserData*>> &contacts) {
+	if (!hash || contacts.empty()) {
+		ClearFile(kContactsFileName.utf16(), _basePath);
+		return;
+	}
+	quint32 size = sizeof(qint32) * 2;
+	for (const auto user : contacts) {
+		size += Serialize::peerSize(user);
+	}
+	EncryptedDescriptor data(size);
+	data.stream << qint32(hash) << qint32(contacts.size());
+	for (const auto user : contacts) {
+		Serialize::writePeer(data.stream, user);
+	}
+
+	FileWriteDescriptor file(kContactsFileName.utf16(), _basePath);
+	file.writeEncrypted(data, _localKey);
+}
+
+SavedContacts Account::readContacts() {
+	FileReadDescriptor contacts;
+	if (!ReadEncryptedFile(
+			contacts,
+			kContactsFileName.utf16(),
+			_basePath,
+			_localKey)) {
+		return {};
+	}
+
+	qint32 hash = 0, count = 0;
+	contacts.stream >> hash >> count;
+	if (!CheckStreamStatus(contacts.stream)) {
+		return {};
+	}
+	auto result = SavedContacts();
+	result.users.reserve(count);
+	for (auto i = 0; i < count; ++i) {
+		const auto peer = Serialize::readPeer(
+			&_owner->session(),
+			contacts.version,
+			contacts.stream);
+		if (!peer || !CheckStreamStatus(contacts.stream)) {
+			result.hash = 0; // Broken data, request everything.
+			return result;
+		} else if (const auto user = peer->asUser()) {
+			result.users.push_back(user);
+		}
+	}
+	result.hash = hash;
+	return result;
+}
+
 bool Account::encrypt(
 		const void *src,
 		void *dst,
@@ -8,11 +8,13 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #pragma once
 
 #include "base/timer.h"
+#include "base/flags.h"
 #include "storage/cache/storage_cache_database.h"
 #include "data/stickers/data_stickers_set.h"
 #include "data/data_drafts.h"
 
 class History;
+class UserData;
 
 namespace Core {
 class FileLocation;
@@ -55,6 +57,21 @@ struct MessageDraft {
 	bool previewCancelled = false;
 };
 
+// Acknowledged parts of a big file upload, to continue it after restart.
+struct UploadResumeState {
+	uint64 fileId = 0;
+	qint64 size = 0;
+	qint64 modified = 0;
+	int32 partSize = 0;
+	int32 partsDone = 0;
+	TimeId saved = 0;
+};
+
+struct SavedContacts {
+	int32 hash = 0;
+	std::vector<not_null<UserData*>> users;
+};
+
 class Account final {
 public:
 	Account(not_null<Main::Account*> owner, const QString &dataName);
@@ -64,12 +81,19 @@ public:
 	[[nodiscartd]] std::unique_ptr<MTP::Config> start(
 		MTP::AuthKeyPtr localKey);
 	void startAdded(MTP::AuthKeyPtr localKey);
+
+	// Reads the account files in the background, so that start() finds
+	// them in the file system cache when several accounts start in a row.
+	void prefetchLocalFiles() const;
 	[[nodiscard]] int oldMapVersion() const {
 		return _oldMapVersion;
 	}
 
 	[[nodiscard]] QString tempDirectory() const;
 
+	// Temporary copies of the files being uploaded, cleared on start.
+	[[nodiscard]] QString uploadsTempDirectory() const;
+
 	[[nodiscard]] MTP::AuthKeyPtr peekLegacyLocalKey() const {
 		return _localKey;
 	}
@@ -118,6 +142,9 @@ public:
 	void writeSavedGifs();
 	void readSavedGifs();
 
+	// Reads and decrypts the files on a worker thread, parses on the main.
+	void readStickersAndSavedGifsAsync(Fn<void()> done);
+
 	void writeRecentHashtagsAndBots();
 	void readRecentHashtagsAndBots();
 	void saveRecentSentHashtags(const QString &text);
@@ -126,6 +153,18 @@ public:
 	void writeExportSettings(const Export::Settings &settings);
 	[[nodiscard]] Export::Settings readExportSettings();
 
+	[[nodiscard]] std::optional<UploadResumeState> uploadResumeState(
+		const QString &path);
+	void saveUploadResumeState(
+		const QString &path,
+		const UploadResumeState &state);
+	void clearUploadResumeState(const QString &path);
+
+	void writeContacts(
+		int32 hash,
+		const std::vector<not_null<UserData*>> &contacts);
+	[[nodiscard]] SavedContacts readContacts();
+
 	void writeSelf();
 
 	// Read self is special, it can't get session from account, because
@@ -157,6 +196,19 @@ private:
 		IncorrectPasscode,
 		Failed,
 	};
+	struct WrittenDraft {
+		FileKey key = 0;
+		std::array<char, 16> hash = { { 0 } };
+	};
+	enum class StickersFile {
+		Installed = 0x01,
+		Featured  = 0x02,
+		Recent    = 0x04,
+		Faved     = 0x08,
+		SavedGifs = 0x10,
+	};
+	using StickersFiles = base::flags<StickersFile>;
+	friend inline constexpr auto is_flag_type(StickersFile) { return true; };
 
 	[[nodiscard]] base::flat_set<QString> collectGoodNames() const;
 	[[nodiscard]] auto prepareReadSettingsContext() const
@@ -171,7 +223,13 @@ private:
 	void writeMap();
 
 	void readLocations();
+	void ensureLocationsRead();
+	void readLocationsJournal();
+	[[nodiscard]] bool applyLocationsJournalRecord(QDataStream &stream);
 	void writeLocations();
+	void writeLocationsFull();
+	[[nodiscard]] bool appendLocationsJournal();
+	[[nodiscard]] QString locationsJournalPath() const;
 	void writeLocationsQueued();
 	void writeLocationsDelayed();
 
@@ -190,6 +248,11 @@ private:
 		quint64 draftPeer,
 		Data::HistoryDrafts &map);
 	void clearDraftCursors(PeerId peerId);
+	[[nodiscard]] static bool DraftContentChanged(
+		base::flat_map<PeerId, WrittenDraft> &written,
+		PeerId peerId,
+		FileKey key,
+		const QByteArray &data);
 	void readDraftsWithCursorsLegacy(
 		not_null<History*> history,
 		details::FileReadDescriptor &draft,
@@ -206,11 +269,22 @@ private:
 	void readStickerSets(
 		FileKey &stickersKey,
 		Data::StickersSetsOrder *outOrder = nullptr,
-		MTPDstickerSet::Flags readingFlags = 0);
+		MTPDstickerSet::Flags readingFlags = 0,
+		details::FileReadDescriptor *preread = nullptr);
 	void importOldRecentStickers();
 
+	// Files are not written while they are read on a worker thread.
+	[[nodiscard]] bool delayStickersWrite(StickersFile file);
+
+	// The preread file is already read and decrypted, if not null.
+	void readInstalledStickers(details::FileReadDescriptor *preread);
+	void readFeaturedStickers(details::FileReadDescriptor *preread);
+	void readSavedGifs(details::FileReadDescriptor *preread);
+
 	void readTrustedBots();
 	void writeTrustedBots();
+	void readUploadStates();
+	void writeUploadStates();
 
 	std::optional<RecentHashtagPack> saveRecentHashtags(
 		Fn<RecentHashtagPack()> getPack,
@@ -228,10 +302,16 @@ private:
 	base::flat_map<PeerId, FileKey> _draftsMap;
 	base::flat_map<PeerId, FileKey> _draftCursorsMap;
 	base::flat_map<PeerId, bool> _draftsNotReadMap;
+	base::flat_map<PeerId, WrittenDraft> _draftsWritten;
+	base::flat_map<PeerId, WrittenDraft> _draftCursorsWritten;
 
 	QMultiMap<MediaKey, Core::FileLocation> _fileLocations;
 	QMap<QString, QPair<MediaKey, Core::FileLocation>> _fileLocationPairs;
 	QMap<MediaKey, MediaKey> _fileLocationAliases;
+	base::flat_set<MediaKey> _locationsJournalKeys;
+	base::flat_set<MediaKey> _locationsJournalAliases;
+	qint64 _locationsJournalSize = 0;
+	qint64 _locationsFullSize = 0;
 
 	FileKey _locationsKey = 0;
 	FileKey _trustedBotsKey = 0;
@@ -257,13 +337,21 @@ private:
 	bool _trustedBotsRead = false;
 	bool _readingUserSettings = false;
 	bool _recentHashtagsAndBotsWereRead = false;
+	bool _stickersReadAsync = false;
+	StickersFiles _stickersWritesDelayed;
+
+	base::flat_map<QString, UploadResumeState> _uploadStates;
+	bool _uploadStatesRead = false;
 
 	int _oldMapVersion = 0;
 
 	base::Timer _writeMapTimer;
 	base::Timer _writeLocationsTimer;
+	base::Timer _writeUploadStatesTimer;
 	bool _mapChanged = false;
 	bool _locationsChanged = false;
+	bool _locationsCompactNeeded = false;
+	bool _locationsRead = true;
 
 };
 
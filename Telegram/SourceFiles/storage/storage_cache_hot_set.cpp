@@ -0,0 +1,68 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#include "storage/storage_cache_hot_set.h"
+
+#include "storage/cache/storage_cache_types.h"
+
+namespace Storage {
+namespace {
+
+constexpr auto kMaxValueSize = 64 * 1024;
+constexpr auto kMaxTotalSize = int64(8 * 1024 * 1024);
+
+// When the limit is exceeded the least used entries are dropped
+// until the size is less than that.
+constexpr auto kPruneTillSize = kMaxTotalSize * 3 / 4;
+
+} // namespace
+
+QByteArray CacheHotSet::get(const Cache::Key &key) {
+	const auto i = _entries.find(Key(key.high, key.low));
+	if (i == end(_entries)) {
+		return QByteArray();
+	}
+	i->second.lastUsed = ++_useCounter;
+	return i->second.value;
+}
+
+void CacheHotSet::put(const Cache::Key &key, const QByteArray &value) {
+	if (value.isEmpty() || value.size() > kMaxValueSize) {
+		return;
+	}
+	auto &entry = _entries[Key(key.high, key.low)];
+	_size += value.size() - entry.value.size();
+	entry.value = value;
+	entry.lastUsed = ++_useCounter;
+	if (_size > kMaxTotalSize) {
+		prune();
+	}
+}
+
+void CacheHotSet::clear() {
+	_entries.clear();
+	_size = 0;
+}
+
+void CacheHotSet::prune() {
+	auto used = std::vector<std::pair<uint64, Key>>();
+	used.reserve(_entries.size());
+	for (const auto &[key, entry] : _entries) {
+		used.emplace_back(entry.lastUsed, key);
+	}
+	ranges::sort(used);
+	for (const auto &[lastUsed, key] : used) {
+		if (_size <= kPruneTillSize) {
+			break;
+		}
+		const auto i = _entries.find(key);
+		_size -= i->second.value.size();
+		_entries.erase(i);
+	}
+}
+
+} // namespace Storage
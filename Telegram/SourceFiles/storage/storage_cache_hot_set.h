@@ -0,0 +1,41 @@
+/*
+This file is part of Telegram Desktop,
+the official desktop application for the Telegram messaging service.
+
+For license and copyright information please follow this link:
+https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
+*/
+#pragma once
+
+#include "base/flat_map.h"
+
+namespace Storage {
+namespace Cache {
+struct Key;
+} // namespace Cache
+
+// Main thread. Keeps recently used small cached blobs (thumbnails,
+// stickers, userpics) in memory, so that scrolling back and forth in
+// a chat doesn't read them from the cache database again and again.
+class CacheHotSet final {
+public:
+	[[nodiscard]] QByteArray get(const Cache::Key &key);
+	void put(const Cache::Key &key, const QByteArray &value);
+	void clear();
+
+private:
+	using Key = std::pair<uint64, uint64>;
+	struct Entry {
+		QByteArray value;
+		uint64 lastUsed = 0;
+	};
+
+	void prune();
+
+	base::flat_map<Key, Entry> _entries;
+	int64 _size = 0;
+	uint64 _useCounter = 0;
+
+};
+
+} // namespace Storage
@@ -28,13 +28,46 @@ QByteArray ReadFinalFile(const QString &path) {
 
 bool ExtractZipFile(zlib::FileToRead &zip, const QString path) {
 	constexpr auto kMaxSize = 25 * 1024 * 1024;
-	const auto content = zip.readCurrentFileContent(kMaxSize);
-	if (content.isEmpty() || zip.error() != UNZ_OK) {
+	constexpr auto kBufferSize = 64 * 1024;
+
+	auto info = unz_file_info();
+	if (zip.getCurrentFileInfo(&info, nullptr, 0, nullptr, 0, nullptr, 0)
+			!= UNZ_OK
+		|| !info.uncompressed_size
+		|| info.uncompressed_size > kMaxSize
+		|| zip.openCurrentFile() != UNZ_OK) {
 		return false;
 	}
 	auto file = QFile(path);
-	return file.open(QIODevice::WriteOnly)
-		&& (file.write(content) == content.size());
+	if (!file.open(QIODevice::WriteOnly)) {
+		zip.closeCurrentFile();
+		return false;
+	}
+
+	// Stream the entry to disk instead of holding it whole in memory.
+	auto buffer = QByteArray(kBufferSize, Qt::Uninitialized);
+	auto written = qint64(0);
+	auto good = true;
+	while (good) {
+		const auto read = zip.readCurrentFile(buffer.data(), buffer.size());
+		if (read <= 0) {
+			good = (read == 0);
+			break;
+		}
+		written += read;
+		good = (written <= info.uncompressed_size)
+			&& (file.write(buffer.constData(), read) == read);
+	}
+
+	// Closing the entry verifies the CRC of everything we have read.
+	good = (zip.closeCurrentFile() == UNZ_OK)
+		&& good
+		&& (written == info.uncompressed_size);
+	file.close();
+	if (!good) {
+		file.remove();
+	}
+	return good;
 }
 
 } // namespace
@@ -172,33 +172,44 @@ Domain::StartModernResult Domain::startModern(
 	_oldVersion = keyData.version;
 
 	auto tried = base::flat_set<int>();
-	auto sessions = base::flat_set<uint64>();
-	auto active = 0;
+	auto accounts = std::vector<std::pair<int, std::unique_ptr<Main::Account>>>();
 	for (auto i = 0; i != count; ++i) {
 		auto index = qint32();
 		info.stream >> index;
 		if (index >= 0
 			&& index < Main::Domain::kMaxAccounts
 			&& tried.emplace(index).second) {
-			auto account = std::make_unique<Main::Account>(
+			accounts.emplace_back(index, std::make_unique<Main::Account>(
 				_owner,
 				_dataName,
-				index);
-			auto config = account->prepareToStart(_localKey);
-			const auto sessionId = account->willHaveSessionUniqueId(
-				config.get());
-			if (!sessions.contains(sessionId)
-				&& (sessionId != 0 || (sessions.empty() && i + 1 == count))) {
-				if (sessions.empty()) {
-					active = index;
-				}
-				account->start(std::move(config));
-				_owner->accountAddedInStorage({
-					.index = index,
-					.account = std::move(account)
-				});
-				sessions.emplace(sessionId);
+				index));
+		}
+	}
+
+	// The first account is read right away, prefetch the others meanwhile.
+	for (auto i = 1; i < int(accounts.size()); ++i) {
+		accounts[i].second->local().prefetchLocalFiles();
+	}
+
+	auto sessions = base::flat_set<uint64>();
+	auto active = 0;
+	for (auto i = 0; i != int(accounts.size()); ++i) {
+		auto &[index, account] = accounts[i];
+		auto config = account->prepareToStart(_localKey);
+		const auto sessionId = account->willHaveSessionUniqueId(
+			config.get());
+		if (!sessions.contains(sessionId)
+			&& (sessionId != 0
+				|| (sessions.empty() && i + 1 == int(accounts.size())))) {
+			if (sessions.empty()) {
+				active = index;
 			}
+			account->start(std::move(config));
+			_owner->accountAddedInStorage({
+				.index = index,
+				.account = std::move(account)
+			});
+			sessions.emplace(sessionId);
 		}
 	}
 	if (sessions.empty()) {
@@ -254,6 +265,26 @@ bool Domain::checkPasscode(const QByteArray &passcode) const {
 	return checkKey->equals(_passcodeKey);
 }
 
+void Domain::checkPasscodeAsync(
+		const QByteArray &passcode,
+		Fn<void(bool)> done) const {
+	Expects(!_passcodeKeySalt.isEmpty());
+	Expects(_passcodeKey != nullptr);
+
+	// Key derivation is slow, don't freeze the lock screen with it.
+	crl::async([
+		=,
+		salt = _passcodeKeySalt,
+		key = _passcodeKey,
+		done = std::move(done)
+	]() mutable {
+		const auto correct = CreateLocalKey(passcode, salt)->equals(key);
+		crl::on_main([=, done = std::move(done)] {
+			done(correct);
+		});
+	});
+}
+
 void Domain::setPasscode(const QByteArray &passcode) {
 	Expects(!_passcodeKeySalt.isEmpty());
 	Expects(_localKey != nullptr);
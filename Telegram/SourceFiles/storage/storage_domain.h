@@ -39,6 +39,9 @@ public:
 	void startFromScratch();
 
 	[[nodiscard]] bool checkPasscode(const QByteArray &passcode) const;
+	void checkPasscodeAsync(
+		const QByteArray &passcode,
+		Fn<void(bool)> done) const;
 	void setPasscode(const QByteArray &passcode);
 
 	[[nodiscard]] int oldVersion() const;
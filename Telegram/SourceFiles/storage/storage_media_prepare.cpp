@@ -78,6 +78,33 @@ void PrepareDetailsInParallel(PreparedList &result, int previewWidth) {
 	semaphore.acquire(result.files.size());
 }
 
+struct FileStat {
+	qint64 size = 0;
+	bool directory = false;
+};
+
+std::vector<FileStat> StatFilesInParallel(const QStringList &files) {
+	// Stats may be slow on network shares, so don't do them one by one.
+	auto result = std::vector<FileStat>(files.size());
+	if (files.size() < 2) {
+		if (!files.isEmpty()) {
+			const auto info = QFileInfo(files.front());
+			result.front() = { info.size(), info.isDir() };
+		}
+		return result;
+	}
+	QSemaphore semaphore;
+	for (auto i = 0, count = int(files.size()); i != count; ++i) {
+		crl::async([=, &semaphore, &files, &result] {
+			const auto info = QFileInfo(files[i]);
+			result[i] = { info.size(), info.isDir() };
+			semaphore.release();
+		});
+	}
+	semaphore.acquire(files.size());
+	return result;
+}
+
 } // namespace
 
 bool ValidateEditMediaDragData(
@@ -122,19 +149,22 @@ MimeDataState ComputeMimeDataState(const QMimeData *data) {
 
 	const auto imageExtensions = Ui::ImageExtensions();
 	auto files = QStringList();
-	auto allAreSmallImages = true;
+	files.reserve(urls.size());
 	for (const auto &url : urls) {
 		if (!url.isLocalFile()) {
 			return MimeDataState::None;
 		}
-		const auto file = Platform::File::UrlToLocal(url);
-
-		const auto info = QFileInfo(file);
-		if (info.isDir()) {
+		files.push_back(Platform::File::UrlToLocal(url));
+	}
+	const auto stats = StatFilesInParallel(files);
+	auto allAreSmallImages = true;
+	for (auto i = 0, count = int(files.size()); i != count; ++i) {
+		const auto &file = files[i];
+		if (stats[i].directory) {
 			return MimeDataState::None;
 		}
 
-		const auto filesize = info.size();
+		const auto filesize = stats[i].size;
 		if (filesize > kFileSizeLimit) {
 			return MimeDataState::None;
 		} else if (allAreSmallImages) {
@@ -169,10 +199,11 @@ PreparedList PrepareMediaList(const QStringList &files, int previewWidth) {
 	auto result = PreparedList();
 	result.files.reserve(files.size());
 	const auto extensionsToCompress = Ui::ExtensionsForCompression();
-	for (const auto &file : files) {
-		const auto fileinfo = QFileInfo(file);
-		const auto filesize = fileinfo.size();
-		if (fileinfo.isDir()) {
+	const auto stats = StatFilesInParallel(files);
+	for (auto i = 0, count = int(files.size()); i != count; ++i) {
+		const auto &file = files[i];
+		const auto filesize = stats[i].size;
+		if (stats[i].directory) {
 			return {
 				PreparedList::Error::Directory,
 				file
@@ -280,11 +311,12 @@ void PrepareDetails(PreparedFile &file, int previewWidth) {
 	} else if (const auto video = std::get_if<Video>(
 			&file.information->media)) {
 		if (ValidVideoForAlbum(*video)) {
-			auto blurred = Images::prepareBlur(Images::prepareOpaque(video->thumbnail));
+			// Video frames can be large, blur the preview-sized image.
 			file.shownDimensions = PrepareShownDimensions(video->thumbnail);
-			file.preview = std::move(blurred).scaledToWidth(
-				previewWidth * cIntRetinaFactor(),
-				Qt::SmoothTransformation);
+			file.preview = Images::prepareBlur(Images::prepareOpaque(
+				video->thumbnail.scaledToWidth(
+					previewWidth * cIntRetinaFactor(),
+					Qt::SmoothTransformation)));
 			Assert(!file.preview.isNull());
 			file.preview.setDevicePixelRatio(cRetinaFactor());
 			file.type = PreparedFile::Type::Video;
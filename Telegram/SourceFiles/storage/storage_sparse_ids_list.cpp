@@ -8,6 +8,13 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 #include "storage/storage_sparse_ids_list.h"
 
 namespace Storage {
+namespace {
+
+// flat_set::merge() sorts the whole set again, for a few new ids
+// inserting them one by one is much cheaper in large slices.
+constexpr auto kInsertOneByOneLimit = 16;
+
+} // namespace
 
 SparseIdsList::Slice::Slice(
 	base::flat_set<MsgId> &&messages,
@@ -23,7 +30,13 @@ void SparseIdsList::Slice::merge(
 	Expects(moreNoSkipRange.from <= range.till);
 	Expects(range.from <= moreNoSkipRange.till);
 
-	messages.merge(std::begin(moreMessages), std::end(moreMessages));
+	if (int(std::size(moreMessages)) <= kInsertOneByOneLimit) {
+		for (const auto messageId : moreMessages) {
+			messages.emplace(messageId);
+		}
+	} else {
+		messages.merge(std::begin(moreMessages), std::end(moreMessages));
+	}
 	range = {
 		qMin(range.from, moreNoSkipRange.from),
 		qMax(range.till, moreNoSkipRange.till)
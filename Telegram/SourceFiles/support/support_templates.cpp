@@ -275,6 +275,7 @@ TemplatesIndex ComputeIndex(const TemplatesData &data) {
 	using Term = TemplatesIndex::Term;
 
 	auto uniqueFirst = std::map<QChar, base::flat_set<Id>>();
+	auto uniqueWords = std::map<QString, base::flat_set<Id>>();
 	auto uniqueFull = std::map<Id, base::flat_set<Term>>();
 	const auto pushString = [&](
 			const Id &id,
@@ -283,6 +284,7 @@ TemplatesIndex ComputeIndex(const TemplatesData &data) {
 		const auto list = TextUtilities::PrepareSearchWords(string);
 		for (const auto &word : list) {
 			uniqueFirst[word[0]].emplace(id);
+			uniqueWords[word].emplace(id);
 			uniqueFull[id].emplace(std::make_pair(word, weight));
 		}
 	};
@@ -301,6 +303,9 @@ TemplatesIndex ComputeIndex(const TemplatesData &data) {
 	for (const auto &[ch, unique] : uniqueFirst) {
 		result.first.emplace(ch, unique | ranges::to_vector);
 	}
+	for (const auto &[word, unique] : uniqueWords) {
+		result.words.emplace(word, unique | ranges::to_vector);
+	}
 	for (const auto &[id, unique] : uniqueFull) {
 		result.full.emplace(id, unique | ranges::to_vector);
 	}
@@ -340,6 +345,30 @@ void ReplaceFileIndex(
 			std::make_move_iterator(end(list)));
 		ranges::sort(to);
 	}
+
+	for (auto i = begin(result.words); i != end(result.words);) {
+		auto &list = i->second;
+		const auto from = ranges::lower_bound(
+			list,
+			std::make_pair(path, QString()));
+		const auto till = std::find_if(from, end(list), [&](const Id &id) {
+			return id.first != path;
+		});
+		list.erase(from, till);
+		if (list.empty()) {
+			i = result.words.erase(i);
+		} else {
+			++i;
+		}
+	}
+	for (auto &[word, list] : source.words) {
+		auto &to = result.words[word];
+		to.insert(
+			end(to),
+			std::make_move_iterator(begin(list)),
+			std::make_move_iterator(end(list)));
+		ranges::sort(to);
+	}
 }
 
 void MoveKeys(TemplatesFile &to, const TemplatesFile &from) {
@@ -674,10 +703,20 @@ auto Templates::query(const QString &text) const -> std::vector<Question> {
 	if (best == std::end(words)) {
 		return {};
 	}
-	const auto narrowed = _index.first.find((*best)[0]);
-	if (narrowed == end(_index.first)) {
+
+	// Every found question has a word starting with the best query word.
+	auto candidates = std::vector<TemplatesIndex::Id>();
+	for (auto i = _index.words.lower_bound(*best)
+		; i != end(_index.words) && i->first.startsWith(*best)
+		; ++i) {
+		candidates.insert(end(candidates), begin(i->second), end(i->second));
+	}
+	if (candidates.empty()) {
 		return {};
 	}
+	ranges::sort(candidates);
+	candidates.erase(ranges::unique(candidates), end(candidates));
+
 	using Id = TemplatesIndex::Id;
 	using Term = TemplatesIndex::Term;
 	const auto questionById = [&](const Id &id) {
@@ -730,14 +769,19 @@ auto Templates::query(const QString &text) const -> std::vector<Question> {
 			return (a.first.second < b.first.second);
 		}
 	};
-	const auto good = narrowed->second | ranges::view::transform(
+	auto good = candidates | ranges::view::transform(
 		pairById
 	) | ranges::view::filter([](const Pair &pair) {
 		return pair.second > 0;
-	}) | ranges::to_vector | ranges::action::stable_sort(sorter);
+	}) | ranges::to_vector;
+
+	// The sorter is a strict total order, so a partial sort of the few
+	// questions we show gives the same result as sorting all of them.
+	const auto shown = std::min(int(good.size()), kQueryLimit);
+	std::partial_sort(begin(good), begin(good) + shown, end(good), sorter);
 	return good | ranges::view::transform([&](const Pair &pair) {
 		return questionById(pair.first);
-	}) | ranges::view::take(kQueryLimit) | ranges::to_vector;
+	}) | ranges::view::take(shown) | ranges::to_vector;
 }
 
 } // namespace Support
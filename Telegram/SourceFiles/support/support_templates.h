@@ -39,6 +39,7 @@ struct TemplatesIndex {
 	using Term = std::pair<QString, int>; // search term, weight
 
 	std::map<QChar, std::vector<Id>> first;
+	std::map<QString, std::vector<Id>> words;
 	std::map<Id, std::vector<Term>> full;
 };
 
@@ -7,9 +7,16 @@ https://github.com/telegramdesktop/tdesktop/blob/master/LEGAL
 */
 #include "ui/grouped_layout.h"
 
+#include "base/flat_map.h"
+
 namespace Ui {
 namespace {
 
+// Layouts are recounted for every album on each relayout,
+// but identical albums and repeated relayouts give the same result.
+// The cache is used only from the main thread.
+constexpr auto kCachedLayoutsLimit = 256;
+
 int Round(float64 value) {
 	return int(std::round(value));
 }
@@ -572,7 +579,28 @@ std::vector<GroupMediaLayout> LayoutMediaGroup(
 		int maxWidth,
 		int minWidth,
 		int spacing) {
-	return Layouter(sizes, maxWidth, minWidth, spacing).layout();
+	static auto Cache = base::flat_map<
+		std::vector<int>,
+		std::vector<GroupMediaLayout>>();
+
+	auto key = std::vector<int>();
+	key.reserve(3 + sizes.size() * 2);
+	key.push_back(maxWidth);
+	key.push_back(minWidth);
+	key.push_back(spacing);
+	for (const auto &size : sizes) {
+		key.push_back(size.width());
+		key.push_back(size.height());
+	}
+	if (const auto i = Cache.find(key); i != end(Cache)) {
+		return i->second;
+	}
+	auto result = Layouter(sizes, maxWidth, minWidth, spacing).layout();
+	if (Cache.size() >= kCachedLayoutsLimit) {
+		Cache.clear();
+	}
+	Cache.emplace(std::move(key), result);
+	return result;
 }
 
 RectParts GetCornersFromSides(RectParts sides) {
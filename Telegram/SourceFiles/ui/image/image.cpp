@@ -17,6 +17,35 @@ using namespace Images;
 namespace Images {
 namespace {
 
+// Keep that part of the budget after an eviction, so that we don't
+// evict again right after the next pixmap is added.
+constexpr auto kPixmapCacheEvictTo = 0.75;
+
+// All the cached pixmaps of all the images, evicted by last use time.
+struct PixmapCache {
+	base::flat_set<not_null<const Image*>> images;
+	int64 bytes = 0;
+	uint64 useCounter = 0;
+	int64 hits = 0;
+	int64 misses = 0;
+	int64 evicted = 0;
+	bool evictScheduled = false;
+};
+
+[[nodiscard]] PixmapCache &GlobalPixmapCache() {
+	// Never destroyed, because static images may outlive it.
+	static const auto result = new PixmapCache();
+	return *result;
+}
+
+[[nodiscard]] int64 PixmapCacheLimit() {
+	return int64(cImagePixmapCacheLimit()) * 1024 * 1024;
+}
+
+[[nodiscard]] int64 ComputePixmapBytes(const QPixmap &pixmap) {
+	return int64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+}
+
 [[nodiscard]] uint64 PixKey(int width, int height, Options options) {
 	return static_cast<uint64>(width)
 		| (static_cast<uint64>(height) << 24)
@@ -116,6 +145,20 @@ Image::Image(QImage &&data)
 	Expects(!_data.isNull());
 }
 
+Image::Image(const Image &other) : _data(other._data) {
+}
+
+Image::~Image() {
+	if (_cache.empty()) {
+		return;
+	}
+	auto &cache = GlobalPixmapCache();
+	cache.images.remove(this);
+	for (const auto &[key, cached] : _cache) {
+		cache.bytes -= ComputePixmapBytes(cached.pixmap);
+	}
+}
+
 not_null<Image*> Image::Empty() {
 	static auto result = Image([] {
 		const auto factor = cIntRetinaFactor();
@@ -148,6 +191,87 @@ QImage Image::original() const {
 	return _data;
 }
 
+const QPixmap *Image::findCached(uint64 key) const {
+	auto &cache = GlobalPixmapCache();
+	const auto i = _cache.find(key);
+	if (i == _cache.end()) {
+		++cache.misses;
+		return nullptr;
+	}
+	++cache.hits;
+	i->second.lastUsed = ++cache.useCounter;
+	return &i->second.pixmap;
+}
+
+const QPixmap &Image::storeCached(uint64 key, QPixmap &&pixmap) const {
+	auto &cache = GlobalPixmapCache();
+	const auto i = _cache.find(key);
+	if (i != _cache.end()) {
+		cache.bytes -= ComputePixmapBytes(i->second.pixmap);
+	} else if (_cache.empty()) {
+		cache.images.emplace(this);
+	}
+	cache.bytes += ComputePixmapBytes(pixmap);
+	const auto limit = PixmapCacheLimit();
+	if (limit > 0 && cache.bytes > limit && !cache.evictScheduled) {
+		// Evict later, so that references returned right now stay valid.
+		cache.evictScheduled = true;
+		crl::on_main(&Image::EvictCached);
+	}
+	auto &result = _cache[key];
+	result.pixmap = std::move(pixmap);
+	result.lastUsed = ++cache.useCounter;
+	return result.pixmap;
+}
+
+void Image::EvictCached() {
+	auto &cache = GlobalPixmapCache();
+	cache.evictScheduled = false;
+	const auto limit = PixmapCacheLimit();
+	if (limit <= 0 || cache.bytes <= limit) {
+		return;
+	}
+	struct Entry {
+		uint64 lastUsed = 0;
+		not_null<const Image*> image;
+		uint64 key = 0;
+	};
+	auto entries = std::vector<Entry>();
+	for (const auto image : cache.images) {
+		for (const auto &[key, cached] : image->_cache) {
+			entries.push_back({ cached.lastUsed, image, key });
+		}
+	}
+	ranges::sort(entries, ranges::less(), &Entry::lastUsed);
+
+	const auto evictTo = int64(limit * kPixmapCacheEvictTo);
+	auto evicted = 0;
+	for (const auto &entry : entries) {
+		if (cache.bytes <= evictTo) {
+			break;
+		}
+		auto &images = entry.image->_cache;
+		const auto i = images.find(entry.key);
+		cache.bytes -= ComputePixmapBytes(i->second.pixmap);
+		images.erase(i);
+		if (images.empty()) {
+			cache.images.remove(entry.image);
+		}
+		++evicted;
+	}
+	cache.evicted += evicted;
+
+	const auto requests = cache.hits + cache.misses;
+	DEBUG_LOG(("Image Cache: evicted %1 pixmaps, %2 bytes left, "
+		"%3 images, hit rate %4% (%5 requests, %6 evicted total)."
+		).arg(evicted
+		).arg(cache.bytes
+		).arg(int(cache.images.size())
+		).arg(requests ? (cache.hits * 100 / requests) : 0
+		).arg(requests
+		).arg(cache.evicted));
+}
+
 const QPixmap &Image::pix(int w, int h) const {
 	if (w <= 0 || !width() || !height()) {
 		w = width();
@@ -157,13 +281,12 @@ const QPixmap &Image::pix(int w, int h) const {
 	}
 	auto options = Option::Smooth | Option::None;
 	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixNoCache(w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	if (const auto cached = findCached(k)) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixNoCache(w, h, options);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 const QPixmap &Image::pixRounded(
@@ -192,13 +315,12 @@ const QPixmap &Image::pixRounded(
 		options |= Option::Circled | cornerOptions(corners);
 	}
 	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixNoCache(w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	if (const auto cached = findCached(k)) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixNoCache(w, h, options);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 const QPixmap &Image::pixCircled(int w, int h) const {
@@ -210,13 +332,12 @@ const QPixmap &Image::pixCircled(int w, int h) const {
 	}
 	auto options = Option::Smooth | Option::Circled;
 	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixNoCache(w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	if (const auto cached = findCached(k)) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixNoCache(w, h, options);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 const QPixmap &Image::pixBlurredCircled(int w, int h) const {
@@ -228,13 +349,12 @@ const QPixmap &Image::pixBlurredCircled(int w, int h) const {
 	}
 	auto options = Option::Smooth | Option::Circled | Option::Blurred;
 	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixNoCache(w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	if (const auto cached = findCached(k)) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixNoCache(w, h, options);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 const QPixmap &Image::pixBlurred(int w, int h) const {
@@ -246,13 +366,12 @@ const QPixmap &Image::pixBlurred(int w, int h) const {
 	}
 	auto options = Option::Smooth | Option::Blurred;
 	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixNoCache(w, h, options);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	if (const auto cached = findCached(k)) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixNoCache(w, h, options);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 const QPixmap &Image::pixColored(style::color add, int w, int h) const {
@@ -264,13 +383,12 @@ const QPixmap &Image::pixColored(style::color add, int w, int h) const {
 	}
 	auto options = Option::Smooth | Option::Colored;
 	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixColoredNoCache(add, w, h, true);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	if (const auto cached = findCached(k)) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixColoredNoCache(add, w, h, true);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 const QPixmap &Image::pixBlurredColored(
@@ -285,13 +403,12 @@ const QPixmap &Image::pixBlurredColored(
 	}
 	auto options = Option::Blurred | Option::Smooth | Option::Colored;
 	auto k = PixKey(w, h, options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend()) {
-		auto p = pixBlurredColoredNoCache(add, w, h);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	if (const auto cached = findCached(k)) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixBlurredColoredNoCache(add, w, h);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 const QPixmap &Image::pixSingle(
@@ -328,13 +445,15 @@ const QPixmap &Image::pixSingle(
 	}
 
 	auto k = SinglePixKey(options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend() || i->second.width() != (outerw * cIntRetinaFactor()) || i->second.height() != (outerh * cIntRetinaFactor())) {
-		auto p = pixNoCache(w, h, options, outerw, outerh, colored);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	const auto cached = findCached(k);
+	if (cached
+		&& cached->width() == (outerw * cIntRetinaFactor())
+		&& cached->height() == (outerh * cIntRetinaFactor())) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixNoCache(w, h, options, outerw, outerh, colored);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 const QPixmap &Image::pixBlurredSingle(
@@ -367,13 +486,15 @@ const QPixmap &Image::pixBlurredSingle(
 	}
 
 	auto k = SinglePixKey(options);
-	auto i = _cache.find(k);
-	if (i == _cache.cend() || i->second.width() != (outerw * cIntRetinaFactor()) || i->second.height() != (outerh * cIntRetinaFactor())) {
-		auto p = pixNoCache(w, h, options, outerw, outerh);
-		p.setDevicePixelRatio(cRetinaFactor());
-		i = _cache.emplace_or_assign(k, p).first;
+	const auto cached = findCached(k);
+	if (cached
+		&& cached->width() == (outerw * cIntRetinaFactor())
+		&& cached->height() == (outerh * cIntRetinaFactor())) {
+		return *cached;
 	}
-	return i->second;
+	auto p = pixNoCache(w, h, options, outerw, outerh);
+	p.setDevicePixelRatio(cRetinaFactor());
+	return storeCached(k, std::move(p));
 }
 
 QPixmap Image::pixNoCache(
@@ -460,12 +581,17 @@ QPixmap Image::pixBlurredColoredNoCache(
 		return Empty()->pix();
 	}
 
-	auto img = prepareBlur(_data);
+	// Blur the smaller image of the two, it costs per pixel.
+	const auto shrinking = (w < _data.width());
+	auto img = shrinking ? _data : prepareBlur(_data);
 	if (h <= 0) {
 		img = img.scaledToWidth(w, Qt::SmoothTransformation);
 	} else {
 		img = img.scaled(w, h, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
 	}
+	if (shrinking) {
+		img = prepareBlur(std::move(img));
+	}
 
-	return App::pixmapFromImageInPlace(prepareColored(add, img));
+	return App::pixmapFromImageInPlace(prepareColored(add, std::move(img)));
 }
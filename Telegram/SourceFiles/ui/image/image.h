@@ -24,6 +24,8 @@ public:
 	explicit Image(const QString &path);
 	explicit Image(const QByteArray &content);
 	explicit Image(QImage &&data);
+	Image(const Image &other);
+	~Image();
 
 	[[nodiscard]] static not_null<Image*> Empty(); // 1x1 transparent
 	[[nodiscard]] static not_null<Image*> BlankMedia(); // 1x1 black
@@ -91,7 +93,16 @@ public:
 		int h = 0) const;
 
 private:
+	struct CachedPixmap {
+		QPixmap pixmap;
+		uint64 lastUsed = 0;
+	};
+
+	[[nodiscard]] const QPixmap *findCached(uint64 key) const;
+	const QPixmap &storeCached(uint64 key, QPixmap &&pixmap) const;
+	static void EvictCached();
+
 	const QImage _data;
-	mutable base::flat_map<uint64, QPixmap> _cache;
+	mutable base::flat_map<uint64, CachedPixmap> _cache;
 
 };
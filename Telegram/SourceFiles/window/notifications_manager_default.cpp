@@ -329,9 +329,35 @@ void Manager::removeWidget(internal::Widget *remove) {
 	showNextFromQueue();
 }
 
+bool Manager::mergeWithExisting(
+		not_null<HistoryItem*> item,
+		int forwardedCount) {
+	for (const auto &notification : _notifications) {
+		if (notification->tryMerge(item, forwardedCount)) {
+			return true;
+		}
+	}
+	const auto history = item->history();
+	const auto fromScheduled = item->isFromScheduled();
+	for (auto &queued : _queuedNotifications) {
+		if (queued.history == history
+			&& !queued.fromScheduled
+			&& !fromScheduled) {
+			queued = QueuedNotification(item, forwardedCount);
+			return true;
+		}
+	}
+	return false;
+}
+
 void Manager::doShowNotification(
 		not_null<HistoryItem*> item,
 		int forwardedCount) {
+	// Bursts from one chat update a single notification instead of
+	// flooding the screen and the queue with separate widgets.
+	if (mergeWithExisting(item, forwardedCount)) {
+		return;
+	}
 	_queuedNotifications.emplace_back(item, forwardedCount);
 	showNextFromQueue();
 }
@@ -841,6 +867,41 @@ void Notification::updateNotifyDisplay() {
 	update();
 }
 
+void Notification::updateNotifyDisplayQueued() {
+	if (_updateDisplayQueued) {
+		return;
+	}
+	_updateDisplayQueued = true;
+	crl::on_main(this, [=] {
+		_updateDisplayQueued = false;
+		updateNotifyDisplay();
+	});
+}
+
+bool Notification::tryMerge(
+		not_null<HistoryItem*> item,
+		int forwardedCount) {
+	if (!_history
+		|| _history != item->history()
+		|| _fromScheduled
+		|| item->isFromScheduled()
+		|| _replyArea
+		|| isHiding()) {
+		return false;
+	}
+	_author = item->notificationHeader();
+	_item = (forwardedCount < 2) ? item.get() : nullptr;
+	_forwardedCount = forwardedCount;
+
+	// Keep the notification on the screen for the new message as well.
+	_started = crl::now();
+	if (_hideTimer.isActive()) {
+		_hideTimer.start(st::notifyWaitLongHide);
+	}
+	updateNotifyDisplayQueued();
+	return true;
+}
+
 void Notification::updatePeerPhoto() {
 	if (_userpicLoaded) {
 		return;
@@ -73,6 +73,9 @@ private:
 	void doClearFromSession(not_null<Main::Session*> session) override;
 	void doClearFromItem(not_null<HistoryItem*> item) override;
 
+	[[nodiscard]] bool mergeWithExisting(
+		not_null<HistoryItem*> item,
+		int forwardedCount);
 	void showNextFromQueue();
 	void unlinkFromShown(Notification *remove);
 	void startAllHiding();
@@ -137,6 +140,9 @@ public:
 	bool isShowing() const {
 		return _a_opacity.animating() && !_hiding;
 	}
+	bool isHiding() const {
+		return _hiding;
+	}
 
 	void updateOpacity();
 	void changeShift(int top);
@@ -210,6 +216,9 @@ public:
 	void updateNotifyDisplay();
 	void updatePeerPhoto();
 
+	// Shows the new message in this widget if it is from the same chat.
+	bool tryMerge(not_null<HistoryItem*> item, int forwardedCount);
+
 	bool isUnlinked() const {
 		return !_history;
 	}
@@ -246,6 +255,7 @@ private:
 	void showReplyField();
 	void sendReply();
 	void changeHeight(int newHeight);
+	void updateNotifyDisplayQueued();
 	void updateGeometry(int x, int y, int width, int height) override;
 	void actionsOpacityCallback();
 
@@ -268,6 +278,7 @@ private:
 	HistoryItem *_item = nullptr;
 	int _forwardedCount = 0;
 	bool _fromScheduled = false;
+	bool _updateDisplayQueued = false;
 	object_ptr<Ui::IconButton> _close;
 	object_ptr<Ui::RoundButton> _reply;
 	object_ptr<Background> _background = { nullptr };
@@ -328,6 +328,10 @@ bool LoadTheme(
 			if (colorizer) {
 				Colorize(background, colorizer);
 			}
+
+			// Limit the size the same way as for the chat wallpapers,
+			// so that the cached bitmap read on each launch stays small.
+			background = ProcessBackgroundImage(std::move(background));
 			if (cache) {
 				auto buffer = QBuffer(&cache->background);
 				if (!background.save(&buffer, "BMP")) {
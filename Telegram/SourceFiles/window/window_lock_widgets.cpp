@@ -139,7 +139,9 @@ void PasscodeLockWidget::paintContent(Painter &p) {
 }
 
 void PasscodeLockWidget::submit() {
-	if (_passcode->text().isEmpty()) {
+	if (_checking) {
+		return;
+	} else if (_passcode->text().isEmpty()) {
 		_passcode->showError();
 		return;
 	}
@@ -152,9 +154,18 @@ void PasscodeLockWidget::submit() {
 
 	const auto passcode = _passcode->text().toUtf8();
 	auto &domain = Core::App().domain();
-	const auto correct = domain.started()
-		? domain.local().checkPasscode(passcode)
-		: (domain.start(passcode) == Storage::StartResult::Success);
+	if (domain.started()) {
+		_checking = true;
+		domain.local().checkPasscodeAsync(
+			passcode,
+			crl::guard(this, [=](bool correct) { checked(correct); }));
+		return;
+	}
+	checked(domain.start(passcode) == Storage::StartResult::Success);
+}
+
+void PasscodeLockWidget::checked(bool correct) {
+	_checking = false;
 	if (!correct) {
 		cSetPasscodeBadTries(cPasscodeBadTries() + 1);
 		cSetPasscodeLastTry(crl::now());
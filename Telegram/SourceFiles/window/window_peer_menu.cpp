@@ -1102,6 +1102,7 @@ QPointer<Ui::RpWidget> ShowForwardMessagesBox(
 		not_null<PeerData*> peer;
 		MessageIdsList msgIds;
 		int requestsLeft = 0;
+		base::flat_set<not_null<PeerData*>> failed;
 		FnMut<void()> submitCallback;
 	};
 	struct MsgIdsGroup {
@@ -1266,10 +1267,20 @@ QPointer<Ui::RpWidget> ShowForwardMessagesBox(
 		const auto checkAndClose = [=] {
 			data->requestsLeft--;
 			if (!data->requestsLeft) {
-				Ui::Toast::Show(tr::lng_share_done(tr::now));
+				const auto failed = base::take(data->failed);
+				Ui::Toast::Show(failed.empty()
+					? tr::lng_share_done(tr::now)
+					: tr::ktg_share_failed(
+						tr::now,
+						lt_count,
+						failed.size()));
 				Ui::hideLayer();
 			}
 		};
+		const auto requestFailed = [=](not_null<PeerData*> peer) {
+			data->failed.emplace(peer);
+			checkAndClose();
+		};
 		auto &api = owner->session().api();
 		auto &histories = owner->histories();
 		const auto requestType = Data::Histories::RequestType::Send;
@@ -1292,6 +1303,7 @@ QPointer<Ui::RpWidget> ShowForwardMessagesBox(
 					checkAndClose();
 					finish();
 				}).fail([=](const RPCError &error) {
+					requestFailed(history->peer);
 					finish();
 				}).afterRequest(history->sendRequestId).send();
 				return history->sendRequestId;
@@ -1301,9 +1313,7 @@ QPointer<Ui::RpWidget> ShowForwardMessagesBox(
 
 		const auto forwardAlbumUnquoted = [&] (MsgIdsGroup &&group, not_null<History*> history) {
 			auto medias = QVector<MTPInputSingleMedia>();
-			auto mediaRefs = QVector<QByteArray>();
 			medias.reserve(group.items.size());
-			mediaRefs.reserve(group.items.size());
 
 			auto randomIds = generateRandom(group.items.size());
 
@@ -1332,9 +1342,6 @@ QPointer<Ui::RpWidget> ShowForwardMessagesBox(
 					randomId,
 					MTP_string(caption.text),
 					sentEntities));
-				mediaRefs.push_back(media->photo()
-					? media->photo()->fileReference()
-					: media->document()->fileReference());
 			}
 
 			const auto flags = MTPmessages_SendMultiMedia::Flags(0)
@@ -1345,14 +1352,19 @@ QPointer<Ui::RpWidget> ShowForwardMessagesBox(
 					? MTPmessages_SendMultiMedia::Flag::f_schedule_date
 					: MTPmessages_SendMultiMedia::Flag(0));
 
-			auto performRequest = [=, &mediaRefs, &histories](const auto &repeatRequest) -> void {
-				mediaRefs.clear();
+			const auto fileReference = [](not_null<Data::Media*> media) {
+				return media->photo()
+					? media->photo()->fileReference()
+					: media->document()->fileReference();
+			};
+
+			auto performRequest = [=](const auto &repeatRequest) -> void {
+				auto usedFileReferences = QVector<QByteArray>();
+				usedFileReferences.reserve(group.items.size());
 				for (const auto item : group.items) {
-					const auto media = item->media();
-					mediaRefs.push_back(media->photo()
-						? media->photo()->fileReference()
-						: media->document()->fileReference());
+					usedFileReferences.push_back(fileReference(item->media()));
 				}
+				auto &histories = history->owner().histories();
 				histories.sendRequest(history, requestType, [=](Fn<void()> finish) {
 					auto &api = history->session().api();
 					history->sendRequestId = api.request(MTPmessages_SendMultiMedia(
@@ -1368,36 +1380,36 @@ QPointer<Ui::RpWidget> ShowForwardMessagesBox(
 					}).fail([=](const RPCError &error) {
 						if (error.code() == 400
 							&& error.type().startsWith(qstr("FILE_REFERENCE_"))) {
-							auto refreshRequests = mediaRefs.size();
+							// Repeat or fail the whole album once,
+							// after all the references are refreshed.
+							const auto refreshesLeft = std::make_shared<int>(
+								group.items.size());
+							const auto changed = std::make_shared<bool>(false);
 							auto index = 0;
 							for (const auto item : group.items) {
 								const auto media = item->media();
 								const auto origin = media->document()
 										? media->document()->stickerOrGifOrigin()
 										: Data::FileOrigin();
-								const auto usedFileReference = mediaRefs.value(index);
-								
-								history->session().api().refreshFileReference(origin, [=, &refreshRequests](const auto &result) {
-									if (refreshRequests > 0) {
-										refreshRequests--;
-										return;
+								const auto usedFileReference = usedFileReferences.value(index++);
+								history->session().api().refreshFileReference(origin, [=](const auto &result) {
+									if (fileReference(media) != usedFileReference) {
+										*changed = true;
 									}
-
-									const auto currentMediaReference = media->photo()
-											? media->photo()->fileReference()
-											: media->document()->fileReference();
-
-									if (currentMediaReference != usedFileReference) {
+									if (--*refreshesLeft) {
+										return;
+									} else if (*changed) {
 										repeatRequest(repeatRequest);
 									} else {
 										history->session().api().sendMessageFail(error, history->peer);
+										requestFailed(history->peer);
 									}
 								});
-								index++;
 							}
 						} else {
-							finish();
+							requestFailed(history->peer);
 						}
+						finish();
 					}).afterRequest(history->sendRequestId).send();
 					return history->sendRequestId;
 				});
@@ -1426,6 +1438,9 @@ QPointer<Ui::RpWidget> ShowForwardMessagesBox(
 			auto doneCallback = [=] () {
 				checkAndClose();
 			};
+			auto failCallback = [=] () {
+				requestFailed(history->peer);
+			};
 
 			auto &api = history->session().api();
 
@@ -1435,33 +1450,37 @@ QPointer<Ui::RpWidget> ShowForwardMessagesBox(
 					poll,
 					message.action,
 					std::move(doneCallback),
-					nullptr);
+					[=](const RPCError &error) { failCallback(); });
 			} else if (media->geoPoint()) {
 				const auto location = *(media->geoPoint());
 				Api::SendLocationPoint(
 					location,
 					message.action,
 					std::move(doneCallback),
-					nullptr);
+					[=](const RPCError &error) { failCallback(); });
 			} else if (media->sharedContact()) {
 				const auto contact = media->sharedContact();
 				api.shareContact(
 					contact->phoneNumber,
 					contact->firstName,
 					contact->lastName,
-					message.action);
+					message.action,
+					std::move(doneCallback),
+					std::move(failCallback));
 			} else if (media->photo()) {
 				Api::SendExistingPhoto(
 					std::move(message),
 					media->photo(),
 					std::move(doneCallback),
-					true); // forwarding
+					true, // forwarding
+					std::move(failCallback));
 			} else if (media->document()) {
 				Api::SendExistingDocument(
 					std::move(message),
 					media->document(),
 					std::move(doneCallback),
-					true); // forwarding
+					true, // forwarding
+					std::move(failCallback));
 			} else {
 				Unexpected("Media type in Window::ShowForwardMessagesBox.");
 			}
@@ -1490,7 +1509,10 @@ QPointer<Ui::RpWidget> ShowForwardMessagesBox(
 				[=] (const MTPUpdates &result, mtpRequestId requestId) {
 					checkAndClose();
 				},
-				true); // forwarding
+				true, // forwarding
+				[=] (const RPCError &error) {
+					requestFailed(history->peer);
+				});
 
 			data->requestsLeft++;
 		};
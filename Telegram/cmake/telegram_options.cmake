@@ -7,6 +7,7 @@
 option(TDESKTOP_DISABLE_GTK_INTEGRATION "Disable all code for GTK integration (Linux only)." OFF)
 option(TDESKTOP_API_TEST "Use test API credentials." OFF)
 option(KTGDESKTOP_ENABLE_PACKER "Enable building update packer on non-special targets." OFF)
+option(KTGDESKTOP_ENABLE_OPENGL_OVERLAY "Use OpenGL for rendering the media viewer on all platforms." OFF)
 set(TDESKTOP_API_ID "0" CACHE STRING "Provide 'api_id' for the Telegram API access.")
 set(TDESKTOP_API_HASH "" CACHE STRING "Provide 'api_hash' for the Telegram API access.")
 set(TDESKTOP_LAUNCHER_BASENAME "" CACHE STRING "Desktop file base name (Linux only).")
@@ -34,6 +35,10 @@ if (TDESKTOP_DISABLE_GTK_INTEGRATION)
     target_compile_definitions(Telegram PRIVATE TDESKTOP_DISABLE_GTK_INTEGRATION)
 endif()
 
+if (KTGDESKTOP_ENABLE_OPENGL_OVERLAY)
+    target_compile_definitions(Telegram PRIVATE KTGDESKTOP_ENABLE_OPENGL_OVERLAY)
+endif()
+
 if (NOT TDESKTOP_LAUNCHER_BASENAME)
     set(TDESKTOP_LAUNCHER_BASENAME "kotatogramdesktop")
 endif()